@@ -120,6 +120,8 @@ if(ENABLE_DEBUG_LOGGING)
 endif()
 if(ENABLE_TESTING)
     add_definitions(-DENABLE_TESTING)
+    # The tests are written with doctest.
+    set(USE_DOC_TEST ON)
 endif()
 
 #########################
@@ -144,6 +146,18 @@ if (ENABLE_TESTING)
   add_definitions(-DENABLE_TESTING)
 endif()
 
+# Build the benchmark executable
+option(BUILD_BENCHMARKS "Build the benchmark executable" OFF)
+if (BUILD_BENCHMARKS)
+  add_definitions(-DBUILD_BENCHMARKS)
+endif()
+
+# Build the load generator executable
+option(BUILD_LOADGEN "Build the load generator executable" OFF)
+if (BUILD_LOADGEN)
+  add_definitions(-DBUILD_LOADGEN)
+endif()
+
 # Enable the test of clang-tidy
 option(ENABLE_CLANG_TIDY "Enabling the test of clang-tidy" OFF)
 if (ENABLE_CLANG_TIDY)
@@ -0,0 +1,31 @@
+# Package Info.
+set(ZMQ_NAME "ZeroMQ")
+set(ZMQ_DESCRIPTION "High-performance asynchronous messaging library, used for bitcoind ZMQ notifications.")
+
+# Pakcage option.
+option(USE_ZMQ ${ZMQ_DESCRIPTION} FALSE)
+if (USE_ZMQ)
+    add_definitions(-DUSE_ZMQ)
+endif()
+
+# Package data repository.
+if(USE_ZMQ)
+    # Search libzmq
+    find_package(PkgConfig REQUIRED)
+    pkg_search_module(ZMQ REQUIRED libzmq)
+    if( ZMQ_FOUND )
+        message(STATUS "Using ZeroMQ ${ZMQ_VERSION}")
+    else()
+        # Error; with REQUIRED, pkg_search_module() will throw an error by it's own
+    endif()
+    list(APPEND LIB_MODULES ${ZMQ_LIBRARIES})
+    list(APPEND LIB_TARGET_INCLUDE_DIRECTORIES ${ZMQ_INCLUDE_DIRS})
+    list(APPEND LIB_TARGET_LIBRARY_DIRECTORIES ${ZMQ_LIBRARY_DIRS})
+    list(APPEND LIB_TARGET_LINK_DIRECTORIES ${ZMQ_LIBRARY_DIRS})
+    list(APPEND LIB_TARGET_COMPILER_DEFINATION "")
+
+    if(NOT ZMQ_FOUND)
+        message("Please install libzmq from system root first! Use [https://zeromq.org/download/]")
+        return()
+    endif()
+endif()
@@ -0,0 +1,242 @@
+#include "address.hpp"
+#include "sha256.hpp"
+#include <algorithm>
+#include <array>
+
+namespace {
+constexpr std::string_view BASE58_ALPHABET = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+constexpr std::string_view BECH32_CHARSET = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+constexpr std::uint32_t BECH32_CONSTANT = 1;
+constexpr std::uint32_t BECH32M_CONSTANT = 0x2bc830a3;
+
+constexpr std::uint8_t OP_0 = 0x00;
+constexpr std::uint8_t OP_1 = 0x51;
+constexpr std::uint8_t OP_16 = 0x60;
+constexpr std::uint8_t OP_DUP = 0x76;
+constexpr std::uint8_t OP_EQUAL = 0x87;
+constexpr std::uint8_t OP_EQUALVERIFY = 0x88;
+constexpr std::uint8_t OP_HASH160 = 0xa9;
+constexpr std::uint8_t OP_CHECKSIG = 0xac;
+
+/**
+ * @struct NetworkParams
+ * @brief The address prefixes of one network.
+ */
+struct NetworkParams {
+    std::uint8_t pubkeyHashVersion;
+    std::uint8_t scriptHashVersion;
+    std::string_view hrp;
+};
+
+NetworkParams paramsOf(AddressNetwork network) {
+    switch (network) {
+    case AddressNetwork::Main: return {0x00, 0x05, "bc"};
+    case AddressNetwork::Test: return {0x6f, 0xc4, "tb"};
+    default: return {0x6f, 0xc4, "bcrt"};
+    }
+}
+
+std::uint32_t bech32Polymod(std::span<const std::uint8_t> values, std::uint32_t checksum = 1) {
+    constexpr std::uint32_t GENERATOR[5] = {0x3b6a57b2, 0x26508e6d, 0x1ea119fa, 0x3d4233dd, 0x2a1462b3};
+    for (const std::uint8_t value : values) {
+        const std::uint32_t top = checksum >> 25;
+        checksum = (checksum & 0x1ffffff) << 5 ^ value;
+        for (int i = 0; i < 5; ++i) {
+            if ((top >> i) & 1) checksum ^= GENERATOR[i];
+        }
+    }
+    return checksum;
+}
+
+/**
+ * @brief Returns the human-readable part as the checksum covers it.
+ */
+std::vector<std::uint8_t> expandHrp(std::string_view hrp) {
+    std::vector<std::uint8_t> expanded;
+    expanded.reserve(hrp.size() * 2 + 1);
+    for (const char c : hrp) expanded.push_back(static_cast<std::uint8_t>(c) >> 5);
+    expanded.push_back(0);
+    for (const char c : hrp) expanded.push_back(static_cast<std::uint8_t>(c) & 31);
+    return expanded;
+}
+
+/**
+ * @brief Regroups bits, e.g. bytes into five-bit groups and back.
+ * @return `false` if `pad` is off and the input leaves more than `from - 1` bits or non-zero padding.
+ */
+template<int From, int To>
+bool convertBits(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out, bool pad) {
+    std::uint32_t accumulator = 0;
+    int bits = 0;
+    for (const std::uint8_t value : in) {
+        accumulator = accumulator << From | value;
+        bits += From;
+        while (bits >= To) {
+            bits -= To;
+            out.push_back(static_cast<std::uint8_t>((accumulator >> bits) & ((1u << To) - 1)));
+        }
+    }
+    if (pad) {
+        if (bits > 0) out.push_back(static_cast<std::uint8_t>((accumulator << (To - bits)) & ((1u << To) - 1)));
+        return true;
+    }
+    return bits < From && ((accumulator << (To - bits)) & ((1u << To) - 1)) == 0;
+}
+
+std::string encodeSegwit(std::string_view hrp, int version, std::span<const std::uint8_t> program) {
+    std::vector<std::uint8_t> data {static_cast<std::uint8_t>(version)};
+    convertBits<8, 5>(program, data, true);
+
+    std::vector<std::uint8_t> checked = expandHrp(hrp);
+    checked.insert(checked.end(), data.begin(), data.end());
+    checked.resize(checked.size() + 6);
+    const std::uint32_t checksum = bech32Polymod(checked) ^ (version == 0 ? BECH32_CONSTANT : BECH32M_CONSTANT);
+
+    std::string address(hrp);
+    address += '1';
+    for (const std::uint8_t value : data) address += BECH32_CHARSET[value];
+    for (int i = 0; i < 6; ++i) address += BECH32_CHARSET[(checksum >> (5 * (5 - i))) & 31];
+    return address;
+}
+
+bool decodeSegwit(std::string_view hrp, std::string_view address, int& version, std::vector<std::uint8_t>& program) {
+    if (address.size() > 90) return false;
+    bool lower = false, upper = false;
+    for (const char c : address) {
+        if (c < 33 || c > 126) return false;
+        lower |= c >= 'a' && c <= 'z';
+        upper |= c >= 'A' && c <= 'Z';
+    }
+    if (lower && upper) return false;
+
+    const std::size_t separator = address.rfind('1');
+    if (separator == std::string_view::npos || separator + 7 > address.size() || separator != hrp.size()) return false;
+    for (std::size_t i = 0; i < hrp.size(); ++i) {
+        if ((address[i] | 0x20) != hrp[i]) return false;
+    }
+
+    std::vector<std::uint8_t> data;
+    for (std::size_t i = separator + 1; i < address.size(); ++i) {
+        const std::size_t value = BECH32_CHARSET.find(static_cast<char>(address[i] | 0x20));
+        if (value == std::string_view::npos) return false;
+        data.push_back(static_cast<std::uint8_t>(value));
+    }
+    if (data.size() < 7) return false;
+
+    version = data[0];
+    std::vector<std::uint8_t> checked = expandHrp(hrp);
+    checked.insert(checked.end(), data.begin(), data.end());
+    if (version > 16 || bech32Polymod(checked) != (version == 0 ? BECH32_CONSTANT : BECH32M_CONSTANT)) return false;
+
+    program.clear();
+    if (!convertBits<5, 8>(std::span(data).subspan(1, data.size() - 7), program, false)) return false;
+    if (program.size() < 2 || program.size() > 40) return false;
+    return version != 0 || program.size() == 20 || program.size() == 32;
+}
+
+std::string encodeBase58(std::span<const std::uint8_t> data) {
+    const std::size_t zeros = std::find_if(data.begin(), data.end(), [](std::uint8_t byte) { return byte != 0; }) - data.begin();
+    // Base-58 digits, least significant first; log(256) / log(58) < 1.37.
+    std::vector<std::uint8_t> digits;
+    digits.reserve((data.size() - zeros) * 137 / 100 + 1);
+    for (std::size_t i = zeros; i < data.size(); ++i) {
+        std::uint32_t carry = data[i];
+        for (std::uint8_t& digit : digits) {
+            carry += std::uint32_t(digit) << 8;
+            digit = static_cast<std::uint8_t>(carry % 58);
+            carry /= 58;
+        }
+        for (; carry > 0; carry /= 58) digits.push_back(static_cast<std::uint8_t>(carry % 58));
+    }
+
+    std::string text(zeros, '1');
+    for (auto digit = digits.rbegin(); digit != digits.rend(); ++digit) text += BASE58_ALPHABET[*digit];
+    return text;
+}
+
+bool decodeBase58(std::string_view text, std::vector<std::uint8_t>& out) {
+    const std::size_t ones = std::find_if(text.begin(), text.end(), [](char c) { return c != '1'; }) - text.begin();
+    // Bytes, least significant first.
+    std::vector<std::uint8_t> bytes;
+    for (std::size_t i = ones; i < text.size(); ++i) {
+        const std::size_t value = BASE58_ALPHABET.find(text[i]);
+        if (value == std::string_view::npos) return false;
+        std::uint32_t carry = static_cast<std::uint32_t>(value);
+        for (std::uint8_t& byte : bytes) {
+            carry += std::uint32_t(byte) * 58;
+            byte = static_cast<std::uint8_t>(carry);
+            carry >>= 8;
+        }
+        for (; carry > 0; carry >>= 8) bytes.push_back(static_cast<std::uint8_t>(carry));
+    }
+
+    out.assign(ones, 0);
+    out.insert(out.end(), bytes.rbegin(), bytes.rend());
+    return true;
+}
+}
+
+std::string encodeBase58Check(std::span<const std::uint8_t> payload) {
+    std::vector<std::uint8_t> checked(payload.begin(), payload.end());
+    const std::array<std::uint8_t, 32> digest = sha256d(payload);
+    checked.insert(checked.end(), digest.begin(), digest.begin() + 4);
+    return encodeBase58(checked);
+}
+
+bool decodeBase58Check(std::string_view text, std::vector<std::uint8_t>& payload) {
+    if (!decodeBase58(text, payload) || payload.size() < 4) return false;
+    const std::size_t size = payload.size() - 4;
+    const std::array<std::uint8_t, 32> digest = sha256d(std::span(payload).first(size));
+    if (!std::equal(digest.begin(), digest.begin() + 4, payload.begin() + size)) return false;
+    payload.resize(size);
+    return true;
+}
+
+std::string encodeAddress(std::span<const std::uint8_t> script, AddressNetwork network) {
+    const NetworkParams params = paramsOf(network);
+    if (script.size() == 25 && script[0] == OP_DUP && script[1] == OP_HASH160 && script[2] == 20
+        && script[23] == OP_EQUALVERIFY && script[24] == OP_CHECKSIG) {
+        std::array<std::uint8_t, 21> payload {params.pubkeyHashVersion};
+        std::copy(script.begin() + 3, script.begin() + 23, payload.begin() + 1);
+        return encodeBase58Check(payload);
+    }
+    if (script.size() == 23 && script[0] == OP_HASH160 && script[1] == 20 && script[22] == OP_EQUAL) {
+        std::array<std::uint8_t, 21> payload {params.scriptHashVersion};
+        std::copy(script.begin() + 2, script.begin() + 22, payload.begin() + 1);
+        return encodeBase58Check(payload);
+    }
+    if (script.size() >= 4 && script.size() <= 42 && script[1] == script.size() - 2
+        && (script[0] == OP_0 || (script[0] >= OP_1 && script[0] <= OP_16))) {
+        const int version = script[0] == OP_0 ? 0 : script[0] - OP_1 + 1;
+        if (version == 0 && script[1] != 20 && script[1] != 32) return {};
+        return encodeSegwit(params.hrp, version, script.subspan(2));
+    }
+    return {};
+}
+
+bool decodeAddress(std::string_view address, AddressNetwork network, std::vector<std::uint8_t>& scriptPubKey) {
+    const NetworkParams params = paramsOf(network);
+    int version = 0;
+    std::vector<std::uint8_t> program;
+    if (decodeSegwit(params.hrp, address, version, program)) {
+        scriptPubKey.assign({version == 0 ? OP_0 : static_cast<std::uint8_t>(OP_1 + version - 1), static_cast<std::uint8_t>(program.size())});
+        scriptPubKey.insert(scriptPubKey.end(), program.begin(), program.end());
+        return true;
+    }
+
+    std::vector<std::uint8_t> payload;
+    if (!decodeBase58Check(address, payload) || payload.size() != 21) return false;
+    if (payload[0] == params.pubkeyHashVersion) {
+        scriptPubKey.assign({OP_DUP, OP_HASH160, 20});
+        scriptPubKey.insert(scriptPubKey.end(), payload.begin() + 1, payload.end());
+        scriptPubKey.insert(scriptPubKey.end(), {OP_EQUALVERIFY, OP_CHECKSIG});
+        return true;
+    }
+    if (payload[0] == params.scriptHashVersion) {
+        scriptPubKey.assign({OP_HASH160, 20});
+        scriptPubKey.insert(scriptPubKey.end(), payload.begin() + 1, payload.end());
+        scriptPubKey.push_back(OP_EQUAL);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,51 @@
+#ifndef ADDRESS_HPP
+#define ADDRESS_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+
+/**
+ * @enum AddressNetwork
+ * @brief The chain an address is encoded for; it sets the base58 versions and the bech32 prefix.
+ */
+enum class AddressNetwork : std::uint8_t {
+    Main,       ///< `1…`, `3…` and `bc1…`.
+    Test,       ///< testnet, testnet4 and signet: `m…`/`n…`, `2…` and `tb1…`.
+    Regtest     ///< Like Test, but `bcrt1…`.
+};
+
+/**
+ * @name Address encoding
+ * @brief Converts between output scripts and the addresses `deriveaddresses` and `validateaddress` use.
+ * @{
+ */
+
+/**
+ * @brief Encodes a payload followed by the first four bytes of its double SHA-256 in base58.
+ */
+std::string encodeBase58Check(std::span<const std::uint8_t> payload);
+
+/**
+ * @brief Decodes base58 text and checks and strips its four-byte checksum.
+ * @return `false` if the text is not base58 or the checksum does not match.
+ */
+bool decodeBase58Check(std::string_view text, std::vector<std::uint8_t>& payload);
+
+/**
+ * @brief Returns the address of an output script.
+ * @return The P2PKH, P2SH or segwit (bech32 for version 0, bech32m above) address; empty for
+ *         scripts without an address form, such as bare multisig.
+ */
+std::string encodeAddress(std::span<const std::uint8_t> scriptPubKey, AddressNetwork network);
+
+/**
+ * @brief Parses an address into the output script it pays to, as `validateaddress` does without a round trip.
+ * @return `false` if the address is malformed or belongs to another network.
+ */
+bool decodeAddress(std::string_view address, AddressNetwork network, std::vector<std::uint8_t>& scriptPubKey);
+/** @} */
+
+#endif // ADDRESS_HPP
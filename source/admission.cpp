@@ -0,0 +1,170 @@
+#include "admission.hpp"
+#include "network.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace {
+constexpr std::uint64_t STRIDE = 1 << 20;      ///< Virtual time a lane of weight 1 advances per admission.
+constexpr std::size_t INTERACTIVE = static_cast<std::size_t>(RequestPriority::Interactive);
+
+thread_local std::optional<RequestPriority> threadPriority;    ///< Innermost PriorityScope of the thread.
+}
+
+std::string_view requestPriorityName(RequestPriority priority) {
+    switch (priority) {
+    case RequestPriority::Interactive: return "interactive";
+    case RequestPriority::Normal: break;
+    case RequestPriority::Bulk: return "bulk";
+    }
+    return "normal";
+}
+
+RequestPriority defaultPriority(std::string_view method, bool heavy) {
+    if (heavy) return RequestPriority::Bulk;
+    if (method == "sendrawtransaction" || method == "testmempoolaccept" || method == "getmempoolentry") {
+        return RequestPriority::Interactive;
+    }
+    return RequestPriority::Normal;
+}
+
+bool isHeavyCall(std::string_view method, const Json::Value& params) {
+    if (isHeavyMethod(method)) return true;
+    if (method != "getblock" || !params.isArray() || params.size() < 2) return false;
+    const Json::Value& verbosity = params[Json::ArrayIndex(1)];
+    return verbosity.isIntegral() && !verbosity.isBool() && verbosity.asInt() >= 2;
+}
+
+PriorityScope::PriorityScope(RequestPriority priority)
+    : previous(threadPriority) {
+    threadPriority = priority;
+}
+
+PriorityScope::~PriorityScope() {
+    threadPriority = previous;
+}
+
+std::optional<RequestPriority> PriorityScope::current() {
+    return threadPriority;
+}
+
+AdmissionControl::Ticket::Ticket(Ticket&& other) noexcept
+    : owner(std::exchange(other.owner, nullptr)), lane(other.lane), heavy(other.heavy), wait(other.wait) {}
+
+AdmissionControl::Ticket& AdmissionControl::Ticket::operator=(Ticket&& other) noexcept {
+    if (this != &other) {
+        release();
+        owner = std::exchange(other.owner, nullptr);
+        lane = other.lane;
+        heavy = other.heavy;
+        wait = other.wait;
+    }
+    return *this;
+}
+
+void AdmissionControl::Ticket::release() {
+    if (owner) std::exchange(owner, nullptr)->release(lane, heavy);
+}
+
+AdmissionControl::AdmissionControl(const AdmissionSettings& settings)
+    : admissionSettings(settings) {
+    admissionSettings.maxInFlight = std::max<std::uint32_t>(admissionSettings.maxInFlight, 1);
+    admissionSettings.maxHeavyInFlight = std::clamp<std::uint32_t>(admissionSettings.maxHeavyInFlight, 1, admissionSettings.maxInFlight);
+    admissionSettings.interactiveReserve = std::min(admissionSettings.interactiveReserve, admissionSettings.maxInFlight - 1);
+    for (std::uint32_t& weight : admissionSettings.weights) weight = std::max<std::uint32_t>(weight, 1);
+}
+
+bool AdmissionControl::fits(std::size_t lane, bool heavy) const {
+    if (inFlight >= admissionSettings.maxInFlight) return false;
+    if (lane != INTERACTIVE && sharedInFlight >= admissionSettings.maxInFlight - admissionSettings.interactiveReserve) return false;
+    return !heavy || heavyInFlight < admissionSettings.maxHeavyInFlight;
+}
+
+void AdmissionControl::grant(std::size_t lane, bool heavy) {
+    ++inFlight;
+    if (lane != INTERACTIVE) ++sharedInFlight;
+    if (heavy) ++heavyInFlight;
+    ++admitted[lane];
+    virtualTime = pass[lane];
+    pass[lane] += STRIDE / admissionSettings.weights[lane];
+}
+
+void AdmissionControl::dispatch() {
+    for (;;) {
+        std::size_t best = REQUEST_PRIORITIES;
+        std::deque<Waiter*>::iterator chosen;
+        for (std::size_t lane = 0; lane < REQUEST_PRIORITIES; ++lane) {
+            if (best != REQUEST_PRIORITIES && pass[lane] >= pass[best]) continue;
+            auto& queue = queues[lane];
+            const auto next = std::find_if(queue.begin(), queue.end(), [&](const Waiter* waiter) { return fits(lane, waiter->heavy); });
+            if (next == queue.end()) continue;
+            best = lane;
+            chosen = next;
+        }
+        if (best == REQUEST_PRIORITIES) return;
+
+        Waiter* waiter = *chosen;
+        queues[best].erase(chosen);
+        grant(best, waiter->heavy);
+        waiter->granted = true;
+        waiter->wake.notify_one();
+    }
+}
+
+AdmissionControl::Ticket AdmissionControl::admit(RequestPriority priority, bool heavy) {
+    const auto started = std::chrono::steady_clock::now();
+    const std::size_t lane = static_cast<std::size_t>(priority);
+    Ticket ticket;
+    ticket.lane = lane;
+    ticket.heavy = heavy;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    const bool anyWaiting = std::any_of(queues.begin(), queues.end(), [](const auto& queue) { return !queue.empty(); });
+    if (!anyWaiting && fits(lane, heavy)) {
+        pass[lane] = std::max(pass[lane], virtualTime);
+        grant(lane, heavy);
+        ticket.owner = this;
+        return ticket;
+    }
+
+    // An idle lane rejoins at the current virtual time, so it cannot hoard credit while idle.
+    if (queues[lane].empty()) pass[lane] = std::max(pass[lane], virtualTime);
+    Waiter waiter;
+    waiter.heavy = heavy;
+    queues[lane].push_back(&waiter);
+    dispatch();
+
+    const std::optional<DeadlineScope::Clock::time_point> deadline = DeadlineScope::current();
+    while (!waiter.granted) {
+        if (!deadline) {
+            waiter.wake.wait(lock);
+        } else if (waiter.wake.wait_until(lock, *deadline) == std::cv_status::timeout && !waiter.granted) {
+            std::erase(queues[lane], &waiter);
+            ++expired[lane];
+            return ticket;
+        }
+    }
+    ticket.owner = this;
+    ticket.wait = std::chrono::steady_clock::now() - started;
+    return ticket;
+}
+
+void AdmissionControl::release(std::size_t lane, bool heavy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    --inFlight;
+    if (lane != INTERACTIVE) --sharedInFlight;
+    if (heavy) --heavyInFlight;
+    dispatch();
+}
+
+AdmissionStats AdmissionControl::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    AdmissionStats current;
+    current.inFlight = inFlight;
+    current.heavyInFlight = heavyInFlight;
+    for (std::size_t lane = 0; lane < REQUEST_PRIORITIES; ++lane) {
+        current.queued[lane] = static_cast<std::uint32_t>(queues[lane].size());
+    }
+    current.admitted = admitted;
+    current.expired = expired;
+    return current;
+}
@@ -0,0 +1,235 @@
+#ifndef ADMISSION_HPP
+#define ADMISSION_HPP
+
+#if __has_include("rpcmethods.hpp")
+#   include "rpcmethods.hpp"
+#else
+#   error "Bitcoin's \"rpcmethods.hpp\" was not found!"
+#endif
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+/**
+ * @enum RequestPriority
+ * @brief The lane a request waits in when the node is busy.
+ */
+enum class RequestPriority : std::uint8_t {
+    Interactive,    ///< Someone is waiting: broadcasts and mempool lookups of a payment.
+    Normal,         ///< Everything not classified otherwise.
+    Bulk            ///< Throughput work: backfills, rescans, UTXO set scans.
+};
+
+inline constexpr std::size_t REQUEST_PRIORITIES = 3;   ///< Number of RequestPriority lanes.
+
+/**
+ * @brief Returns the lowercase name of a priority, as used in metric labels.
+ */
+std::string_view requestPriorityName(RequestPriority priority);
+
+/**
+ * @brief Returns the lane of a call made outside any PriorityScope.
+ *
+ * Heavy calls are `Bulk`; `sendrawtransaction`, `testmempoolaccept` and `getmempoolentry`
+ * are `Interactive`; everything else is `Normal`.
+ */
+RequestPriority defaultPriority(std::string_view method, bool heavy);
+
+/**
+ * @brief Checks whether a call keeps a node worker busy for long: an `RPC_HEAVY` method, or
+ *        `getblock` at verbosity 2 and above, which decodes every transaction of the block.
+ */
+bool isHeavyCall(std::string_view method, const Json::Value& params);
+
+/**
+ * @brief `isHeavyCall` for the typed arguments of `BitcoinClient::call`.
+ */
+template<RpcMethod Method, typename... Args>
+bool isHeavyCall(const Args&... args) {
+    if constexpr ((rpcMethodTraits(Method) & RPC_HEAVY) != 0) {
+        return true;
+    } else if constexpr (Method == RpcMethod::getblock && sizeof...(Args) >= 2) {
+        using Verbosity = std::remove_cvref_t<std::tuple_element_t<1, std::tuple<Args...>>>;
+        if constexpr (std::is_integral_v<Verbosity> && !std::is_same_v<Verbosity, bool>) {
+            return std::get<1>(std::forward_as_tuple(args...)) >= 2;
+        } else {
+            return false;
+        }
+    } else {
+        return false;
+    }
+}
+
+/**
+ * @class PriorityScope
+ * @brief Puts every request made by the current thread while the scope is alive in one lane.
+ *
+ * Like DeadlineScope, the priority is propagated rather than passed around, so a backfill
+ * job can mark all its calls as bulk without touching the code that makes them. The
+ * innermost scope wins.
+ *
+ * @code
+ * PriorityScope bulk(RequestPriority::Bulk);
+ * for (std::int64_t height = from; height < to; ++height) backfill(client, height);
+ * @endcode
+ */
+class PriorityScope {
+public:
+    explicit PriorityScope(RequestPriority priority);
+    PriorityScope(const PriorityScope&) = delete;
+    PriorityScope& operator=(const PriorityScope&) = delete;
+
+    /**
+     * @brief Restores the enclosing priority.
+     */
+    ~PriorityScope();
+
+    /**
+     * @brief Returns the priority of the current thread, if a scope set one.
+     */
+    static std::optional<RequestPriority> current();
+
+private:
+    std::optional<RequestPriority> previous;    ///< The enclosing priority, restored on destruction.
+};
+
+/**
+ * @struct AdmissionSettings
+ * @brief How many requests AdmissionControl lets through, and how it shares them out.
+ */
+struct AdmissionSettings {
+    std::uint32_t maxInFlight = 8;              ///< Requests at the node at once; keep it below the node's `-rpcworkqueue`.
+    std::uint32_t maxHeavyInFlight = 2;         ///< Heavy calls among them (see `isHeavyCall`).
+    std::uint32_t interactiveReserve = 1;       ///< Slots the other lanes may never fill, so interactive requests never wait for bulk work to finish.
+    std::array<std::uint32_t, REQUEST_PRIORITIES> weights {16, 4, 1};  ///< Share of freed slots per lane while several lanes wait.
+};
+
+/**
+ * @struct AdmissionStats
+ * @brief Counters of an AdmissionControl, indexed by RequestPriority.
+ */
+struct AdmissionStats {
+    std::uint32_t inFlight = 0;                                 ///< Requests admitted and not finished.
+    std::uint32_t heavyInFlight = 0;                            ///< Heavy calls among them.
+    std::array<std::uint32_t, REQUEST_PRIORITIES> queued {};    ///< Requests waiting now.
+    std::array<std::uint64_t, REQUEST_PRIORITIES> admitted {};  ///< Requests let through so far.
+    std::array<std::uint64_t, REQUEST_PRIORITIES> expired {};   ///< Requests whose deadline passed while they waited.
+};
+
+/**
+ * @class AdmissionControl
+ * @brief Limits the requests a node is asked to serve at once and orders the ones that wait.
+ *
+ * A node runs RPCs on a few worker threads fed from a bounded work queue. A backfill that
+ * fills the queue with `getblock` calls makes a broadcast wait behind all of them, or get
+ * rejected when the queue is full. Requests therefore pass this gate before they are sent.
+ *
+ * Admission is bounded three ways: by `maxInFlight` overall, by `maxHeavyInFlight` for heavy
+ * calls, and by letting the other lanes hold at most `maxInFlight - interactiveReserve` slots.
+ * When a slot frees, waiting lanes share it by weighted fair queuing (stride scheduling):
+ * each lane advances its virtual time by the inverse of its weight per admission, and the
+ * waiting lane with the earliest virtual time goes next. With the default weights, 16
+ * interactive requests are admitted for every bulk one while both wait. A lane that was
+ * idle rejoins at the current virtual time rather than with saved-up credit. Within a lane
+ * requests are admitted in order, except that a heavy call held back by its cap lets the
+ * light calls behind it pass.
+ *
+ * A waiting request gives up when the thread's DeadlineScope expires. One controller may be
+ * shared by every client of a node; wallet handles share their node client's.
+ */
+class AdmissionControl {
+public:
+    /**
+     * @class Ticket
+     * @brief Holds one admitted slot until it is released or destroyed.
+     */
+    class Ticket {
+    public:
+        Ticket() = default;
+        Ticket(Ticket&& other) noexcept;
+        Ticket& operator=(Ticket&& other) noexcept;
+        ~Ticket() { release(); }
+
+        /**
+         * @brief Checks whether the request was admitted.
+         */
+        explicit operator bool() const { return owner != nullptr; }
+
+        /**
+         * @brief Returns how long the request waited for admission.
+         */
+        std::chrono::nanoseconds waited() const { return wait; }
+
+        /**
+         * @brief Frees the slot; does nothing if it is already free.
+         */
+        void release();
+
+    private:
+        friend class AdmissionControl;
+
+        AdmissionControl* owner = nullptr;      ///< Null unless a slot is held.
+        std::size_t lane = 0;
+        bool heavy = false;
+        std::chrono::nanoseconds wait {0};
+    };
+
+    explicit AdmissionControl(const AdmissionSettings& settings = {});
+    AdmissionControl(const AdmissionControl&) = delete;
+    AdmissionControl& operator=(const AdmissionControl&) = delete;
+
+    /**
+     * @brief Waits until a request may be sent.
+     * @param priority The lane to wait in.
+     * @param heavy Whether the request counts against `maxHeavyInFlight`.
+     * @return An admitted ticket, or an empty one if the thread's deadline passed first.
+     */
+    Ticket admit(RequestPriority priority, bool heavy);
+
+    /**
+     * @brief Returns the current counters.
+     */
+    AdmissionStats stats() const;
+
+    /**
+     * @brief Returns the settings, after adjustment to sane bounds.
+     */
+    const AdmissionSettings& settings() const { return admissionSettings; }
+
+private:
+    /**
+     * @struct Waiter
+     * @brief A request blocked in `admit()`; lives on the waiting thread's stack.
+     */
+    struct Waiter {
+        bool heavy = false;
+        bool granted = false;
+        std::condition_variable wake;
+    };
+
+    bool fits(std::size_t lane, bool heavy) const;     ///< A slot is free for such a request; `mutex` is held.
+    void grant(std::size_t lane, bool heavy);          ///< Takes a slot and advances the lane's virtual time.
+    void dispatch();                                    ///< Hands free slots to waiters in fair order.
+    void release(std::size_t lane, bool heavy);
+
+    AdmissionSettings admissionSettings;
+    mutable std::mutex mutex;
+    std::array<std::deque<Waiter*>, REQUEST_PRIORITIES> queues;    ///< Waiters per lane, oldest first.
+    std::array<std::uint64_t, REQUEST_PRIORITIES> pass {};         ///< Virtual time of each lane's next admission.
+    std::uint64_t virtualTime = 0;                                 ///< Virtual time of the last admission.
+    std::uint32_t inFlight = 0;
+    std::uint32_t sharedInFlight = 0;                              ///< Admitted requests of the lanes other than interactive.
+    std::uint32_t heavyInFlight = 0;
+    std::array<std::uint64_t, REQUEST_PRIORITIES> admitted {};
+    std::array<std::uint64_t, REQUEST_PRIORITIES> expired {};
+};
+
+#endif // ADMISSION_HPP
@@ -0,0 +1,141 @@
+#include "asyncengine.hpp"
+#include "logger.hpp"
+#include <format>
+#include <memory>
+
+AsyncEngine::AsyncEngine(const PoolSettings& settings)
+    : engineSettings(settings) {
+    Network::globalInit();
+    multi = curl_multi_init();
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(engineSettings.maxConnections));
+    // Over HTTP/2, concurrent requests to one host share a connection as separate streams.
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    worker = std::thread(&AsyncEngine::run, this);
+}
+
+AsyncEngine::~AsyncEngine() {
+    stopping.store(true);
+    curl_multi_wakeup(multi);
+    if (worker.joinable()) worker.join();
+    curl_multi_cleanup(multi);
+}
+
+size_t AsyncEngine::WriteCallback(void* contents, size_t size, size_t nmemb, std::string* outBuffer) {
+    size_t totalSize = size * nmemb;
+    outBuffer->append(static_cast<char*>(contents), totalSize);
+    return totalSize;
+}
+
+void AsyncEngine::submit(HttpPostRequest request, Completion done) {
+    auto transfer = std::make_unique<Transfer>();
+    transfer->request = std::move(request);
+    transfer->done = std::move(done);
+
+    inFlight.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard lock(queueMutex);
+        queued.push_back(transfer.release());
+    }
+    curl_multi_wakeup(multi);
+}
+
+void AsyncEngine::startQueued() {
+    std::vector<Transfer*> batch;
+    {
+        std::lock_guard lock(queueMutex);
+        batch.swap(queued);
+    }
+
+    for (Transfer* transfer : batch) {
+        CURL* curl = curl_easy_init();
+        if (!curl) {
+            Logger::error("Failed to initialize CURL");
+            finish(transfer, false);
+            continue;
+        }
+        transfer->easy = curl;
+        const HttpPostRequest& request = transfer->request;
+
+        curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+        if (!request.user.empty() || !request.password.empty()) {
+            curl_easy_setopt(curl, CURLOPT_USERPWD, (request.user + ":" + request.password).c_str());
+        }
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.body.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(request.body.size()));
+        for (const auto& [key, value] : request.headers) {
+            transfer->headers = curl_slist_append(transfer->headers, (key + ": " + value).c_str());
+        }
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->response);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, Network::PresizeCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer->response);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        Network::applyTransport(curl, request.transport);
+        if (request.transport.httpVersion == HttpVersion::Http2Tls || request.transport.httpVersion == HttpVersion::Http2PriorKnowledge) {
+            // Wait for a connection that may multiplex instead of opening one per request.
+            curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+        }
+        // Never let the connect phase outlast the whole transfer.
+        const auto connectTimeout = request.timeout.count() > 0 && (request.connectTimeout.count() == 0 || request.connectTimeout > request.timeout)
+                                        ? request.timeout : request.connectTimeout;
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(connectTimeout.count()));
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(request.timeout.count()));
+        curl_easy_setopt(curl, CURLOPT_MAXAGE_CONN, static_cast<long>(engineSettings.idleTimeout.count()));
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+
+        if (curl_multi_add_handle(multi, curl) != CURLM_OK) {
+            Logger::error("Failed to queue asynchronous request");
+            finish(transfer, false);
+            continue;
+        }
+        active.insert(transfer);
+    }
+}
+
+void AsyncEngine::finish(Transfer* transfer, bool success) {
+    std::unique_ptr<Transfer> owned(transfer);
+    active.erase(transfer);
+    if (owned->easy) {
+        curl_multi_remove_handle(multi, owned->easy);
+        curl_easy_cleanup(owned->easy);
+    }
+    curl_slist_free_all(owned->headers);
+
+    // Count the request as done before the callback, so a caller woken by it sees a consistent value.
+    inFlight.fetch_sub(1, std::memory_order_relaxed);
+    if (owned->done) owned->done(success, success ? std::move(owned->response) : std::string());
+}
+
+void AsyncEngine::run() {
+    int running = 0;
+    while (!stopping.load()) {
+        startQueued();
+
+        curl_multi_perform(multi, &running);
+
+        int remaining = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &remaining)) {
+            if (message->msg != CURLMSG_DONE) continue;
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &transfer);
+            const CURLcode result = message->data.result;
+            if (result != CURLE_OK) {
+                Logger::formattedError("CURL error: {}", curl_easy_strerror(result));
+            }
+            finish(transfer, result == CURLE_OK);
+        }
+
+        curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+    }
+
+    // Fail whatever is still queued or running, so no caller waits forever.
+    std::vector<Transfer*> abandoned;
+    {
+        std::lock_guard lock(queueMutex);
+        abandoned.swap(queued);
+    }
+    abandoned.insert(abandoned.end(), active.begin(), active.end());
+    for (Transfer* transfer : abandoned) finish(transfer, false);
+}
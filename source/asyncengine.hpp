@@ -0,0 +1,111 @@
+#ifndef ASYNCENGINE_HPP
+#define ASYNCENGINE_HPP
+
+#if __has_include("network.hpp")
+#   include "network.hpp"
+#else
+#   error "Bitcoin's \"network.hpp\" was not found!"
+#endif
+
+#include <string>
+#include <map>
+#include <vector>
+#include <unordered_set>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <curl/curl.h>
+
+/**
+ * @struct HttpPostRequest
+ * @brief Everything needed to perform one HTTP POST on the asynchronous engine.
+ */
+struct HttpPostRequest {
+    std::string url;                                ///< Target URL.
+    std::string body;                               ///< Request body.
+    std::string user;                               ///< Optional username for HTTP authentication.
+    std::string password;                           ///< Optional password for HTTP authentication.
+    std::map<std::string, std::string> headers;     ///< Extra HTTP headers.
+    std::chrono::milliseconds connectTimeout {0};   ///< Limit for establishing a connection; 0 uses curl's default.
+    std::chrono::milliseconds timeout {0};          ///< Limit for the whole transfer; 0 means none.
+    TransportSettings transport;                    ///< Compression, HTTP version and Unix socket.
+};
+
+/**
+ * @class AsyncEngine
+ * @brief Multiplexes many HTTP requests over a single I/O thread using `curl_multi`.
+ *
+ * Requests submitted from any thread are handed to a dedicated I/O thread that drives all
+ * transfers with one `curl_multi` handle. Connections are cached by the multi handle and
+ * reused between transfers; transfers beyond the per-host connection limit are queued by
+ * curl until a connection becomes free. One engine can serve any number of endpoints and
+ * can be shared by several `BitcoinClient` instances.
+ *
+ * Completion callbacks run on the I/O thread, so they should be short; any heavy work
+ * blocks every other transfer of the engine.
+ */
+class AsyncEngine {
+public:
+    /**
+     * @brief Called once per request with the outcome of the transfer.
+     * @param success `true` if the HTTP exchange completed; `false` on transport errors.
+     * @param response The response body (empty on failure).
+     */
+    using Completion = std::function<void(bool success, std::string&& response)>;
+
+    /**
+     * @brief Starts the I/O thread.
+     * @param settings `maxConnections` bounds the connections per host; `idleTimeout` closes unused ones.
+     */
+    explicit AsyncEngine(const PoolSettings& settings = {});
+    AsyncEngine(const AsyncEngine&) = delete;
+    AsyncEngine& operator=(const AsyncEngine&) = delete;
+
+    /**
+     * @brief Stops the I/O thread. Transfers still pending fail with `success == false`.
+     */
+    ~AsyncEngine();
+
+    /**
+     * @brief Queues an HTTP POST request.
+     *
+     * Thread-safe and non-blocking: the request is started on the I/O thread.
+     *
+     * @param request The request to perform.
+     * @param done The completion callback, invoked on the I/O thread.
+     */
+    void submit(HttpPostRequest request, Completion done);
+
+    /**
+     * @brief Returns the number of submitted requests that have not completed yet.
+     */
+    std::size_t pending() const { return inFlight.load(std::memory_order_relaxed); }
+
+private:
+    struct Transfer {
+        HttpPostRequest request;
+        Completion done;
+        std::string response;
+        CURL* easy = nullptr;
+        curl_slist* headers = nullptr;
+    };
+
+    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* outBuffer);
+
+    void run();
+    void startQueued();
+    void finish(Transfer* transfer, bool success);
+
+    PoolSettings engineSettings;
+    CURLM* multi = nullptr;
+    std::mutex queueMutex;
+    std::vector<Transfer*> queued;                  ///< Submitted, not yet handed to curl.
+    std::unordered_set<Transfer*> active;           ///< Owned by the I/O thread only.
+    std::atomic<bool> stopping {false};
+    std::atomic<std::size_t> inFlight {0};
+    std::thread worker;
+};
+
+#endif // ASYNCENGINE_HPP
@@ -1,708 +1,1264 @@
 #include "bitcoinclient.hpp"
+#include "rpcmethods.hpp"
+#include <cctype>
+#include <latch>
+#include <thread>
+
+BitcoinClient::BitcoinClient(const std::string& user, const std::string& password, const std::string& url,
+                             std::size_t poolSize, std::chrono::seconds idleTimeout)
+    : rpcUser(user), rpcPassword(password), rpcUrl(url), network(PoolSettings{poolSize, idleTimeout}),
+    poolSettings{poolSize, idleTimeout} {}
+
+BitcoinClient::BitcoinClient(BitcoinClient& node, const std::string& url)
+    : rpcUser(node.rpcUser), rpcPassword(node.rpcPassword), rpcUrl(url), network(node.network.sharedPool()),
+    poolSettings(node.poolSettings), cache(node.cache), archive(node.archive), coalescer(node.coalescer), retryPolicy(node.retryPolicy), breaker(node.breaker),
+    admission(node.admission), nodeClient(&node), callMetrics(node.callMetrics) {
+    network.setTimeouts(node.network.timeouts());
+    network.setTransportSettings(node.network.transportSettings());
+    network.setMetrics(callMetrics);
+}
+
+namespace {
+constexpr int RPC_CLIENT_PARSE_ERROR = -32700;      ///< The response body is not valid JSON.
+constexpr int RPC_CLIENT_TRANSPORT_ERROR = -32603;  ///< The HTTP exchange failed or returned no answer.
+
+constexpr std::size_t MAX_RETAINED_REQUEST_BUFFER = 1 << 20;     ///< Larger request buffers are freed rather than kept for reuse.
+constexpr std::size_t MAX_RETAINED_RESPONSE_BUFFER = 16 << 20;   ///< Larger response buffers are freed rather than kept for reuse.
+
+const std::map<std::string, std::string> JSON_RPC_HEADERS = {{"Content-Type", "application/json"}};
+
+/**
+ * @brief Empties a per-thread buffer for its next use, keeping its capacity unless it grew past `limit`.
+ *
+ * One huge exchange (a large batch, a raw block) should not pin its memory to the thread.
+ */
+std::string& recycle(std::string& buffer, std::size_t limit) {
+    if (buffer.capacity() > limit) {
+        std::string().swap(buffer);
+    }
+    buffer.clear();
+    return buffer;
+}
+
+/**
+ * @brief Maps an empty optional string argument to an omitted (null) parameter.
+ */
+std::optional<std::string_view> unlessEmpty(const std::string& value) {
+    if (value.empty()) return std::nullopt;
+    return value;
+}
+
+/**
+ * @brief Maps a non-positive optional height argument to an omitted (null) parameter.
+ */
+std::optional<int> unlessZero(int value) {
+    if (value <= 0) return std::nullopt;
+    return value;
+}
+
+/**
+ * @brief Decodes a hex string result into a DecodedBlock or DecodedTransaction without copying the text.
+ */
+template<typename Decoded>
+std::optional<Decoded> decodeHexResult(const Json::Value& result, std::string_view method) {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    if (!result.isString() || !result.getString(&begin, &end)) {
+        return std::nullopt;
+    }
+    Decoded decoded;
+    if (!decoded.decode(std::string_view(begin, static_cast<std::size_t>(end - begin)))) {
+        Logger::formattedError("Failed to decode raw data returned by {}", method);
+        return std::nullopt;
+    }
+    return decoded;
+}
+}
 
-BitcoinClient::BitcoinClient(const std::string& user, const std::string& password, const std::string& url)
-    : rpcUser(user), rpcPassword(password), rpcUrl(url) {}
+std::uint64_t BitcoinClient::reserveRequestIds(std::size_t count) {
+    thread_local std::uint64_t nextId = 1;
+    return std::exchange(nextId, nextId + count);
+}
 
-std::string BitcoinClient::buildRpcRequest(const std::string& method, const Json::Value& params) {
-    Json::Value request;
-    request["jsonrpc"] = "1.0";
-    request["id"] = "Genyleap-Bitcoin-RPC";
-    request["method"] = method;
-    request["params"] = params;
+std::string& BitcoinClient::requestBuffer() {
+    thread_local std::string buffer;
+    return recycle(buffer, MAX_RETAINED_REQUEST_BUFFER);
+}
 
-    Json::StreamWriterBuilder writer;
-    return Json::writeString(writer, request);
+std::string& BitcoinClient::responseBuffer() {
+    thread_local std::string buffer;
+    return recycle(buffer, MAX_RETAINED_RESPONSE_BUFFER);
 }
 
-Json::Value BitcoinClient::parseRpcResponse(const std::string& response) {
-    Json::Value jsonResponse;
-    Json::CharReaderBuilder reader;
+std::string BitcoinClient::buildRpcRequest(std::string_view method, const Json::Value& params) {
+    std::string payload;
+    JsonWriter(payload).rpcRequestWithParams(method, reserveRequestIds(1), params);
+    return payload;
+}
+
+bool BitcoinClient::parseJson(const std::string& response, Json::Value& document) {
+    // Parses straight from the buffer; a CharReader is not thread-safe, so every thread keeps its own.
+    thread_local const std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
     std::string errors;
-    std::istringstream responseStream(response);
 
-    if (!Json::parseFromStream(reader, responseStream, &jsonResponse, &errors)) {
+    if (!reader->parse(response.data(), response.data() + response.size(), &document, &errors)) {
         Logger::formattedError("Failed to parse JSON response: {}", errors);
+        return false;
+    }
+    return true;
+}
+
+Json::Value BitcoinClient::parseRpcResponse(const std::string& response, CallFailure* failure) {
+    Json::Value jsonResponse;
+    if (!parseJson(response, jsonResponse)) {
+        if (failure) *failure = CallFailure::Parse;
         return Json::Value();
     }
 
     if (!jsonResponse["error"].isNull()) {
         Logger::formattedError("RPC error: {}", Json::writeString(Json::StreamWriterBuilder(), jsonResponse["error"]));
+        if (failure) *failure = CallFailure::Rpc;
         return Json::Value();
     }
 
-    return jsonResponse["result"];
+    return std::move(jsonResponse["result"]);
+}
+
+Json::Value BitcoinClient::makeRpcError(int code, const std::string& message) {
+    Json::Value error;
+    error["code"] = code;
+    error["message"] = message;
+    return error;
 }
 
 Json::Value BitcoinClient::sendRequest(const std::string& method, const Json::Value& params) {
-    std::string rpcRequest = buildRpcRequest(method, params);
-    Logger::formattedInfo("Sending RPC request: {}", rpcRequest);
+    ResponseCache* activeCache = cache.get();
+    if (!activeCache || !ResponseCache::isCacheable(method, params)) {
+        return coalesceRequest(method, params, std::string());
+    }
 
-    std::map<std::string, std::string> headers = {{"Content-Type", "application/json"}};
-    std::string response;
+    refreshCacheTip(*activeCache);
+    const std::string key = ResponseCache::makeKey(method, params);
+    if (auto cached = activeCache->lookup(key)) {
+        Logger::formattedDebug("Served RPC request from cache: {}", method);
+        return *std::move(cached);
+    }
+
+    const std::uint64_t generation = activeCache->generation();
+    Json::Value result = coalesceRequest(method, params, key);
+    activeCache->store(key, method, result, generation);
+    return result;
+}
+
+Json::Value BitcoinClient::coalesceRequest(const std::string& method, const Json::Value& params, const std::string& key) {
+    RequestCoalescer* activeCoalescer = coalescer.get();
+    if (!activeCoalescer || !RequestCoalescer::isCoalescable(method)) return fetchRequest(method, params);
+    return activeCoalescer->run(key.empty() ? ResponseCache::makeKey(method, params) : key,
+                                [&] { return fetchRequest(method, params); });
+}
 
-    if (!network.sendPostRequest(rpcUrl, rpcRequest, response, rpcUser, rpcPassword, headers, true)) {
-        Logger::error("Failed to send RPC request");
+Json::Value BitcoinClient::fetchRequest(const std::string& method, const Json::Value& params) {
+    ResponseArchive* activeArchive = archive.get();
+    if (!activeArchive || !ResponseArchive::isArchivable(method, params)) {
+        Json::Value result = executeRequest(method, params);
+        if (activeArchive && method == "getblockcount" && result.isIntegral()) activeArchive->noteTip(result.asInt64());
+        return result;
+    }
+    if (auto archived = activeArchive->lookup(method, params)) {
+        Logger::formattedDebug("Served RPC request from archive: {}", method);
+        return *std::move(archived);
+    }
+
+    Json::Value result = executeRequest(method, params);
+    activeArchive->store(method, params, result);
+    return result;
+}
+
+void BitcoinClient::refreshCacheTip(ResponseCache& responseCache) {
+    if (!responseCache.beginTipCheck()) return;
+
+    const ChainTip known = responseCache.tip();
+    Json::Value best = executeRequest("getbestblockhash", Json::Value());
+    if (best.isString() && best.asString() != known.hash) {
+        Json::Value header = executeRequest("getblockheader", buildParams(best.asString()));
+        if (header.isObject() && header["height"].isIntegral()) {
+            const std::int64_t forkHeight = known.height < 0 ? 0 : findForkHeight(known, responseCache.settings().maxReorgDepth);
+            responseCache.advanceTip(ChainTip{best.asString(), header["height"].asInt64()}, forkHeight);
+        }
+    }
+    responseCache.finishTipCheck();
+}
+
+std::int64_t BitcoinClient::findForkHeight(const ChainTip& oldTip, std::int64_t maxDepth) {
+    // Blocks that left the active chain report -1 confirmations; walk back to the first one that did not.
+    std::string cursor = oldTip.hash;
+    for (std::int64_t depth = 0; depth <= maxDepth; ++depth) {
+        Json::Value header = executeRequest("getblockheader", buildParams(cursor));
+        if (!header.isObject()) break;
+        if (header["confirmations"].asInt64() > 0) return header["height"].asInt64();
+        if (!header["previousblockhash"].isString()) break;
+        cursor = header["previousblockhash"].asString();
+    }
+    Logger::warning("Could not locate the fork point of a chain reorganization; dropping cached chain data");
+    return 0;
+}
+
+AdmissionControl::Ticket BitcoinClient::admitRequest(std::string_view method, bool heavy) {
+    const RequestPriority priority = PriorityScope::current().value_or(defaultPriority(method, heavy));
+    AdmissionControl::Ticket ticket = admission->admit(priority, heavy);
+    if (!ticket) {
+        Logger::formattedWarning("RPC request {} expired while waiting for admission", method);
+    } else if (callMetrics) {
+        callMetrics->recordQueueWait(priority, ticket.waited());
+    }
+    return ticket;
+}
+
+TransferError BitcoinClient::post(std::string_view method, bool idempotent, bool heavy, const std::string& payload,
+                                  std::string& response) {
+    for (std::uint32_t attempt = 1;; ++attempt) {
+        // Admission comes first: a half-open breaker lets one probe through, which must then be sent.
+        AdmissionControl::Ticket ticket;
+        if (admission && !(ticket = admitRequest(method, heavy))) return TransferError::TimedOut;
+        if (breaker && !breaker->allow()) return TransferError::CircuitOpen;
+
+        response.clear();
+        TransferError error = TransferError::None;
+        if (!network.sendPostRequest(rpcUrl, payload, response, rpcUser, rpcPassword, JSON_RPC_HEADERS)) {
+            error = Network::lastError();
+            if (error == TransferError::None) error = TransferError::Failed;
+        }
+        if (breaker) {
+            if (error == TransferError::None) breaker->recordSuccess();
+            else breaker->recordFailure();
+        }
+        if (error == TransferError::None) return error;
+
+        // A request that may have reached the node is only repeated if repeating it is harmless.
+        const bool retryable = idempotent || error == TransferError::ConnectFailed;
+        if (!retryable || attempt >= retryPolicy.maxAttempts) return error;
+        if (breaker && breaker->state() == CircuitBreaker::State::Open) return error;
+
+        const std::chrono::milliseconds delay = backoffDelay(retryPolicy, attempt - 1);
+        const auto deadline = DeadlineScope::current();
+        if (deadline && DeadlineScope::Clock::now() + delay >= *deadline) return error;
+        Logger::formattedWarning("RPC request {} failed ({}); retrying in {} ms", method, describeTransferError(error), delay.count());
+        ticket.release();
+        std::this_thread::sleep_for(delay);
+    }
+}
+
+HttpPostRequest BitcoinClient::makeAsyncRequest(std::string body) const {
+    const RequestTimeouts& timeouts = network.timeouts();
+    // The deadline is fixed when the call is made, not when the engine gets to it.
+    const std::chrono::milliseconds limit = DeadlineScope::limit(timeouts.total);
+    return HttpPostRequest {rpcUrl, std::move(body), rpcUser, rpcPassword, JSON_RPC_HEADERS, timeouts.connect,
+                            limit.count() < 0 ? std::chrono::milliseconds(1) : limit, network.transportSettings()};
+}
+
+void BitcoinClient::enableCircuitBreaker(const BreakerSettings& settings) {
+    breaker = std::make_shared<CircuitBreaker>(settings);
+}
+
+void BitcoinClient::enableAdmissionControl(const AdmissionSettings& settings) {
+    admission = std::make_shared<AdmissionControl>(settings);
+}
+
+void BitcoinClient::setAdmissionControl(std::shared_ptr<AdmissionControl> sharedAdmission) {
+    admission = std::move(sharedAdmission);
+}
+
+void BitcoinClient::enableCache(const CacheSettings& settings) {
+    cache = std::make_shared<ResponseCache>(settings);
+}
+
+void BitcoinClient::setResponseCache(std::shared_ptr<ResponseCache> sharedCache) {
+    cache = std::move(sharedCache);
+}
+
+void BitcoinClient::setResponseArchive(std::shared_ptr<ResponseArchive> sharedArchive) {
+    archive = std::move(sharedArchive);
+}
+
+void BitcoinClient::enableCoalescing(const CoalesceSettings& settings) {
+    coalescer = std::make_shared<RequestCoalescer>(settings);
+}
+
+void BitcoinClient::setRequestCoalescer(std::shared_ptr<RequestCoalescer> sharedCoalescer) {
+    coalescer = std::move(sharedCoalescer);
+}
+
+std::size_t BitcoinClient::warmUp(std::size_t connections) {
+    connections = std::clamp<std::size_t>(connections, 1, network.connectionPool().settings().maxConnections);
+    std::atomic<std::size_t> succeeded {0};
+    std::latch done(static_cast<std::ptrdiff_t>(connections));
+    std::vector<std::thread> workers;
+    workers.reserve(connections);
+    for (std::size_t i = 0; i < connections; ++i) {
+        workers.emplace_back([&] {
+            if (sendCall("uptime").ok()) succeeded.fetch_add(1, std::memory_order_relaxed);
+            // Each thread keeps its handle until all calls are done, so no call reuses another's
+            // connection. When the threads exit, the handles go back to the pool still connected.
+            done.arrive_and_wait();
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    return succeeded.load(std::memory_order_relaxed);
+}
+
+void BitcoinClient::setMetrics(std::shared_ptr<Metrics> sink) {
+    network.setMetrics(sink);
+    callMetrics = std::move(sink);
+}
+
+void BitcoinClient::recordCall(std::string_view method, std::chrono::steady_clock::time_point started, CallFailure failure,
+                               std::size_t requestBytes, std::size_t responseBytes) const {
+    if (!callMetrics) return;
+    CallSample sample {std::chrono::steady_clock::now() - started, {}, requestBytes, responseBytes, failure};
+    if (failure == CallFailure::None || failure == CallFailure::Parse || failure == CallFailure::Rpc) {
+        sample.serverTime = Network::lastTransfer().serverTime;
+    }
+    callMetrics->recordCall(method, sample);
+}
+
+Json::Value BitcoinClient::executeRequest(const std::string& method, const Json::Value& params) {
+    std::string& payload = requestBuffer();
+    JsonWriter(payload).rpcRequestWithParams(method, reserveRequestIds(1), params);
+    return executePayload(method, payload, isHeavyCall(method, params));
+}
+
+Json::Value BitcoinClient::executePayload(std::string_view method, const std::string& payload, bool heavy) {
+    Logger::formattedDebug("Sending RPC request: {}", payload);
+
+    const auto started = std::chrono::steady_clock::now();
+    std::string& response = responseBuffer();
+
+    if (const TransferError error = post(method, isIdempotentMethod(method), heavy, payload, response); error != TransferError::None) {
+        Logger::formattedError("Failed to send RPC request {}: {}", method, describeTransferError(error));
+        recordCall(method, started, callFailureOf(error), payload.size(), 0);
         return Json::Value();
     }
 
     Logger::json(response);
-    return parseRpcResponse(response);
+    CallFailure failure = CallFailure::None;
+    Json::Value result = parseRpcResponse(response, &failure);
+    recordCall(method, started, failure, payload.size(), response.size());
+    return result;
+}
+
+RpcResult BitcoinClient::sendCall(const std::string& method, const Json::Value& params) {
+    std::string& rpcRequest = requestBuffer();
+    JsonWriter(rpcRequest).rpcRequestWithParams(method, reserveRequestIds(1), params);
+    Logger::formattedDebug("Sending RPC request: {}", rpcRequest);
+
+    const auto started = std::chrono::steady_clock::now();
+    std::string& response = responseBuffer();
+    const bool heavy = isHeavyCall(method, params);
+    if (const TransferError error = post(method, isIdempotentMethod(method), heavy, rpcRequest, response); error != TransferError::None) {
+        RpcResult outcome;
+        outcome.error = makeRpcError(RPC_CLIENT_TRANSPORT_ERROR, std::format("Failed to send RPC request: {}", describeTransferError(error)));
+        outcome.transportFailure = true;
+        recordCall(method, started, callFailureOf(error), rpcRequest.size(), 0);
+        return outcome;
+    }
+
+    Logger::json(response);
+    CallFailure failure = CallFailure::None;
+    RpcResult outcome = parseCallResult(response, failure);
+    recordCall(method, started, failure, rpcRequest.size(), response.size());
+    return outcome;
+}
+
+RpcResult BitcoinClient::parseCallResult(const std::string& response, CallFailure& failure) {
+    RpcResult outcome;
+    Json::Value document;
+    if (!parseJson(response, document) || !document.isObject()) {
+        outcome.error = makeRpcError(RPC_CLIENT_PARSE_ERROR, "Failed to parse JSON response");
+        outcome.transportFailure = true;
+        failure = CallFailure::Parse;
+        return outcome;
+    }
+    outcome.result = std::move(document["result"]);
+    outcome.error = std::move(document["error"]);
+    failure = outcome.ok() ? CallFailure::None : CallFailure::Rpc;
+    return outcome;
+}
+
+std::uint64_t BitcoinClient::writeBatchRequest(const RpcBatch& batch, std::string& out) {
+    const auto& calls = batch.entries();
+
+    // Reserve a contiguous id range, so a response id maps straight to its call index.
+    const std::uint64_t firstId = reserveRequestIds(calls.size());
+    JsonWriter writer(out);
+    out += '[';
+    for (std::size_t i = 0; i < calls.size(); ++i) {
+        if (i) out += ',';
+        writer.rpcRequestWithParams(calls[i].method, firstId + i, calls[i].params);
+    }
+    out += ']';
+    return firstId;
+}
+
+std::vector<RpcResult> BitcoinClient::parseBatchResponse(bool success, const std::string& response, std::size_t count, std::uint64_t firstId) {
+    std::vector<RpcResult> results(count);
+    const auto failAll = [&](int code, const std::string& message, bool transportFailure = false) {
+        for (auto& result : results) {
+            result.error = makeRpcError(code, message);
+            result.transportFailure = transportFailure;
+        }
+        return results;
+    };
+
+    if (!success) {
+        Logger::error("Failed to send RPC batch");
+        return failAll(RPC_CLIENT_TRANSPORT_ERROR, "Failed to send RPC batch", true);
+    }
+
+    Json::Value document;
+    if (!parseJson(response, document)) {
+        return failAll(RPC_CLIENT_PARSE_ERROR, "Failed to parse JSON response", true);
+    }
+
+    // A server that rejects the batch as a whole answers with a single response object.
+    if (!document.isArray()) {
+        const Json::Value& error = document.isObject() ? document["error"] : Json::Value::nullSingleton();
+        return failAll(RPC_CLIENT_TRANSPORT_ERROR, error.isObject() ? error.get("message", "").asString()
+                                                                     : "Unexpected batch response");
+    }
+
+    std::vector<bool> answered(count, false);
+    for (auto& entry : document) {
+        const Json::Value& id = entry["id"];
+        if (!id.isIntegral()) continue;
+        const std::uint64_t value = id.asUInt64();
+        if (value < firstId || value - firstId >= count) continue;
+
+        const std::size_t index = value - firstId;
+        results[index].result = std::move(entry["result"]);
+        results[index].error = std::move(entry["error"]);
+        answered[index] = true;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!answered[i]) results[i].error = makeRpcError(RPC_CLIENT_TRANSPORT_ERROR, "No response for call");
+    }
+    return results;
+}
+
+std::vector<RpcResult> BitcoinClient::sendBatch(const RpcBatch& batch) {
+    if (batch.empty()) return {};
+
+    std::string& rpcRequest = requestBuffer();
+    const std::uint64_t firstId = writeBatchRequest(batch, rpcRequest);
+    Logger::formattedDebug("Sending RPC batch of {} calls", batch.size());
+
+    std::string& response = responseBuffer();
+    const bool idempotent = std::all_of(batch.entries().begin(), batch.entries().end(),
+                                        [](const RpcBatch::Call& call) { return isIdempotentMethod(call.method); });
+    const auto started = std::chrono::steady_clock::now();
+    // A batch waits in the lane of its least urgent call, so it is Interactive only if every call is.
+    bool heavy = false;
+    RequestPriority lane = RequestPriority::Interactive;
+    for (const RpcBatch::Call& call : batch.entries()) {
+        const bool heavyCall = isHeavyCall(call.method, call.params);
+        heavy = heavy || heavyCall;
+        lane = std::max(lane, defaultPriority(call.method, heavyCall));
+    }
+    const PriorityScope scope(PriorityScope::current().value_or(lane));
+    const TransferError error = post("batch", idempotent, heavy, rpcRequest, response);
+    recordCall("batch", started, callFailureOf(error), rpcRequest.size(), response.size());
+    return parseBatchResponse(error == TransferError::None, response, batch.size(), firstId);
+}
+
+void BitcoinClient::setAsyncEngine(std::shared_ptr<AsyncEngine> sharedEngine) {
+    std::call_once(asyncEngineOnce, [&] { asyncEngine = std::move(sharedEngine); });
+}
+
+AsyncEngine& BitcoinClient::engine() {
+    std::call_once(asyncEngineOnce, [&] {
+        if (nodeClient) {
+            nodeClient->engine();
+            asyncEngine = nodeClient->asyncEngine;
+        } else {
+            asyncEngine = std::make_shared<AsyncEngine>(poolSettings);
+        }
+    });
+    return *asyncEngine;
+}
+
+std::unique_ptr<BitcoinClient> BitcoinClient::wallet(const std::string& name) {
+    // Handles of handles still belong to the node, not to a path below a wallet.
+    BitcoinClient& node = nodeClient ? *nodeClient : *this;
+    return std::unique_ptr<BitcoinClient>(new BitcoinClient(node, node.walletUrl(name)));
+}
+
+std::string BitcoinClient::walletUrl(std::string_view name) const {
+    static constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+    std::string url = rpcUrl;
+    while (!url.empty() && url.back() == '/') url.pop_back();
+    url += "/wallet/";
+    for (const char c : name) {
+        const auto byte = static_cast<unsigned char>(c);
+        if (std::isalnum(byte) || c == '-' || c == '_' || c == '.' || c == '~') {
+            url += c;
+        } else {
+            url += '%';
+            url += HEX_DIGITS[byte >> 4];
+            url += HEX_DIGITS[byte & 0x0F];
+        }
+    }
+    return url;
+}
+
+std::vector<RpcResult> BitcoinClient::sendWalletCalls(const std::string& method, const std::vector<std::string>& wallets,
+                                                      const Json::Value& params) {
+    return fanOut(wallets, buildRpcRequest(method, params), AsyncMethodName {{}, method});
+}
+
+std::vector<RpcResult> BitcoinClient::fanOut(const std::vector<std::string>& wallets, const std::string& body,
+                                             const AsyncMethodName& method) {
+    Logger::formattedDebug("Sending RPC request {} to {} wallets", method.view(), wallets.size());
+    const BitcoinClient& node = nodeClient ? *nodeClient : *this;
+    const auto started = std::chrono::steady_clock::now();
+
+    std::vector<std::future<RpcResult>> pending;
+    pending.reserve(wallets.size());
+    for (const std::string& name : wallets) {
+        auto promise = std::make_shared<std::promise<RpcResult>>();
+        pending.push_back(promise->get_future());
+        HttpPostRequest request = makeAsyncRequest(body);
+        request.url = node.walletUrl(name);
+        engine().submit(std::move(request), [promise, sink = callMetrics, method, requestBytes = body.size(), started]
+                                            (bool success, std::string&& response) {
+            RpcResult outcome;
+            CallFailure failure = CallFailure::Transport;
+            if (success) {
+                outcome = parseCallResult(response, failure);
+            } else {
+                outcome.error = makeRpcError(RPC_CLIENT_TRANSPORT_ERROR, "Failed to send RPC request");
+                outcome.transportFailure = true;
+            }
+            if (sink) sink->recordCall(method.view(), CallSample {std::chrono::steady_clock::now() - started, {}, requestBytes, response.size(), failure});
+            promise->set_value(std::move(outcome));
+        });
+    }
+
+    std::vector<RpcResult> results;
+    results.reserve(pending.size());
+    for (std::future<RpcResult>& answer : pending) results.push_back(answer.get());
+    return results;
+}
+
+std::future<Json::Value> BitcoinClient::sendRequestAsync(const std::string& method, const Json::Value& params) {
+    return submitAsync(makeAsyncRequest(buildRpcRequest(method, params)), AsyncMethodName {{}, method});
+}
+
+std::future<Json::Value> BitcoinClient::submitAsync(HttpPostRequest request, AsyncMethodName method) {
+    Logger::formattedDebug("Sending asynchronous RPC request: {}", method.view());
+
+    auto promise = std::make_shared<std::promise<Json::Value>>();
+    std::future<Json::Value> future = promise->get_future();
+    const std::size_t requestBytes = request.body.size();
+    engine().submit(std::move(request), [promise, sink = callMetrics, method = std::move(method), requestBytes,
+                                         started = std::chrono::steady_clock::now()]
+                                        (bool success, std::string&& response) {
+        CallFailure failure = success ? CallFailure::None : CallFailure::Transport;
+        Json::Value result;
+        if (success) {
+            result = parseRpcResponse(response, &failure);
+        } else {
+            Logger::error("Failed to send RPC request");
+        }
+        if (sink) sink->recordCall(method.view(), CallSample {std::chrono::steady_clock::now() - started, {}, requestBytes, response.size(), failure});
+        promise->set_value(std::move(result));
+    });
+    return future;
+}
+
+std::future<std::vector<RpcResult>> BitcoinClient::sendBatchAsync(const RpcBatch& batch) {
+    auto promise = std::make_shared<std::promise<std::vector<RpcResult>>>();
+    std::future<std::vector<RpcResult>> future = promise->get_future();
+    if (batch.empty()) {
+        promise->set_value({});
+        return future;
+    }
+
+    HttpPostRequest request = makeAsyncRequest(std::string());
+    const std::uint64_t firstId = writeBatchRequest(batch, request.body);
+    Logger::formattedDebug("Sending asynchronous RPC batch of {} calls", batch.size());
+
+    const std::size_t requestBytes = request.body.size();
+    engine().submit(std::move(request), [promise, count = batch.size(), firstId, sink = callMetrics, requestBytes,
+                                         started = std::chrono::steady_clock::now()](bool success, std::string&& response) {
+        if (sink) {
+            sink->recordCall("batch", CallSample {std::chrono::steady_clock::now() - started, {}, requestBytes, response.size(),
+                                                  success ? CallFailure::None : CallFailure::Transport});
+        }
+        promise->set_value(parseBatchResponse(success, response, count, firstId));
+    });
+    return future;
+}
+
+bool BitcoinClient::streamRequest(std::string_view method, const Json::Value& params, JsonHandler& handler) {
+    const std::string rpcRequest = buildRpcRequest(method, params);
+    Logger::formattedDebug("Streaming RPC request: {}", rpcRequest);
+
+    JsonStreamParser parser(handler);
+    std::size_t received = 0;
+    const Network::DataCallback onData = [&parser, &received](std::string_view chunk) {
+        received += chunk.size();
+        return parser.feed(chunk);
+    };
+
+    const auto started = std::chrono::steady_clock::now();
+    AdmissionControl::Ticket ticket;
+    if (admission && !(ticket = admitRequest(method, isHeavyCall(method, params)))) {
+        recordCall(method, started, CallFailure::TimedOut, rpcRequest.size(), 0);
+        return false;
+    }
+    if (breaker && !breaker->allow()) {
+        Logger::formattedError("Failed to send RPC request {}: {}", method, describeTransferError(TransferError::CircuitOpen));
+        recordCall(method, started, CallFailure::CircuitOpen, rpcRequest.size(), 0);
+        return false;
+    }
+    const bool sent = network.streamPostRequest(rpcUrl, rpcRequest, onData, rpcUser, rpcPassword, JSON_RPC_HEADERS);
+    if (breaker) {
+        if (sent || Network::lastError() == TransferError::Aborted) breaker->recordSuccess();
+        else breaker->recordFailure();
+    }
+    if (!sent || !parser.finish()) {
+        if (parser.failed()) {
+            Logger::formattedError("Failed to parse JSON response: {}", parser.error());
+        } else {
+            Logger::error("Failed to send RPC request");
+        }
+        const CallFailure failure = parser.failed() ? CallFailure::Parse : callFailureOf(Network::lastError());
+        recordCall(method, started, failure == CallFailure::None ? CallFailure::Transport : failure, rpcRequest.size(), received);
+        return false;
+    }
+    recordCall(method, started, CallFailure::None, rpcRequest.size(), received);
+    return true;
+}
+
+Json::Value BitcoinClient::streamResult(const std::string& method, const Json::Value& params,
+                                        const std::vector<std::string>& path,
+                                        const JsonElementStreamer::ElementCallback& onElement) {
+    std::vector<std::string> fullPath {"result"};
+    fullPath.insert(fullPath.end(), path.begin(), path.end());
+
+    JsonElementStreamer streamer(std::move(fullPath), onElement);
+    if (!streamRequest(method, params, streamer)) {
+        return Json::Value();
+    }
+
+    Json::Value& document = streamer.document();
+    if (!document.isObject()) {
+        Logger::error("Unexpected RPC response");
+        return Json::Value();
+    }
+    if (!document["error"].isNull()) {
+        Logger::formattedError("RPC error: {}", Json::writeString(Json::StreamWriterBuilder(), document["error"]));
+        return Json::Value();
+    }
+    return document["result"];
+}
+
+Json::Value BitcoinClient::streamBlockTransactions(const std::string& blockHash, const JsonElementStreamer::ElementCallback& onTransaction) {
+    return streamResult("getblock", buildParams(blockHash, 2), {"tx"}, onTransaction);
+}
+
+Json::Value BitcoinClient::streamRawMempool(const JsonElementStreamer::ElementCallback& onEntry) {
+    return streamResult("getrawmempool", buildParams(true), {}, onEntry);
+}
+
+std::optional<BlockHeaderResult> BitcoinClient::getBlockHeaderTyped(const std::string& blockHash) {
+    return callTyped<RpcMethod::getblockheader>(blockHash, true);
+}
+
+std::optional<TxOutResult> BitcoinClient::getTxOutTyped(const std::string& txid, int n, bool includeMempool) {
+    return callTyped<RpcMethod::gettxout>(txid, n, includeMempool);
+}
+
+std::optional<MempoolEntryResult> BitcoinClient::getMempoolEntryTyped(const std::string& txid) {
+    return callTyped<RpcMethod::getmempoolentry>(txid);
+}
+
+std::optional<BlockStatsResult> BitcoinClient::getBlockStatsTyped(const std::string& blockHash) {
+    return callTyped<RpcMethod::getblockstats>(blockHash);
+}
+
+std::optional<SmartFeeResult> BitcoinClient::estimateSmartFeeTyped(int confTarget, const std::string& estimateMode) {
+    return callTyped<RpcMethod::estimatesmartfee>(confTarget, estimateMode);
+}
+
+std::optional<BlockchainInfoResult> BitcoinClient::getBlockchainInfoTyped() {
+    return callTyped<RpcMethod::getblockchaininfo>();
+}
+
+std::optional<DecodedBlock> BitcoinClient::getBlockDecoded(const std::string& blockHash) {
+    return decodeHexResult<DecodedBlock>(call<RpcMethod::getblock>(blockHash, 0), "getblock");
+}
+
+std::optional<DecodedTransaction> BitcoinClient::getRawTransactionDecoded(const std::string& txid) {
+    return decodeHexResult<DecodedTransaction>(call<RpcMethod::getrawtransaction>(txid, false), "getrawtransaction");
+}
+
+std::vector<std::optional<DecodedTransaction>> BitcoinClient::getRawTransactionsDecoded(const std::vector<std::string>& txids) {
+    RpcBatch batch;
+    for (const auto& txid : txids) batch.call<RpcMethod::getrawtransaction>(txid, false);
+
+    std::vector<std::optional<DecodedTransaction>> decoded;
+    decoded.reserve(txids.size());
+    for (const auto& result : sendBatch(batch)) {
+        decoded.push_back(result.ok() ? decodeHexResult<DecodedTransaction>(result.result, "getrawtransaction") : std::nullopt);
+    }
+    return decoded;
 }
 
 Json::Value BitcoinClient::getBestBlockHash() {
-    return sendRequest("getbestblockhash");
+    return call<RpcMethod::getbestblockhash>();
 }
 
 Json::Value BitcoinClient::getBlock(const std::string& blockHash, bool verbose) {
-    return sendRequest("getblock", buildParams(blockHash, verbose ? 2 : 1));
+    return call<RpcMethod::getblock>(blockHash, verbose ? 2 : 1);
 }
 
 Json::Value BitcoinClient::getBlockchainInfo() {
-    return sendRequest("getblockchaininfo");
+    return call<RpcMethod::getblockchaininfo>();
 }
 
 Json::Value BitcoinClient::getBlockCount() {
-    return sendRequest("getblockcount");
+    return call<RpcMethod::getblockcount>();
 }
 
 Json::Value BitcoinClient::getBlockFilter(const std::string& blockHash, const std::string& filterType) {
-    return sendRequest("getblockfilter", buildParams(blockHash, filterType));
+    return call<RpcMethod::getblockfilter>(blockHash, filterType);
 }
 
 Json::Value BitcoinClient::getBlockHash(int height) {
-    return sendRequest("getblockhash", buildParams(height));
+    return call<RpcMethod::getblockhash>(height);
 }
 
 Json::Value BitcoinClient::getBlockHeader(const std::string& blockHash, bool verbose) {
-    return sendRequest("getblockheader", buildParams(blockHash, verbose));
+    return call<RpcMethod::getblockheader>(blockHash, verbose);
 }
 
 Json::Value BitcoinClient::getBlockStats(const std::string& blockHash, const std::vector<std::string>& stats) {
-    Json::Value statsArray;
-    for (const auto& stat : stats) statsArray.append(stat);
-    return sendRequest("getblockstats", buildParams(blockHash, statsArray));
+    return call<RpcMethod::getblockstats>(blockHash, stats);
 }
 
 Json::Value BitcoinClient::getChainTips() {
-    return sendRequest("getchaintips");
+    return call<RpcMethod::getchaintips>();
 }
 
 Json::Value BitcoinClient::getChainTxStats(int nBlocks, const std::string& blockHash) {
-    Json::Value params = buildParams(nBlocks);
-    if (!blockHash.empty()) params.append(blockHash);
-    return sendRequest("getchaintxstats", params);
+    return call<RpcMethod::getchaintxstats>(nBlocks, unlessEmpty(blockHash));
 }
 
 Json::Value BitcoinClient::getDifficulty() {
-    return sendRequest("getdifficulty");
+    return call<RpcMethod::getdifficulty>();
 }
 
 Json::Value BitcoinClient::getMempoolAncestors(const std::string& txid, bool verbose) {
-    return sendRequest("getmempoolancestors", buildParams(txid, verbose));
+    return call<RpcMethod::getmempoolancestors>(txid, verbose);
 }
 
 Json::Value BitcoinClient::getMempoolDescendants(const std::string& txid, bool verbose) {
-    return sendRequest("getmempooldescendants", buildParams(txid, verbose));
+    return call<RpcMethod::getmempooldescendants>(txid, verbose);
 }
 
 Json::Value BitcoinClient::getMempoolEntry(const std::string& txid) {
-    return sendRequest("getmempoolentry", buildParams(txid));
+    return call<RpcMethod::getmempoolentry>(txid);
 }
 
 Json::Value BitcoinClient::getMempoolInfo() {
-    return sendRequest("getmempoolinfo");
+    return call<RpcMethod::getmempoolinfo>();
 }
 
 Json::Value BitcoinClient::getRawMempool(bool verbose) {
-    return sendRequest("getrawmempool", buildParams(verbose));
+    return call<RpcMethod::getrawmempool>(verbose);
 }
 
 Json::Value BitcoinClient::getTxOut(const std::string& txid, int n, bool includeMempool) {
-    return sendRequest("gettxout", buildParams(txid, n, includeMempool));
+    return call<RpcMethod::gettxout>(txid, n, includeMempool);
 }
 
 Json::Value BitcoinClient::getTxOutProof(const std::vector<std::string>& txids, const std::string& blockHash) {
-    Json::Value txidsArray;
-    for (const auto& txid : txids) txidsArray.append(txid);
-    Json::Value params = buildParams(txidsArray);
-    if (!blockHash.empty()) params.append(blockHash);
-    return sendRequest("gettxoutproof", params);
+    return call<RpcMethod::gettxoutproof>(txids, unlessEmpty(blockHash));
 }
 
 Json::Value BitcoinClient::getTxOutSetInfo() {
-    return sendRequest("gettxoutsetinfo");
+    return call<RpcMethod::gettxoutsetinfo>();
 }
 
 Json::Value BitcoinClient::preciousBlock(const std::string& blockHash) {
-    return sendRequest("preciousblock", buildParams(blockHash));
+    return call<RpcMethod::preciousblock>(blockHash);
 }
 
 Json::Value BitcoinClient::pruneBlockchain(int height) {
-    return sendRequest("pruneblockchain", buildParams(height));
+    return call<RpcMethod::pruneblockchain>(height);
 }
 
 Json::Value BitcoinClient::saveMempool() {
-    return sendRequest("savemempool");
+    return call<RpcMethod::savemempool>();
 }
 
 Json::Value BitcoinClient::scanTxOutSet(const std::vector<std::string>& descriptors) {
-    Json::Value descriptorsArray;
-    for (const auto& desc : descriptors) descriptorsArray.append(desc);
-    return sendRequest("scantxoutset", buildParams(descriptorsArray));
+    return call<RpcMethod::scantxoutset>(descriptors);
 }
 
 Json::Value BitcoinClient::verifyChain(int checkLevel, int nBlocks) {
-    return sendRequest("verifychain", buildParams(checkLevel, nBlocks));
+    return call<RpcMethod::verifychain>(checkLevel, nBlocks);
 }
 
 Json::Value BitcoinClient::verifyTxOutProof(const std::string& proof) {
-    return sendRequest("verifytxoutproof", buildParams(proof));
+    return call<RpcMethod::verifytxoutproof>(proof);
 }
 
 Json::Value BitcoinClient::getMemoryInfo() {
-    return sendRequest("getmemoryinfo");
+    return call<RpcMethod::getmemoryinfo>();
 }
 
 Json::Value BitcoinClient::getRpcInfo() {
-    return sendRequest("getrpcinfo");
+    return call<RpcMethod::getrpcinfo>();
 }
 
 Json::Value BitcoinClient::help(const std::string& command) {
-    return sendRequest("help", command.empty() ? Json::Value() : buildParams(command));
+    return call<RpcMethod::help>(unlessEmpty(command));
 }
 
 Json::Value BitcoinClient::logging(const std::vector<std::string>& include, const std::vector<std::string>& exclude) {
-    Json::Value includeArray, excludeArray;
-    for (const auto& inc : include) includeArray.append(inc);
-    for (const auto& exc : exclude) excludeArray.append(exc);
-    return sendRequest("logging", buildParams(includeArray, excludeArray));
+    return call<RpcMethod::logging>(include, exclude);
 }
 
 Json::Value BitcoinClient::stop() {
-    return sendRequest("stop");
+    return call<RpcMethod::stop>();
 }
 
 Json::Value BitcoinClient::uptime() {
-    return sendRequest("uptime");
+    return call<RpcMethod::uptime>();
 }
 
 Json::Value BitcoinClient::generateBlock(const std::string& outputAddress, const std::vector<std::string>& transactions) {
-    Json::Value txArray;
-    for (const auto& tx : transactions) txArray.append(tx);
-    return sendRequest("generateblock", buildParams(outputAddress, txArray));
+    return call<RpcMethod::generateblock>(outputAddress, transactions);
 }
 
 Json::Value BitcoinClient::generateToAddress(int nBlocks, const std::string& address) {
-    return sendRequest("generatetoaddress", buildParams(nBlocks, address));
+    return call<RpcMethod::generatetoaddress>(nBlocks, address);
 }
 
 Json::Value BitcoinClient::generateToDescriptor(int nBlocks, const std::string& descriptor) {
-    return sendRequest("generatetodescriptor", buildParams(nBlocks, descriptor));
+    return call<RpcMethod::generatetodescriptor>(nBlocks, descriptor);
 }
 
 Json::Value BitcoinClient::getBlockTemplate(const std::string& templateRequest) {
-    return sendRequest("getblocktemplate", templateRequest.empty() ? Json::Value() : buildParams(templateRequest));
+    return call<RpcMethod::getblocktemplate>(unlessEmpty(templateRequest));
 }
 
 Json::Value BitcoinClient::getMiningInfo() {
-    return sendRequest("getmininginfo");
+    return call<RpcMethod::getmininginfo>();
 }
 
 Json::Value BitcoinClient::getNetworkHashPS(int nBlocks, int height) {
-    return sendRequest("getnetworkhashps", buildParams(nBlocks, height));
+    return call<RpcMethod::getnetworkhashps>(nBlocks, height);
 }
 
 Json::Value BitcoinClient::prioritiseTransaction(const std::string& txid, double feeDelta) {
-    return sendRequest("prioritisetransaction", buildParams(txid, feeDelta));
+    return call<RpcMethod::prioritisetransaction>(txid, feeDelta);
 }
 
 Json::Value BitcoinClient::submitBlock(const std::string& hexData, const std::string& parameters) {
-    return parameters.empty() ? sendRequest("submitblock", buildParams(hexData))
-                              : sendRequest("submitblock", buildParams(hexData, parameters));
+    return call<RpcMethod::submitblock>(hexData, unlessEmpty(parameters));
 }
 
 Json::Value BitcoinClient::submitHeader(const std::string& hexHeader) {
-    return sendRequest("submitheader", buildParams(hexHeader));
+    return call<RpcMethod::submitheader>(hexHeader);
 }
 
 Json::Value BitcoinClient::addNode(const std::string& node, const std::string& command) {
-    return sendRequest("addnode", buildParams(node, command));
+    return call<RpcMethod::addnode>(node, command);
 }
 
 Json::Value BitcoinClient::clearBanned() {
-    return sendRequest("clearbanned");
+    return call<RpcMethod::clearbanned>();
 }
 
 Json::Value BitcoinClient::disconnectNode(const std::string& address) {
-    return sendRequest("disconnectnode", buildParams(address));
+    return call<RpcMethod::disconnectnode>(address);
 }
 
 Json::Value BitcoinClient::getAddedNodeInfo(const std::string& node) {
-    return sendRequest("getaddednodeinfo", node.empty() ? Json::Value() : buildParams(node));
+    return call<RpcMethod::getaddednodeinfo>(unlessEmpty(node));
 }
 
 Json::Value BitcoinClient::getConnectionCount() {
-    return sendRequest("getconnectioncount");
+    return call<RpcMethod::getconnectioncount>();
 }
 
 Json::Value BitcoinClient::getNetTotals() {
-    return sendRequest("getnettotals");
+    return call<RpcMethod::getnettotals>();
 }
 
 Json::Value BitcoinClient::getNetworkInfo() {
-    return sendRequest("getnetworkinfo");
+    return call<RpcMethod::getnetworkinfo>();
 }
 
 Json::Value BitcoinClient::getNodeAddresses(int count) {
-    return sendRequest("getnodeaddresses", buildParams(count));
+    return call<RpcMethod::getnodeaddresses>(count);
 }
 
 Json::Value BitcoinClient::getPeerInfo() {
-    return sendRequest("getpeerinfo");
+    return call<RpcMethod::getpeerinfo>();
 }
 
 Json::Value BitcoinClient::listBanned() {
-    return sendRequest("listbanned");
+    return call<RpcMethod::listbanned>();
 }
 
 Json::Value BitcoinClient::ping() {
-    return sendRequest("ping");
+    return call<RpcMethod::ping>();
 }
 
 Json::Value BitcoinClient::setBan(const std::string& subnet, const std::string& command, int banTime, bool absolute) {
-    return sendRequest("setban", buildParams(subnet, command, banTime, absolute));
+    return call<RpcMethod::setban>(subnet, command, banTime, absolute);
 }
 
 Json::Value BitcoinClient::setNetworkActive(bool state) {
-    return sendRequest("setnetworkactive", buildParams(state));
+    return call<RpcMethod::setnetworkactive>(state);
 }
 
 Json::Value BitcoinClient::analyzePsbt(const std::string& psbt) {
-    return sendRequest("analyzepsbt", buildParams(psbt));
+    return call<RpcMethod::analyzepsbt>(psbt);
 }
 
 Json::Value BitcoinClient::combinePsbt(const std::vector<std::string>& psbts) {
-    Json::Value psbtsArray;
-    for (const auto& psbt : psbts) psbtsArray.append(psbt);
-    return sendRequest("combinepsbt", buildParams(psbtsArray));
+    return call<RpcMethod::combinepsbt>(psbts);
 }
 
 Json::Value BitcoinClient::combineRawTransaction(const std::vector<std::string>& hexStrings) {
-    Json::Value hexArray;
-    for (const auto& hex : hexStrings) hexArray.append(hex);
-    return sendRequest("combinerawtransaction", buildParams(hexArray));
+    return call<RpcMethod::combinerawtransaction>(hexStrings);
 }
 
 Json::Value BitcoinClient::convertToPsbt(const std::string& hexString, bool permitsigdata, bool iswitness) {
-    return sendRequest("converttopsbt", buildParams(hexString, permitsigdata, iswitness));
+    return call<RpcMethod::converttopsbt>(hexString, permitsigdata, iswitness);
 }
 
 Json::Value BitcoinClient::createPsbt(const std::vector<Json::Value>& inputs, const std::map<std::string, double>& outputs) {
-    Json::Value inputsArray;
-    for (const auto& input : inputs) inputsArray.append(input);
-
-    Json::Value outputsObj;
-    for (const auto& [addr, amount] : outputs) outputsObj[addr] = amount;
-
-    return sendRequest("createpsbt", buildParams(inputsArray, outputsObj));
+    return call<RpcMethod::createpsbt>(inputs, outputs);
 }
 
 Json::Value BitcoinClient::createRawTransaction(const std::vector<Json::Value>& inputs, const std::map<std::string, double>& outputs) {
-    Json::Value inputsArray;
-    for (const auto& input : inputs) inputsArray.append(input);
-
-    Json::Value outputsObj;
-    for (const auto& [addr, amount] : outputs) outputsObj[addr] = amount;
-
-    return sendRequest("createrawtransaction", buildParams(inputsArray, outputsObj));
+    return call<RpcMethod::createrawtransaction>(inputs, outputs);
 }
 
 Json::Value BitcoinClient::decodePsbt(const std::string& psbt) {
-    return sendRequest("decodepsbt", buildParams(psbt));
+    return call<RpcMethod::decodepsbt>(psbt);
 }
 
 Json::Value BitcoinClient::decodeRawTransaction(const std::string& hexString, bool iswitness) {
-    return sendRequest("decoderawtransaction", buildParams(hexString, iswitness));
+    return call<RpcMethod::decoderawtransaction>(hexString, iswitness);
 }
 
 Json::Value BitcoinClient::decodeScript(const std::string& hexString) {
-    return sendRequest("decodescript", buildParams(hexString));
+    return call<RpcMethod::decodescript>(hexString);
 }
 
 Json::Value BitcoinClient::finalizePsbt(const std::string& psbt, bool extract) {
-    return sendRequest("finalizepsbt", buildParams(psbt, extract));
+    return call<RpcMethod::finalizepsbt>(psbt, extract);
 }
 
 Json::Value BitcoinClient::fundRawTransaction(const std::string& hexString, const Json::Value& options) {
-    Json::Value params = buildParams(hexString);
-    if (!options.isNull()) params.append(options);
-    return sendRequest("fundrawtransaction", params);
+    return call<RpcMethod::fundrawtransaction>(hexString, options);
 }
 
 Json::Value BitcoinClient::getRawTransaction(const std::string& txid, bool verbose) {
-    return sendRequest("getrawtransaction", buildParams(txid, verbose));
+    return call<RpcMethod::getrawtransaction>(txid, verbose);
 }
 
 Json::Value BitcoinClient::joinPsbts(const std::vector<std::string>& psbts) {
-    Json::Value psbtsArray;
-    for (const auto& psbt : psbts) psbtsArray.append(psbt);
-    return sendRequest("joinpsbts", buildParams(psbtsArray));
+    return call<RpcMethod::joinpsbts>(psbts);
 }
 
 Json::Value BitcoinClient::sendRawTransaction(const std::string& hexString, bool allowhighfees) {
-    return sendRequest("sendrawtransaction", buildParams(hexString, allowhighfees));
+    return call<RpcMethod::sendrawtransaction>(hexString, allowhighfees);
 }
 
 Json::Value BitcoinClient::signRawTransactionWithKey(const std::string& hexString, const std::vector<std::string>& privKeys, const Json::Value& prevTxs) {
-    Json::Value keysArray;
-    for (const auto& key : privKeys) keysArray.append(key);
-    Json::Value params = buildParams(hexString, keysArray);
-    if (!prevTxs.isNull()) params.append(prevTxs);
-    return sendRequest("signrawtransactionwithkey", params);
+    return call<RpcMethod::signrawtransactionwithkey>(hexString, privKeys, prevTxs);
 }
 
 Json::Value BitcoinClient::testMempoolAccept(const std::vector<std::string>& rawTxns, bool allowhighfees) {
-    Json::Value txnArray;
-    for (const auto& txn : rawTxns) txnArray.append(txn);
-    return sendRequest("testmempoolaccept", buildParams(txnArray, allowhighfees));
+    return call<RpcMethod::testmempoolaccept>(rawTxns, allowhighfees);
 }
 
 Json::Value BitcoinClient::utxoUpdatePsbt(const std::string& psbt, const Json::Value& descriptors) {
-    Json::Value params = buildParams(psbt);
-    if (!descriptors.isNull()) params.append(descriptors);
-    return sendRequest("utxoupdatepsbt", params);
+    return call<RpcMethod::utxoupdatepsbt>(psbt, descriptors);
 }
 
 Json::Value BitcoinClient::createMultiSig(int nRequired, const std::vector<std::string>& keys) {
-    Json::Value keysArray;
-    for (const auto& key : keys) keysArray.append(key);
-    return sendRequest("createmultisig", buildParams(nRequired, keysArray));
+    return call<RpcMethod::createmultisig>(nRequired, keys);
 }
 
 Json::Value BitcoinClient::deriveAddresses(const std::string& descriptor, const Json::Value& range) {
-    Json::Value params = buildParams(descriptor);
-    if (!range.isNull()) params.append(range);
-    return sendRequest("deriveaddresses", params);
+    return call<RpcMethod::deriveaddresses>(descriptor, range);
 }
 
 Json::Value BitcoinClient::estimateSmartFee(int confTarget, const std::string& estimateMode) {
-    return sendRequest("estimatesmartfee", buildParams(confTarget, estimateMode));
+    return call<RpcMethod::estimatesmartfee>(confTarget, estimateMode);
 }
 
 Json::Value BitcoinClient::getDescriptorInfo(const std::string& descriptor) {
-    return sendRequest("getdescriptorinfo", buildParams(descriptor));
+    return call<RpcMethod::getdescriptorinfo>(descriptor);
 }
 
 Json::Value BitcoinClient::getIndexInfo() {
-    return sendRequest("getindexinfo");
+    return call<RpcMethod::getindexinfo>();
 }
 
 Json::Value BitcoinClient::signMessageWithPrivKey(const std::string& privKey, const std::string& message) {
-    return sendRequest("signmessagewithprivkey", buildParams(privKey, message));
+    return call<RpcMethod::signmessagewithprivkey>(privKey, message);
 }
 
 Json::Value BitcoinClient::validateAddress(const std::string& address) {
-    return sendRequest("validateaddress", buildParams(address));
+    return call<RpcMethod::validateaddress>(address);
 }
 
 Json::Value BitcoinClient::verifyMessage(const std::string& address, const std::string& signature, const std::string& message) {
-    return sendRequest("verifymessage", buildParams(address, signature, message));
+    return call<RpcMethod::verifymessage>(address, signature, message);
 }
 
 Json::Value BitcoinClient::abandonTransaction(const std::string& txid) {
-    return sendRequest("abandontransaction", buildParams(txid));
+    return call<RpcMethod::abandontransaction>(txid);
 }
 
 Json::Value BitcoinClient::abortRescan() {
-    return sendRequest("abortrescan");
+    return call<RpcMethod::abortrescan>();
 }
 
 Json::Value BitcoinClient::addMultiSigAddress(int nRequired, const std::vector<std::string>& keys, const std::string& label) {
-    Json::Value keysArray;
-    for (const auto& key : keys) keysArray.append(key);
-    Json::Value params = buildParams(nRequired, keysArray);
-    if (!label.empty()) params.append(label);
-    return sendRequest("addmultisigaddress", params);
+    return call<RpcMethod::addmultisigaddress>(nRequired, keys, unlessEmpty(label));
 }
 
 Json::Value BitcoinClient::backupWallet(const std::string& destination) {
-    return sendRequest("backupwallet", buildParams(destination));
+    return call<RpcMethod::backupwallet>(destination);
 }
 
 Json::Value BitcoinClient::bumpFee(const std::string& txid, const Json::Value& options) {
-    Json::Value params = buildParams(txid);
-    if (!options.isNull()) params.append(options);
-    return sendRequest("bumpfee", params);
+    return call<RpcMethod::bumpfee>(txid, options);
 }
 
 Json::Value BitcoinClient::createWallet(const std::string& walletName, bool disablePrivateKeys, bool blank) {
-    return sendRequest("createwallet", buildParams(walletName, disablePrivateKeys, blank));
+    return call<RpcMethod::createwallet>(walletName, disablePrivateKeys, blank);
 }
 
 Json::Value BitcoinClient::dumpPrivKey(const std::string& address) {
-    return sendRequest("dumpprivkey", buildParams(address));
+    return call<RpcMethod::dumpprivkey>(address);
 }
 
 Json::Value BitcoinClient::dumpWallet(const std::string& filename) {
-    return sendRequest("dumpwallet", buildParams(filename));
+    return call<RpcMethod::dumpwallet>(filename);
 }
 
 Json::Value BitcoinClient::encryptWallet(const std::string& passphrase) {
-    return sendRequest("encryptwallet", buildParams(passphrase));
+    return call<RpcMethod::encryptwallet>(passphrase);
 }
 
 Json::Value BitcoinClient::getAddressesByLabel(const std::string& label) {
-    return sendRequest("getaddressesbylabel", buildParams(label));
+    return call<RpcMethod::getaddressesbylabel>(label);
 }
 
 Json::Value BitcoinClient::getAddressInfo(const std::string& address) {
-    return sendRequest("getaddressinfo", buildParams(address));
+    return call<RpcMethod::getaddressinfo>(address);
 }
 
 Json::Value BitcoinClient::getBalance(const std::string& dummy, int minconf, bool includeWatchonly) {
-    return sendRequest("getbalance", buildParams(dummy, minconf, includeWatchonly));
+    return call<RpcMethod::getbalance>(dummy, minconf, includeWatchonly);
 }
 
 Json::Value BitcoinClient::getBalances() {
-    return sendRequest("getbalances");
+    return call<RpcMethod::getbalances>();
 }
 
 Json::Value BitcoinClient::getNewAddress(const std::string& label) {
-    return sendRequest("getnewaddress", label.empty() ? Json::Value() : buildParams(label));
+    return call<RpcMethod::getnewaddress>(unlessEmpty(label));
 }
 
 Json::Value BitcoinClient::getRawChangeAddress(const std::string& addressType) {
-    return sendRequest("getrawchangeaddress", addressType.empty() ? Json::Value() : buildParams(addressType));
+    return call<RpcMethod::getrawchangeaddress>(unlessEmpty(addressType));
 }
 
 Json::Value BitcoinClient::getReceivedByAddress(const std::string& address, int minconf) {
-    return sendRequest("getreceivedbyaddress", buildParams(address, minconf));
+    return call<RpcMethod::getreceivedbyaddress>(address, minconf);
 }
 
 Json::Value BitcoinClient::getReceivedByLabel(const std::string& label, int minconf) {
-    return sendRequest("getreceivedbylabel", buildParams(label, minconf));
+    return call<RpcMethod::getreceivedbylabel>(label, minconf);
 }
 
 Json::Value BitcoinClient::getTransaction(const std::string& txid, bool includeWatchonly) {
-    return sendRequest("gettransaction", buildParams(txid, includeWatchonly));
+    return call<RpcMethod::gettransaction>(txid, includeWatchonly);
 }
 
 Json::Value BitcoinClient::getUnconfirmedBalance() {
-    return sendRequest("getunconfirmedbalance");
+    return call<RpcMethod::getunconfirmedbalance>();
 }
 
 Json::Value BitcoinClient::getWalletInfo() {
-    return sendRequest("getwalletinfo");
+    return call<RpcMethod::getwalletinfo>();
 }
 
 Json::Value BitcoinClient::importAddress(const std::string& address, const std::string& label, bool rescan) {
-    Json::Value params = buildParams(address);
-    if (!label.empty()) params.append(label);
-    params.append(rescan);
-    return sendRequest("importaddress", params);
+    return call<RpcMethod::importaddress>(address, label, rescan);
 }
 
 Json::Value BitcoinClient::importDescriptors(const Json::Value& requests) {
-    return sendRequest("importdescriptors", buildParams(requests));
+    return call<RpcMethod::importdescriptors>(requests);
 }
 
 Json::Value BitcoinClient::importMulti(const Json::Value& requests, const Json::Value& options) {
-    Json::Value params = buildParams(requests);
-    if (!options.isNull()) params.append(options);
-    return sendRequest("importmulti", params);
+    return call<RpcMethod::importmulti>(requests, options);
 }
 
 Json::Value BitcoinClient::importPrivKey(const std::string& privKey, const std::string& label, bool rescan) {
-    Json::Value params = buildParams(privKey);
-    if (!label.empty()) params.append(label);
-    params.append(rescan);
-    return sendRequest("importprivkey", params);
+    return call<RpcMethod::importprivkey>(privKey, label, rescan);
 }
 
 Json::Value BitcoinClient::importPrunedFunds(const std::string& rawTransaction, const std::string& txOutProof) {
-    return sendRequest("importprunedfunds", buildParams(rawTransaction, txOutProof));
+    return call<RpcMethod::importprunedfunds>(rawTransaction, txOutProof);
 }
 
 Json::Value BitcoinClient::importPubKey(const std::string& pubKey, const std::string& label, bool rescan) {
-    Json::Value params = buildParams(pubKey);
-    if (!label.empty()) params.append(label);
-    params.append(rescan);
-    return sendRequest("importpubkey", params);
+    return call<RpcMethod::importpubkey>(pubKey, label, rescan);
 }
 
 Json::Value BitcoinClient::importWallet(const std::string& filename) {
-    return sendRequest("importwallet", buildParams(filename));
+    return call<RpcMethod::importwallet>(filename);
 }
 
 Json::Value BitcoinClient::keyPoolRefill(int newSize) {
-    return sendRequest("keypoolrefill", buildParams(newSize));
+    return call<RpcMethod::keypoolrefill>(newSize);
 }
 
 Json::Value BitcoinClient::listAddressGroupings() {
-    return sendRequest("listaddressgroupings");
+    return call<RpcMethod::listaddressgroupings>();
 }
 
 Json::Value BitcoinClient::listLabels() {
-    return sendRequest("listlabels");
+    return call<RpcMethod::listlabels>();
 }
 
 Json::Value BitcoinClient::listLockUnspent() {
-    return sendRequest("listlockunspent");
+    return call<RpcMethod::listlockunspent>();
 }
 
 Json::Value BitcoinClient::listReceivedByAddress(int minconf, bool includeEmpty, bool includeWatchonly) {
-    return sendRequest("listreceivedbyaddress", buildParams(minconf, includeEmpty, includeWatchonly));
+    return call<RpcMethod::listreceivedbyaddress>(minconf, includeEmpty, includeWatchonly);
 }
 
 Json::Value BitcoinClient::listReceivedByLabel(int minconf, bool includeEmpty, bool includeWatchonly) {
-    return sendRequest("listreceivedbylabel", buildParams(minconf, includeEmpty, includeWatchonly));
+    return call<RpcMethod::listreceivedbylabel>(minconf, includeEmpty, includeWatchonly);
 }
 
 Json::Value BitcoinClient::listSinceBlock(const std::string& blockHash, int targetConfirmations, bool includeWatchonly) {
-    Json::Value params;
-    if (!blockHash.empty()) params.append(blockHash);
-    params.append(targetConfirmations);
-    params.append(includeWatchonly);
-    return sendRequest("listsinceblock", params);
+    return call<RpcMethod::listsinceblock>(unlessEmpty(blockHash), targetConfirmations, includeWatchonly);
 }
 
 Json::Value BitcoinClient::listTransactions(const std::string& label, int count, int skip, bool includeWatchonly) {
-    Json::Value params;
-    if (!label.empty()) params.append(label);
-    params.append(count);
-    params.append(skip);
-    params.append(includeWatchonly);
-    return sendRequest("listtransactions", params);
+    return call<RpcMethod::listtransactions>(unlessEmpty(label), count, skip, includeWatchonly);
 }
 
 Json::Value BitcoinClient::listUnspent(int minconf, int maxconf, const std::vector<std::string>& addresses, bool includeUnsafe) {
-    Json::Value addrArray;
-    for (const auto& addr : addresses) addrArray.append(addr);
-    return sendRequest("listunspent", buildParams(minconf, maxconf, addrArray, includeUnsafe));
+    return call<RpcMethod::listunspent>(minconf, maxconf, addresses, includeUnsafe);
 }
 
 Json::Value BitcoinClient::listWalletDir() {
-    return sendRequest("listwalletdir");
+    return call<RpcMethod::listwalletdir>();
 }
 
 Json::Value BitcoinClient::listWallets() {
-    return sendRequest("listwallets");
+    return call<RpcMethod::listwallets>();
 }
 
 Json::Value BitcoinClient::loadWallet(const std::string& walletName) {
-    return sendRequest("loadwallet", buildParams(walletName));
+    return call<RpcMethod::loadwallet>(walletName);
 }
 
 Json::Value BitcoinClient::lockUnspent(bool unlock, const Json::Value& transactions) {
-    Json::Value params = buildParams(unlock);
-    if (!transactions.isNull()) params.append(transactions);
-    return sendRequest("lockunspent", params);
+    return call<RpcMethod::lockunspent>(unlock, transactions);
 }
 
 Json::Value BitcoinClient::psbtBumpFee(const std::string& txid, const Json::Value& options) {
-    Json::Value params = buildParams(txid);
-    if (!options.isNull()) params.append(options);
-    return sendRequest("psbtbumpfee", params);
+    return call<RpcMethod::psbtbumpfee>(txid, options);
 }
 
 Json::Value BitcoinClient::removePrunedFunds(const std::string& txid) {
-    return sendRequest("removeprunedfunds", buildParams(txid));
+    return call<RpcMethod::removeprunedfunds>(txid);
 }
 
 Json::Value BitcoinClient::rescanBlockchain(int startHeight, int stopHeight) {
-    Json::Value params;
-    if (startHeight > 0) params.append(startHeight);
-    if (stopHeight > 0) params.append(stopHeight);
-    return sendRequest("rescanblockchain", params);
+    return call<RpcMethod::rescanblockchain>(unlessZero(startHeight), unlessZero(stopHeight));
 }
 
 Json::Value BitcoinClient::send(const Json::Value& outputs, int confTarget, const std::string& estimateMode, bool replaceable) {
-    return sendRequest("send", buildParams(outputs, confTarget, estimateMode, replaceable));
+    return call<RpcMethod::send>(outputs, confTarget, estimateMode, replaceable);
 }
 
 Json::Value BitcoinClient::sendMany(const std::string& dummy, const std::map<std::string, double>& amounts, int minconf, const std::string& comment, const std::vector<std::string>& subtractFeeFrom) {
-    Json::Value amountsObj;
-    for (const auto& [addr, amt] : amounts) amountsObj[addr] = amt;
-
-    Json::Value params = buildParams(dummy, amountsObj, minconf);
-    if (!comment.empty()) params.append(comment);
-
-    Json::Value feeArray;
-    for (const auto& addr : subtractFeeFrom) feeArray.append(addr);
-    params.append(feeArray);
-
-    return sendRequest("sendmany", params);
+    return call<RpcMethod::sendmany>(dummy, amounts, minconf, unlessEmpty(comment), subtractFeeFrom);
 }
 
 Json::Value BitcoinClient::sendToAddress(const std::string& address, double amount, const std::string& comment, const std::string& commentTo, bool subtractFeeFromAmount) {
-    Json::Value params = buildParams(address, amount);
-    if (!comment.empty()) params.append(comment);
-    if (!commentTo.empty()) params.append(commentTo);
-    params.append(subtractFeeFromAmount);
-    return sendRequest("sendtoaddress", params);
+    return call<RpcMethod::sendtoaddress>(address, amount, unlessEmpty(comment), unlessEmpty(commentTo), subtractFeeFromAmount);
 }
 
-Json::Value BitcoinClient::setHdSeed(const std::string& seed, bool rescan) {
-    Json::Value params;
-    if (!seed.empty()) params.append(seed);
-    params.append(rescan);
-    return sendRequest("sethdseed", params);
+Json::Value BitcoinClient::setHdSeed(const std::string& seed, bool newKeypool) {
+    return call<RpcMethod::sethdseed>(newKeypool, unlessEmpty(seed));
 }
 
 Json::Value BitcoinClient::setLabel(const std::string& address, const std::string& label) {
-    return sendRequest("setlabel", buildParams(address, label));
+    return call<RpcMethod::setlabel>(address, label);
 }
 
 Json::Value BitcoinClient::setTxFee(double amount) {
-    return sendRequest("settxfee", buildParams(amount));
+    return call<RpcMethod::settxfee>(amount);
 }
 
 Json::Value BitcoinClient::setWalletFlag(const std::string& flag, bool value) {
-    return sendRequest("setwalletflag", buildParams(flag, value));
+    return call<RpcMethod::setwalletflag>(flag, value);
 }
 
 Json::Value BitcoinClient::signMessage(const std::string& address, const std::string& message) {
-    return sendRequest("signmessage", buildParams(address, message));
+    return call<RpcMethod::signmessage>(address, message);
 }
 
 Json::Value BitcoinClient::signRawTransactionWithWallet(const std::string& hexString, const Json::Value& prevTxs) {
-    Json::Value params = buildParams(hexString);
-    if (!prevTxs.isNull()) params.append(prevTxs);
-    return sendRequest("signrawtransactionwithwallet", params);
+    return call<RpcMethod::signrawtransactionwithwallet>(hexString, prevTxs);
 }
 
 Json::Value BitcoinClient::unloadWallet(const std::string& walletName) {
-    return sendRequest("unloadwallet", walletName.empty() ? Json::Value() : buildParams(walletName));
+    return call<RpcMethod::unloadwallet>(unlessEmpty(walletName));
 }
 
 Json::Value BitcoinClient::upgradeWallet(const std::string& walletName) {
-    return sendRequest("upgradewallet", walletName.empty() ? Json::Value() : buildParams(walletName));
+    return call<RpcMethod::upgradewallet>(unlessEmpty(walletName));
 }
 
 Json::Value BitcoinClient::walletCreateFundedPsbt(const std::vector<Json::Value>& inputs, const std::map<std::string, double>& outputs, int locktime, const Json::Value& options) {
-    Json::Value inputsArray;
-    for (const auto& input : inputs) inputsArray.append(input);
-
-    Json::Value outputsObj;
-    for (const auto& [addr, amt] : outputs) outputsObj[addr] = amt;
-
-    Json::Value params = buildParams(inputsArray, outputsObj, locktime);
-    if (!options.isNull()) params.append(options);
-    return sendRequest("walletcreatefundedpsbt", params);
+    return call<RpcMethod::walletcreatefundedpsbt>(inputs, outputs, locktime, options);
 }
 
 Json::Value BitcoinClient::walletLock() {
-    return sendRequest("walletlock");
+    return call<RpcMethod::walletlock>();
 }
 
 Json::Value BitcoinClient::walletPassphrase(const std::string& passphrase, int timeout) {
-    return sendRequest("walletpassphrase", buildParams(passphrase, timeout));
+    return call<RpcMethod::walletpassphrase>(passphrase, timeout);
 }
 
 Json::Value BitcoinClient::walletPassphraseChange(const std::string& oldPassphrase, const std::string& newPassphrase) {
-    return sendRequest("walletpassphrasechange", buildParams(oldPassphrase, newPassphrase));
+    return call<RpcMethod::walletpassphrasechange>(oldPassphrase, newPassphrase);
 }
 
 Json::Value BitcoinClient::walletProcessPsbt(const std::string& psbt, bool sign, bool sighashType, bool bip32derivs) {
-    return sendRequest("walletprocesspsbt", buildParams(psbt, sign, sighashType, bip32derivs));
+    return call<RpcMethod::walletprocesspsbt>(psbt, sign, sighashType, bip32derivs);
 }
@@ -15,12 +15,108 @@
 #endif
 
 
+#if __has_include("asyncengine.hpp")
+#   include "asyncengine.hpp"
+#else
+#   error "Bitcoin's \"asyncengine.hpp\" was not found!"
+#endif
+
+
+#if __has_include("jsonstream.hpp")
+#   include "jsonstream.hpp"
+#else
+#   error "Bitcoin's \"jsonstream.hpp\" was not found!"
+#endif
+
+
+#if __has_include("rpctypes.hpp")
+#   include "rpctypes.hpp"
+#else
+#   error "Bitcoin's \"rpctypes.hpp\" was not found!"
+#endif
+
+
+#if __has_include("responsecache.hpp")
+#   include "responsecache.hpp"
+#else
+#   error "Bitcoin's \"responsecache.hpp\" was not found!"
+#endif
+
+#if __has_include("responsearchive.hpp")
+#   include "responsearchive.hpp"
+#else
+#   error "Bitcoin's \"responsearchive.hpp\" was not found!"
+#endif
+
+
+#if __has_include("jsonwriter.hpp")
+#   include "jsonwriter.hpp"
+#else
+#   error "Bitcoin's \"jsonwriter.hpp\" was not found!"
+#endif
+
+
+#if __has_include("resilience.hpp")
+#   include "resilience.hpp"
+#else
+#   error "Bitcoin's \"resilience.hpp\" was not found!"
+#endif
+
+
+#if __has_include("coalescer.hpp")
+#   include "coalescer.hpp"
+#else
+#   error "Bitcoin's \"coalescer.hpp\" was not found!"
+#endif
+
+
+#if __has_include("admission.hpp")
+#   include "admission.hpp"
+#else
+#   error "Bitcoin's \"admission.hpp\" was not found!"
+#endif
+
+
+#if __has_include("metrics.hpp")
+#   include "metrics.hpp"
+#else
+#   error "Bitcoin's \"metrics.hpp\" was not found!"
+#endif
+
+
+#if __has_include("rawblock.hpp")
+#   include "rawblock.hpp"
+#else
+#   error "Bitcoin's \"rawblock.hpp\" was not found!"
+#endif
+
+
+#if __has_include("rpcmethods.hpp")
+#   include "rpcmethods.hpp"
+#else
+#   error "Bitcoin's \"rpcmethods.hpp\" was not found!"
+#endif
+
+
+#if __has_include("rpcbatch.hpp")
+#   include "rpcbatch.hpp"
+#else
+#   error "Bitcoin's \"rpcbatch.hpp\" was not found!"
+#endif
+
+
 #if __has_include(<json/json.h>)
 #   include <json/json.h>
 #else
 #   error "Bitcoin's <json/json.h> was not found!"
 #endif
 
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <optional>
+
 
 /**
  * @class BitcoinClient
@@ -29,28 +125,262 @@
  * This class provides methods to communicate with a Bitcoin node using JSON-RPC.
  * It supports various RPC methods for blockchain, control, generating, mining,
  * network, raw transactions, utility, and wallet operations.
+ *
+ * One client may be shared by any number of threads. The request path reads only
+ * immutable members (credentials, URL) and uses the calling thread's pooled connection,
+ * so concurrent requests do not contend with each other. Configuration calls
+ * (`enableCache`, `setResponseCache`, `setResponseArchive`, `enableCoalescing`, `setRequestCoalescer`, `setAsyncEngine`, `setTimeouts`, `setTransportSettings`, `setRetryPolicy`,
+ * `enableCircuitBreaker`, `enableAdmissionControl`, `setAdmissionControl`, `enableMetrics`, `setMetrics`) must happen
+ * before the client is shared.
  */
 class BitcoinClient {
 private:
-    std::string rpcUser;       ///< RPC username for authentication.
-    std::string rpcPassword;   ///< RPC password for authentication.
-    std::string rpcUrl;        ///< URL of the Bitcoin RPC server.
-    Network network;           ///< Network instance for handling HTTP requests.
+    const std::string rpcUser;       ///< RPC username for authentication.
+    const std::string rpcPassword;   ///< RPC password for authentication.
+    const std::string rpcUrl;        ///< URL of the Bitcoin RPC server.
+    Network network;                 ///< Network instance for handling HTTP requests.
+    std::shared_ptr<AsyncEngine> asyncEngine;       ///< Engine for asynchronous requests, created on first use.
+    std::once_flag asyncEngineOnce;                 ///< Guards the lazy creation of `asyncEngine`.
+    PoolSettings poolSettings;                      ///< Connection limits, also applied to the default async engine.
+    std::shared_ptr<ResponseCache> cache;           ///< Cache of immutable results; null when caching is disabled.
+    std::shared_ptr<ResponseArchive> archive;       ///< On-disk archive of block results, read before the node; null when not archiving.
+    std::shared_ptr<RequestCoalescer> coalescer;    ///< Shares answers between identical concurrent calls; null when disabled.
+    RetryPolicy retryPolicy;                        ///< Retries of failed synchronous requests.
+    std::shared_ptr<CircuitBreaker> breaker;        ///< Guards the node, shared with its wallet handles; null when disabled.
+    std::shared_ptr<AdmissionControl> admission;    ///< Limits and orders requests to the node, shared with its wallet handles; null when unlimited.
+    BitcoinClient* nodeClient = nullptr;            ///< The client a wallet handle was made from; null for node clients.
+    std::shared_ptr<Metrics> callMetrics;           ///< Receives call and transfer measurements; null when not collecting.
+
+    /**
+     * @brief Records a finished call in the metrics, if they are enabled.
+     *
+     * Calls that received a response take their server time from the thread's last transfer.
+     *
+     * @param method The RPC method, or "batch".
+     * @param started When the request was handed to the transport.
+     * @param failure Why the call failed, if it did.
+     * @param requestBytes Size of the serialized request.
+     * @param responseBytes Size of the response body.
+     */
+    void recordCall(std::string_view method, std::chrono::steady_clock::time_point started, CallFailure failure,
+                    std::size_t requestBytes, std::size_t responseBytes) const;
+
+    /**
+     * @brief Waits for admission of a request, in the lane of the thread's PriorityScope or the method's default.
+     * @param method The RPC method, or "batch".
+     * @param heavy Whether the request counts as a heavy call.
+     * @return The ticket; empty if the thread's deadline passed while waiting.
+     */
+    AdmissionControl::Ticket admitRequest(std::string_view method, bool heavy);
+
+    /**
+     * @brief Posts a serialized request, honouring admission control, the circuit breaker and the retry policy.
+     * @param method The RPC method (or "batch"), for logging.
+     * @param idempotent Whether the request may be repeated after it possibly reached the node.
+     * @param heavy Whether the request counts as a heavy call for admission control.
+     * @param payload The serialized request.
+     * @param[out] response The response body of the successful attempt.
+     * @return `TransferError::None` on success, or why the last attempt failed.
+     */
+    TransferError post(std::string_view method, bool idempotent, bool heavy, const std::string& payload, std::string& response);
+
+    /**
+     * @brief Builds an asynchronous request carrying the client's credentials and time limits.
+     * @param body The serialized request.
+     */
+    HttpPostRequest makeAsyncRequest(std::string body) const;
+
+    /**
+     * @brief Reserves `count` consecutive JSON-RPC ids.
+     *
+     * Ids only have to be unique within one HTTP exchange, so every thread counts on its own
+     * rather than all threads contending for one shared counter.
+     *
+     * @return The first reserved id.
+     */
+    static std::uint64_t reserveRequestIds(std::size_t count);
+
+    /**
+     * @brief Returns the calling thread's empty request buffer.
+     *
+     * Synchronous requests serialize into it, so a thread that keeps sending requests
+     * reuses one allocation. The buffer must not be held across another request.
+     */
+    static std::string& requestBuffer();
+
+    /**
+     * @brief Returns the calling thread's empty response buffer.
+     *
+     * Synchronous requests receive into it; together with the `Content-Length` presizing
+     * in Network, steady-state traffic stops growing a fresh string for every response.
+     * The buffer must not be held across another request.
+     */
+    static std::string& responseBuffer();
 
     /**
      * @brief Builds the JSON-RPC request payload.
      * @param method The RPC method to call.
      * @param params The parameters for the RPC method.
-     * @return A JSON-RPC formatted string.
+     * @return A compact JSON-RPC formatted string.
+     */
+    std::string buildRpcRequest(std::string_view method, const Json::Value& params);
+
+    /**
+     * @brief Sends a JSON-RPC request to the node, bypassing the response cache.
+     * @param method The RPC method to call.
+     * @param params The parameters for the RPC method.
+     * @return The `result` member, or a null value on failure.
+     */
+    Json::Value executeRequest(const std::string& method, const Json::Value& params);
+
+    /**
+     * @brief Answers a request from the response archive, or sends it and archives the result.
+     * @param method The RPC method to call.
+     * @param params The parameters for the RPC method.
+     * @return The `result` member, or a null value on failure (as `executeRequest`).
+     */
+    Json::Value fetchRequest(const std::string& method, const Json::Value& params);
+
+    /**
+     * @brief `fetchRequest`, shared with identical calls in flight when a coalescer is set.
+     * @param key The call's key, as `ResponseCache::makeKey` builds it; empty to build it here.
+     */
+    Json::Value coalesceRequest(const std::string& method, const Json::Value& params, const std::string& key);
+
+    /**
+     * @brief Sends a serialized JSON-RPC request and returns its result.
+     * @param method The RPC method, for logging.
+     * @param payload The serialized request.
+     * @param heavy Whether the request counts as a heavy call for admission control.
+     * @return The `result` member, or a null value on failure.
      */
-    std::string buildRpcRequest(const std::string& method, const Json::Value& params);
+    Json::Value executePayload(std::string_view method, const std::string& payload, bool heavy);
+
+    /**
+     * @brief The method name of an asynchronous request, kept until its response arrives.
+     *
+     * Names from the method table have static storage and are only referenced.
+     */
+    struct AsyncMethodName {
+        std::string_view interned;  ///< A method table name; empty if `owned` holds the name.
+        std::string owned;          ///< A name given at run time.
+
+        std::string_view view() const { return interned.empty() ? std::string_view(owned) : interned; }
+    };
+
+    /**
+     * @brief Hands a serialized single request to the async engine.
+     * @param request The request, body included.
+     * @param method The method, for logging and metrics.
+     * @return A future holding the `result` member, or a null value on failure.
+     */
+    std::future<Json::Value> submitAsync(HttpPostRequest request, AsyncMethodName method);
+
+    /**
+     * @brief Polls the best block if due and invalidates cached results that a reorg made stale.
+     * @param responseCache The cache to update.
+     */
+    void refreshCacheTip(ResponseCache& responseCache);
+
+    /**
+     * @brief Finds the last block of a former tip's chain that is still in the active chain.
+     * @param oldTip The previous best block.
+     * @param maxDepth The maximum number of blocks to walk back.
+     * @return The height of that block, or 0 if it could not be found.
+     */
+    std::int64_t findForkHeight(const ChainTip& oldTip, std::int64_t maxDepth);
+
+    /**
+     * @brief Parses a raw response body into a JSON document.
+     * @param response The raw JSON response from the server.
+     * @param[out] document The parsed document.
+     * @return `true` if the body is valid JSON; `false` otherwise.
+     */
+    static bool parseJson(const std::string& response, Json::Value& document);
 
     /**
      * @brief Parses the JSON-RPC response.
      * @param response The raw JSON response from the server.
+     * @param[out] failure If given, set to `CallFailure::Parse` or `CallFailure::Rpc` when there is no result.
      * @return A Json::Value object containing the parsed response.
      */
-    Json::Value parseRpcResponse(const std::string& response);
+    static Json::Value parseRpcResponse(const std::string& response, CallFailure* failure = nullptr);
+
+    /**
+     * @brief Builds a JSON-RPC error object for failures detected on the client side.
+     * @param code The JSON-RPC error code.
+     * @param message A human readable description.
+     * @return An object with `code` and `message` members.
+     */
+    static Json::Value makeRpcError(int code, const std::string& message);
+
+    /**
+     * @brief Serializes a batch, reserving one request id per call.
+     * @param batch The calls to serialize.
+     * @param[out] out The string the JSON-RPC batch payload is appended to.
+     * @return The id assigned to the first call; the others follow consecutively.
+     */
+    static std::uint64_t writeBatchRequest(const RpcBatch& batch, std::string& out);
+
+    /**
+     * @brief Matches a batch response back to its calls.
+     * @param success Whether the HTTP exchange succeeded.
+     * @param response The raw response body.
+     * @param count The number of calls in the batch.
+     * @param firstId The id of the first call.
+     * @return One RpcResult per call.
+     */
+    static std::vector<RpcResult> parseBatchResponse(bool success, const std::string& response, std::size_t count, std::uint64_t firstId);
+
+    /**
+     * @brief Returns the async engine, creating a private one on first use.
+     * Wallet handles use the engine of their node client.
+     */
+    AsyncEngine& engine();
+
+    /**
+     * @brief Creates a wallet handle of `node` that sends to `url`.
+     */
+    BitcoinClient(BitcoinClient& node, const std::string& url);
+
+    /**
+     * @brief Returns the endpoint of one wallet: the node URL followed by `/wallet/<name>`, the name percent-encoded.
+     */
+    std::string walletUrl(std::string_view name) const;
+
+    /**
+     * @brief Extracts the outcome of one call from a raw response body.
+     * @param[out] failure Set to the failure class for metrics.
+     */
+    static RpcResult parseCallResult(const std::string& response, CallFailure& failure);
+
+    /**
+     * @brief Sends one serialized request to several wallets at once on the async engine and waits for every answer.
+     * @return One RpcResult per wallet, in order.
+     */
+    std::vector<RpcResult> fanOut(const std::vector<std::string>& wallets, const std::string& body, const AsyncMethodName& method);
+
+    /**
+     * @brief Sends a request and decodes its result straight into a struct, without a JSON DOM.
+     * @tparam T A result struct with a matching `decodeField` overload.
+     * @param method The RPC method to call.
+     * @param params The parameters for the RPC method.
+     * @return The decoded result; empty on failure or when the result is null.
+     */
+    template<typename T>
+    std::optional<T> requestTyped(std::string_view method, const Json::Value& params) {
+        TypedResultDecoder<T> decoder;
+        if (!streamRequest(method, params, decoder)) return std::nullopt;
+        if (decoder.hasRpcError()) {
+            Logger::formattedError("RPC error: {} (code {})", decoder.rpcErrorMessage(), decoder.rpcErrorCode());
+            return std::nullopt;
+        }
+        if (decoder.isMalformed()) {
+            Logger::formattedError("Unexpected result for RPC method: {}", method);
+            return std::nullopt;
+        }
+        return decoder.take();
+    }
 
     /**
      * @brief Helper method to build a Json::Value array from variadic parameters.
@@ -71,17 +401,475 @@ public:
      * @param user RPC username.
      * @param password RPC password.
      * @param url RPC server URL (default: http://127.0.0.1:8332/).
+     * @param poolSize Maximum number of keep-alive connections to the server (default: 8).
+     * @param idleTimeout Time after which an unused pooled connection is closed (default: 60 s).
      */
-    BitcoinClient(const std::string& user, const std::string& password, const std::string& url = "http://127.0.0.1:8332/");
+    BitcoinClient(const std::string& user, const std::string& password, const std::string& url = "http://127.0.0.1:8332/",
+                  std::size_t poolSize = 8, std::chrono::seconds idleTimeout = std::chrono::seconds(60));
+
+    /**
+     * @brief Opens pooled keep-alive connections before the first calls need them.
+     *
+     * Sends `connections` concurrent `uptime` calls, which are cheap and need no wallet.
+     * Each call opens its own connection, and the node's address is resolved into the pool's
+     * DNS cache. The connections stay in the pool, so the first calls of later threads skip
+     * connection setup. libcurl itself is initialized when the client is constructed.
+     * Configure the client before warming it up; the calls are recorded in its metrics.
+     *
+     * @param connections Connections to open; capped at the pool size.
+     * @return The number of calls that succeeded.
+     */
+    std::size_t warmUp(std::size_t connections = 1);
 
     /**
      * @brief Sends a generic JSON-RPC request to the Bitcoin server.
+     *
+     * When a response cache is enabled, immutable hash-keyed calls (see ResponseCache) are
+     * answered from it when possible. Block calls the response archive holds (see
+     * ResponseArchive) are read from it before the node is asked. With coalescing enabled,
+     * a read-only call identical to one in flight waits for that call's answer (see
+     * RequestCoalescer).
+     *
      * @param method The RPC method to call.
      * @param params The parameters for the RPC method (default: empty).
      * @return A Json::Value object containing the response.
      */
     Json::Value sendRequest(const std::string& method, const Json::Value& params = Json::Value());
 
+    /**
+     * @brief Calls a method from the method table (`BITCOIN_RPC_METHODS`).
+     *
+     * The method name is escaped at compile time and the arguments are written straight into
+     * the thread's request buffer, so no Json::Value is built for the parameters. Methods with
+     * `RPC_IMMUTABLE` go through the response cache and archive when set, and `RPC_READ_ONLY`
+     * methods through the coalescer; `RPC_IDEMPOTENT`
+     * methods are retried according to the retry policy.
+     *
+     * @code
+     * Json::Value block = client.call<RpcMethod::getblock>(hash, 2);
+     * @endcode
+     *
+     * @tparam Method The method.
+     * @param args Parameters of the call, in positional order: scalars, strings, Json::Value,
+     *        vectors, string-keyed maps, or `std::optional` (empty is sent as null, which the
+     *        node treats as omitted).
+     * @return The `result` member, or a null value on failure (as `sendRequest`).
+     */
+    template<RpcMethod Method, typename... Args>
+    Json::Value call(const Args&... args) {
+        if constexpr ((rpcMethodTraits(Method) & RPC_IMMUTABLE) != 0) {
+            // Cache keys are built from Json::Value parameters.
+            if (cache || archive || coalescer) return sendRequest(std::string(rpcMethodName(Method)), toJsonParams(args...));
+        } else if constexpr ((rpcMethodTraits(Method) & RPC_READ_ONLY) != 0) {
+            // The archive also knows the hashes of deep blocks.
+            if (coalescer || (Method == RpcMethod::getblockhash && archive)) {
+                return sendRequest(std::string(rpcMethodName(Method)), toJsonParams(args...));
+            }
+        }
+        std::string& payload = requestBuffer();
+        JsonWriter(payload).rpcRequest(RpcMethodLiteral<Method>::value, reserveRequestIds(1), args...);
+        return executePayload(rpcMethodName(Method), payload, isHeavyCall<Method>(args...));
+    }
+
+    /**
+     * @brief Calls a method from the method table without blocking the calling thread.
+     * @tparam Method The method.
+     * @param args Parameters of the call, as for `call`.
+     * @return A future holding the `result` member, or a null value on failure.
+     */
+    template<RpcMethod Method, typename... Args>
+    std::future<Json::Value> callAsync(const Args&... args) {
+        HttpPostRequest request = makeAsyncRequest(std::string());
+        JsonWriter(request.body).rpcRequest(RpcMethodLiteral<Method>::value, reserveRequestIds(1), args...);
+        return submitAsync(std::move(request), AsyncMethodName {rpcMethodName(Method), {}});
+    }
+
+    /**
+     * @brief Calls a method listed in `BITCOIN_RPC_TYPED_RESULTS` and decodes its result into its struct.
+     * @tparam Method The method.
+     * @param args Parameters of the call, as for `call`.
+     * @return The decoded result; empty on failure or when the result is null.
+     */
+    template<RpcMethod Method, typename... Args>
+    std::optional<typename RpcTypedResult<Method>::type> callTyped(const Args&... args) {
+        return requestTyped<typename RpcTypedResult<Method>::type>(rpcMethodName(Method), toJsonParams(args...));
+    }
+
+    /**
+     * @brief Sends a JSON-RPC request and reports the outcome in full, bypassing the response cache.
+     *
+     * Unlike `sendRequest`, errors are returned rather than logged, and a null result can be
+     * told apart from a failure. Failures detected on the client side carry a JSON-RPC error
+     * with code -32603 (transport) or -32700 (parse) and set `transportFailure`.
+     *
+     * @param method The RPC method to call.
+     * @param params The parameters for the RPC method (default: empty).
+     * @return The result and error members of the response.
+     */
+    RpcResult sendCall(const std::string& method, const Json::Value& params = Json::Value());
+
+    /**
+     * @brief Sets the connect and total time limits of every request.
+     *
+     * A DeadlineScope around a call can shorten the limits further.
+     *
+     * @param timeouts The limits.
+     */
+    void setTimeouts(const RequestTimeouts& timeouts) { network.setTimeouts(timeouts); }
+
+    /**
+     * @brief Enables compressed responses, HTTP/2 or a Unix domain socket, for nodes behind a proxy.
+     *
+     * Compressed bodies are decoded as they arrive, so streaming and typed requests keep
+     * parsing incrementally. Asynchronous requests to one proxy are multiplexed over a
+     * single HTTP/2 connection when the proxy supports it. With `unixSocket` set, every
+     * request of this client, asynchronous ones included, goes through the socket; clients
+     * of other nodes keep their own settings.
+     *
+     * @param settings The wire-level options.
+     */
+    void setTransportSettings(const TransportSettings& settings) { network.setTransportSettings(settings); }
+
+    /**
+     * @brief Sets how synchronous requests are retried after transport failures (default: no retries).
+     *
+     * Retries stop early when the current DeadlineScope would expire during the backoff.
+     * Asynchronous and streaming requests are not retried.
+     *
+     * @param policy The retry policy.
+     */
+    void setRetryPolicy(const RetryPolicy& policy) { retryPolicy = policy; }
+
+    /**
+     * @brief Makes requests fail fast while the node keeps failing.
+     *
+     * Refused requests report `TransferError::CircuitOpen` as a transport failure.
+     *
+     * @param settings When the circuit opens and for how long.
+     */
+    void enableCircuitBreaker(const BreakerSettings& settings = {});
+
+    /**
+     * @brief Limits the requests this client has at the node at once, and lets interactive ones go first.
+     *
+     * Synchronous and streamed requests wait in a lane: the thread's PriorityScope, or the
+     * method's default (see `defaultPriority`); a batch takes the least urgent default of its
+     * calls, so a batch of broadcasts is Interactive. Asynchronous requests are bounded by the
+     * async engine's connection limit instead. A request whose deadline passes while it
+     * waits fails with `TransferError::TimedOut` without being sent.
+     *
+     * @param settings Concurrency caps and lane weights.
+     */
+    void enableAdmissionControl(const AdmissionSettings& settings = {});
+
+    /**
+     * @brief Makes this client use the given admission control; clients of the same node should share one.
+     * @param sharedAdmission The controller to use, or `nullptr` to send requests without waiting.
+     */
+    void setAdmissionControl(std::shared_ptr<AdmissionControl> sharedAdmission);
+
+    /**
+     * @brief Returns the admission control, or `nullptr` when requests are not limited.
+     */
+    std::shared_ptr<AdmissionControl> admissionControl() const { return admission; }
+
+    /**
+     * @brief Returns the circuit breaker, or `nullptr` when it is disabled.
+     */
+    const CircuitBreaker* circuitBreaker() const { return breaker.get(); }
+
+    /**
+     * @brief Enables an in-process cache of immutable results for `sendRequest`.
+     *
+     * Must be called before the client is used from several threads.
+     *
+     * @param settings Memory budget and freshness rules.
+     */
+    void enableCache(const CacheSettings& settings = {});
+
+    /**
+     * @brief Makes this client use the given cache; several clients of the same node may share one.
+     * @param sharedCache The cache to use, or `nullptr` to disable caching.
+     */
+    void setResponseCache(std::shared_ptr<ResponseCache> sharedCache);
+
+    /**
+     * @brief Returns the response cache, or `nullptr` when caching is disabled.
+     */
+    std::shared_ptr<ResponseCache> responseCache() const { return cache; }
+
+    /**
+     * @brief Makes this client read block results from an opened archive before asking the node.
+     *
+     * Misses are fetched from the node and, unless the archive is read-only, appended to it.
+     * Several clients, and later runs, may share one archive.
+     *
+     * @param sharedArchive The archive to use, or `nullptr` to stop archiving.
+     */
+    void setResponseArchive(std::shared_ptr<ResponseArchive> sharedArchive);
+
+    /**
+     * @brief Returns the response archive, or `nullptr` when not archiving.
+     */
+    std::shared_ptr<ResponseArchive> responseArchive() const { return archive; }
+
+    /**
+     * @brief Makes identical concurrent read-only calls share one request.
+     * @param settings How long a finished answer is still shared.
+     */
+    void enableCoalescing(const CoalesceSettings& settings = {});
+
+    /**
+     * @brief Makes this client use the given coalescer; only clients of the same node may share one.
+     * @param sharedCoalescer The coalescer to use, or `nullptr` to send every call.
+     */
+    void setRequestCoalescer(std::shared_ptr<RequestCoalescer> sharedCoalescer);
+
+    /**
+     * @brief Returns the request coalescer, or `nullptr` when coalescing is disabled.
+     */
+    std::shared_ptr<RequestCoalescer> requestCoalescer() const { return coalescer; }
+
+    /**
+     * @brief Starts collecting per-method call statistics and the transport statistics of this client.
+     */
+    void enableMetrics() { setMetrics(std::make_shared<Metrics>()); }
+
+    /**
+     * @brief Makes this client record into the given metrics; several clients may share one.
+     * @param sink The metrics to record into, or `nullptr` to stop collecting.
+     */
+    void setMetrics(std::shared_ptr<Metrics> sink);
+
+    /**
+     * @brief Returns the metrics, or `nullptr` when they are not collected.
+     */
+    std::shared_ptr<Metrics> metrics() const { return callMetrics; }
+
+    /**
+     * @brief Sends all calls of a batch to the Bitcoin server in a single HTTP request.
+     *
+     * Each call gets a unique id, and the responses are matched back to their calls by id,
+     * so the order in which the server answers does not matter. Errors are reported per call;
+     * if the whole request fails (transport or parse error), every result carries that error.
+     *
+     * @param batch The calls to send.
+     * @return One RpcResult per call, in the order the calls were added to the batch.
+     */
+    std::vector<RpcResult> sendBatch(const RpcBatch& batch);
+
+    /**
+     * @brief Sends a generic JSON-RPC request without blocking the calling thread.
+     *
+     * The request is performed by the client's AsyncEngine, which multiplexes all in-flight
+     * requests over a single I/O thread. The response is parsed on that thread.
+     *
+     * @param method The RPC method to call.
+     * @param params The parameters for the RPC method (default: empty).
+     * @return A future holding the `result` member, or a null value on failure (as `sendRequest`).
+     */
+    std::future<Json::Value> sendRequestAsync(const std::string& method, const Json::Value& params = Json::Value());
+
+    /**
+     * @brief Sends a generic JSON-RPC request asynchronously, building the parameters from the arguments.
+     * @tparam Args Types of the parameters.
+     * @param method The RPC method to call.
+     * @param args Parameters of the call, in positional order.
+     * @return A future holding the `result` member, or a null value on failure.
+     */
+    template<typename... Args>
+    std::future<Json::Value> callAsync(const std::string& method, Args&&... args) {
+        return sendRequestAsync(method, buildParams(std::forward<Args>(args)...));
+    }
+
+    /**
+     * @brief Sends a batch without blocking the calling thread.
+     * @param batch The calls to send.
+     * @return A future holding one RpcResult per call, as returned by `sendBatch`.
+     */
+    std::future<std::vector<RpcResult>> sendBatchAsync(const RpcBatch& batch);
+
+    /**
+     * @brief Makes asynchronous requests of this client run on the given engine.
+     *
+     * Sharing one engine between clients keeps all their requests on a single I/O thread.
+     * Must be called before the first asynchronous request; later calls have no effect.
+     *
+     * @param sharedEngine The engine to use.
+     */
+    void setAsyncEngine(std::shared_ptr<AsyncEngine> sharedEngine);
+
+           // Multiwallet
+    /**
+     * @brief Returns a client whose requests go to one wallet of a multiwallet node (`<url>/wallet/<name>`).
+     *
+     * Without it, wallet RPCs reach the node's base URL, which fails or picks the default wallet
+     * when several wallets are loaded. The handle shares this client's connection pool (wallet
+     * endpoints differ only in the path, so they reuse the same keep-alive connections), its
+     * async engine, response cache and archive, coalescer, metrics, circuit breaker, retry policy and time limits;
+     * configure this client first. Handles are cheap, so one may be kept per wallet.
+     *
+     * @code
+     * std::unique_ptr<BitcoinClient> alice = client.wallet("alice");
+     * Json::Value balances = alice->getBalances();
+     * @endcode
+     *
+     * @param name The wallet name, as given to `loadWallet`.
+     * @return The handle; it must not outlive this client.
+     */
+    std::unique_ptr<BitcoinClient> wallet(const std::string& name);
+
+    /**
+     * @brief Sends the same wallet call to several wallets concurrently and gathers the answers.
+     *
+     * The request is serialized once and posted to every wallet endpoint on the async engine,
+     * so N wallets cost one round trip of wall time, bounded by the connection limit per host
+     * rather than N sequential calls.
+     *
+     * @code
+     * std::vector<RpcResult> balances = client.callWallets<RpcMethod::getbalances>(names);
+     * std::vector<RpcResult> deltas = client.callWallets<RpcMethod::listsinceblock>(names, checkpoint);
+     * @endcode
+     *
+     * @tparam Method A method with the `RPC_WALLET` trait.
+     * @param wallets The wallet names.
+     * @param args Parameters of the call, as for `call`.
+     * @return One RpcResult per wallet, in order. Transport failures set `transportFailure`.
+     */
+    template<RpcMethod Method, typename... Args>
+    std::vector<RpcResult> callWallets(const std::vector<std::string>& wallets, const Args&... args) {
+        static_assert((rpcMethodTraits(Method) & RPC_WALLET) != 0, "callWallets needs a wallet method");
+        std::string body;
+        JsonWriter(body).rpcRequest(RpcMethodLiteral<Method>::value, reserveRequestIds(1), args...);
+        return fanOut(wallets, body, AsyncMethodName {rpcMethodName(Method), {}});
+    }
+
+    /**
+     * @brief Sends the same JSON-RPC request to several wallets concurrently, as `callWallets`.
+     * @param method The RPC method to call.
+     * @param wallets The wallet names.
+     * @param params The parameters for the RPC method.
+     * @return One RpcResult per wallet, in order.
+     */
+    std::vector<RpcResult> sendWalletCalls(const std::string& method, const std::vector<std::string>& wallets,
+                                           const Json::Value& params = Json::Value());
+
+    /**
+     * @brief Sends a JSON-RPC request and feeds the response to a SAX handler as it arrives.
+     *
+     * The response is never buffered or materialized: bytes received by curl go straight
+     * into a JsonStreamParser, which reports the whole JSON-RPC envelope
+     * (`{"result": ..., "error": ..., "id": ...}`) to `handler`.
+     *
+     * @param method The RPC method to call.
+     * @param params The parameters for the RPC method.
+     * @param handler Receives the parse events; returning `false` from any event aborts the transfer.
+     * @return `true` if the response was received and is well-formed JSON; `false` otherwise.
+     */
+    bool streamRequest(std::string_view method, const Json::Value& params, JsonHandler& handler);
+
+    /**
+     * @brief Sends a JSON-RPC request and delivers the elements of one container of the result one by one.
+     *
+     * Each element of the container at `path` (member names relative to `result`) is built
+     * on its own and passed to `onElement`, so the full result is never held in memory.
+     *
+     * @param method The RPC method to call.
+     * @param params The parameters for the RPC method.
+     * @param path Member names leading from `result` to the streamed container; empty streams `result` itself.
+     * @param onElement Receives each element (and its member name, for objects).
+     * @return The rest of the result, with the streamed container left empty; null on failure.
+     */
+    Json::Value streamResult(const std::string& method, const Json::Value& params,
+                             const std::vector<std::string>& path,
+                             const JsonElementStreamer::ElementCallback& onElement);
+
+    /**
+     * @brief Streams the decoded transactions of a block (`getblock <hash> 2`).
+     * @param blockHash The hash of the block.
+     * @param onTransaction Receives each transaction object; the key is empty.
+     * @return The block without its `tx` entries; null on failure.
+     */
+    Json::Value streamBlockTransactions(const std::string& blockHash, const JsonElementStreamer::ElementCallback& onTransaction);
+
+    /**
+     * @brief Streams the verbose mempool (`getrawmempool true`) one entry at a time.
+     * @param onEntry Receives each entry, with the txid as key.
+     * @return An empty object on success; null on failure.
+     */
+    Json::Value streamRawMempool(const JsonElementStreamer::ElementCallback& onEntry);
+
+           // Typed results
+    /**
+     * @brief Returns a block header as a fixed-layout struct (`getblockheader <hash> true`).
+     * @param blockHash The hash of the block.
+     * @return The header; empty on failure.
+     */
+    std::optional<BlockHeaderResult> getBlockHeaderTyped(const std::string& blockHash);
+
+    /**
+     * @brief Returns details about an unspent transaction output as a struct.
+     * @param txid The transaction ID.
+     * @param n The output index.
+     * @param includeMempool Whether to include the mempool (default: true).
+     * @return The output; empty if it is spent or unknown, or on failure.
+     */
+    std::optional<TxOutResult> getTxOutTyped(const std::string& txid, int n, bool includeMempool = true);
+
+    /**
+     * @brief Returns a mempool entry as a struct, with fees in satoshis.
+     * @param txid The transaction ID.
+     * @return The entry; empty on failure.
+     */
+    std::optional<MempoolEntryResult> getMempoolEntryTyped(const std::string& txid);
+
+    /**
+     * @brief Returns all statistics of a block as a struct.
+     * @param blockHash The hash of the block.
+     * @return The statistics; empty on failure.
+     */
+    std::optional<BlockStatsResult> getBlockStatsTyped(const std::string& blockHash);
+
+    /**
+     * @brief Returns a fee estimate as a struct, with the fee rate in satoshis per kvB.
+     * @param confTarget The confirmation target in blocks.
+     * @param estimateMode The estimate mode (default: "CONSERVATIVE").
+     * @return The estimate; empty on failure.
+     */
+    std::optional<SmartFeeResult> estimateSmartFeeTyped(int confTarget, const std::string& estimateMode = "CONSERVATIVE");
+
+    /**
+     * @brief Returns information about the blockchain as a struct.
+     * @return The information; empty on failure.
+     */
+    std::optional<BlockchainInfoResult> getBlockchainInfoTyped();
+
+           // Decoded raw data
+    /**
+     * @brief Fetches a block as hex (`getblock <hash> 0`) and decodes it locally.
+     *
+     * Cheaper for the node than verbosity 2, and the client decodes the binary form
+     * in place instead of parsing a JSON rendering several times larger.
+     *
+     * @param blockHash The hash of the block.
+     * @return The block; empty on failure.
+     */
+    std::optional<DecodedBlock> getBlockDecoded(const std::string& blockHash);
+
+    /**
+     * @brief Fetches a transaction as hex (`getrawtransaction <txid> false`) and decodes it locally.
+     * @param txid The transaction ID.
+     * @return The transaction; empty on failure.
+     */
+    std::optional<DecodedTransaction> getRawTransactionDecoded(const std::string& txid);
+
+    /**
+     * @brief Fetches many transactions in one batch request and decodes them locally.
+     * @param txids The transaction IDs.
+     * @return One entry per txid, in order; empty for transactions that could not be fetched or decoded.
+     */
+    std::vector<std::optional<DecodedTransaction>> getRawTransactionsDecoded(const std::vector<std::string>& txids);
+
            // Blockchain RPCs
     /**
      * @brief Returns the hash of the best (tip) block in the blockchain.
@@ -1015,11 +1803,11 @@ public:
 
     /**
      * @brief Sets the HD seed for the wallet.
-     * @param seed The seed to set (default: empty for a new seed).
-     * @param rescan If true, rescans the blockchain (default: true).
+     * @param seed The WIF private key to use as the seed (default: empty for a random seed).
+     * @param newKeypool If true, flushes the keypool so new addresses come from the new seed (default: true).
      * @return A Json::Value containing the result.
      */
-    Json::Value setHdSeed(const std::string& seed = "", bool rescan = true);
+    Json::Value setHdSeed(const std::string& seed = "", bool newKeypool = true);
 
     /**
      * @brief Sets a label for an address.
@@ -0,0 +1,171 @@
+#include "blockfetcher.hpp"
+#include "merkle.hpp"
+#include <algorithm>
+#include <format>
+#include <thread>
+#include <vector>
+
+namespace {
+/**
+ * @brief Decodes a hex block and checks it against the hash it was fetched by; logs failures.
+ */
+bool verifyRawBlock(const Json::Value& block, const std::string& hash, std::int64_t height) {
+    thread_local DecodedBlock decoded;
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    Hash256 expected;
+    if (!block.isString() || !block.getString(&begin, &end) || !parseHash(hash, expected)
+        || !decoded.decode(std::string_view(begin, static_cast<std::size_t>(end - begin)))) {
+        Logger::formattedError("Failed to decode block {} at height {}", hash, height);
+        return false;
+    }
+    const BlockCheck check = verifyBlock(decoded.view(), &expected);
+    if (check != BlockCheck::Valid) {
+        Logger::formattedError("Block {} at height {} failed verification: {}", hash, height, blockCheckName(check));
+        return false;
+    }
+    return true;
+}
+}
+
+BlockFetcher::BlockFetcher(BitcoinClient& client, const BlockFetchSettings& settings)
+    : client(client), fetchSettings(settings) {
+    fetchSettings.concurrency = std::max<std::size_t>(fetchSettings.concurrency, 1);
+    fetchSettings.hashBatchSize = std::max<std::size_t>(fetchSettings.hashBatchSize, 1);
+    if (fetchSettings.reorderWindow == 0) fetchSettings.reorderWindow = 2 * fetchSettings.concurrency;
+    fetchSettings.reorderWindow = std::max(fetchSettings.reorderWindow, fetchSettings.concurrency);
+}
+
+bool BlockFetcher::run(std::int64_t from, std::int64_t to, const BlockConsumer& consume) {
+    resumeHeight = from;
+    if (from > to) return true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        lastHeight = to;
+        nextClaim = nextDeliver = from;
+        hashes.clear();
+        ready.clear();
+        hashLookupRunning = stopping = failed = false;
+    }
+
+    const std::size_t workerCount = std::min<std::size_t>(fetchSettings.concurrency, static_cast<std::size_t>(to - from + 1));
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < workerCount; ++i) workers.emplace_back(&BlockFetcher::work, this);
+
+    std::string previousHash;
+    bool completed = true;
+    for (std::int64_t height = from; height <= to; ++height) {
+        Json::Value block;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            stateChanged.wait(lock, [&] { return ready.count(height) != 0 || failed; });
+            auto found = ready.find(height);
+            if (found == ready.end()) {
+                completed = false;
+                break;
+            }
+            block = std::move(found->second);
+            ready.erase(found);
+            nextDeliver = height + 1;
+        }
+        stateChanged.notify_all();
+
+        if (block.isObject()) {
+            // Hashes were looked up by height: a reorg during the walk shows up as a broken link.
+            if (!previousHash.empty() && block["previousblockhash"].asString() != previousHash) {
+                Logger::formattedError("Chain reorganized at height {} while fetching blocks", height);
+                completed = false;
+                break;
+            }
+            previousHash = block["hash"].asString();
+        }
+
+        if (!consume(height, std::move(block))) {
+            resumeHeight = height + 1;
+            completed = false;
+            break;
+        }
+        resumeHeight = height + 1;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    stateChanged.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    ready.clear();
+    return completed;
+}
+
+void BlockFetcher::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // Backpressure: never run more than the reorder window ahead of the consumer.
+        stateChanged.wait(lock, [&] {
+            return stopping || nextClaim > lastHeight
+                || (nextClaim < nextDeliver + static_cast<std::int64_t>(fetchSettings.reorderWindow)
+                    && (!hashes.empty() || !hashLookupRunning));
+        });
+        if (stopping || nextClaim > lastHeight) return;
+
+        if (hashes.empty()) {
+            hashLookupRunning = true;
+            const std::int64_t first = nextClaim;
+            const std::size_t count = std::min<std::size_t>(fetchSettings.hashBatchSize, static_cast<std::size_t>(lastHeight - first + 1));
+            std::deque<std::string> fetched;
+            lock.unlock();
+            const bool success = fetchHashes(first, count, fetched);
+            lock.lock();
+            hashLookupRunning = false;
+            if (!success) {
+                failed = stopping = true;
+                stateChanged.notify_all();
+                return;
+            }
+            hashes = std::move(fetched);
+            stateChanged.notify_all();
+            continue;
+        }
+
+        const std::int64_t height = nextClaim++;
+        const std::string hash = std::move(hashes.front());
+        hashes.pop_front();
+        lock.unlock();
+
+        Json::Value params(Json::arrayValue);
+        params.append(hash);
+        params.append(fetchSettings.verbosity);
+        Json::Value block = client.sendRequest("getblock", params);
+        bool usable = !block.isNull();
+        if (!usable) {
+            Logger::formattedError("Failed to fetch block {} at height {}", hash, height);
+        } else if (fetchSettings.verifyRawBlocks && fetchSettings.verbosity == 0) {
+            usable = verifyRawBlock(block, hash, height);
+        }
+
+        lock.lock();
+        if (!usable) {
+            failed = stopping = true;
+            stateChanged.notify_all();
+            return;
+        }
+        ready.emplace(height, std::move(block));
+        stateChanged.notify_all();
+    }
+}
+
+bool BlockFetcher::fetchHashes(std::int64_t first, std::size_t count, std::deque<std::string>& out) {
+    RpcBatch batch;
+    for (std::size_t i = 0; i < count; ++i) batch.call("getblockhash", Json::Int64(first + static_cast<std::int64_t>(i)));
+
+    for (RpcResult& result : client.sendBatch(batch)) {
+        if (!result.ok() || !result.result.isString()) {
+            Logger::formattedError("Failed to look up block hashes from height {}", first);
+            return false;
+        }
+        out.push_back(result.result.asString());
+    }
+    return out.size() == count;
+}
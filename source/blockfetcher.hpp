@@ -0,0 +1,117 @@
+#ifndef BLOCKFETCHER_HPP
+#define BLOCKFETCHER_HPP
+
+#if __has_include("bitcoinclient.hpp")
+#   include "bitcoinclient.hpp"
+#else
+#   error "Bitcoin's \"bitcoinclient.hpp\" was not found!"
+#endif
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/**
+ * @struct BlockFetchSettings
+ * @brief Parallelism and memory bounds of a BlockFetcher.
+ */
+struct BlockFetchSettings {
+    std::size_t concurrency = 8;        ///< Blocks fetched at the same time; keep at or below the client's pool size.
+    std::size_t hashBatchSize = 500;    ///< `getblockhash` calls sent per batch.
+    std::size_t reorderWindow = 0;      ///< Blocks fetched or buffered ahead of the consumer; 0 means `2 * concurrency`.
+    int verbosity = 2;                  ///< `getblock` verbosity (0: hex, 1: txids, 2: decoded transactions, 3: with prevouts).
+    bool verifyRawBlocks = false;       ///< With verbosity 0, check each block's hash, merkle root and witness commitment locally.
+};
+
+/**
+ * @class BlockFetcher
+ * @brief Walks a range of heights, fetching blocks in parallel and delivering them in order.
+ *
+ * Block hashes are looked up with batched `getblockhash` calls; blocks are then fetched by
+ * `concurrency` worker threads over the client's pooled connections, and parsed on those
+ * threads. Blocks that arrive early wait in a reorder buffer, so the consumer always sees
+ * consecutive heights. Workers never run more than `reorderWindow` blocks ahead of the
+ * consumer: a slow consumer throttles the fetch instead of growing the buffer.
+ *
+ * With verbosity 1 or more, each block is checked to extend the previously delivered one;
+ * a mismatch (the chain reorganized during the walk) stops the run, as does any failed
+ * request. With verbosity 0 and `verifyRawBlocks`, workers instead decode each block and
+ * check it against the hash it was fetched by (see `verifyBlock`), so its txids and
+ * contents can be trusted without further requests; a block that fails stops the run.
+ *
+ * @code
+ * BlockFetcher fetcher(client);
+ * fetcher.run(0, 100000, [](std::int64_t height, Json::Value&& block) {
+ *     index(height, block);
+ *     return true;
+ * });
+ * @endcode
+ */
+class BlockFetcher {
+public:
+    /**
+     * @brief Receives one block; returning `false` stops the run.
+     * @param height The height of the block.
+     * @param block The result of `getblock`.
+     */
+    using BlockConsumer = std::function<bool(std::int64_t height, Json::Value&& block)>;
+
+    /**
+     * @brief Creates a fetcher.
+     * @param client The client to fetch with; must outlive the fetcher.
+     * @param settings Parallelism and memory bounds.
+     */
+    explicit BlockFetcher(BitcoinClient& client, const BlockFetchSettings& settings = {});
+
+    /**
+     * @brief Fetches the blocks at heights `[from, to]` and hands them to `consume` in height order.
+     *
+     * Blocks until the range is delivered, the consumer stops, or a request fails.
+     * The consumer runs on the calling thread.
+     *
+     * @param from The first height.
+     * @param to The last height (inclusive).
+     * @param consume Receives the blocks.
+     * @return `true` if every block was delivered; `false` otherwise.
+     */
+    bool run(std::int64_t from, std::int64_t to, const BlockConsumer& consume);
+
+    /**
+     * @brief Returns the height of the next block the last run would have delivered.
+     *
+     * After a failed or stopped run, this is where a new run can resume.
+     */
+    std::int64_t nextHeight() const { return resumeHeight; }
+
+private:
+    /**
+     * @brief Claims heights, fetches their blocks and stores them in the reorder buffer.
+     */
+    void work();
+
+    /**
+     * @brief Looks up the hashes of the next heights; called without holding `mutex`.
+     * @return `false` if the lookup failed.
+     */
+    bool fetchHashes(std::int64_t first, std::size_t count, std::deque<std::string>& out);
+
+    BitcoinClient& client;                      ///< Client used for all requests.
+    BlockFetchSettings fetchSettings;           ///< Parallelism and memory bounds.
+    std::int64_t resumeHeight = 0;              ///< First height not delivered by the last run.
+
+    std::mutex mutex;                           ///< Guards the run state below.
+    std::condition_variable stateChanged;       ///< Signals claims, arrivals, deliveries and stops.
+    std::int64_t lastHeight = 0;                ///< Last height of the current run.
+    std::int64_t nextClaim = 0;                 ///< Next height to be fetched.
+    std::int64_t nextDeliver = 0;               ///< Next height to be consumed.
+    std::deque<std::string> hashes;             ///< Hashes of the heights from `nextClaim` on.
+    bool hashLookupRunning = false;             ///< A worker is fetching the next hashes.
+    std::map<std::int64_t, Json::Value> ready;  ///< Blocks fetched but not consumed yet.
+    bool stopping = false;                      ///< The run failed or was stopped.
+    bool failed = false;                        ///< A request failed.
+};
+
+#endif // BLOCKFETCHER_HPP
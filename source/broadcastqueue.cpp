@@ -0,0 +1,241 @@
+#include "broadcastqueue.hpp"
+#include "rawblock.hpp"
+#include "merkle.hpp"
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <unordered_set>
+
+namespace {
+constexpr std::size_t MAX_PACKAGE_COUNT = 25;           ///< Most transactions `testmempoolaccept` takes at once.
+constexpr std::size_t MAX_PACKAGE_WEIGHT = 404000;      ///< Largest total weight `testmempoolaccept` takes at once.
+
+/**
+ * @brief Checks whether a rejection only means the node has the transaction already.
+ */
+bool alreadyKnown(std::string_view reason) {
+    return reason == "txn-already-in-mempool" || reason == "txn-already-known";
+}
+}
+
+std::size_t BroadcastQueue::TxidHash::operator()(const Hash256& txid) const {
+    std::size_t bits;
+    std::memcpy(&bits, txid.data(), sizeof(bits));
+    return bits;
+}
+
+BroadcastQueue::BroadcastQueue(BitcoinClient& client, const BroadcastSettings& settings)
+    : client(client), broadcastSettings(settings) {
+    broadcastSettings.workers = std::max<std::size_t>(broadcastSettings.workers, 1);
+    broadcastSettings.chunkSize = std::clamp<std::size_t>(broadcastSettings.chunkSize, 1, MAX_PACKAGE_COUNT);
+    if (broadcastSettings.maxFeeRate > 0) {
+        maxFeeRate = std::format("{}.{:08}", broadcastSettings.maxFeeRate / COIN, broadcastSettings.maxFeeRate % COIN);
+    }
+    workers.reserve(broadcastSettings.workers);
+    for (std::size_t i = 0; i < broadcastSettings.workers; ++i) workers.emplace_back(&BroadcastQueue::workerLoop, this);
+}
+
+BroadcastQueue::~BroadcastQueue() {
+    stop();
+}
+
+std::future<BroadcastResult> BroadcastQueue::submit(std::string hex) {
+    std::vector<std::string> hexes;
+    hexes.push_back(std::move(hex));
+    return std::move(submit(std::move(hexes)).front());
+}
+
+std::vector<std::future<BroadcastResult>> BroadcastQueue::submit(std::vector<std::string> hexes) {
+    std::vector<std::future<BroadcastResult>> results;
+    results.reserve(hexes.size());
+    std::vector<std::unique_ptr<Job>> jobs;
+    jobs.reserve(hexes.size());
+    for (std::string& hex : hexes) {
+        auto job = std::make_unique<Job>();
+        results.push_back(job->promise.get_future());
+        if (prepare(*job, std::move(hex))) jobs.push_back(std::move(job));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!stopping) {
+            for (std::unique_ptr<Job>& job : jobs) {
+                ++unsettled[job->txid];
+                queue.push_back(std::move(job));
+            }
+            unsettledCount += jobs.size();
+            jobs.clear();
+        }
+    }
+    for (std::unique_ptr<Job>& job : jobs) deliver(*job, {job->txid, BroadcastStatus::Failed, "broadcast queue stopped"});
+    workAvailable.notify_all();
+    return results;
+}
+
+bool BroadcastQueue::prepare(Job& job, std::string hex) {
+    thread_local DecodedTransaction decoded;
+    if (!decoded.decode(hex)) {
+        deliver(job, {{}, BroadcastStatus::Invalid, "not a valid serialized transaction"});
+        return false;
+    }
+    const TxView& tx = decoded.view();
+    job.txid = computeTxid(tx);
+    job.parents.reserve(tx.inputs.size());
+    for (const TxInView& input : tx.inputs) job.parents.push_back(input.prevTxid);
+    std::sort(job.parents.begin(), job.parents.end());
+    job.parents.erase(std::unique(job.parents.begin(), job.parents.end()), job.parents.end());
+    // Version and lock time belong to the base size, like the inputs and outputs.
+    job.weight = (tx.ioBytes.size() + 8) * 3 + tx.raw.size();
+    job.hex = std::move(hex);
+    return true;
+}
+
+void BroadcastQueue::flush() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    chunkSettled.wait(lock, [this] { return unsettledCount == 0; });
+}
+
+std::size_t BroadcastQueue::pending() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return unsettledCount;
+}
+
+void BroadcastQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+
+    std::deque<std::unique_ptr<Job>> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        abandoned.swap(queue);
+        unsettled.clear();
+        unsettledCount = 0;
+    }
+    for (std::unique_ptr<Job>& job : abandoned) deliver(*job, {job->txid, BroadcastStatus::Failed, "broadcast queue stopped"});
+    chunkSettled.notify_all();
+}
+
+BroadcastQueue::Chunk BroadcastQueue::takeChunk() {
+    Chunk chunk;
+    std::unordered_set<Hash256, TxidHash> inChunk;
+    std::size_t weight = 0;
+    for (auto job = queue.begin(); job != queue.end() && chunk.size() < broadcastSettings.chunkSize;) {
+        // A parent still queued or in flight elsewhere has to reach the node first.
+        const bool waits = std::any_of((*job)->parents.begin(), (*job)->parents.end(), [&](const Hash256& parent) {
+            return unsettled.contains(parent) && !inChunk.contains(parent);
+        });
+        if (waits || (!chunk.empty() && weight + (*job)->weight > MAX_PACKAGE_WEIGHT)) {
+            ++job;
+            continue;
+        }
+        weight += (*job)->weight;
+        inChunk.insert((*job)->txid);
+        chunk.push_back(std::move(*job));
+        job = queue.erase(job);
+    }
+    return chunk;
+}
+
+void BroadcastQueue::workerLoop() {
+    while (true) {
+        Chunk chunk;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            workAvailable.wait(lock, [&] {
+                if (stopping) return true;
+                chunk = takeChunk();
+                return !chunk.empty();
+            });
+            if (chunk.empty()) return;
+        }
+        process(chunk);
+    }
+}
+
+void BroadcastQueue::process(Chunk& chunk) {
+    Logger::formattedDebug("Broadcasting a chunk of {} transactions", chunk.size());
+    std::vector<std::optional<BroadcastResult>> results(chunk.size());
+    if (broadcastSettings.validate) validate(chunk, results);
+    send(chunk, results);
+    settle(chunk, results);
+}
+
+void BroadcastQueue::validate(const Chunk& chunk, std::vector<std::optional<BroadcastResult>>& results) {
+    std::vector<std::string_view> hexes;
+    hexes.reserve(chunk.size());
+    for (const std::unique_ptr<Job>& job : chunk) hexes.push_back(job->hex);
+
+    const RpcResult answer = client.sendCall("testmempoolaccept", toJsonParams(hexes, maxFeeRate));
+    if (answer.transportFailure) {
+        for (std::size_t i = 0; i < chunk.size(); ++i) {
+            results[i] = BroadcastResult {chunk[i]->txid, BroadcastStatus::Failed, answer.error["message"].asString()};
+        }
+        return;
+    }
+    // The node refused the chunk as a whole; `sendrawtransaction` then judges each transaction.
+    if (!answer.ok() || !answer.result.isArray() || answer.result.size() != chunk.size()) return;
+
+    for (std::size_t i = 0; i < chunk.size(); ++i) {
+        const Json::Value& entry = answer.result[static_cast<Json::ArrayIndex>(i)];
+        // Without `allowed` the transaction was not judged on its own, e.g. after a package error.
+        if (!entry.isMember("allowed") || entry["allowed"].asBool()) continue;
+        const std::string reason = entry["reject-reason"].asString();
+        if (alreadyKnown(reason)) {
+            results[i] = BroadcastResult {chunk[i]->txid, BroadcastStatus::Accepted, {}};
+        } else {
+            results[i] = BroadcastResult {chunk[i]->txid, BroadcastStatus::Rejected, reason};
+        }
+    }
+}
+
+void BroadcastQueue::send(const Chunk& chunk, std::vector<std::optional<BroadcastResult>>& results) {
+    RpcBatch batch;
+    std::vector<std::size_t> sent;
+    for (std::size_t i = 0; i < chunk.size(); ++i) {
+        if (results[i]) continue;
+        batch.call<RpcMethod::sendrawtransaction>(std::string_view(chunk[i]->hex), maxFeeRate);
+        sent.push_back(i);
+    }
+    if (batch.empty()) return;
+
+    // The node runs the calls of a batch in order, so parents still go first.
+    const std::vector<RpcResult> answers = client.sendBatch(batch);
+    for (std::size_t k = 0; k < sent.size(); ++k) {
+        const std::size_t i = sent[k];
+        const RpcResult& answer = answers[k];
+        if (answer.ok()) {
+            results[i] = BroadcastResult {chunk[i]->txid, BroadcastStatus::Accepted, {}};
+        } else if (answer.transportFailure) {
+            results[i] = BroadcastResult {chunk[i]->txid, BroadcastStatus::Failed, answer.error["message"].asString()};
+        } else {
+            results[i] = BroadcastResult {chunk[i]->txid, BroadcastStatus::Rejected, answer.error["message"].asString(),
+                                          answer.error["code"].asInt()};
+        }
+    }
+}
+
+void BroadcastQueue::settle(Chunk& chunk, std::vector<std::optional<BroadcastResult>>& results) {
+    for (std::size_t i = 0; i < chunk.size(); ++i) deliver(*chunk[i], std::move(*results[i]));
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        for (const std::unique_ptr<Job>& job : chunk) {
+            const auto count = unsettled.find(job->txid);
+            if (count != unsettled.end() && --count->second == 0) unsettled.erase(count);
+        }
+        unsettledCount -= std::min(unsettledCount, chunk.size());
+    }
+    // Children of this chunk may be ready now.
+    workAvailable.notify_all();
+    chunkSettled.notify_all();
+}
+
+void BroadcastQueue::deliver(Job& job, BroadcastResult result) const {
+    if (broadcastSettings.onResult) broadcastSettings.onResult(result);
+    job.promise.set_value(std::move(result));
+}
@@ -0,0 +1,204 @@
+#ifndef BROADCASTQUEUE_HPP
+#define BROADCASTQUEUE_HPP
+
+#if __has_include("bitcoinclient.hpp")
+#   include "bitcoinclient.hpp"
+#else
+#   error "Bitcoin's \"bitcoinclient.hpp\" was not found!"
+#endif
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+
+/**
+ * @enum BroadcastStatus
+ * @brief What became of a queued transaction.
+ */
+enum class BroadcastStatus : std::uint8_t {
+    Accepted,   ///< In the node's mempool, sent now or already there.
+    Rejected,   ///< Refused by the node's policy or consensus rules; `reason` tells why.
+    Invalid,    ///< Not a decodable transaction; never sent.
+    Failed      ///< The node did not answer; the transaction may or may not have reached it.
+};
+
+/**
+ * @struct BroadcastResult
+ * @brief The outcome of one queued transaction.
+ */
+struct BroadcastResult {
+    Hash256 txid {};                                ///< Internal byte order; zero for invalid transactions.
+    BroadcastStatus status = BroadcastStatus::Failed;
+    std::string reason;                             ///< `reject-reason` or the error message; empty when accepted.
+    int code = 0;                                   ///< JSON-RPC error code of a refused `sendrawtransaction`; 0 otherwise.
+};
+
+/**
+ * @struct BroadcastSettings
+ * @brief How a BroadcastQueue submits its transactions.
+ */
+struct BroadcastSettings {
+    std::size_t workers = 4;                        ///< Threads submitting chunks at the same time, each on its own pooled connection.
+    std::size_t chunkSize = 25;                     ///< Transactions per chunk; `testmempoolaccept` takes at most 25.
+    bool validate = true;                           ///< Check each chunk with `testmempoolaccept` first; rejected transactions are not sent.
+    Amount maxFeeRate = 0;                          ///< Highest fee rate accepted, in satoshis per kvB; 0 keeps the node's default.
+    std::function<void(const BroadcastResult&)> onResult;   ///< Also receives every result, on a worker thread.
+};
+
+/**
+ * @class BroadcastQueue
+ * @brief Submits bursts of raw transactions in chunks, on several connections, with a result per transaction.
+ *
+ * Sending thousands of transactions with one blocking `sendrawtransaction` each makes
+ * throughput a function of the round-trip time. The queue instead groups transactions into
+ * chunks, checks a chunk with one `testmempoolaccept` call, and sends the transactions it
+ * allows in one JSON-RPC batch. Several workers handle chunks at the same time.
+ *
+ * Transactions are decoded locally when queued, so the queue knows their txids and the
+ * outputs they spend. A transaction is only put into a chunk once every queued parent is
+ * settled or sits earlier in the same chunk; the node then always sees parents first,
+ * whatever order they were queued in. Within a chunk, `testmempoolaccept` evaluates parents
+ * and children together as a package.
+ *
+ * Every transaction gets its result through the future returned by `submit()` and, if set,
+ * `onResult`. Errors are reported rather than logged.
+ *
+ * @code
+ * BroadcastQueue broadcaster(client);
+ * std::vector<std::future<BroadcastResult>> results = broadcaster.submit(std::move(payouts));
+ * for (auto& result : results) {
+ *     const BroadcastResult outcome = result.get();
+ *     if (outcome.status != BroadcastStatus::Accepted) retryLater(outcome.txid, outcome.reason);
+ * }
+ * @endcode
+ */
+class BroadcastQueue {
+public:
+    /**
+     * @brief Starts the workers.
+     * @param client The client used for all requests; must outlive the queue.
+     * @param settings How transactions are submitted.
+     */
+    explicit BroadcastQueue(BitcoinClient& client, const BroadcastSettings& settings = {});
+    BroadcastQueue(const BroadcastQueue&) = delete;
+    BroadcastQueue& operator=(const BroadcastQueue&) = delete;
+
+    /**
+     * @brief Stops the workers, as `stop()`.
+     */
+    ~BroadcastQueue();
+
+    /**
+     * @brief Queues one raw transaction.
+     * @param hex The serialized transaction, as `sendrawtransaction` takes it.
+     * @return A future holding the result once the transaction is settled.
+     */
+    std::future<BroadcastResult> submit(std::string hex);
+
+    /**
+     * @brief Queues several raw transactions at once.
+     * @return One future per transaction, in order.
+     */
+    std::vector<std::future<BroadcastResult>> submit(std::vector<std::string> hexes);
+
+    /**
+     * @brief Blocks until every transaction queued so far is settled.
+     */
+    void flush();
+
+    /**
+     * @brief Returns the number of transactions not settled yet.
+     */
+    std::size_t pending() const;
+
+    /**
+     * @brief Lets the workers finish their chunks and stops them; transactions still queued fail.
+     */
+    void stop();
+
+private:
+    struct TxidHash {
+        std::size_t operator()(const Hash256& txid) const;  ///< Txids are uniformly distributed already.
+    };
+
+    /**
+     * @struct Job
+     * @brief One queued transaction.
+     */
+    struct Job {
+        std::string hex;
+        Hash256 txid {};
+        std::vector<Hash256> parents;               ///< Distinct txids of the outputs it spends.
+        std::size_t weight = 0;                     ///< Weight units, for the package limit of `testmempoolaccept`.
+        std::promise<BroadcastResult> promise;
+    };
+
+    using Chunk = std::vector<std::unique_ptr<Job>>;
+
+    /**
+     * @brief Decodes a transaction into its job, or settles the job as invalid.
+     * @return `false` if the job was settled.
+     */
+    bool prepare(Job& job, std::string hex);
+
+    /**
+     * @brief Moves the next ready transactions out of the queue; `queueMutex` must be held.
+     * @return An empty chunk if every queued transaction waits for a parent in flight.
+     */
+    Chunk takeChunk();
+
+    /**
+     * @brief Validates and sends one chunk, then settles its transactions.
+     */
+    void process(Chunk& chunk);
+
+    /**
+     * @brief Runs `testmempoolaccept` on a chunk.
+     * @param[out] results Set for the transactions that are settled by the check already.
+     */
+    void validate(const Chunk& chunk, std::vector<std::optional<BroadcastResult>>& results);
+
+    /**
+     * @brief Sends the transactions of a chunk that have no result yet, in one batch.
+     */
+    void send(const Chunk& chunk, std::vector<std::optional<BroadcastResult>>& results);
+
+    /**
+     * @brief Hands out the results and unblocks the children of the chunk.
+     */
+    void settle(Chunk& chunk, std::vector<std::optional<BroadcastResult>>& results);
+
+    /**
+     * @brief Fulfils the promise of one job and reports the result to `onResult`.
+     */
+    void deliver(Job& job, BroadcastResult result) const;
+
+    /**
+     * @brief Body of a worker thread.
+     */
+    void workerLoop();
+
+    BitcoinClient& client;                      ///< Client used for all requests.
+    BroadcastSettings broadcastSettings;        ///< Submission rules.
+    std::optional<std::string> maxFeeRate;      ///< `maxfeerate` in BTC/kvB, or null for the node's default.
+
+    mutable std::mutex queueMutex;              ///< Guards the members below.
+    std::condition_variable workAvailable;      ///< Wakes the workers.
+    std::condition_variable chunkSettled;       ///< Wakes `flush()`.
+    std::deque<std::unique_ptr<Job>> queue;     ///< Transactions not in a chunk yet, in submission order.
+    std::unordered_map<Hash256, std::size_t, TxidHash> unsettled;   ///< Queued or in-flight transactions per txid.
+    std::size_t unsettledCount = 0;             ///< Queued or in-flight transactions.
+    bool stopping = false;                      ///< Stops the workers.
+    std::vector<std::thread> workers;           ///< Worker threads.
+};
+
+#endif // BROADCASTQUEUE_HPP
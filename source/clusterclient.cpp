@@ -0,0 +1,187 @@
+#include "clusterclient.hpp"
+#include <algorithm>
+#include <format>
+
+namespace {
+constexpr int RPC_CLIENT_TRANSPORT_ERROR = -32603;  ///< No node could be reached.
+constexpr std::int64_t LATENCY_SMOOTHING = 8;       ///< Weight of the history in the latency moving average.
+
+RpcResult unavailable() {
+    RpcResult outcome;
+    outcome.error["code"] = RPC_CLIENT_TRANSPORT_ERROR;
+    outcome.error["message"] = "No node of the cluster answered";
+    outcome.transportFailure = true;
+    return outcome;
+}
+}
+
+BitcoinClusterClient::BitcoinClusterClient(const std::vector<ClusterNode>& nodes, const ClusterSettings& settings)
+    : clusterSettings(settings) {
+    if (nodes.empty()) Logger::error("BitcoinClusterClient needs at least one node");
+    for (const ClusterNode& node : nodes) {
+        auto member = std::make_unique<Member>();
+        member->url = node.url;
+        member->client = std::make_unique<BitcoinClient>(node.user, node.password, node.url,
+                                                         clusterSettings.poolSize, clusterSettings.idleTimeout);
+        member->client->setTimeouts(clusterSettings.timeouts);
+        members.push_back(std::move(member));
+    }
+
+    checkHealth();
+    if (clusterSettings.healthCheckInterval.count() > 0) {
+        healthThread = std::thread(&BitcoinClusterClient::healthLoop, this);
+    }
+}
+
+BitcoinClusterClient::~BitcoinClusterClient() {
+    {
+        std::lock_guard<std::mutex> lock(healthMutex);
+        stopping = true;
+    }
+    healthWake.notify_all();
+    if (healthThread.joinable()) healthThread.join();
+}
+
+void BitcoinClusterClient::recordOutcome(Member& member, bool transportFailure, std::chrono::steady_clock::duration elapsed) {
+    if (transportFailure) {
+        const std::uint32_t failures = member.failures.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (failures >= clusterSettings.failureThreshold && member.healthy.exchange(false)) {
+            Logger::formattedWarning("Node {} taken out of rotation after {} failures", member.url, failures);
+        }
+        return;
+    }
+
+    member.failures.store(0, std::memory_order_relaxed);
+    // Concurrent updates may overwrite each other; the average only needs to be roughly right.
+    const std::int64_t sample = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    const std::int64_t average = member.latencyMicros.load(std::memory_order_relaxed);
+    member.latencyMicros.store(average == 0 ? std::max<std::int64_t>(sample, 1)
+                                            : average + (sample - average) / LATENCY_SMOOTHING,
+                               std::memory_order_relaxed);
+}
+
+RpcResult BitcoinClusterClient::callOn(Member& member, const std::string& method, const Json::Value& params) {
+    member.outstanding.fetch_add(1, std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    RpcResult outcome = member.client->sendCall(method, params);
+    member.outstanding.fetch_sub(1, std::memory_order_relaxed);
+    recordOutcome(member, outcome.transportFailure, std::chrono::steady_clock::now() - start);
+    return outcome;
+}
+
+std::vector<RpcResult> BitcoinClusterClient::batchOn(Member& member, const RpcBatch& batch) {
+    member.outstanding.fetch_add(1, std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<RpcResult> results = member.client->sendBatch(batch);
+    member.outstanding.fetch_sub(1, std::memory_order_relaxed);
+    // A transport failure fails every call of the batch alike.
+    const bool failed = !results.empty() && results.front().transportFailure;
+    recordOutcome(member, failed, std::chrono::steady_clock::now() - start);
+    return results;
+}
+
+std::vector<BitcoinClusterClient::Member*> BitcoinClusterClient::readCandidates() const {
+    std::int64_t bestHeight = -1;
+    for (const auto& member : members) {
+        if (member->healthy.load(std::memory_order_relaxed)) {
+            bestHeight = std::max(bestHeight, member->height.load(std::memory_order_relaxed));
+        }
+    }
+
+    std::vector<Member*> candidates;
+    for (const auto& member : members) {
+        if (!member->healthy.load(std::memory_order_relaxed)) continue;
+        // Replicas that fell behind would answer with stale chain data.
+        if (bestHeight >= 0 && member->height.load(std::memory_order_relaxed) < bestHeight - clusterSettings.maxTipLag) continue;
+        candidates.push_back(member.get());
+    }
+    if (candidates.empty()) {
+        // Nothing is known to be up: try every node rather than fail without asking.
+        for (const auto& member : members) candidates.push_back(member.get());
+        return candidates;
+    }
+
+    const auto score = [this](const Member* member) {
+        const std::int64_t outstanding = member->outstanding.load(std::memory_order_relaxed);
+        const std::int64_t latency = member->latencyMicros.load(std::memory_order_relaxed);
+        return clusterSettings.policy == BalancePolicy::LatencyWeighted
+            ? std::pair{(outstanding + 1) * std::max<std::int64_t>(latency, 1), std::int64_t(0)}
+            : std::pair{outstanding, latency};
+    };
+    std::stable_sort(candidates.begin(), candidates.end(), [&](const Member* a, const Member* b) {
+        return score(a) < score(b);
+    });
+    return candidates;
+}
+
+RpcResult BitcoinClusterClient::sendCall(const std::string& method, const Json::Value& params) {
+    if (members.empty()) return unavailable();
+    if (!isReadOnlyMethod(method)) return callOn(*members.front(), method, params);
+
+    for (Member* member : readCandidates()) {
+        RpcResult outcome = callOn(*member, method, params);
+        if (!outcome.transportFailure) return outcome;
+        Logger::formattedWarning("Node {} did not answer {}, failing over", member->url, method);
+    }
+    return unavailable();
+}
+
+Json::Value BitcoinClusterClient::sendRequest(const std::string& method, const Json::Value& params) {
+    RpcResult outcome = sendCall(method, params);
+    if (!outcome.ok()) {
+        Logger::formattedError("RPC error: {}", Json::writeString(Json::StreamWriterBuilder(), outcome.error));
+        return Json::Value();
+    }
+    return outcome.result;
+}
+
+std::vector<RpcResult> BitcoinClusterClient::sendBatch(const RpcBatch& batch) {
+    if (members.empty()) return std::vector<RpcResult>(batch.size(), unavailable());
+
+    const bool readOnly = std::all_of(batch.entries().begin(), batch.entries().end(),
+                                      [](const RpcBatch::Call& call) { return isReadOnlyMethod(call.method); });
+    if (!readOnly) return batchOn(*members.front(), batch);
+
+    for (Member* member : readCandidates()) {
+        std::vector<RpcResult> results = batchOn(*member, batch);
+        if (results.empty() || !results.front().transportFailure) return results;
+        Logger::formattedWarning("Node {} did not answer a batch, failing over", member->url);
+    }
+    return std::vector<RpcResult>(batch.size(), unavailable());
+}
+
+void BitcoinClusterClient::checkHealth() {
+    for (const auto& member : members) {
+        RpcResult outcome = callOn(*member, "getblockcount", Json::Value());
+        if (!outcome.ok() || !outcome.result.isIntegral()) continue;
+
+        member->height.store(outcome.result.asInt64(), std::memory_order_relaxed);
+        if (!member->healthy.exchange(true)) {
+            Logger::formattedInfo("Node {} is back in rotation", member->url);
+        }
+    }
+}
+
+std::vector<NodeStatus> BitcoinClusterClient::status() const {
+    std::vector<NodeStatus> nodes;
+    for (const auto& member : members) {
+        NodeStatus node;
+        node.url = member->url;
+        node.primary = member.get() == members.front().get();
+        node.healthy = member->healthy.load(std::memory_order_relaxed);
+        node.height = member->height.load(std::memory_order_relaxed);
+        node.outstanding = member->outstanding.load(std::memory_order_relaxed);
+        node.latency = std::chrono::microseconds(member->latencyMicros.load(std::memory_order_relaxed));
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+void BitcoinClusterClient::healthLoop() {
+    std::unique_lock<std::mutex> lock(healthMutex);
+    while (!healthWake.wait_for(lock, clusterSettings.healthCheckInterval, [this] { return stopping; })) {
+        lock.unlock();
+        checkHealth();
+        lock.lock();
+    }
+}
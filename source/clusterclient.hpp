@@ -0,0 +1,210 @@
+#ifndef CLUSTERCLIENT_HPP
+#define CLUSTERCLIENT_HPP
+
+#if __has_include("bitcoinclient.hpp")
+#   include "bitcoinclient.hpp"
+#else
+#   error "Bitcoin's \"bitcoinclient.hpp\" was not found!"
+#endif
+
+
+#if __has_include("rpcmethods.hpp")
+#   include "rpcmethods.hpp"
+#else
+#   error "Bitcoin's \"rpcmethods.hpp\" was not found!"
+#endif
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+/**
+ * @struct ClusterNode
+ * @brief Address and credentials of one node of a cluster.
+ */
+struct ClusterNode {
+    std::string url;        ///< RPC URL of the node.
+    std::string user;       ///< RPC username.
+    std::string password;   ///< RPC password.
+};
+
+/**
+ * @enum BalancePolicy
+ * @brief How read-only calls are spread over the healthy nodes.
+ */
+enum class BalancePolicy : std::uint8_t {
+    LeastOutstanding,   ///< The node with the fewest requests in flight; ties go to the faster node.
+    LatencyWeighted     ///< The node with the lowest `(outstanding + 1) * average latency`.
+};
+
+/**
+ * @struct ClusterSettings
+ * @brief Routing and health-check rules of a BitcoinClusterClient.
+ */
+struct ClusterSettings {
+    BalancePolicy policy = BalancePolicy::LeastOutstanding;     ///< Read routing policy.
+    std::size_t poolSize = 8;                                   ///< Keep-alive connections per node.
+    std::chrono::seconds idleTimeout {60};                      ///< Idle connection timeout.
+    std::chrono::milliseconds healthCheckInterval {5000};       ///< Time between two `getblockcount` probes of every node; 0 disables them.
+    std::int64_t maxTipLag = 0;                                 ///< Nodes more blocks than this behind the best tip get no reads.
+    std::uint32_t failureThreshold = 3;                         ///< Consecutive transport failures that take a node out of rotation.
+    RequestTimeouts timeouts;                                   ///< Time limits of every request; a stuck node then fails over instead of hanging.
+};
+
+/**
+ * @struct NodeStatus
+ * @brief A snapshot of the state of one node.
+ */
+struct NodeStatus {
+    std::string url;                    ///< RPC URL of the node.
+    bool primary = false;               ///< Wallet, broadcast and other state-changing calls go here.
+    bool healthy = false;               ///< In rotation for reads.
+    std::int64_t height = -1;           ///< Block count at the last probe; -1 if unknown.
+    std::uint32_t outstanding = 0;      ///< Requests in flight.
+    std::chrono::microseconds latency {0};  ///< Moving average of the request latency.
+};
+
+/**
+ * @class BitcoinClusterClient
+ * @brief Spreads read-only calls over several bitcoind replicas and pins the rest to a primary.
+ *
+ * Calls listed by `isReadOnlyMethod()` go to the best healthy node according to the
+ * balance policy. If that node does not answer, the call is retried on the next best one,
+ * and a node that fails `failureThreshold` times in a row is taken out of rotation until a
+ * health check succeeds again. Nodes whose tip is more than `maxTipLag` blocks behind the
+ * best known tip get no reads, so a lagging replica does not serve stale data.
+ *
+ * Every other call (wallet, broadcast, mining, node administration) goes to the primary,
+ * the first node, without failover: wallet state and broadcasts belong to one node.
+ *
+ * A background thread probes every node with `getblockcount` to track health, height and
+ * latency. All members are thread-safe.
+ *
+ * @code
+ * BitcoinClusterClient cluster({{"http://10.0.0.1:8332/", "user", "pass"},
+ *                               {"http://10.0.0.2:8332/", "user", "pass"}});
+ * Json::Value block = cluster.call("getblock", hash, 2);  // Any synchronized node.
+ * cluster.call("sendrawtransaction", hex);                // Always the primary.
+ * @endcode
+ */
+class BitcoinClusterClient {
+public:
+    /**
+     * @brief Creates clients for all nodes, probes them once and starts the health checks.
+     * @param nodes The nodes; the first one is the primary. Must not be empty.
+     * @param settings Routing and health-check rules.
+     */
+    explicit BitcoinClusterClient(const std::vector<ClusterNode>& nodes, const ClusterSettings& settings = {});
+    BitcoinClusterClient(const BitcoinClusterClient&) = delete;
+    BitcoinClusterClient& operator=(const BitcoinClusterClient&) = delete;
+
+    /**
+     * @brief Stops the health checks.
+     */
+    ~BitcoinClusterClient();
+
+    /**
+     * @brief Sends a call to the node chosen by the routing rules and reports the outcome in full.
+     * @param method The RPC method to call.
+     * @param params The parameters for the RPC method.
+     * @return The outcome, as `BitcoinClient::sendCall`.
+     */
+    RpcResult sendCall(const std::string& method, const Json::Value& params = Json::Value());
+
+    /**
+     * @brief Sends a call to the node chosen by the routing rules.
+     * @return The `result` member, or a null value on failure (the error is logged).
+     */
+    Json::Value sendRequest(const std::string& method, const Json::Value& params = Json::Value());
+
+    /**
+     * @brief Sends a call, building the parameters from the arguments.
+     */
+    template<typename... Args>
+    Json::Value call(const std::string& method, Args&&... args) {
+        Json::Value params(Json::arrayValue);
+        (params.append(std::forward<Args>(args)), ...);
+        return sendRequest(method, params);
+    }
+
+    /**
+     * @brief Sends a batch to one node: any healthy node if every call is read-only, else the primary.
+     * @param batch The calls to send.
+     * @return One RpcResult per call, as `BitcoinClient::sendBatch`.
+     */
+    std::vector<RpcResult> sendBatch(const RpcBatch& batch);
+
+    /**
+     * @brief Probes every node now instead of waiting for the next health check.
+     */
+    void checkHealth();
+
+    /**
+     * @brief Returns a snapshot of every node, primary first.
+     */
+    std::vector<NodeStatus> status() const;
+
+    /**
+     * @brief Returns the client of the primary node, e.g. for streaming or async calls.
+     */
+    BitcoinClient& primary() { return *members.front()->client; }
+
+    /**
+     * @brief Returns the client of a node.
+     * @param index The position of the node in the constructor argument.
+     */
+    BitcoinClient& node(std::size_t index) { return *members.at(index)->client; }
+
+private:
+    /**
+     * @struct Member
+     * @brief One node with its live routing state.
+     */
+    struct Member {
+        std::string url;
+        std::unique_ptr<BitcoinClient> client;
+        std::atomic<std::uint32_t> outstanding {0};         ///< Requests in flight.
+        std::atomic<bool> healthy {true};                   ///< In rotation.
+        std::atomic<std::int64_t> height {-1};              ///< Block count at the last probe.
+        std::atomic<std::int64_t> latencyMicros {0};        ///< Moving average latency; 0 until measured.
+        std::atomic<std::uint32_t> failures {0};            ///< Consecutive transport failures.
+    };
+
+    /**
+     * @brief Orders the healthy, synchronized nodes from best to worst for the next read.
+     */
+    std::vector<Member*> readCandidates() const;
+
+    /**
+     * @brief Sends a call to one member and updates its routing state.
+     */
+    RpcResult callOn(Member& member, const std::string& method, const Json::Value& params);
+
+    /**
+     * @brief Sends a batch to one member and updates its routing state.
+     */
+    std::vector<RpcResult> batchOn(Member& member, const RpcBatch& batch);
+
+    /**
+     * @brief Records the outcome of an exchange.
+     */
+    void recordOutcome(Member& member, bool transportFailure, std::chrono::steady_clock::duration elapsed);
+
+    void healthLoop();
+
+    ClusterSettings clusterSettings;                    ///< Routing and health-check rules.
+    std::vector<std::unique_ptr<Member>> members;       ///< The nodes, primary first.
+
+    std::mutex healthMutex;                             ///< Guards `stopping`.
+    std::condition_variable healthWake;                 ///< Wakes the health thread on shutdown.
+    bool stopping = false;                              ///< Set to stop the health thread.
+    std::thread healthThread;                           ///< Runs the periodic probes.
+};
+
+#endif // CLUSTERCLIENT_HPP
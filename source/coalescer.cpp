@@ -0,0 +1,58 @@
+#include "coalescer.hpp"
+#include "rpcmethods.hpp"
+
+RequestCoalescer::RequestCoalescer(const CoalesceSettings& settings)
+    : coalesceSettings(settings) {
+    if (coalesceSettings.ttl.count() < 0) coalesceSettings.ttl = std::chrono::milliseconds(0);
+}
+
+bool RequestCoalescer::isCoalescable(const std::string& method) {
+    return isReadOnlyMethod(method);
+}
+
+bool RequestCoalescer::join(const std::string& key, std::shared_ptr<Flight>& flight) {
+    const Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = flights.find(key);
+    if (found != flights.end() && found->second->expiry > now) {
+        flight = found->second;
+        shared.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    if (now >= nextSweep) sweep(now);
+    flight = std::make_shared<Flight>();
+    flight->answer = flight->result.get_future().share();
+    if (found != flights.end()) found->second = flight;
+    else flights.emplace(key, flight);
+    sent.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void RequestCoalescer::land(const std::string& key, const std::shared_ptr<Flight>& flight, const Json::Value* result,
+                            std::exception_ptr error) {
+    // A failure is not worth keeping, and without a TTL nothing is.
+    const bool keep = result && !result->isNull() && coalesceSettings.ttl.count() > 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = flights.find(key);
+        if (found != flights.end() && found->second == flight) {
+            if (keep) found->second->expiry = Clock::now() + coalesceSettings.ttl;
+            else flights.erase(found);
+        }
+        // Joiners copy the pointer under the lock, so once the flight is unlisted nobody else can.
+        // Without any, the result need not be copied into the promise.
+        if (!keep && flight.use_count() == 1) return;
+    }
+    if (error) flight->result.set_exception(error);
+    else flight->result.set_value(*result);
+}
+
+void RequestCoalescer::sweep(Clock::time_point now) {
+    std::erase_if(flights, [now](const auto& entry) { return entry.second->expiry <= now; });
+    nextSweep = now + coalesceSettings.ttl;
+}
+
+CoalesceStats RequestCoalescer::stats() const {
+    return {sent.load(std::memory_order_relaxed), shared.load(std::memory_order_relaxed)};
+}
@@ -0,0 +1,130 @@
+#ifndef COALESCER_HPP
+#define COALESCER_HPP
+
+#if __has_include(<json/json.h>)
+#   include <json/json.h>
+#else
+#   error "The JsonCpp header was not found!"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @struct CoalesceSettings
+ * @brief How long RequestCoalescer shares a result.
+ */
+struct CoalesceSettings {
+    std::chrono::milliseconds ttl {0};  ///< How long a finished result still answers identical calls; 0 only shares calls in flight.
+};
+
+/**
+ * @struct CoalesceStats
+ * @brief Counters of a RequestCoalescer.
+ */
+struct CoalesceStats {
+    std::uint64_t sent = 0;         ///< Calls that went to the node.
+    std::uint64_t shared = 0;       ///< Calls answered by another call's request.
+};
+
+/**
+ * @class RequestCoalescer
+ * @brief Lets identical concurrent calls share one request to the node ("single flight").
+ *
+ * When a block arrives, every thread of a service tends to ask `getbestblockhash`,
+ * `getblockchaininfo` or `getblock` of the new hash at the same moment. With a coalescer,
+ * the first call of a method and parameters is sent and the calls that arrive while it is
+ * in flight wait for its answer instead of sending their own. With a `ttl`, the answer keeps
+ * serving identical calls for that long after it arrived, which bounds the staleness of
+ * volatile results such as the tip to the TTL.
+ *
+ * Only read-only methods are coalesced (see `isCoalescable`); calls that change node state
+ * are always sent. Failed calls, which return null, are shared with the calls already
+ * waiting but are never kept. A coalescer must only be shared by clients of one node.
+ *
+ * @code
+ * client.enableCoalescing({std::chrono::milliseconds(50)});
+ * @endcode
+ */
+class RequestCoalescer {
+public:
+    explicit RequestCoalescer(const CoalesceSettings& settings = {});
+    RequestCoalescer(const RequestCoalescer&) = delete;
+    RequestCoalescer& operator=(const RequestCoalescer&) = delete;
+
+    /**
+     * @brief Checks whether calls of a method may share answers: those with `RPC_READ_ONLY`.
+     */
+    static bool isCoalescable(const std::string& method);
+
+    /**
+     * @brief Answers a call from an identical one in flight or recently finished, or runs `fetch` and shares its answer.
+     * @param key Identifies the call, as `ResponseCache::makeKey` builds it.
+     * @param fetch Sends the call; invoked at most once, on the calling thread.
+     */
+    template<typename Fetch>
+    Json::Value run(const std::string& key, Fetch&& fetch) {
+        std::shared_ptr<Flight> flight;
+        if (join(key, flight)) return flight->answer.get();
+        try {
+            Json::Value result = fetch();
+            land(key, flight, &result, nullptr);
+            return result;
+        } catch (...) {
+            land(key, flight, nullptr, std::current_exception());
+            throw;
+        }
+    }
+
+    /**
+     * @brief Returns the current counters.
+     */
+    CoalesceStats stats() const;
+
+    /**
+     * @brief Returns the settings the coalescer was created with.
+     */
+    const CoalesceSettings& settings() const { return coalesceSettings; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @struct Flight
+     * @brief One request and the calls that share it.
+     */
+    struct Flight {
+        std::promise<Json::Value> result;           ///< Set by the call that sent the request.
+        std::shared_future<Json::Value> answer;     ///< Read by every call sharing it.
+        Clock::time_point expiry = Clock::time_point::max();    ///< When a landed answer stops being shared; `max` while in flight.
+    };
+
+    /**
+     * @brief Finds a flight to join, or starts one in `flight`.
+     * @return `true` to wait for `flight->answer`; `false` if the caller has to send the request.
+     */
+    bool join(const std::string& key, std::shared_ptr<Flight>& flight);
+
+    /**
+     * @brief Publishes the answer of a flight started by `join`, or the exception it failed with.
+     */
+    void land(const std::string& key, const std::shared_ptr<Flight>& flight, const Json::Value* result, std::exception_ptr error);
+
+    void sweep(Clock::time_point now);     ///< Drops expired answers; `mutex` is held.
+
+    CoalesceSettings coalesceSettings;
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights;  ///< In flight, or landed and not expired.
+    Clock::time_point nextSweep {};                                    ///< Expired answers are dropped no more often than once per TTL.
+    std::atomic<std::uint64_t> sent {0};
+    std::atomic<std::uint64_t> shared {0};
+};
+
+#endif // COALESCER_HPP
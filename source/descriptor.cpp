@@ -0,0 +1,436 @@
+#include "descriptor.hpp"
+#include "bitcoinclient.hpp"
+#include "hexcodec.hpp"
+#include "ripemd160.hpp"
+#include "sha256.hpp"
+#include "sha512.hpp"
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <thread>
+
+namespace {
+constexpr std::size_t MIN_ADDRESSES_PER_THREAD = 64;
+constexpr std::size_t MAX_MULTISIG_KEYS = 20;           ///< `OP_CHECKMULTISIG` limit.
+constexpr std::size_t MAX_P2SH_MULTISIG_KEYS = 15;      ///< Largest multisig within the 520-byte P2SH script limit.
+constexpr std::size_t EXTENDED_KEY_SIZE = 78;
+
+constexpr std::array<std::uint8_t, 4> XPUB_VERSION = {0x04, 0x88, 0xb2, 0x1e};
+constexpr std::array<std::uint8_t, 4> TPUB_VERSION = {0x04, 0x35, 0x87, 0xcf};
+
+constexpr std::uint8_t OP_0 = 0x00;
+constexpr std::uint8_t OP_1 = 0x51;
+constexpr std::uint8_t OP_DUP = 0x76;
+constexpr std::uint8_t OP_EQUAL = 0x87;
+constexpr std::uint8_t OP_EQUALVERIFY = 0x88;
+constexpr std::uint8_t OP_HASH160 = 0xa9;
+constexpr std::uint8_t OP_CHECKSIG = 0xac;
+constexpr std::uint8_t OP_CHECKMULTISIG = 0xae;
+
+/**
+ * @brief Extracts the argument of a call such as `wpkh(…)`.
+ * @return `false` if `text` is not `name(…)`.
+ */
+bool unwrap(std::string_view text, std::string_view name, std::string_view& inner) {
+    if (text.size() < name.size() + 2 || !text.starts_with(name) || text[name.size()] != '(' || text.back() != ')') return false;
+    inner = text.substr(name.size() + 1, text.size() - name.size() - 2);
+    return true;
+}
+
+std::vector<std::string_view> split(std::string_view text, char separator) {
+    std::vector<std::string_view> parts;
+    for (std::size_t start = 0;;) {
+        const std::size_t end = text.find(separator, start);
+        parts.push_back(text.substr(start, end - start));
+        if (end == std::string_view::npos) return parts;
+        start = end + 1;
+    }
+}
+
+bool parseNumber(std::string_view text, std::uint32_t& out) {
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return error == std::errc() && end == text.data() + text.size() && !text.empty();
+}
+
+void pushNumber(std::vector<std::uint8_t>& script, std::size_t value) {
+    if (value <= 16) {
+        script.push_back(value == 0 ? OP_0 : static_cast<std::uint8_t>(OP_1 + value - 1));
+    } else {
+        script.insert(script.end(), {1, static_cast<std::uint8_t>(value)});
+    }
+}
+
+void pushHash160(std::vector<std::uint8_t>& script, std::span<const std::uint8_t> data) {
+    const std::array<std::uint8_t, 20> hash = hash160(data);
+    script.push_back(20);
+    script.insert(script.end(), hash.begin(), hash.end());
+}
+
+/**
+ * @brief Returns the BIP341 tweak of an internal key without script paths: `hash_TapTweak(key)`.
+ */
+std::array<std::uint8_t, 32> tapTweak(std::span<const std::uint8_t> internalKey) {
+    static const std::array<std::uint8_t, 32> tagHash = [] {
+        constexpr std::string_view tag = "TapTweak";
+        return Sha256().write({reinterpret_cast<const std::uint8_t*>(tag.data()), tag.size()}).finalize();
+    }();
+    return Sha256().write(tagHash).write(tagHash).write(internalKey).finalize();
+}
+
+std::uint64_t checksumPolymod(std::uint64_t checksum, int value) {
+    const std::uint8_t top = static_cast<std::uint8_t>(checksum >> 35);
+    checksum = (checksum & 0x7ffffffff) << 5 ^ static_cast<std::uint64_t>(value);
+    if (top & 1) checksum ^= 0xf5dee51989;
+    if (top & 2) checksum ^= 0xa9fdca3312;
+    if (top & 4) checksum ^= 0x1bab10e32d;
+    if (top & 8) checksum ^= 0x3706b1677a;
+    if (top & 16) checksum ^= 0x644d626ffd;
+    return checksum;
+}
+}
+
+bool ExtendedPublicKey::parse(std::string_view text) {
+    std::vector<std::uint8_t> data;
+    if (!decodeBase58Check(text, data) || data.size() != EXTENDED_KEY_SIZE) return false;
+    std::copy_n(data.begin(), 4, version.begin());
+    if (version != XPUB_VERSION && version != TPUB_VERSION) return false;
+    depth = data[4];
+    std::copy_n(data.begin() + 5, 4, parentFingerprint.begin());
+    childNumber = std::uint32_t(data[9]) << 24 | std::uint32_t(data[10]) << 16 | std::uint32_t(data[11]) << 8 | data[12];
+    std::copy_n(data.begin() + 13, 32, chainCode.begin());
+    std::copy_n(data.begin() + 45, 33, key.begin());
+    return isValidPublicKey(key);
+}
+
+std::string ExtendedPublicKey::toString() const {
+    std::array<std::uint8_t, EXTENDED_KEY_SIZE> data;
+    std::copy(version.begin(), version.end(), data.begin());
+    data[4] = depth;
+    std::copy(parentFingerprint.begin(), parentFingerprint.end(), data.begin() + 5);
+    for (int i = 0; i < 4; ++i) data[9 + i] = static_cast<std::uint8_t>(childNumber >> (24 - 8 * i));
+    std::copy(chainCode.begin(), chainCode.end(), data.begin() + 13);
+    std::copy(key.begin(), key.end(), data.begin() + 45);
+    return encodeBase58Check(data);
+}
+
+bool ExtendedPublicKey::derive(std::uint32_t index, ExtendedPublicKey& child) const {
+    if (index >= HARDENED_CHILD) return false;
+    std::array<std::uint8_t, 37> data;
+    std::copy(key.begin(), key.end(), data.begin());
+    for (int i = 0; i < 4; ++i) data[33 + i] = static_cast<std::uint8_t>(index >> (24 - 8 * i));
+    const std::array<std::uint8_t, 64> mac = hmacSha512(chainCode, data);
+
+    // `child` may be this key, so the fingerprint is taken first.
+    const std::array<std::uint8_t, 20> identifier = hash160(key);
+    if (!tweakPublicKey(key, std::span(mac).first<32>(), child.key)) return false;
+    std::copy_n(identifier.begin(), 4, child.parentFingerprint.begin());
+    std::copy(mac.begin() + 32, mac.end(), child.chainCode.begin());
+    child.version = version;
+    child.depth = static_cast<std::uint8_t>(depth + 1);
+    child.childNumber = index;
+    return true;
+}
+
+std::string descriptorChecksum(std::string_view descriptor) {
+    // Characters in groups of 32: the position within a group is checksummed per character,
+    // the group numbers three characters at a time.
+    constexpr std::string_view INPUT_CHARSET =
+        "0123456789()[],'/*abcdefgh@:$%{}"
+        "IJKLMNOPQRSTUVWXYZ&+-.;<=>?!^_|~"
+        "ijklmnopqrstuvwxyzABCDEFGH`#\"\\ ";
+    constexpr std::string_view CHECKSUM_CHARSET = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+
+    std::uint64_t checksum = 1;
+    int groups = 0;
+    int groupCount = 0;
+    for (const char c : descriptor) {
+        const std::size_t position = INPUT_CHARSET.find(c);
+        if (position == std::string_view::npos) return {};
+        checksum = checksumPolymod(checksum, static_cast<int>(position & 31));
+        groups = groups * 3 + static_cast<int>(position >> 5);
+        if (++groupCount == 3) {
+            checksum = checksumPolymod(checksum, groups);
+            groups = 0;
+            groupCount = 0;
+        }
+    }
+    if (groupCount > 0) checksum = checksumPolymod(checksum, groups);
+    for (int i = 0; i < 8; ++i) checksum = checksumPolymod(checksum, 0);
+    checksum ^= 1;
+
+    std::string result(8, ' ');
+    for (int i = 0; i < 8; ++i) result[i] = CHECKSUM_CHARSET[(checksum >> (5 * (7 - i))) & 31];
+    return result;
+}
+
+bool Descriptor::fail(std::string message) {
+    parseError = std::move(message);
+    return false;
+}
+
+bool Descriptor::parse(std::string_view descriptor) {
+    *this = Descriptor();
+    const std::size_t hash = descriptor.find('#');
+    text = descriptor.substr(0, hash);
+    if (hash != std::string_view::npos) {
+        const std::string_view checksum = descriptor.substr(hash + 1);
+        const std::string expected = descriptorChecksum(text);
+        if (checksum.size() != 8) return fail("Expected 8 character checksum");
+        if (expected.empty()) return fail("Invalid characters in payload");
+        if (checksum != expected) {
+            return fail(std::format("Provided checksum '{}' does not match computed checksum '{}'", checksum, expected));
+        }
+    }
+    if (!parseScript(text, Wrapper::None)) return false;
+    ranged = std::any_of(keys.begin(), keys.end(), [](const Key& key) { return key.ranged; });
+    return true;
+}
+
+bool Descriptor::parseScript(std::string_view script, Wrapper context) {
+    std::string_view inner;
+    if (unwrap(script, "sh", inner)) {
+        if (context != Wrapper::None) return fail("sh() is only allowed at the top level");
+        return parseScript(inner, Wrapper::Sh);
+    }
+    if (unwrap(script, "wsh", inner)) {
+        if (context == Wrapper::Wsh || context == Wrapper::ShWsh) return fail("wsh() cannot be nested in wsh()");
+        return parseScript(inner, context == Wrapper::Sh ? Wrapper::ShWsh : Wrapper::Wsh);
+    }
+
+    wrapper = context;
+    keys.emplace_back();
+    if (unwrap(script, "pkh", inner)) {
+        shape = Template::Pkh;
+        return parseKey(inner, keys.back());
+    }
+    if (unwrap(script, "wpkh", inner)) {
+        if (context != Wrapper::None && context != Wrapper::Sh) return fail("wpkh() is only allowed at the top level or inside sh()");
+        shape = Template::Wpkh;
+        return parseKey(inner, keys.back());
+    }
+    if (unwrap(script, "tr", inner)) {
+        if (context != Wrapper::None) return fail("tr() is only allowed at the top level");
+        if (inner.find(',') != std::string_view::npos) return fail("tr() with script paths is not supported");
+        shape = Template::Tr;
+        xonly = true;
+        return parseKey(inner, keys.back());
+    }
+    keys.clear();
+
+    sorted = unwrap(script, "sortedmulti", inner);
+    if (!sorted && !unwrap(script, "multi", inner)) return fail(std::format("'{}' is not a supported descriptor", script));
+    shape = Template::Multi;
+    const std::vector<std::string_view> arguments = split(inner, ',');
+    std::uint32_t required = 0;
+    if (!parseNumber(arguments.front(), required)) return fail(std::format("Multi threshold '{}' is not valid", arguments.front()));
+    const std::size_t limit = context == Wrapper::Sh ? MAX_P2SH_MULTISIG_KEYS : MAX_MULTISIG_KEYS;
+    if (arguments.size() - 1 > limit) return fail(std::format("Cannot have {} keys in multisig; must have at most {}", arguments.size() - 1, limit));
+    if (required < 1 || required > arguments.size() - 1) {
+        return fail(std::format("Multisig threshold cannot be {}, must be at least 1 and at most {}", required, arguments.size() - 1));
+    }
+    threshold = required;
+    keys.resize(arguments.size() - 1);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        if (!parseKey(arguments[i + 1], keys[i])) return false;
+    }
+    return true;
+}
+
+bool Descriptor::parseKey(std::string_view expression, Key& key) {
+    if (expression.starts_with('[')) {
+        const std::size_t close = expression.find(']');
+        if (close == std::string_view::npos) return fail("Key origin start '[' character without corresponding end ']'");
+        std::array<std::uint8_t, 4> fingerprint;
+        const std::string_view origin = expression.substr(1, close - 1);
+        if (origin.size() < 8 || (origin.size() > 8 && origin[8] != '/') || !decodeHex(origin.substr(0, 8), fingerprint.data())) {
+            return fail(std::format("Fingerprint '{}' is not 8 hex characters", origin.substr(0, 8)));
+        }
+        expression.remove_prefix(close + 1);
+    }
+
+    const std::vector<std::string_view> steps = split(expression, '/');
+    const std::string_view head = steps.front();
+    std::vector<std::uint8_t> bytes(head.size() / 2);
+    if (head.size() % 2 == 0 && decodeHex(head, bytes.data())) {
+        if (steps.size() > 1) return fail("Derivation steps are only allowed after extended keys");
+        if (bytes.size() == 32 && xonly) {
+            key.fixed[0] = 0x02;
+            std::copy(bytes.begin(), bytes.end(), key.fixed.begin() + 1);
+        } else if (bytes.size() == 33) {
+            std::copy(bytes.begin(), bytes.end(), key.fixed.begin());
+        } else if (bytes.size() == 65) {
+            return fail("Uncompressed keys are not supported");
+        } else {
+            return fail(std::format("Pubkey '{}' is invalid", head));
+        }
+        if (!isValidPublicKey(key.fixed)) return fail(std::format("Pubkey '{}' is invalid", head));
+        return true;
+    }
+
+    if (head.starts_with("xprv") || head.starts_with("tprv")) return fail("Private keys are not supported; use the extended public key");
+    if (!key.extended.parse(head)) return fail(std::format("Key '{}' is not valid", head));
+    key.isExtended = true;
+    for (std::size_t i = 1; i < steps.size(); ++i) {
+        const std::string_view step = steps[i];
+        if (step == "*" && i + 1 == steps.size()) {
+            key.ranged = true;
+            break;
+        }
+        if (step.ends_with('\'') || step.ends_with('h') || step.ends_with('H')) {
+            return fail(std::format("Hardened step '{}' needs the private key", step));
+        }
+        std::uint32_t index = 0;
+        if (!parseNumber(step, index) || index >= HARDENED_CHILD) return fail(std::format("Key path value '{}' is not a valid uint31", step));
+        if (!key.extended.derive(index, key.extended)) return fail(std::format("Key '{}' has no child {}", head, index));
+    }
+    return true;
+}
+
+bool Descriptor::Key::derive(std::uint32_t index, PublicKey& out) const {
+    if (!isExtended) {
+        out = fixed;
+        return true;
+    }
+    if (!ranged) {
+        out = extended.key;
+        return true;
+    }
+    ExtendedPublicKey child;
+    if (!extended.derive(index, child)) return false;
+    out = child.key;
+    return true;
+}
+
+std::string Descriptor::toString() const {
+    return text + '#' + descriptorChecksum(text);
+}
+
+bool Descriptor::scriptPubKey(std::uint32_t index, std::vector<std::uint8_t>& script) const {
+    std::array<PublicKey, MAX_MULTISIG_KEYS> derived;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        if (!keys[i].derive(index, derived[i])) return false;
+    }
+
+    script.clear();
+    switch (shape) {
+    case Template::Pkh:
+        script.insert(script.end(), {OP_DUP, OP_HASH160});
+        pushHash160(script, derived[0]);
+        script.insert(script.end(), {OP_EQUALVERIFY, OP_CHECKSIG});
+        break;
+    case Template::Wpkh:
+        script.push_back(OP_0);
+        pushHash160(script, derived[0]);
+        break;
+    case Template::Tr: {
+        const XOnlyPublicKey internalKey = [&] {
+            XOnlyPublicKey x;
+            std::copy(derived[0].begin() + 1, derived[0].end(), x.begin());
+            return x;
+        }();
+        XOnlyPublicKey outputKey;
+        if (!tweakXOnlyPublicKey(internalKey, tapTweak(internalKey), outputKey)) return false;
+        script.insert(script.end(), {OP_1, 32});
+        script.insert(script.end(), outputKey.begin(), outputKey.end());
+        break;
+    }
+    case Template::Multi:
+        if (sorted) std::sort(derived.begin(), derived.begin() + keys.size());
+        pushNumber(script, threshold);
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            script.push_back(33);
+            script.insert(script.end(), derived[i].begin(), derived[i].end());
+        }
+        pushNumber(script, keys.size());
+        script.push_back(OP_CHECKMULTISIG);
+        break;
+    }
+
+    if (wrapper == Wrapper::Wsh || wrapper == Wrapper::ShWsh) {
+        const std::array<std::uint8_t, 32> hash = Sha256().write(script).finalize();
+        script.assign({OP_0, 32});
+        script.insert(script.end(), hash.begin(), hash.end());
+    }
+    if (wrapper == Wrapper::Sh || wrapper == Wrapper::ShWsh) {
+        const std::vector<std::uint8_t> redeemScript = std::move(script);
+        script.assign({OP_HASH160});
+        pushHash160(script, redeemScript);
+        script.push_back(OP_EQUAL);
+    }
+    return true;
+}
+
+std::string Descriptor::address(std::uint32_t index, AddressNetwork network) const {
+    thread_local std::vector<std::uint8_t> script;
+    if (!scriptPubKey(index, script)) return {};
+    return encodeAddress(script, network);
+}
+
+std::vector<std::string> Descriptor::addresses(std::uint32_t begin, std::uint32_t end, AddressNetwork network, unsigned threads) const {
+    const std::size_t count = end > begin ? end - begin : 0;
+    std::vector<std::string> result(count);
+    if (!ranged) {
+        if (count > 0) std::fill(result.begin(), result.end(), address(begin, network));
+        return result;
+    }
+
+    // Every index costs the same, so each thread takes one contiguous slice.
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t workerCount = std::max<std::size_t>(1, std::min<std::size_t>(threads, count / MIN_ADDRESSES_PER_THREAD));
+    const auto derive = [&](std::size_t worker) {
+        const std::size_t first = count * worker / workerCount;
+        const std::size_t last = count * (worker + 1) / workerCount;
+        for (std::size_t i = first; i < last; ++i) result[i] = address(begin + static_cast<std::uint32_t>(i), network);
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount - 1);
+    for (std::size_t i = 1; i < workerCount; ++i) workers.emplace_back(derive, i);
+    derive(0);
+    for (std::thread& worker : workers) worker.join();
+    return result;
+}
+
+bool Descriptor::crossCheck(BitcoinClient& client, std::uint32_t begin, std::uint32_t end, AddressNetwork network,
+                            std::size_t samples) const {
+    if (end <= begin) return true;
+    std::vector<std::uint32_t> indexes;
+    if (ranged) {
+        const std::size_t count = end - begin;
+        samples = std::clamp<std::size_t>(samples, 1, count);
+        for (std::size_t i = 0; i < samples; ++i) {
+            indexes.push_back(begin + static_cast<std::uint32_t>(samples == 1 ? 0 : (count - 1) * i / (samples - 1)));
+        }
+        indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+    } else {
+        indexes.push_back(begin);
+    }
+
+    const std::string checked = toString();
+    RpcBatch batch;
+    for (const std::uint32_t index : indexes) {
+        Json::Value range;
+        if (ranged) {
+            range.append(index);
+            range.append(index);
+        }
+        batch.call<RpcMethod::deriveaddresses>(std::string_view(checked), range);
+    }
+    const std::vector<RpcResult> answers = client.sendBatch(batch);
+
+    bool matches = true;
+    for (std::size_t i = 0; i < indexes.size(); ++i) {
+        const RpcResult& answer = answers[i];
+        if (!answer.ok() || !answer.result.isArray() || answer.result.size() != 1) {
+            Logger::formattedError("Descriptor cross-check: deriveaddresses failed at index {}: {}", indexes[i], answer.error["message"].asString());
+            matches = false;
+            continue;
+        }
+        const std::string local = address(indexes[i], network);
+        const std::string remote = answer.result[0].asString();
+        if (local != remote) {
+            Logger::formattedError("Descriptor cross-check: index {} derives {} locally but {} on the node", indexes[i], local, remote);
+            matches = false;
+        }
+    }
+    return matches;
+}
@@ -0,0 +1,170 @@
+#ifndef DESCRIPTOR_HPP
+#define DESCRIPTOR_HPP
+
+#if __has_include("secp256k1.hpp")
+#   include "secp256k1.hpp"
+#else
+#   error "Bitcoin's \"secp256k1.hpp\" was not found!"
+#endif
+
+#if __has_include("address.hpp")
+#   include "address.hpp"
+#else
+#   error "Bitcoin's \"address.hpp\" was not found!"
+#endif
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class BitcoinClient;
+
+/**
+ * @brief The first BIP32 child number that needs the private key.
+ */
+constexpr std::uint32_t HARDENED_CHILD = 0x80000000;
+
+/**
+ * @struct ExtendedPublicKey
+ * @brief A BIP32 extended public key (`xpub…`/`tpub…`), from which non-hardened children derive locally.
+ */
+struct ExtendedPublicKey {
+    std::array<std::uint8_t, 4> version {};             ///< Serialization version: `xpub` or `tpub`.
+    std::uint8_t depth = 0;                             ///< Derivation steps from the master key.
+    std::array<std::uint8_t, 4> parentFingerprint {};   ///< First bytes of HASH160 of the parent key.
+    std::uint32_t childNumber = 0;                      ///< Index of this key below its parent.
+    std::array<std::uint8_t, 32> chainCode {};
+    PublicKey key {};
+
+    /**
+     * @brief Parses the base58check serialization of an `xpub` or `tpub`.
+     * @return `false` if the text is malformed, not a public key, or its key is not on the curve.
+     */
+    bool parse(std::string_view text);
+
+    /**
+     * @brief Returns the base58check serialization.
+     */
+    std::string toString() const;
+
+    /**
+     * @brief Derives child `index` (BIP32 CKDpub).
+     * @return `false` for a hardened index, or for the roughly 1 in 2^127 indexes without a valid child.
+     */
+    bool derive(std::uint32_t index, ExtendedPublicKey& child) const;
+};
+
+/**
+ * @brief Returns the eight-character checksum `getdescriptorinfo` appends after `#`.
+ * @return An empty string if the text has characters descriptors cannot contain.
+ */
+std::string descriptorChecksum(std::string_view descriptor);
+
+/**
+ * @class Descriptor
+ * @brief A watch-only output descriptor that derives scripts and addresses locally.
+ *
+ * Wallet back ends that pre-generate deposit addresses would otherwise call `deriveaddresses`
+ * or `getnewaddress` once per address, paying a round trip and the node's descriptor
+ * evaluation for each. Public derivation needs no secrets, so it is done here instead:
+ * BIP32 CKDpub, the script templates and the address encodings, with large ranges split
+ * across threads. `crossCheck()` compares a sample with the node's own derivation.
+ *
+ * Supported: `pkh`, `wpkh`, `sh(wpkh)`, `tr` without script paths, and `multi`/`sortedmulti`
+ * bare or inside `sh`, `wsh` and `sh(wsh)`. Keys are compressed hex public keys (x-only in
+ * `tr`) or an `xpub`/`tpub` with an optional key origin and non-hardened steps, the last of
+ * which may be `*`. Private keys and hardened steps after the extended key are rejected,
+ * since deriving them needs the private key.
+ *
+ * Steps before the `*` are derived once when parsing, so every index costs one CKDpub per key.
+ *
+ * @code
+ * Descriptor receive;
+ * if (!receive.parse(settings.receiveDescriptor)) Logger::error(receive.error());
+ * std::vector<std::string> addresses = receive.addresses(0, 100000, AddressNetwork::Main);
+ * if (!receive.crossCheck(client, 0, 100000, AddressNetwork::Main)) abort();
+ * @endcode
+ */
+class Descriptor {
+public:
+    /**
+     * @brief Replaces the contents with `descriptor`.
+     *
+     * A `#checksum` suffix is optional; when present, it has to match.
+     * @return `false` if the descriptor is malformed or unsupported; `error()` then says why.
+     */
+    bool parse(std::string_view descriptor);
+
+    const std::string& error() const { return parseError; }    ///< Why the last `parse()` failed.
+
+    /**
+     * @brief Returns the descriptor as parsed, with its checksum, as `deriveaddresses` takes it.
+     */
+    std::string toString() const;
+
+    /**
+     * @brief Checks whether the descriptor has a `*` step, so that the index matters.
+     */
+    bool isRange() const { return ranged; }
+
+    /**
+     * @brief Derives the output script at `index`; the index is ignored unless `isRange()`.
+     * @return `false` if a key has no valid child at that index.
+     */
+    bool scriptPubKey(std::uint32_t index, std::vector<std::uint8_t>& script) const;
+
+    /**
+     * @brief Returns the address at `index`, or an empty string if derivation fails.
+     */
+    std::string address(std::uint32_t index, AddressNetwork network) const;
+
+    /**
+     * @brief Returns the addresses of `[begin, end)`, the range `deriveaddresses` takes as `[begin, end - 1]`.
+     * @param threads Threads to derive on, the caller included; 0 uses every hardware thread.
+     * @return One address per index; empty where derivation fails.
+     */
+    std::vector<std::string> addresses(std::uint32_t begin, std::uint32_t end, AddressNetwork network, unsigned threads = 0) const;
+
+    /**
+     * @brief Compares local derivation with `deriveaddresses` at a sample of indexes, in one batch.
+     * @param samples Indexes to check, spread evenly over `[begin, end)` and including both ends.
+     * @return `false` on a mismatch or failed call; details are logged.
+     */
+    bool crossCheck(BitcoinClient& client, std::uint32_t begin, std::uint32_t end, AddressNetwork network,
+                    std::size_t samples = 8) const;
+
+private:
+    enum class Template : std::uint8_t { Pkh, Wpkh, Tr, Multi };
+    enum class Wrapper : std::uint8_t { None, Sh, Wsh, ShWsh };
+
+    /**
+     * @struct Key
+     * @brief One key expression, with its fixed steps applied.
+     */
+    struct Key {
+        ExtendedPublicKey extended;         ///< Valid if `isExtended`.
+        PublicKey fixed {};                 ///< The key itself otherwise.
+        bool isExtended = false;
+        bool ranged = false;                ///< Ends in `*`.
+
+        bool derive(std::uint32_t index, PublicKey& out) const;
+    };
+
+    bool parseScript(std::string_view script, Wrapper context);
+    bool parseKey(std::string_view expression, Key& key);
+    bool fail(std::string message);
+
+    std::string text;                       ///< The descriptor without its checksum.
+    std::string parseError;
+    Template shape = Template::Pkh;
+    Wrapper wrapper = Wrapper::None;
+    bool sorted = false;                    ///< `sortedmulti`.
+    bool xonly = false;                     ///< Inside `tr`, where hex keys are 32 bytes.
+    bool ranged = false;
+    std::size_t threshold = 0;              ///< Signatures a multisig needs.
+    std::vector<Key> keys;
+};
+
+#endif // DESCRIPTOR_HPP
@@ -0,0 +1,403 @@
+#include "bitcoinclient.hpp"
+#include "jsonstream.hpp"
+#include "jsonwriter.hpp"
+#include "network.hpp"
+#include "../mockserver.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Benchmarks of the client's hot paths: request serialization, response parsing, the
+ * Network request path and end-to-end calls. Everything runs against an embedded mock
+ * JSON-RPC server, so results do not depend on a node and are comparable between builds.
+ *
+ * The large responses are generated with a realistic shape (a `getblock` verbosity 2
+ * result and a `getrawmempool true` result), or recorded ones are used instead:
+ *
+ *     bitcoin-cli getblock <hash> 2 > fixtures/getblock.json
+ *     bitcoin-cli getrawmempool true > fixtures/getrawmempool.json
+ *     Bitcoin-RPC-benchmark --fixtures fixtures
+ *
+ * Note that the mock server shares the machine, so end-to-end figures include its cost.
+ */
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr std::uint64_t BLOCK_COUNT = 800000;               ///< What the mock answers to `getblockcount`.
+constexpr std::size_t GENERATED_BLOCK_TRANSACTIONS = 3000;  ///< Transactions of the generated block.
+constexpr std::size_t GENERATED_MEMPOOL_ENTRIES = 20000;    ///< Entries of the generated mempool.
+constexpr std::size_t BATCH_SIZE = 100;                     ///< Calls per batch benchmark.
+
+struct Options {
+    std::size_t iterations = 200;           ///< Timed runs per benchmark (large responses run a tenth as often).
+    std::size_t threads = 4;                ///< Threads of the throughput benchmarks.
+    std::string fixtures;                   ///< Directory with recorded responses; empty to generate them.
+    std::string filter;                     ///< Only benchmarks whose name contains this run.
+};
+
+struct Fixtures {
+    std::string block;                      ///< A `getblock <hash> 2` result.
+    std::string mempool;                    ///< A `getrawmempool true` result.
+    std::string blockResponse;              ///< `block` inside a JSON-RPC envelope.
+    std::string mempoolResponse;            ///< `mempool` inside a JSON-RPC envelope.
+};
+
+std::string generateBlock(std::size_t transactions) {
+    std::string out;
+    out.reserve(transactions * 1500);
+    out += std::format(R"({{"hash":"{}","confirmations":1,"height":{},"version":536870912,"versionHex":"20000000",)"
+                       R"("merkleroot":"{}","time":1700000000,"mediantime":1699999000,"nonce":12345,"bits":"17053894",)"
+                       R"("difficulty":62463471666732.94,"chainwork":"{}","nTx":{},"previousblockhash":"{}","tx":[)",
+                       fakeHash(1), BLOCK_COUNT, fakeHash(2), fakeHash(3), transactions, fakeHash(4));
+    for (std::size_t t = 0; t < transactions; ++t) {
+        if (t) out += ',';
+        const std::string txid = fakeHash(100 + t);
+        out += std::format(R"({{"txid":"{}","hash":"{}","version":2,"size":223,"vsize":142,"weight":565,"locktime":0,"vin":[)",
+                           txid, fakeHash(200000 + t));
+        for (int i = 0; i < 2; ++i) {
+            if (i) out += ',';
+            out += std::format(R"({{"txid":"{}","vout":{},"scriptSig":{{"asm":"","hex":""}},"txinwitness":[)"
+                               R"("3044022040b4a8f2a6c88e2d7f6f2ce7e2e9e0f4a7c2b1d3e5f60718293a4b5c6d7e8f9002203a4b5c6d7e8f)"
+                               R"(9012345678901234567890123456789012345678901234567890123401","02b4632d08485ff1df2db55b9d)"
+                               R"(afd23347d1c47a457072a1e87be26896549a8737"],"sequence":4294967293}})",
+                               fakeHash(300000 + 2 * t + i), i);
+        }
+        out += R"(],"vout":[)";
+        for (int o = 0; o < 2; ++o) {
+            if (o) out += ',';
+            out += std::format(R"({{"value":{}.{:08},"n":{},"scriptPubKey":{{"asm":"0 {}","desc":"addr(bc1q{})#abcdefgh",)"
+                               R"("hex":"0014{}","address":"bc1q{}","type":"witness_v0_keyhash"}}}})",
+                               t % 3, (t * 7919 + o) % 100000000, o, txid.substr(0, 40), txid.substr(0, 38),
+                               txid.substr(0, 40), txid.substr(0, 38));
+        }
+        out += std::format(R"(],"fee":0.0000{:04},"hex":"02000000000102{}"}})", t % 10000, txid + txid + txid);
+    }
+    out += "]}";
+    return out;
+}
+
+std::string generateMempool(std::size_t entries) {
+    std::string out;
+    out.reserve(entries * 600);
+    out += '{';
+    for (std::size_t e = 0; e < entries; ++e) {
+        if (e) out += ',';
+        out += std::format(R"("{}":{{"vsize":{},"weight":{},"time":{},"height":{},"descendantcount":1,"descendantsize":{},)"
+                           R"("ancestorcount":1,"ancestorsize":{},"wtxid":"{}","fees":{{"base":0.0000{:04},"modified":0.0000{:04},)"
+                           R"("ancestor":0.0000{:04},"descendant":0.0000{:04}}},"depends":[{}],"spentby":[],)"
+                           R"("bip125-replaceable":false,"unbroadcast":false}})",
+                           fakeHash(e), 141 + e % 400, 564 + e % 1600, 1700000000 + e, BLOCK_COUNT, 141 + e % 400,
+                           141 + e % 400, fakeHash(1000000 + e), e % 10000, e % 10000, e % 10000, e % 10000,
+                           e % 5 == 0 && e ? "\"" + fakeHash(e - 1) + "\"" : "");
+    }
+    out += '}';
+    return out;
+}
+
+/**
+ * @brief Reads a recorded response, unwrapping a JSON-RPC envelope if there is one.
+ */
+bool loadFixture(const std::filesystem::path& path, std::string& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::stringstream contents;
+    contents << file.rdbuf();
+    out = contents.str();
+
+    Json::Value document;
+    std::string errors;
+    std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+    if (!reader->parse(out.data(), out.data() + out.size(), &document, &errors)) {
+        std::print(stderr, "{} is not valid JSON: {}\n", path.string(), errors);
+        return false;
+    }
+    if (document.isObject() && document.isMember("result")) {
+        out.clear();
+        JsonWriter(out).write(document["result"]);
+    }
+    return true;
+}
+
+/**
+ * @brief Answers the calls the benchmarks make; everything else gets a null result.
+ */
+MockServer::Responder responder(const Fixtures& fixtures) {
+    return [&fixtures](const std::string& method, const std::string& id, std::int64_t argument) {
+        if (method == "getblock") return envelope(fixtures.block, id);
+        if (method == "getrawmempool") return envelope(fixtures.mempool, id);
+        if (method == "getblockcount") return envelope(std::to_string(BLOCK_COUNT), id);
+        if (method == "getblockhash") return envelope("\"" + fakeHash(static_cast<std::uint64_t>(argument)) + "\"", id);
+        return envelope("null", id);
+    };
+}
+
+/**
+ * @class CountingHandler
+ * @brief Consumes SAX events without building anything, to time the streaming parser alone.
+ */
+class CountingHandler : public JsonHandler {
+public:
+    std::size_t events = 0;
+
+    bool onNull() override { return ++events; }
+    bool onBool(bool) override { return ++events; }
+    bool onNumber(std::string_view) override { return ++events; }
+    bool onString(std::string_view) override { return ++events; }
+    bool onKey(std::string_view) override { return ++events; }
+    bool onStartObject() override { return ++events; }
+    bool onEndObject() override { return ++events; }
+    bool onStartArray() override { return ++events; }
+    bool onEndArray() override { return ++events; }
+};
+
+struct Result {
+    std::string name;
+    std::vector<double> latencies;      ///< Microseconds per operation.
+    double seconds = 0;                 ///< Wall time of the timed runs.
+    std::size_t bytesPerOperation = 0;  ///< Payload handled per operation, for MB/s.
+    std::size_t failures = 0;
+};
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(fraction * static_cast<double>(sorted.size())))];
+}
+
+void report(Result& result) {
+    std::sort(result.latencies.begin(), result.latencies.end());
+    const auto count = static_cast<double>(result.latencies.size());
+    double total = 0;
+    for (double latency : result.latencies) total += latency;
+    const double throughput = result.seconds > 0 ? count / result.seconds : 0;
+    std::print("{:<34} {:>7} {:>11.2f} {:>11.2f} {:>11.2f} {:>11.2f} {:>11.0f} {:>9}",
+               result.name, result.latencies.size(), count ? total / count : 0, percentile(result.latencies, 0.50),
+               percentile(result.latencies, 0.99), result.latencies.empty() ? 0 : result.latencies.back(), throughput,
+               result.bytesPerOperation ? std::format("{:.1f}", throughput * static_cast<double>(result.bytesPerOperation) / 1e6) : "-");
+    if (result.failures) std::print("  ({} failed)", result.failures);
+    std::print("\n");
+}
+
+class Suite {
+public:
+    explicit Suite(const Options& options) : options(options) {}
+
+    /**
+     * @brief Times `operation` on one thread; it returns `false` on failure.
+     */
+    template<typename Operation>
+    void run(const std::string& name, std::size_t iterations, std::size_t bytes, Operation&& operation) {
+        if (!selected(name)) return;
+        Result result {name, {}, 0, bytes, 0};
+        result.latencies.reserve(iterations);
+        for (std::size_t i = 0; i < std::max<std::size_t>(iterations / 10, 1); ++i) operation();    // Warm-up.
+
+        const auto begin = Clock::now();
+        for (std::size_t i = 0; i < iterations; ++i) {
+            const auto start = Clock::now();
+            if (!operation()) ++result.failures;
+            result.latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        result.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        report(result);
+    }
+
+    /**
+     * @brief Times `operation` on `threads` threads at once, `iterations` times each.
+     */
+    template<typename Operation>
+    void runParallel(const std::string& name, std::size_t threads, std::size_t iterations, Operation&& operation) {
+        if (!selected(name)) return;
+        Result result {name, {}, 0, 0, 0};
+        std::vector<std::vector<double>> latencies(threads);
+        std::atomic<std::size_t> failures {0};
+        std::vector<std::thread> workers;
+        const auto begin = Clock::now();
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                latencies[t].reserve(iterations);
+                for (std::size_t i = 0; i < iterations; ++i) {
+                    const auto start = Clock::now();
+                    if (!operation()) failures.fetch_add(1, std::memory_order_relaxed);
+                    latencies[t].push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+                }
+            });
+        }
+        for (std::thread& worker : workers) worker.join();
+        result.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        for (const auto& perThread : latencies) result.latencies.insert(result.latencies.end(), perThread.begin(), perThread.end());
+        result.failures = failures.load();
+        report(result);
+    }
+
+private:
+    bool selected(const std::string& name) const {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    }
+
+    const Options& options;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (argument == "--iterations" && hasValue) {
+            options.iterations = std::max<std::size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (argument == "--threads" && hasValue) {
+            options.threads = std::max<std::size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (argument == "--fixtures" && hasValue) {
+            options.fixtures = argv[++i];
+        } else if (argument == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else {
+            std::print("Usage: {} [--iterations N] [--threads N] [--fixtures DIR] [--filter TEXT]\n"
+                       "  --fixtures DIR  Use recorded getblock.json (verbosity 2) and getrawmempool.json (verbose)\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+auto main(int argc, char* argv[]) -> int {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+    Logger::setLevel(LogLevel::Error);
+
+    Fixtures fixtures;
+    if (!options.fixtures.empty()) {
+        const std::filesystem::path directory(options.fixtures);
+        if (!loadFixture(directory / "getblock.json", fixtures.block) || !loadFixture(directory / "getrawmempool.json", fixtures.mempool)) {
+            std::print(stderr, "Expected getblock.json and getrawmempool.json in {}\n", options.fixtures);
+            return 1;
+        }
+    } else {
+        fixtures.block = generateBlock(GENERATED_BLOCK_TRANSACTIONS);
+        fixtures.mempool = generateMempool(GENERATED_MEMPOOL_ENTRIES);
+    }
+    fixtures.blockResponse = envelope(fixtures.block, "1");
+    fixtures.mempoolResponse = envelope(fixtures.mempool, "1");
+
+    MockServer server(responder(fixtures));
+    if (!server.start()) {
+        std::print(stderr, "Failed to start the mock server\n");
+        return 1;
+    }
+    std::print("Mock server at {}; getblock {:.2f} MB, getrawmempool {:.2f} MB\n\n", server.url(),
+               static_cast<double>(fixtures.blockResponse.size()) / 1e6, static_cast<double>(fixtures.mempoolResponse.size()) / 1e6);
+    std::print("{:<34} {:>7} {:>11} {:>11} {:>11} {:>11} {:>11} {:>9}\n",
+               "benchmark", "ops", "mean (us)", "p50 (us)", "p99 (us)", "max (us)", "ops/s", "MB/s");
+
+    Suite suite(options);
+    const std::size_t many = options.iterations * 100;      // Microsecond-scale operations.
+    const std::size_t few = std::max<std::size_t>(options.iterations / 10, 5);    // Megabyte-scale operations.
+
+    // Request serialization: the direct writer against building a Json::Value and writing it.
+    std::string payload;
+    std::uint64_t id = 0;
+    suite.run("serialize/jsonwriter-getblockhash", many, 0, [&] {
+        payload.clear();
+        JsonWriter(payload).rpcRequest(JsonLiteral("getblockhash"), ++id, 800000);
+        return !payload.empty();
+    });
+    const Json::StreamWriterBuilder compact = [] {
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+        return builder;
+    }();
+    suite.run("serialize/jsoncpp-getblockhash", many, 0, [&] {
+        Json::Value request;
+        request["jsonrpc"] = "1.0";
+        request["id"] = Json::UInt64(++id);
+        request["method"] = "getblockhash";
+        request["params"].append(800000);
+        payload = Json::writeString(compact, request);
+        return !payload.empty();
+    });
+    suite.run("serialize/jsonwriter-batch-100", options.iterations * 10, 0, [&] {
+        payload.assign(1, '[');
+        for (std::size_t i = 0; i < BATCH_SIZE; ++i) {
+            if (i) payload += ',';
+            JsonWriter(payload).rpcRequest(JsonLiteral("getblockhash"), ++id, i);
+        }
+        payload += ']';
+        return true;
+    });
+
+    // Response parsing: building the DOM against feeding the streaming parser.
+    std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+    const auto parseDocument = [&](const std::string& text) {
+        Json::Value document;
+        std::string errors;
+        return reader->parse(text.data(), text.data() + text.size(), &document, &errors);
+    };
+    const auto parseStream = [](const std::string& text) {
+        CountingHandler handler;
+        JsonStreamParser parser(handler);
+        return parser.feed(text) && parser.finish();
+    };
+    suite.run("parse/jsoncpp-getblock", few, fixtures.blockResponse.size(), [&] { return parseDocument(fixtures.blockResponse); });
+    suite.run("parse/stream-getblock", few, fixtures.blockResponse.size(), [&] { return parseStream(fixtures.blockResponse); });
+    suite.run("parse/jsoncpp-getrawmempool", few, fixtures.mempoolResponse.size(), [&] { return parseDocument(fixtures.mempoolResponse); });
+    suite.run("parse/stream-getrawmempool", few, fixtures.mempoolResponse.size(), [&] { return parseStream(fixtures.mempoolResponse); });
+
+    // The Network request path on its own: pooled connection, POST, buffered response.
+    Network network;
+    const std::map<std::string, std::string> headers = {{"Content-Type", "application/json"}};
+    const std::string countRequest = R"({"jsonrpc":"1.0","id":1,"method":"getblockcount","params":[]})";
+    const std::string blockRequest = std::format(R"({{"jsonrpc":"1.0","id":1,"method":"getblock","params":["{}",2]}})", fakeHash(1));
+    std::string response;
+    suite.run("network/post-small", options.iterations * 10, 0, [&] {
+        response.clear();
+        return network.sendPostRequest(server.url(), countRequest, response, "user", "password", headers);
+    });
+    suite.run("network/post-getblock", few, fixtures.blockResponse.size(), [&] {
+        response.clear();
+        return network.sendPostRequest(server.url(), blockRequest, response, "user", "password", headers);
+    });
+
+    // End to end through BitcoinClient: serialize, send, parse, unwrap.
+    BitcoinClient client("user", "password", server.url(), options.threads * 2);
+    suite.run("client/getblockcount", options.iterations * 10, 0, [&] { return client.getBlockCount().isIntegral(); });
+    Json::Value blockParams(Json::arrayValue);
+    blockParams.append(fakeHash(1));
+    blockParams.append(2);
+    suite.run("client/getblock-verbosity-2", few, fixtures.blockResponse.size(), [&] {
+        return client.sendCall("getblock", blockParams).ok();
+    });
+    Json::Value verbose(Json::arrayValue);
+    verbose.append(true);
+    suite.run("client/getrawmempool-verbose", few, fixtures.mempoolResponse.size(), [&] {
+        return client.sendCall("getrawmempool", verbose).ok();
+    });
+    suite.run("client/stream-rawmempool", few, fixtures.mempoolResponse.size(), [&] {
+        std::size_t entries = 0;
+        return !client.streamRawMempool([&](std::string_view, Json::Value&&) { return ++entries > 0; }).isNull() && entries > 0;
+    });
+    RpcBatch batch;
+    for (std::size_t height = 0; height < BATCH_SIZE; ++height) batch.call("getblockhash", static_cast<Json::Int64>(height));
+    suite.run("client/batch-100-getblockhash", options.iterations, 0, [&] {
+        const std::vector<RpcResult> results = client.sendBatch(batch);
+        return results.size() == BATCH_SIZE && results.back().ok();
+    });
+
+    // Throughput with concurrent callers sharing the client's pool.
+    suite.runParallel(std::format("throughput/getblockcount-x{}", options.threads), options.threads, options.iterations * 10,
+                      [&] { return client.getBlockCount().isIntegral(); });
+    suite.runParallel(std::format("throughput/getblock-x{}", options.threads), options.threads, few,
+                      [&] { return client.sendCall("getblock", blockParams).ok(); });
+
+    server.stop();
+    return 0;
+}
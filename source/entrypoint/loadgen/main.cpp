@@ -0,0 +1,489 @@
+#include "bitcoinclient.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <print>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Load generator for capacity tests against a real node: how many calls per second a node
+ * and this client sustain before latency climbs, and which pool and batch sizes get there.
+ *
+ * Calls are issued open-loop: call i is due at start + i / rate, whether or not earlier
+ * calls have finished. Each call's response time is measured from when it was due, not from
+ * when it was sent, so time spent queued behind a slow node counts against it. A closed-loop
+ * tool instead stops sending while the node stalls, which hides the stall from its
+ * percentiles ("coordinated omission"). The service time, from send to answer, is reported
+ * next to it; the gap between the two is the queueing.
+ *
+ * The workload is a weighted mix of methods with generated parameters, or a recorded file
+ * of calls replayed in order, one JSON object per line:
+ *
+ *     {"method":"getblock","params":["00000000000000000002a7c4c1e48d76c5a37902165a270156b7a8d72728a054",1]}
+ *
+ *     Bitcoin-RPC-loadgen --rate 2000 --duration 60 --concurrency 32 --mix getblockcount=4,getblock=1
+ *     Bitcoin-RPC-loadgen --rate 500 --mode batch --batch-size 20 --replay calls.jsonl
+ */
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t HASH_SAMPLE = 256;                            ///< Block hashes sampled for generated parameters.
+constexpr auto REAP_INTERVAL = std::chrono::microseconds(50);       ///< How often the async dispatcher polls for answers.
+constexpr auto START_DELAY = std::chrono::milliseconds(100);        ///< Lets the workers start before the first call is due.
+
+enum class Mode { Sync, Async, Batch };
+
+struct Options {
+    std::string url = "http://127.0.0.1:8332/";
+    std::string user;
+    std::string password;
+    std::string cookie;                     ///< Path of the node's `.cookie` file; overrides user and password.
+    std::string unixSocket;                 ///< Reach the node through this socket (see TransportSettings).
+    double rate = 100;                      ///< Calls per second.
+    double duration = 10;                   ///< Seconds of load.
+    std::size_t concurrency = 8;            ///< Sync: worker threads. Async: requests in flight.
+    std::size_t pool = 0;                   ///< Keep-alive connections; 0 uses `concurrency`.
+    Mode mode = Mode::Sync;
+    std::size_t batchSize = 1;              ///< Calls per request; above 1 in batch mode and optionally in async mode.
+    std::string mix = "getblockcount=4,getbestblockhash=2,getblockhash=2,getblockheader=1,getblock=1";
+    std::string replay;                     ///< File of recorded calls; replaces the mix.
+    std::uint64_t seed = 1;
+};
+
+struct Call {
+    std::string method;
+    Json::Value params;
+};
+
+struct Sample {
+    std::uint32_t method;       ///< Index into Workload::methods.
+    bool ok;
+    double response;            ///< Microseconds from when the call was due to its answer.
+    double service;             ///< Microseconds from sending to the answer.
+};
+
+/**
+ * @brief A deterministic 64-bit mix (splitmix64), so call i has the same parameters in every run.
+ */
+std::uint64_t mix64(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @class Workload
+ * @brief Produces the call of every index, from a weighted mix or a recorded file.
+ */
+class Workload {
+public:
+    std::vector<std::string> methods;       ///< Distinct methods, for the per-method report.
+
+    bool loadMix(const std::string& spec, std::uint64_t seed) {
+        randomSeed = seed;
+        std::stringstream entries(spec);
+        std::string entry;
+        while (std::getline(entries, entry, ',')) {
+            if (entry.empty()) continue;
+            const std::size_t equals = entry.find('=');
+            const std::uint64_t weight = equals == std::string::npos ? 1 : std::strtoull(entry.c_str() + equals + 1, nullptr, 10);
+            if (weight == 0) continue;
+            cumulative.push_back((cumulative.empty() ? 0 : cumulative.back()) + weight);
+            mixMethods.push_back(methodIndex(entry.substr(0, equals)));
+        }
+        if (cumulative.empty()) std::print(stderr, "The mix \"{}\" has no methods\n", spec);
+        return !cumulative.empty();
+    }
+
+    bool loadReplay(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            std::print(stderr, "Cannot open {}\n", path);
+            return false;
+        }
+        std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+        std::string line;
+        for (std::size_t number = 1; std::getline(file, line); ++number) {
+            if (line.empty() || line[0] == '#') continue;
+            Json::Value call;
+            std::string errors;
+            if (!reader->parse(line.data(), line.data() + line.size(), &call, &errors) || !call["method"].isString()) {
+                std::print(stderr, "{}:{}: expected {{\"method\":...,\"params\":[...]}}\n", path, number);
+                return false;
+            }
+            recordedMethods.push_back(methodIndex(call["method"].asString()));
+            recorded.push_back({call["method"].asString(), call["params"]});
+        }
+        if (recorded.empty()) std::print(stderr, "{} has no calls\n", path);
+        return !recorded.empty();
+    }
+
+    /**
+     * @brief Samples block hashes and the tip height for the generated parameters.
+     */
+    bool sampleChain(BitcoinClient& client) {
+        if (!recorded.empty()) return true;
+        const Json::Value count = client.getBlockCount();
+        if (!count.isIntegral()) {
+            std::print(stderr, "getblockcount failed; check the URL and credentials\n");
+            return false;
+        }
+        tipHeight = count.asInt64();
+        RpcBatch batch;
+        for (std::size_t i = 0; i < HASH_SAMPLE; ++i) {
+            batch.call("getblockhash", Json::Int64(mix64(randomSeed ^ i) % static_cast<std::uint64_t>(tipHeight + 1)));
+        }
+        for (const RpcResult& result : client.sendBatch(batch)) {
+            if (result.ok() && result.result.isString()) hashes.push_back(result.result.asString());
+        }
+        if (hashes.empty()) std::print(stderr, "getblockhash failed\n");
+        return !hashes.empty();
+    }
+
+    /**
+     * @brief Returns call `index` and the index of its method.
+     */
+    Call call(std::size_t index, std::uint32_t& method) const {
+        if (!recorded.empty()) {
+            method = recordedMethods[index % recorded.size()];
+            return recorded[index % recorded.size()];
+        }
+        const std::uint64_t random = mix64(randomSeed + index);
+        const std::size_t pick = std::upper_bound(cumulative.begin(), cumulative.end(), random % cumulative.back()) - cumulative.begin();
+        method = mixMethods[pick];
+        return {methods[method], generateParams(methods[method], mix64(random))};
+    }
+
+private:
+    std::uint32_t methodIndex(const std::string& method) {
+        const auto found = std::find(methods.begin(), methods.end(), method);
+        if (found != methods.end()) return static_cast<std::uint32_t>(found - methods.begin());
+        methods.push_back(method);
+        return static_cast<std::uint32_t>(methods.size() - 1);
+    }
+
+    /**
+     * @brief Parameters for the methods the mix knows; other methods are called without any.
+     */
+    Json::Value generateParams(const std::string& method, std::uint64_t random) const {
+        Json::Value params(Json::arrayValue);
+        if (method == "getblockhash" || method == "getblockstats") {
+            params.append(Json::Int64(random % static_cast<std::uint64_t>(tipHeight + 1)));
+        } else if (method == "getblock" || method == "getblockheader") {
+            params.append(hashes[random % hashes.size()]);
+            if (method == "getblock") params.append(1);
+        } else if (method == "estimatesmartfee") {
+            static constexpr int TARGETS[] = {2, 6, 12, 144};
+            params.append(TARGETS[random % std::size(TARGETS)]);
+        }
+        return params;
+    }
+
+    std::uint64_t randomSeed = 1;
+    std::vector<std::uint64_t> cumulative;      ///< Running sum of the mix weights.
+    std::vector<std::uint32_t> mixMethods;      ///< Method of each mix entry.
+    std::vector<Call> recorded;
+    std::vector<std::uint32_t> recordedMethods; ///< Method of each recorded call.
+    std::vector<std::string> hashes;
+    std::int64_t tipHeight = 0;
+};
+
+/**
+ * @class Schedule
+ * @brief When each call is due: evenly spaced at the target rate.
+ */
+class Schedule {
+public:
+    Schedule(double rate, std::size_t total)
+        : start(Clock::now() + START_DELAY), interval(1.0 / rate), total(total) {}
+
+    Clock::time_point due(std::size_t index) const {
+        return start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval * static_cast<double>(index)));
+    }
+
+    const Clock::time_point start;
+    const double interval;                  ///< Seconds between calls.
+    const std::size_t total;
+};
+
+double micros(Clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+/**
+ * @brief Records the answers to calls `first` to `first + methods.size() - 1`, sent together at `sent`.
+ */
+void record(const Schedule& schedule, std::size_t first, Clock::time_point sent, Clock::time_point answered,
+            const std::vector<std::uint32_t>& methods, const std::vector<bool>& ok, std::vector<Sample>& samples) {
+    for (std::size_t i = 0; i < methods.size(); ++i) {
+        samples.push_back({methods[i], i < ok.size() && ok[i], micros(answered - schedule.due(first + i)), micros(answered - sent)});
+    }
+}
+
+/**
+ * @brief Sync and batch modes: workers take the next calls in order, wait until the last is due, and send them.
+ */
+void runBlocking(BitcoinClient& client, const Options& options, const Workload& workload, const Schedule& schedule,
+                 std::vector<Sample>& samples) {
+    std::atomic<std::size_t> next {0};
+    std::vector<std::vector<Sample>> perWorker(options.concurrency);
+    std::vector<std::thread> workers;
+    for (std::size_t w = 0; w < options.concurrency; ++w) {
+        workers.emplace_back([&, w] {
+            std::vector<Sample>& mine = perWorker[w];
+            std::vector<std::uint32_t> methods;
+            std::vector<bool> ok;
+            for (;;) {
+                const std::size_t first = next.fetch_add(options.batchSize, std::memory_order_relaxed);
+                if (first >= schedule.total) return;
+                const std::size_t count = std::min(options.batchSize, schedule.total - first);
+                methods.resize(count);
+                ok.clear();
+                if (options.mode == Mode::Sync) {
+                    const Call call = workload.call(first, methods[0]);
+                    std::this_thread::sleep_until(schedule.due(first));
+                    const Clock::time_point sent = Clock::now();
+                    ok.push_back(client.sendCall(call.method, call.params).ok());
+                    record(schedule, first, sent, Clock::now(), methods, ok, mine);
+                } else {
+                    RpcBatch batch;
+                    for (std::size_t i = 0; i < count; ++i) {
+                        const Call call = workload.call(first + i, methods[i]);
+                        batch.add(call.method, call.params);
+                    }
+                    std::this_thread::sleep_until(schedule.due(first + count - 1));
+                    const Clock::time_point sent = Clock::now();
+                    for (const RpcResult& result : client.sendBatch(batch)) ok.push_back(result.ok());
+                    record(schedule, first, sent, Clock::now(), methods, ok, mine);
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    for (const std::vector<Sample>& mine : perWorker) samples.insert(samples.end(), mine.begin(), mine.end());
+}
+
+/**
+ * @brief Async mode: one thread submits calls when they are due, up to `concurrency` in flight, and collects the answers.
+ */
+void runAsync(BitcoinClient& client, const Options& options, const Workload& workload, const Schedule& schedule,
+              std::vector<Sample>& samples) {
+    struct Pending {
+        std::size_t first;
+        std::vector<std::uint32_t> methods;
+        Clock::time_point sent;
+        std::future<Json::Value> single;
+        std::future<std::vector<RpcResult>> batch;
+    };
+    const auto ready = [](const auto& future) { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; };
+
+    std::vector<Pending> pending;
+    std::vector<bool> ok;
+    std::size_t next = 0;
+    while (next < schedule.total || !pending.empty()) {
+        for (std::size_t i = 0; i < pending.size();) {
+            Pending& request = pending[i];
+            if (request.single.valid() ? !ready(request.single) : !ready(request.batch)) {
+                ++i;
+                continue;
+            }
+            const Clock::time_point answered = Clock::now();
+            ok.clear();
+            if (request.single.valid()) {
+                // The async API reports failures as a null result.
+                ok.push_back(!request.single.get().isNull());
+            } else {
+                for (const RpcResult& result : request.batch.get()) ok.push_back(result.ok());
+            }
+            record(schedule, request.first, request.sent, answered, request.methods, ok, samples);
+            std::swap(request, pending.back());
+            pending.pop_back();
+        }
+
+        if (next >= schedule.total) {
+            std::this_thread::sleep_for(REAP_INTERVAL);
+            continue;
+        }
+        const std::size_t count = std::min(options.batchSize, schedule.total - next);
+        const Clock::time_point due = schedule.due(next + count - 1);
+        if (pending.size() >= options.concurrency || Clock::now() < due) {
+            std::this_thread::sleep_until(std::min(due, Clock::now() + REAP_INTERVAL));
+            continue;
+        }
+
+        Pending request {next, std::vector<std::uint32_t>(count), {}, {}, {}};
+        if (count == 1) {
+            const Call call = workload.call(next, request.methods[0]);
+            request.sent = Clock::now();
+            request.single = client.sendRequestAsync(call.method, call.params);
+        } else {
+            RpcBatch batch;
+            for (std::size_t i = 0; i < count; ++i) {
+                const Call call = workload.call(next + i, request.methods[i]);
+                batch.add(call.method, call.params);
+            }
+            request.sent = Clock::now();
+            request.batch = client.sendBatchAsync(batch);
+        }
+        pending.push_back(std::move(request));
+        next += count;
+    }
+}
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(fraction * static_cast<double>(sorted.size())))];
+}
+
+/**
+ * @brief Prints one row of percentiles, in milliseconds.
+ */
+void printRow(const std::string& name, std::vector<double>& values) {
+    std::sort(values.begin(), values.end());
+    double total = 0;
+    for (double value : values) total += value;
+    const double mean = values.empty() ? 0 : total / static_cast<double>(values.size());
+    std::print("{:<24} {:>8} {:>9.3f} {:>9.3f} {:>9.3f} {:>9.3f} {:>9.3f} {:>9.3f} {:>9.3f}\n", name, values.size(), mean / 1e3,
+               percentile(values, 0.50) / 1e3, percentile(values, 0.90) / 1e3, percentile(values, 0.99) / 1e3,
+               percentile(values, 0.999) / 1e3, percentile(values, 0.9999) / 1e3, values.empty() ? 0 : values.back() / 1e3);
+}
+
+void report(const Options& options, const Workload& workload, const std::vector<Sample>& samples, double seconds) {
+    std::size_t failures = 0;
+    for (const Sample& sample : samples) failures += !sample.ok;
+    const double achieved = seconds > 0 ? static_cast<double>(samples.size()) / seconds : 0;
+    std::print("\n{} calls in {:.2f} s: {:.1f} calls/s of {:.1f} targeted, {} failed\n", samples.size(), seconds, achieved,
+               options.rate, failures);
+    if (achieved < options.rate * 0.95) {
+        std::print("The target rate was not sustained; response times include the backlog.\n");
+    }
+
+    std::print("\n{:<24} {:>8} {:>9} {:>9} {:>9} {:>9} {:>9} {:>9} {:>9}\n", "latency (ms)", "calls", "mean", "p50", "p90", "p99",
+               "p99.9", "p99.99", "max");
+    std::vector<double> response;
+    std::vector<double> service;
+    response.reserve(samples.size());
+    service.reserve(samples.size());
+    for (const Sample& sample : samples) {
+        if (!sample.ok) continue;
+        response.push_back(sample.response);
+        service.push_back(sample.service);
+    }
+    printRow("response time", response);
+    printRow("service time", service);
+
+    if (workload.methods.size() < 2) return;
+    std::print("\n");
+    for (std::uint32_t method = 0; method < workload.methods.size(); ++method) {
+        std::vector<double> latencies;
+        for (const Sample& sample : samples) {
+            if (sample.ok && sample.method == method) latencies.push_back(sample.response);
+        }
+        if (!latencies.empty()) printRow(workload.methods[method], latencies);
+    }
+}
+
+bool readCookie(const std::string& path, Options& options) {
+    std::ifstream file(path);
+    std::string line;
+    if (!file || !std::getline(file, line) || line.find(':') == std::string::npos) {
+        std::print(stderr, "Cannot read credentials from {}\n", path);
+        return false;
+    }
+    options.user = line.substr(0, line.find(':'));
+    options.password = line.substr(line.find(':') + 1);
+    return true;
+}
+
+bool usage(const char* program) {
+    std::print("Usage: {} [--url URL] [--user USER --password PASSWORD | --cookie FILE] [--unix-socket PATH]\n"
+               "       [--rate CALLS_PER_S] [--duration S] [--concurrency N] [--pool N]\n"
+               "       [--mode sync|async|batch] [--batch-size N] [--mix METHOD=WEIGHT,...] [--replay FILE] [--seed N]\n"
+               "  --concurrency N  Worker threads (sync, batch) or requests in flight (async)\n"
+               "  --mix            Generated parameters for getblockhash, getblock, getblockheader, getblockstats\n"
+               "                   and estimatesmartfee; other methods are called without parameters\n"
+               "  --replay FILE    One {{\"method\":...,\"params\":[...]}} object per line, replayed in order\n", program);
+    return false;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (argument == "--url" && hasValue) {
+            options.url = argv[++i];
+        } else if (argument == "--user" && hasValue) {
+            options.user = argv[++i];
+        } else if (argument == "--password" && hasValue) {
+            options.password = argv[++i];
+        } else if (argument == "--cookie" && hasValue) {
+            options.cookie = argv[++i];
+        } else if (argument == "--unix-socket" && hasValue) {
+            options.unixSocket = argv[++i];
+        } else if (argument == "--rate" && hasValue) {
+            options.rate = std::max(std::strtod(argv[++i], nullptr), 0.001);
+        } else if (argument == "--duration" && hasValue) {
+            options.duration = std::max(std::strtod(argv[++i], nullptr), 0.001);
+        } else if (argument == "--concurrency" && hasValue) {
+            options.concurrency = std::max<std::size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (argument == "--pool" && hasValue) {
+            options.pool = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--mode" && hasValue) {
+            const std::string_view mode = argv[++i];
+            if (mode == "sync") options.mode = Mode::Sync;
+            else if (mode == "async") options.mode = Mode::Async;
+            else if (mode == "batch") options.mode = Mode::Batch;
+            else return usage(argv[0]);
+        } else if (argument == "--batch-size" && hasValue) {
+            options.batchSize = std::max<std::size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (argument == "--mix" && hasValue) {
+            options.mix = argv[++i];
+        } else if (argument == "--replay" && hasValue) {
+            options.replay = argv[++i];
+        } else if (argument == "--seed" && hasValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (options.mode == Mode::Sync) options.batchSize = 1;
+    return options.cookie.empty() || readCookie(options.cookie, options);
+}
+}
+
+auto main(int argc, char* argv[]) -> int {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+    Logger::setLevel(LogLevel::Error);
+
+    BitcoinClient client(options.user, options.password, options.url, options.pool ? options.pool : options.concurrency);
+    if (!options.unixSocket.empty()) client.setTransportSettings({.unixSocket = options.unixSocket});
+
+    Workload workload;
+    if (!(options.replay.empty() ? workload.loadMix(options.mix, options.seed) : workload.loadReplay(options.replay))) return 1;
+    if (!workload.sampleChain(client)) return 1;
+    if (options.mode != Mode::Async) client.warmUp(options.pool ? options.pool : options.concurrency);
+
+    const auto total = static_cast<std::size_t>(options.rate * options.duration);
+    static constexpr const char* MODES[] = {"sync", "async", "batch"};
+    std::print("{} calls at {:.1f}/s over {:.1f} s: {} mode, batches of {}, concurrency {}\n", total, options.rate,
+               options.duration, MODES[static_cast<int>(options.mode)], options.batchSize, options.concurrency);
+
+    std::vector<Sample> samples;
+    samples.reserve(total);
+    const Schedule schedule(options.rate, total);
+    if (options.mode == Mode::Async) runAsync(client, options, workload, schedule, samples);
+    else runBlocking(client, options, workload, schedule, samples);
+
+    report(options, workload, samples, std::chrono::duration<double>(Clock::now() - schedule.start).count());
+    return 0;
+}
@@ -0,0 +1,240 @@
+#ifndef MOCKSERVER_HPP
+#define MOCKSERVER_HPP
+
+#include "jsonwriter.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*
+ * An embedded JSON-RPC node for the benchmark and the tests, so neither depends on a
+ * running bitcoind. POSIX sockets only.
+ */
+
+/**
+ * @brief Returns a deterministic pseudo-random hash in display form.
+ */
+inline std::string fakeHash(std::uint64_t seed) {
+    std::string hex;
+    hex.reserve(64);
+    for (int i = 0; i < 4; ++i) {
+        seed = seed * 6364136223846793005 + 1442695040888963407;
+        hex += std::format("{:016x}", seed);
+    }
+    return hex;
+}
+
+/**
+ * @brief Wraps a serialized result into a JSON-RPC response.
+ */
+inline std::string envelope(std::string_view result, std::string_view id) {
+    std::string out;
+    out.reserve(result.size() + id.size() + 32);
+    out += R"({"result":)";
+    out += result;
+    out += R"(,"error":null,"id":)";
+    out += id;
+    out += '}';
+    return out;
+}
+
+/**
+ * @class MockServer
+ * @brief A minimal keep-alive HTTP/1.1 JSON-RPC server on a loopback port, one thread per connection.
+ *
+ * Each call is answered by the responder, which gets the method, the request id as written
+ * and the first parameter read as an integer (0 if it is not one), and returns the whole
+ * response object; `envelope()` builds it. Tests that need every parameter pass a
+ * `CallResponder` instead, which is handed the parsed `params` array.
+ */
+class MockServer {
+public:
+    using Responder = std::function<std::string(const std::string& method, const std::string& id, std::int64_t argument)>;
+    using CallResponder = std::function<std::string(const std::string& method, const Json::Value& params, const std::string& id)>;
+
+    explicit MockServer(Responder responder) : responder(std::move(responder)) {}
+    explicit MockServer(CallResponder responder) : callResponder(std::move(responder)) {}
+
+    ~MockServer() { stop(); }
+
+    bool start() {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener < 0) return false;
+        const int on = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 128) != 0
+            || getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            return false;
+        }
+        serverPort = ntohs(address.sin_port);
+        acceptor = std::thread(&MockServer::acceptLoop, this, listener);
+        return true;
+    }
+
+    void stop() {
+        if (listener < 0) return;
+        // Shutting down wakes the blocked accept(); the socket is closed once nothing uses it.
+        shutdown(listener, SHUT_RDWR);
+        if (acceptor.joinable()) acceptor.join();
+        close(listener);
+        listener = -1;
+        std::vector<std::thread> running;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int connection : connections) shutdown(connection, SHUT_RDWR);
+            running.swap(workers);
+        }
+        for (std::thread& worker : running) worker.join();    // Workers take the lock to unregister.
+    }
+
+    std::string url() const { return std::format("http://127.0.0.1:{}/", serverPort); }
+
+    /**
+     * @brief Returns the number of connections accepted so far.
+     */
+    std::size_t accepted() const { return acceptedCount.load(); }
+
+private:
+    void acceptLoop(int listening) {
+        while (true) {
+            const int connection = accept(listening, nullptr, nullptr);
+            if (connection < 0) return;
+            const int on = 1;
+            setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            acceptedCount.fetch_add(1);
+            std::lock_guard<std::mutex> lock(mutex);
+            connections.push_back(connection);
+            workers.emplace_back(&MockServer::serve, this, connection);
+        }
+    }
+
+    void serve(int connection) {
+        std::string buffer;
+        std::string body;
+        std::string reply;
+        char chunk[65536];
+        while (true) {
+            std::size_t headerEnd;
+            while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+                const ssize_t received = recv(connection, chunk, sizeof(chunk), 0);
+                if (received <= 0) return finish(connection);
+                buffer.append(chunk, static_cast<std::size_t>(received));
+            }
+            std::size_t contentLength = 0;
+            const std::size_t field = buffer.find("Content-Length:");
+            if (field != std::string::npos && field < headerEnd) contentLength = std::strtoull(buffer.c_str() + field + 15, nullptr, 10);
+            while (buffer.size() < headerEnd + 4 + contentLength) {
+                const ssize_t received = recv(connection, chunk, sizeof(chunk), 0);
+                if (received <= 0) return finish(connection);
+                buffer.append(chunk, static_cast<std::size_t>(received));
+            }
+            body.assign(buffer, headerEnd + 4, contentLength);
+            buffer.erase(0, headerEnd + 4 + contentLength);
+
+            answer(body, reply);
+            const std::string head = std::format("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: {}\r\n\r\n", reply.size());
+            if (!sendAll(connection, head) || !sendAll(connection, reply)) return finish(connection);
+        }
+    }
+
+    void finish(int connection) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::erase(connections, connection);
+        close(connection);
+    }
+
+    static bool sendAll(int connection, std::string_view data) {
+        while (!data.empty()) {
+            const ssize_t sent = send(connection, data.data(), data.size(), MSG_NOSIGNAL);
+            if (sent <= 0) return false;
+            data.remove_prefix(static_cast<std::size_t>(sent));
+        }
+        return true;
+    }
+
+    void answer(const std::string& body, std::string& reply) {
+        if (callResponder) return answerParsed(body, reply);
+        if (!body.empty() && body[0] == '[') {
+            // Batches are rare enough to be parsed properly.
+            Json::Value calls;
+            std::string errors;
+            std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+            reader->parse(body.data(), body.data() + body.size(), &calls, &errors);
+            reply = "[";
+            for (Json::ArrayIndex i = 0; i < calls.size(); ++i) {
+                if (i) reply += ',';
+                std::string id;
+                JsonWriter(id).write(calls[i]["id"]);
+                const Json::Value& first = calls[i]["params"][0];
+                reply += responder(calls[i]["method"].asString(), id, first.isIntegral() ? first.asInt64() : 0);
+            }
+            reply += ']';
+            return;
+        }
+        reply = responder(field(body, "\"method\":\""), field(body, "\"id\":"),
+                          std::strtoll(field(body, "\"params\":[").c_str(), nullptr, 10));
+    }
+
+    void answerParsed(const std::string& body, std::string& reply) {
+        Json::Value request;
+        std::string errors;
+        std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+        reader->parse(body.data(), body.data() + body.size(), &request, &errors);
+        const auto call = [&](const Json::Value& one) {
+            std::string id;
+            JsonWriter(id).write(one["id"]);
+            return callResponder(one["method"].asString(), one["params"], id);
+        };
+        if (!request.isArray()) {
+            reply = call(request);
+            return;
+        }
+        reply = "[";
+        for (Json::ArrayIndex i = 0; i < request.size(); ++i) {
+            if (i) reply += ',';
+            reply += call(request[i]);
+        }
+        reply += ']';
+    }
+
+    /**
+     * @brief Returns the text of a member of a compact request, up to the next delimiter.
+     */
+    static std::string field(const std::string& body, std::string_view name) {
+        const std::size_t start = body.find(name);
+        if (start == std::string::npos) return {};
+        const std::size_t from = start + name.size();
+        return body.substr(from, body.find_first_of("\",}", from) - from);
+    }
+
+    Responder responder;
+    CallResponder callResponder;
+    int listener = -1;
+    std::uint16_t serverPort = 0;
+    std::atomic<std::size_t> acceptedCount {0};
+    std::thread acceptor;
+    std::mutex mutex;
+    std::vector<int> connections;
+    std::vector<std::thread> workers;
+};
+
+#endif // MOCKSERVER_HPP
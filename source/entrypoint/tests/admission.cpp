@@ -0,0 +1,63 @@
+#include <doctest/doctest.h>
+
+#include "bitcoinclient.hpp"
+#include "../mockserver.hpp"
+
+#include <array>
+#include <string>
+
+/*
+ * The admission lane a request waits in, read back from the queue-wait histograms of Metrics.
+ */
+
+namespace {
+/**
+ * @brief Returns how many requests waited in each lane so far.
+ */
+std::array<std::uint64_t, REQUEST_PRIORITIES> admitted(const BitcoinClient& client) {
+    const MetricsSnapshot snapshot = client.metrics()->snapshot();
+    std::array<std::uint64_t, REQUEST_PRIORITIES> counts {};
+    for (std::size_t i = 0; i < REQUEST_PRIORITIES; ++i) counts[i] = snapshot.transport.queueWait[i].count;
+    return counts;
+}
+
+/**
+ * @brief Sends one batch and returns the lane it was admitted in.
+ */
+RequestPriority laneOf(BitcoinClient& client, const RpcBatch& batch) {
+    const auto before = admitted(client);
+    client.sendBatch(batch);
+    const auto after = admitted(client);
+    for (std::size_t i = 0; i < REQUEST_PRIORITIES; ++i) {
+        if (after[i] != before[i]) return static_cast<RequestPriority>(i);
+    }
+    return static_cast<RequestPriority>(REQUEST_PRIORITIES);      // Not admitted at all.
+}
+}
+
+TEST_CASE("a batch waits in the lane of its least urgent call") {
+    MockServer server([](const std::string&, const std::string& id, std::int64_t) { return envelope("null", id); });
+    REQUIRE(server.start());
+    BitcoinClient client("user", "password", server.url());
+    client.enableMetrics();
+    client.enableAdmissionControl();
+
+    RpcBatch broadcasts;
+    broadcasts.call("sendrawtransaction", "00");
+    broadcasts.call("testmempoolaccept", Json::Value(Json::arrayValue));
+    CHECK(laneOf(client, broadcasts) == RequestPriority::Interactive);
+
+    RpcBatch mixed;
+    mixed.call("sendrawtransaction", "00");
+    mixed.call("getblockcount");
+    CHECK(laneOf(client, mixed) == RequestPriority::Normal);
+
+    RpcBatch heavy;
+    heavy.call("getmempoolentry", "00");
+    heavy.call("getblock", "00", 2);
+    CHECK(laneOf(client, heavy) == RequestPriority::Bulk);
+
+    // An enclosing scope still decides.
+    PriorityScope bulk(RequestPriority::Bulk);
+    CHECK(laneOf(client, broadcasts) == RequestPriority::Bulk);
+}
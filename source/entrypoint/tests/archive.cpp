@@ -0,0 +1,83 @@
+#include <doctest/doctest.h>
+
+#include "responsearchive.hpp"
+#include "../mockserver.hpp"
+#include "scratch.hpp"
+
+#include <string>
+
+/*
+ * ResponseArchive on a scratch directory: height-keyed `getblockstats` must be served from the
+ * archive on the next run once the block is deep, and never while it is shallow.
+ */
+
+namespace {
+Json::Value heightParams(std::int64_t height) {
+    Json::Value params(Json::arrayValue);
+    params.append(Json::Int64(height));
+    return params;
+}
+
+Json::Value stats(std::int64_t height) {
+    Json::Value result(Json::objectValue);
+    result["blockhash"] = fakeHash(static_cast<std::uint64_t>(height));
+    result["height"] = Json::Int64(height);
+    result["totalfee"] = Json::Int64(height * 10);
+    return result;
+}
+}
+
+TEST_CASE("getblockstats by height is served from the archive once the block is deep") {
+    ScratchDirectory directory("bitcoin-rpc-archive");
+    ArchiveSettings settings;
+    settings.minConfirmations = 6;
+    {
+        ResponseArchive archive(directory.string(), settings);
+        REQUIRE(archive.open());
+        archive.noteTip(1000);
+        archive.store("getblockstats", heightParams(995), stats(995));     // 6 confirmations.
+        archive.store("getblockstats", heightParams(996), stats(996));     // 5: archived by hash only.
+        CHECK(archive.lookup("getblockstats", heightParams(995)).has_value());
+        CHECK_FALSE(archive.lookup("getblockstats", heightParams(996)).has_value());
+        CHECK(archive.blockHash(995).has_value());
+        CHECK_FALSE(archive.blockHash(996).has_value());
+
+        // The chain moves on; fetching the shallow height again indexes the record it already has.
+        archive.noteTip(1001);
+        archive.store("getblockstats", heightParams(996), stats(996));
+        CHECK(archive.stats().records == 2);
+    }
+
+    // The next run finds both by height, and the hash form of each as well.
+    ResponseArchive archive(directory.string(), settings);
+    REQUIRE(archive.open());
+    for (const std::int64_t height : {995, 996}) {
+        CAPTURE(height);
+        const std::optional<Json::Value> byHeight = archive.lookup("getblockstats", heightParams(height));
+        REQUIRE(byHeight.has_value());
+        CHECK((*byHeight)["totalfee"].asInt64() == height * 10);
+        Json::Value byHash(Json::arrayValue);
+        byHash.append(fakeHash(static_cast<std::uint64_t>(height)));
+        CHECK(archive.lookup("getblockstats", byHash).has_value());
+    }
+    CHECK(archive.stats().heights == 2);
+}
+
+TEST_CASE("getblockstats is not indexed by height before the archive has seen a tip") {
+    ScratchDirectory directory("bitcoin-rpc-archive-notip");
+    ResponseArchive archive(directory.string());
+    REQUIRE(archive.open());
+    archive.store("getblockstats", heightParams(100), stats(100));
+    CHECK_FALSE(archive.lookup("getblockstats", heightParams(100)).has_value());
+
+    // A verbose header 200 deep tells the archive where the tip is.
+    Json::Value header(Json::objectValue);
+    header["hash"] = fakeHash(7);
+    header["height"] = 50;
+    header["confirmations"] = 200;
+    Json::Value params(Json::arrayValue);
+    params.append(fakeHash(7));
+    archive.store("getblockheader", params, header);
+    archive.store("getblockstats", heightParams(100), stats(100));
+    CHECK(archive.lookup("getblockstats", heightParams(100)).has_value());
+}
@@ -0,0 +1,211 @@
+#include <doctest/doctest.h>
+
+#include "address.hpp"
+#include "descriptor.hpp"
+#include "hexcodec.hpp"
+#include "ripemd160.hpp"
+#include "secp256k1.hpp"
+#include "sha512.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Known-answer vectors for local address derivation: the hashes, BIP32 CKDpub, the script
+ * templates, taproot tweaking and the address encodings. A wrong result here means wrong
+ * deposit addresses, so every expected value comes from a specification or from Bitcoin Core,
+ * never from this code.
+ */
+
+namespace {
+std::span<const std::uint8_t> bytes(std::string_view text) {
+    return {reinterpret_cast<const std::uint8_t*>(text.data()), text.size()};
+}
+
+std::vector<std::uint8_t> fromHex(std::string_view hex) {
+    std::vector<std::uint8_t> out(hex.size() / 2);
+    REQUIRE(decodeHex(hex, out.data()));
+    return out;
+}
+
+PublicKey publicKey(std::string_view hex) {
+    PublicKey key;
+    REQUIRE(decodeHex(hex, key.data()));
+    return key;
+}
+
+std::string scriptOf(std::string_view descriptor, std::uint32_t index = 0) {
+    Descriptor parsed;
+    REQUIRE(parsed.parse(descriptor));
+    std::vector<std::uint8_t> script;
+    REQUIRE(parsed.scriptPubKey(index, script));
+    return encodeHex(script);
+}
+
+std::string addressOf(std::string_view descriptor, std::uint32_t index) {
+    Descriptor parsed;
+    REQUIRE(parsed.parse(descriptor));
+    return parsed.address(index, AddressNetwork::Main);
+}
+
+// BIP32 test vector 2.
+constexpr std::string_view BIP32_TV2_M = "xpub661MyMwAqRbcFW31YEwpkMuc5THy2PSt5bDMsktWQcFF8syAmRUapSCGu8ED9W6oDMSgv6Zz8idoc4a6mr8BDzTJY47LJhkJ8UB7WEGuduB";
+constexpr std::string_view BIP32_TV2_M_0 = "xpub69H7F5d8KSRgmmdJg2KhpAK8SR3DjMwAdkxj3ZuxV27CprR9LgpeyGmXUbC6wb7ERfvrnKZjXoUmmDznezpbZb7ap6r1D3tgFxHmwMkQTPH";
+
+// Account keys of the BIP44/84/86 test mnemonic "abandon abandon ... about".
+constexpr std::string_view BIP44_ACCOUNT = "xpub6BosfCnifzxcFwrSzQiqu2DBVTshkCXacvNsWGYJVVhhawA7d4R5WSWGFNbi8Aw6ZRc1brxMyWMzG3DSSSSoekkudhUd9yLb6qx39T9nMdj";
+constexpr std::string_view BIP84_ACCOUNT = "xpub6CatWdiZiodmUeTDp8LT5or8nmbKNcuyvz7WyksVFkKB4RHwCD3XyuvPEbvqAQY3rAPshWcMLoP2fMFMKHPJ4ZeZXYVUhLv1VMrjPC7PW6V";
+constexpr std::string_view BIP86_ACCOUNT = "xpub6BgBgsespWvERF3LHQu6CnqdvfEvtMcQjYrcRzx53QJjSxarj2afYWcLteoGVky7D3UKDP9QyrLprQ3VCECoY49yfdDEHGCtMMj92pReUsQ";
+}
+
+TEST_CASE("RIPEMD-160 matches the reference vectors") {
+    CHECK(encodeHex(ripemd160(bytes(""))) == "9c1185a5c5e9fc54612808977ee8f548b2258d31");
+    CHECK(encodeHex(ripemd160(bytes("abc"))) == "8eb208f7e05d987a9b044a8e98c6b087f15a0bfc");
+    CHECK(encodeHex(ripemd160(bytes("message digest"))) == "5d0689ef49d2fae572b881b123a85ffa21595f36");
+}
+
+TEST_CASE("SHA-512 and HMAC-SHA512 match FIPS 180 and RFC 4231") {
+    Sha512 hasher;
+    CHECK(encodeHex(hasher.write(bytes("abc")).finalize())
+          == "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f");
+    // Two blocks once padded.
+    CHECK(encodeHex(hasher.write(bytes("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu")).finalize())
+          == "8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909");
+
+    // RFC 4231 test cases 1, 2 and 6 (a key longer than the block is hashed first).
+    const std::vector<std::uint8_t> key1(20, 0x0b);
+    CHECK(encodeHex(hmacSha512(key1, bytes("Hi There")))
+          == "87aa7cdea5ef619d4ff0b4241a1d6cb02379f4e2ce4ec2787ad0b30545e17cdedaa833b7d6b8a702038b274eaea3f4e4be9d914eeb61f1702e696c203a126854");
+    CHECK(encodeHex(hmacSha512(bytes("Jefe"), bytes("what do ya want for nothing?")))
+          == "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea2505549758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737");
+    const std::vector<std::uint8_t> key6(131, 0xaa);
+    CHECK(encodeHex(hmacSha512(key6, bytes("Test Using Larger Than Block-Size Key - Hash Key First")))
+          == "80b24263c7c1a3ebb71493c1dd7be8b49b46d1f41b4aeec1121b013783f8f3526b56d037e05f2598bd0fd2215d6a1e5295e64f73f63f0aec8b915a985d786598");
+}
+
+TEST_CASE("public keys off the curve are rejected") {
+    // The generator point.
+    CHECK(isValidPublicKey(publicKey("0279be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798")));
+    // x = 5: x^3 + 7 has no square root modulo p.
+    CHECK_FALSE(isValidPublicKey(publicKey("020000000000000000000000000000000000000000000000000000000000000005")));
+    // x = p is not a field element.
+    CHECK_FALSE(isValidPublicKey(publicKey("02fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f")));
+    // Not a compressed key.
+    CHECK_FALSE(isValidPublicKey(publicKey("0479be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798")));
+
+    // An xpub whose key is off the curve, with a valid base58check checksum.
+    ExtendedPublicKey master;
+    REQUIRE(master.parse(BIP32_TV2_M));
+    master.key = publicKey("020000000000000000000000000000000000000000000000000000000000000005");
+    ExtendedPublicKey parsed;
+    CHECK_FALSE(parsed.parse(master.toString()));
+}
+
+TEST_CASE("BIP32 public derivation matches test vector 2") {
+    ExtendedPublicKey master;
+    REQUIRE(master.parse(BIP32_TV2_M));
+    CHECK(master.toString() == BIP32_TV2_M);
+
+    ExtendedPublicKey child;
+    REQUIRE(master.derive(0, child));
+    CHECK(child.toString() == BIP32_TV2_M_0);
+    CHECK_FALSE(master.derive(HARDENED_CHILD, child));
+}
+
+TEST_CASE("descriptor scripts match the BIP 381, 382, 386 and Bitcoin Core vectors") {
+    CHECK(scriptOf("pkh(02c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5)")
+          == "76a91406afd46bcdfd22ef94ac122aa11f241244a37ecc88ac");
+    CHECK(scriptOf("wpkh(02f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9)")
+          == "00147dd65592d0ab2fe0d0257d571abf032cd9db93dc");
+    CHECK(scriptOf("sh(wpkh(03fff97bd5755eeea420453a14355235d382f6472f8568a18b2f057a1460297556))")
+          == "a914cc6ffbc0bf31af759451068f90ba7a0272b6b33287");
+    CHECK(scriptOf("tr(a34b99f22c790c4e36b2b3c2c35a36db06226e41c692fc82b8b56ac1c540c5bd)")
+          == "512077aab6e066f8a7419c5ab714c12c67d25007ed55a43cadcacb4d7a970a093f11");
+}
+
+TEST_CASE("multisig descriptors match the BIP 383 vectors bare and wrapped") {
+    CHECK(scriptOf("multi(1,022f8bde4d1a07209355b4a7250a5c5128e88b84bddc619ab7cba8d569b240efe4,025cbdf0646e5db4eaa398f365f2ea7a0e3d419b7e0330e39ce92bddedcac4f9bc)")
+          == "5121022f8bde4d1a07209355b4a7250a5c5128e88b84bddc619ab7cba8d569b240efe421025cbdf0646e5db4eaa398f365f2ea7a0e3d419b7e0330e39ce92bddedcac4f9bc52ae");
+    // The same two keys in the order given and sorted; `sortedmulti` swaps them.
+    const std::string keys = "03acd484e2f0c7f65309ad178a9f559abde09796974c57e714c35f110dfc27ccbe,022f01e5e15cca351daff3843fb70f3c2f0a1bdd05e5af888a67784ef3e10a2a01";
+    CHECK(scriptOf("sortedmulti(2," + keys + ")")
+          == "5221022f01e5e15cca351daff3843fb70f3c2f0a1bdd05e5af888a67784ef3e10a2a012103acd484e2f0c7f65309ad178a9f559abde09796974c57e714c35f110dfc27ccbe52ae");
+    CHECK(addressOf("sh(multi(2," + keys + "))", 0) == "3482LuQXaHVd7wtSy4wxNV6XKVJCCNJQXw");
+    CHECK(scriptOf("sh(sortedmulti(2," + keys + "))") == "a914a6a8b030a38762f4c1f5cbe387b61a3c5da5cd2687");
+    CHECK(addressOf("sh(sortedmulti(2," + keys + "))", 0) == "3GtEB3yg3r5de2cDJG48SkQwxfxJumKQdN");
+
+    const std::string wsh = "wsh(multi(2,03a0434d9e47f3c86235477c7b1ae6ae5d3442d49b1943c2b752a68e2a47e247c7,"
+                            "03774ae7f858a9411e5ef4246b70c65aac5649980be5c17891bbec17895da008cb,"
+                            "03d01115d548e7561b15c38f004d734633687cf4419620095bc5b0f47070afe85a))";
+    CHECK(scriptOf(wsh) == "0020773d709598b76c4e3b575c08aad40658963f9322affc0f8c28d1d9a68d0c944a");
+    CHECK(addressOf(wsh, 0) == "bc1qwu7hp9vckakyuw6htsy244qxtztrlyez4l7qlrpg68v6drgvj39qn4zazc");
+
+    const std::string shWsh = "sh(wsh(multi(1,03f28773c2d975288bc7d1d205c3748651b075fbc6610e58cddeeddf8f19405aa8,"
+                              "03499fdf9e895e719cfd64e67f07d38e3226aa7b63678949e6e49b241a60e823e4,"
+                              "02d7924d4f7d43ea965a465ae3095ff41131e5946f3c85f79e44adbcf8e27e080e)))";
+    CHECK(scriptOf(shWsh) == "a914aec509e284f909f769bb7dda299a717c87cc97ac87");
+    CHECK(addressOf(shWsh, 0) == "3Hd7YQStg9gYpEt6hgK14ZHUABxSURzeuQ");
+
+    // Ranged keys are derived per index; at index 2 the derived keys sort the other way round.
+    const std::string ranged = std::string(BIP32_TV2_M) + "/1/0/*," + std::string(BIP32_TV2_M_0) + "/0/0/*";
+    CHECK(addressOf("sh(multi(1," + ranged + "))", 0) == "3FLML3R8HNJzPsDV2Z448XtJFfDANDxVs7");
+    CHECK(addressOf("sh(multi(1," + ranged + "))", 1) == "32ru9EqSC58qhtVdMGoredf9ePUnFDsCSZ");
+    CHECK(addressOf("sh(multi(1," + ranged + "))", 2) == "3Jd5ovnK85cA73SjHuWGf7ay6zZbo1gRXL");
+    CHECK(addressOf("wsh(sortedmulti(1," + ranged + "))", 0) == "bc1qvjtfmrxu524qhdevl6yyyasjs7xmnzjlqlu60mrwepact60eyz9s9xjw0c");
+    CHECK(addressOf("wsh(sortedmulti(1," + ranged + "))", 1) == "bc1qp6rfclasvmwys7w7j4svgc2mrujq9m73s5shpw4e799hwkdcqlcsj464fw");
+    CHECK(addressOf("wsh(sortedmulti(1," + ranged + "))", 2) == "bc1qvxcjrqhrkdkkuujfk3enulmwve5r2x4cm9f4q8g64kg64q7puyvsv8vkcm");
+
+    // Thresholds outside 1..n are refused.
+    Descriptor parsed;
+    CHECK_FALSE(parsed.parse("multi(0," + keys + ")"));
+    CHECK_FALSE(parsed.parse("multi(3," + keys + ")"));
+}
+
+TEST_CASE("descriptor checksums follow BIP 380 and are enforced when parsing") {
+    CHECK(descriptorChecksum("raw(deadbeef)") == "89f8spxm");
+    CHECK(descriptorChecksum("pkh(02c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5)") == "8fhd9pwu");
+    CHECK(descriptorChecksum("wpkh(02f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9)") == "8zl0zxma");
+    CHECK(descriptorChecksum("sh(wpkh(03fff97bd5755eeea420453a14355235d382f6472f8568a18b2f057a1460297556))") == "qkrrc7je");
+    CHECK(descriptorChecksum("tr(a34b99f22c790c4e36b2b3c2c35a36db06226e41c692fc82b8b56ac1c540c5bd)") == "dh4fyxrd");
+
+    const std::string descriptor = "wpkh(02f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9)";
+    Descriptor parsed;
+    CHECK(parsed.parse(descriptor + "#8zl0zxma"));
+    CHECK(parsed.toString() == descriptor + "#8zl0zxma");
+    // One character off, a character outside the checksum alphabet, and the wrong length.
+    CHECK_FALSE(parsed.parse(descriptor + "#8zl0zxmq"));
+    CHECK_FALSE(parsed.error().empty());
+    CHECK_FALSE(parsed.parse(descriptor + "#8zl0zxmb"));
+    CHECK_FALSE(parsed.parse(descriptor + "#8zl0zxm"));
+}
+
+TEST_CASE("ranged descriptors derive the BIP 44, 84 and 86 test addresses") {
+    const std::string pkh = "pkh([73c5da0a/44'/0'/0']" + std::string(BIP44_ACCOUNT) + "/0/*)";
+    CHECK(addressOf(pkh, 0) == "1LqBGSKuX5yYUonjxT5qGfpUsXKYYWeabA");
+
+    const std::string wpkh = "wpkh([73c5da0a/84'/0'/0']" + std::string(BIP84_ACCOUNT) + "/0/*)";
+    CHECK(addressOf(wpkh, 0) == "bc1qcr8te4kr609gcawutmrza0j4xv80jy8z306fyu");
+    CHECK(addressOf(wpkh, 1) == "bc1qnjg0jd8228aq7egyzacy8cys3knf9xvrerkf9g");
+
+    // Taproot: BIP86 tweaks the derived key with an empty script tree.
+    const std::string receive = "tr([73c5da0a/86'/0'/0']" + std::string(BIP86_ACCOUNT) + "/0/*)";
+    CHECK(addressOf(receive, 0) == "bc1p5cyxnuxmeuwuvkwfem96lqzszd02n6xdcjrs20cac6yqjjwudpxqkedrcr");
+    CHECK(addressOf(receive, 1) == "bc1p4qhjn9zdvkux4e44uhx8tc55attvtyu358kutcqkudyccelu0was9fqzwh");
+    const std::string change = "tr([73c5da0a/86'/0'/0']" + std::string(BIP86_ACCOUNT) + "/1/*)";
+    CHECK(addressOf(change, 0) == "bc1p3qkhfews2uk44qtvauqyr2ttdsw7svhkl9nkm9s9c3x4ax5h60wqwruhk7");
+
+    // Derivation split across threads gives the same addresses.
+    Descriptor parsed;
+    REQUIRE(parsed.parse(receive));
+    const std::vector<std::string> range = parsed.addresses(0, 2, AddressNetwork::Main, 2);
+    REQUIRE(range.size() == 2);
+    CHECK(range[1] == "bc1p4qhjn9zdvkux4e44uhx8tc55attvtyu358kutcqkudyccelu0was9fqzwh");
+
+    // The address decodes back to the script it was encoded from.
+    std::vector<std::uint8_t> script;
+    REQUIRE(decodeAddress("bc1p5cyxnuxmeuwuvkwfem96lqzszd02n6xdcjrs20cac6yqjjwudpxqkedrcr", AddressNetwork::Main, script));
+    CHECK(encodeHex(script) == "5120a60869f0dbcf1dc659c9cecbaf8050135ea9e8cdc487053f1dc6880949dc684c");
+    CHECK(encodeAddress(fromHex("5120a60869f0dbcf1dc659c9cecbaf8050135ea9e8cdc487053f1dc6880949dc684c"), AddressNetwork::Main)
+          == "bc1p5cyxnuxmeuwuvkwfem96lqzszd02n6xdcjrs20cac6yqjjwudpxqkedrcr");
+}
@@ -0,0 +1,20 @@
+#define DOCTEST_CONFIG_IMPLEMENT
+#include <doctest/doctest.h>
+
+#include "logger.hpp"
+
+/*
+ * Tests of the library, run by ctest:
+ *
+ *     cmake -S . -B build -DENABLE_TESTING=ON
+ *     cmake --build build && ctest --test-dir build --output-on-failure
+ *
+ * Tests that need a node talk to the embedded MockServer instead.
+ */
+
+auto main(int argc, char* argv[]) -> int {
+    // Failures are reported by the assertions; the client's own error log is only noise here.
+    Logger::setLevel(LogLevel::Error);
+    doctest::Context context(argc, argv);
+    return context.run();
+}
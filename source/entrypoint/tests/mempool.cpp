@@ -0,0 +1,212 @@
+#include <doctest/doctest.h>
+
+#include "mempoolmirror.hpp"
+#include "jsonwriter.hpp"
+#include "../mockserver.hpp"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+ * MempoolMirror against a scripted node. The node keeps the mempool sequence the way Bitcoin
+ * Core does: one step per addition and per removal, including the removals of a connected
+ * block, for which the `sequence` feed sends no `R` event. A mirror that loses count reloads
+ * the whole mempool, which the node counts.
+ */
+
+namespace {
+/**
+ * @class FakeNode
+ * @brief Answers `getrawmempool`, `getmempoolentry` and `getblock` from an in-memory mempool.
+ */
+class FakeNode {
+public:
+    FakeNode() : server([this](const std::string& method, const Json::Value& params, const std::string& id) {
+        return answer(method, params, id);
+    }) {}
+
+    bool start() { return server.start(); }
+    std::string url() const { return server.url(); }
+
+    /**
+     * @brief Adds a transaction; returns the mempool sequence of its `A` event.
+     */
+    std::uint64_t add(const std::string& txid) {
+        std::lock_guard<std::mutex> lock(mutex);
+        mempool.insert(txid);
+        return sequence++;
+    }
+
+    /**
+     * @brief Removes a transaction; returns the mempool sequence of its `R` event.
+     */
+    std::uint64_t remove(const std::string& txid) {
+        std::lock_guard<std::mutex> lock(mutex);
+        mempool.erase(txid);
+        return sequence++;
+    }
+
+    /**
+     * @brief Connects a block; every transaction of it that was in the mempool leaves it silently.
+     */
+    void mine(const std::string& blockHash, const std::vector<std::string>& txids) {
+        std::lock_guard<std::mutex> lock(mutex);
+        blocks[blockHash] = txids;
+        for (const std::string& txid : txids) {
+            if (mempool.erase(txid) != 0) ++sequence;
+        }
+    }
+
+    std::size_t loads() const { return verboseLoads.load(); }      ///< `getrawmempool true` calls so far.
+
+    std::uint64_t sequence = 100;   ///< Set before the mirror bootstraps.
+
+private:
+    static std::string entry() {
+        return R"({"vsize":141,"weight":561,"time":1700000000,"height":800000,"fees":{"base":0.00001410,"modified":0.00001410},)"
+               R"("depends":[],"spentby":[],"bip125-replaceable":false})";
+    }
+
+    std::string answer(const std::string& method, const Json::Value& params, const std::string& id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string result;
+        if (method == "getrawmempool" && params[0].asBool()) {
+            verboseLoads.fetch_add(1);
+            result = "{";
+            for (const std::string& txid : mempool) {
+                if (result.size() > 1) result += ',';
+                result += '"' + txid + "\":" + entry();
+            }
+            result += '}';
+        } else if (method == "getrawmempool") {
+            result = R"({"txids":[],"mempool_sequence":)" + std::to_string(sequence) + '}';
+        } else if (method == "getmempoolentry") {
+            if (!mempool.contains(params[0].asString())) {
+                return R"({"result":null,"error":{"code":-5,"message":"Transaction not in mempool"},"id":)" + id + '}';
+            }
+            result = entry();
+        } else if (method == "getblock") {
+            JsonWriter writer(result);
+            Json::Value block(Json::objectValue);
+            Json::Value& tx = block["tx"] = Json::Value(Json::arrayValue);
+            for (const std::string& txid : blocks[params[0].asString()]) tx.append(txid);
+            writer.write(block);
+        } else {
+            result = "null";
+        }
+        return envelope(result, id);
+    }
+
+    std::mutex mutex;
+    std::set<std::string> mempool;
+    std::map<std::string, std::vector<std::string>> blocks;
+    std::atomic<std::size_t> verboseLoads {0};
+    MockServer server;
+};
+
+Hash256 txid(std::uint64_t n) {
+    Hash256 hash {};
+    parseHash(fakeHash(n), hash);
+    return hash;
+}
+}
+
+TEST_CASE("a block between two additions does not make the mirror reload") {
+    FakeNode node;
+    node.add(fakeHash(1));
+    node.add(fakeHash(2));
+    REQUIRE(node.start());
+    BitcoinClient client("user", "password", node.url());
+    MempoolMirror mirror(client);
+    REQUIRE(mirror.bootstrap());
+    REQUIRE(node.loads() == 1);
+
+    // A, C, A in one batch; the block confirms a mirrored transaction and the pending addition.
+    mirror.onTransactionAdded(txid(3), node.add(fakeHash(3)));
+    node.mine(fakeHash(1000), {fakeHash(999), fakeHash(1), fakeHash(3)});
+    mirror.onBlockConnected(txid(1000));
+    mirror.onTransactionAdded(txid(4), node.add(fakeHash(4)));
+    REQUIRE(mirror.sync());
+
+    CHECK(node.loads() == 1);
+    CHECK(mirror.sequence() == node.sequence);
+    CHECK(mirror.size() == 2);
+    CHECK(mirror.contains(txid(2)));
+    CHECK(mirror.contains(txid(4)));
+    CHECK_FALSE(mirror.contains(txid(1)));
+    CHECK_FALSE(mirror.contains(txid(3)));
+
+    // The same across syncs, with a transaction evicted before its block arrives.
+    mirror.onTransactionAdded(txid(5), node.add(fakeHash(5)));
+    REQUIRE(mirror.sync());
+    mirror.onTransactionRemoved(txid(2), node.remove(fakeHash(2)));
+    node.mine(fakeHash(1001), {fakeHash(998), fakeHash(2), fakeHash(4), fakeHash(5)});
+    mirror.onBlockConnected(txid(1001));
+    REQUIRE(mirror.sync());
+    mirror.onTransactionAdded(txid(6), node.add(fakeHash(6)));
+    REQUIRE(mirror.sync());
+
+    CHECK(node.loads() == 1);
+    CHECK(mirror.sequence() == node.sequence);
+    CHECK(mirror.size() == 1);
+    CHECK(mirror.contains(txid(6)));
+}
+
+TEST_CASE("a lost event still makes the mirror reload") {
+    FakeNode node;
+    node.add(fakeHash(1));
+    REQUIRE(node.start());
+    BitcoinClient client("user", "password", node.url());
+    MempoolMirror mirror(client);
+    REQUIRE(mirror.bootstrap());
+
+    node.add(fakeHash(2));      // Never announced.
+    mirror.onTransactionAdded(txid(3), node.add(fakeHash(3)));
+    REQUIRE(mirror.sync());
+
+    CHECK(node.loads() == 2);
+    CHECK(mirror.sequence() == node.sequence);
+    CHECK(mirror.size() == 3);
+    CHECK(mirror.contains(txid(2)));
+}
+
+TEST_CASE("the txid table finds every survivor through growth, erasure and slot reuse") {
+    // Enough transactions for the index to grow several times past its minimum size, so
+    // probe runs are long and erasures shift many members back.
+    constexpr std::uint64_t COUNT = 5000;
+    FakeNode node;
+    for (std::uint64_t n = 0; n < COUNT; ++n) node.add(fakeHash(n));
+    REQUIRE(node.start());
+    BitcoinClient client("user", "password", node.url());
+    MempoolMirror mirror(client);
+    REQUIRE(mirror.bootstrap());
+    REQUIRE(mirror.size() == COUNT);
+
+    // Erase two thirds, so most probe runs lose members from their middle.
+    for (std::uint64_t n = 0; n < COUNT; ++n) {
+        if (n % 3 != 0) mirror.onTransactionRemoved(txid(n), node.remove(fakeHash(n)));
+    }
+    REQUIRE(mirror.sync());
+    CHECK(mirror.size() == (COUNT + 2) / 3);
+    std::size_t misplaced = 0;
+    for (std::uint64_t n = 0; n < COUNT; ++n) {
+        if (mirror.contains(txid(n)) != (n % 3 == 0)) ++misplaced;
+    }
+    CHECK(misplaced == 0);
+
+    // Additions reuse the freed entries and grow the index again.
+    for (std::uint64_t n = COUNT; n < 3 * COUNT; ++n) mirror.onTransactionAdded(txid(n), node.add(fakeHash(n)));
+    REQUIRE(mirror.sync());
+    CHECK(mirror.size() == (COUNT + 2) / 3 + 2 * COUNT);
+    misplaced = 0;
+    for (std::uint64_t n = 0; n < 3 * COUNT; ++n) {
+        if (mirror.contains(txid(n)) != (n >= COUNT || n % 3 == 0)) ++misplaced;
+    }
+    CHECK(misplaced == 0);
+    CHECK(mirror.totalVsize() == 141 * mirror.size());
+    CHECK(node.loads() == 1);
+}
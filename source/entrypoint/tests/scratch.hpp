@@ -0,0 +1,29 @@
+#ifndef SCRATCH_HPP
+#define SCRATCH_HPP
+
+#include <filesystem>
+#include <string>
+
+#include <unistd.h>
+
+/**
+ * @class ScratchDirectory
+ * @brief A fresh directory under the system temporary directory, removed again at the end.
+ */
+class ScratchDirectory {
+public:
+    explicit ScratchDirectory(const std::string& name)
+        : path(std::filesystem::temp_directory_path() / (name + "-" + std::to_string(::getpid()))) {
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+    }
+    ~ScratchDirectory() { std::filesystem::remove_all(path); }
+
+    std::string string() const { return path.string(); }
+    std::filesystem::path operator/(const std::string& file) const { return path / file; }
+
+private:
+    std::filesystem::path path;
+};
+
+#endif // SCRATCH_HPP
@@ -0,0 +1,116 @@
+#include <doctest/doctest.h>
+
+#include "bitcoinclient.hpp"
+#include "../mockserver.hpp"
+
+#include <atomic>
+#include <latch>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/*
+ * Many threads sharing one BitcoinClient. The connection pool parks handles in per-thread
+ * slots without a lock, so these tests are meant to be run under ThreadSanitizer as well
+ * (see the README). Every answer depends on the request, so a response delivered to the
+ * wrong caller is caught, not only a crash.
+ */
+
+namespace {
+constexpr std::size_t THREADS = 32;
+constexpr std::size_t ITERATIONS = 200;     ///< Calls per thread and round.
+constexpr std::size_t BATCH_EVERY = 8;      ///< Every this many calls, a thread sends a batch instead.
+constexpr std::size_t BATCH_SIZE = 16;
+
+MockServer::Responder hashResponder() {
+    return [](const std::string& method, const std::string& id, std::int64_t argument) {
+        if (method == "getblockhash") return envelope("\"" + fakeHash(static_cast<std::uint64_t>(argument)) + "\"", id);
+        return envelope("null", id);
+    };
+}
+
+/**
+ * @brief Runs `THREADS` threads of single and batch `getblockhash` calls; returns the number of wrong answers.
+ */
+std::size_t hammer(BitcoinClient& client, std::size_t round) {
+    std::atomic<std::size_t> wrong {0};
+    std::latch ready(THREADS);
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < THREADS; ++t) {
+        workers.emplace_back([&, t] {
+            ready.arrive_and_wait();
+            const int base = static_cast<int>((round * THREADS + t) * ITERATIONS * BATCH_SIZE);
+            for (std::size_t i = 0; i < ITERATIONS; ++i) {
+                const int height = base + static_cast<int>(i * BATCH_SIZE);
+                if (i % BATCH_EVERY != 0) {
+                    const Json::Value hash = client.getBlockHash(height);
+                    if (!hash.isString() || hash.asString() != fakeHash(static_cast<std::uint64_t>(height))) wrong.fetch_add(1);
+                    continue;
+                }
+                RpcBatch batch;
+                for (std::size_t k = 0; k < BATCH_SIZE; ++k) batch.call("getblockhash", height + static_cast<int>(k));
+                const std::vector<RpcResult> results = client.sendBatch(batch);
+                if (results.size() != BATCH_SIZE) {
+                    wrong.fetch_add(1);
+                    continue;
+                }
+                for (std::size_t k = 0; k < BATCH_SIZE; ++k) {
+                    const RpcResult& result = results[k];
+                    if (!result.ok() || result.result.asString() != fakeHash(static_cast<std::uint64_t>(height) + k)) wrong.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    return wrong.load();
+}
+
+/**
+ * @brief Two rounds on fresh threads, so the second one runs on handles returned by exited threads.
+ */
+void stress(std::size_t poolSize) {
+    MockServer server(hashResponder());
+    REQUIRE(server.start());
+    BitcoinClient client("user", "password", server.url(), poolSize);
+
+    CHECK(hammer(client, 0) == 0);
+    CHECK(hammer(client, 1) == 0);
+    // Handles are reused rather than leaked or reopened: the pool never exceeds its limit.
+    CHECK(server.accepted() <= poolSize);
+}
+}
+
+TEST_CASE("a shared client answers every caller correctly with fewer connections than threads") {
+    // 32 threads on 4 handles: most acquisitions reclaim a handle parked by another thread.
+    stress(4);
+}
+
+TEST_CASE("a shared client answers every caller correctly with a connection per thread") {
+    stress(64);
+}
+
+TEST_CASE("a client can be destroyed before the threads that used it exit") {
+    MockServer server(hashResponder());
+    REQUIRE(server.start());
+    auto client = std::make_unique<BitcoinClient>("user", "password", server.url(), 4);
+
+    std::latch used(THREADS);
+    std::latch destroyed(1);
+    std::atomic<std::size_t> wrong {0};
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < THREADS; ++t) {
+        workers.emplace_back([&, t] {
+            const int height = static_cast<int>(t);
+            const Json::Value hash = client->getBlockHash(height);
+            if (!hash.isString() || hash.asString() != fakeHash(static_cast<std::uint64_t>(height))) wrong.fetch_add(1);
+            used.count_down();
+            // Exiting now returns the parked handle to a pool that no longer exists.
+            destroyed.wait();
+        });
+    }
+    used.wait();
+    client.reset();
+    destroyed.count_down();
+    for (std::thread& worker : workers) worker.join();
+    CHECK(wrong.load() == 0);
+}
@@ -0,0 +1,213 @@
+#include <doctest/doctest.h>
+
+#include "utxoindex.hpp"
+#include "hexcodec.hpp"
+#include "scratch.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+ * UtxoIndex on a scratch directory, fed with hand-built `dumptxoutset` snapshots and
+ * `getblock <hash> 3` results.
+ */
+
+namespace {
+constexpr std::int32_t SNAPSHOT_HEIGHT = 50;    ///< Height of every snapshot coin.
+constexpr Amount COIN_VALUE = 10000;            ///< Value of every snapshot coin; compresses to 5.
+
+struct TestCoin {
+    Hash256 txid;
+    std::uint32_t vout;
+    std::vector<std::uint8_t> script;
+};
+
+/**
+ * @brief Returns deterministic pseudo-random bytes.
+ */
+template<std::size_t N>
+std::array<std::uint8_t, N> bytesOf(std::uint64_t seed) {
+    std::array<std::uint8_t, N> out;
+    for (std::uint8_t& byte : out) {
+        seed = seed * 6364136223846793005 + 1442695040888963407;
+        byte = static_cast<std::uint8_t>(seed >> 56);
+    }
+    return out;
+}
+
+Hash256 hashOf(std::uint64_t seed) {
+    return bytesOf<32>(seed);
+}
+
+/**
+ * @brief Returns a distinct 100-byte script, too long to be kept inside a record.
+ */
+std::vector<std::uint8_t> longScript(std::uint64_t seed) {
+    const auto tail = bytesOf<99>(seed ^ 0x5c5c5c5c);
+    std::vector<std::uint8_t> script {0x51};     // OP_TRUE, so it is not unspendable.
+    script.insert(script.end(), tail.begin(), tail.end());
+    return script;
+}
+
+/**
+ * @brief Serializes coins as `dumptxoutset` does, in the layout before or since Bitcoin Core 28.
+ */
+std::vector<std::uint8_t> snapshot(bool legacy, const Hash256& base, const std::vector<TestCoin>& coins) {
+    std::vector<std::uint8_t> out;
+    const auto put64 = [&](std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    };
+    if (!legacy) out.insert(out.end(), {'u', 't', 'x', 'o', 0xff, 2, 0, 0xf9, 0xbe, 0xb4, 0xd9});
+    out.insert(out.end(), base.begin(), base.end());
+    put64(coins.size());
+    for (std::size_t i = 0; i < coins.size(); ++i) {
+        const TestCoin& coin = coins[i];
+        if (legacy) {
+            out.insert(out.end(), coin.txid.begin(), coin.txid.end());
+            for (int k = 0; k < 4; ++k) out.push_back(static_cast<std::uint8_t>(coin.vout >> (8 * k)));
+        } else {
+            // One group per run of outputs of the same transaction; the tests keep them below 253.
+            if (i == 0 || coins[i - 1].txid != coin.txid) {
+                std::size_t outputs = 1;
+                while (i + outputs < coins.size() && coins[i + outputs].txid == coin.txid) ++outputs;
+                out.insert(out.end(), coin.txid.begin(), coin.txid.end());
+                out.push_back(static_cast<std::uint8_t>(outputs));
+            }
+            out.push_back(static_cast<std::uint8_t>(coin.vout));
+        }
+        out.push_back(SNAPSHOT_HEIGHT * 2);                             // Code: height, not a coinbase.
+        out.push_back(5);                                               // CompressAmount(10000).
+        out.push_back(static_cast<std::uint8_t>(coin.script.size() + 6));   // A raw script of that size.
+        out.insert(out.end(), coin.script.begin(), coin.script.end());
+    }
+    return out;
+}
+
+std::string write(const ScratchDirectory& directory, const std::string& name, const std::vector<std::uint8_t>& bytes) {
+    const std::string path = (directory / name).string();
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return path;
+}
+
+Json::Value output(std::uint32_t n, const std::string& value, const std::vector<std::uint8_t>& script) {
+    Json::Value out(Json::objectValue);
+    out["n"] = n;
+    out["value"] = std::stod(value);
+    out["scriptPubKey"]["hex"] = encodeHex(script);
+    return out;
+}
+
+/**
+ * @brief Returns a verbose block of a coinbase and one transaction spending `spent` and creating `created`.
+ */
+Json::Value block(const Hash256& hash, const Hash256& previous, std::int64_t height, const std::vector<TestCoin>& spent,
+                  const std::vector<std::vector<std::uint8_t>>& created) {
+    Json::Value coinbase(Json::objectValue);
+    coinbase["txid"] = hashToHex(hashOf(static_cast<std::uint64_t>(height) * 1000003));
+    coinbase["vin"].append(Json::Value(Json::objectValue))["coinbase"] = "51";
+    coinbase["vout"].append(output(0, "3.125", {0x51}));
+
+    Json::Value tx(Json::objectValue);
+    tx["txid"] = hashToHex(hashOf(static_cast<std::uint64_t>(height) * 1000033));
+    tx["vin"] = Json::Value(Json::arrayValue);
+    for (const TestCoin& coin : spent) {
+        Json::Value& input = tx["vin"].append(Json::Value(Json::objectValue));
+        input["txid"] = hashToHex(coin.txid);
+        input["vout"] = coin.vout;
+    }
+    tx["vout"] = Json::Value(Json::arrayValue);
+    for (std::uint32_t n = 0; n < created.size(); ++n) tx["vout"].append(output(n, "0.0001", created[n]));
+
+    Json::Value result(Json::objectValue);
+    result["hash"] = hashToHex(hash);
+    result["previousblockhash"] = hashToHex(previous);
+    result["height"] = Json::Int64(height);
+    result["tx"].append(coinbase);
+    result["tx"].append(tx);
+    return result;
+}
+}
+
+TEST_CASE("snapshots of Bitcoin Core 27 and 28 load the same coins") {
+    const Hash256 base = hashOf(1);
+    std::vector<TestCoin> coins;
+    for (std::uint64_t n = 0; n < 40; ++n) {
+        // Short and long scripts, and transactions with more than one output.
+        const std::vector<std::uint8_t> script = n % 2 ? longScript(n) : std::vector<std::uint8_t>(25, static_cast<std::uint8_t>(0x51 + n % 7));
+        coins.push_back({hashOf(100 + n / 3), static_cast<std::uint32_t>(n % 3), script});
+    }
+
+    ScratchDirectory directory("bitcoin-rpc-utxo-snapshots");
+    for (const bool legacy : {true, false}) {
+        CAPTURE(legacy);
+        UtxoIndex utxos((directory / (legacy ? "legacy" : "current")).string());
+        REQUIRE(utxos.open());
+        REQUIRE(utxos.loadSnapshot(write(directory, legacy ? "legacy.dat" : "current.dat", snapshot(legacy, base, coins))));
+        CHECK(utxos.size() == coins.size());
+        CHECK(utxos.totalValue() == COIN_VALUE * static_cast<Amount>(coins.size()));
+        CHECK(utxos.tipHash() == base);
+        for (const TestCoin& coin : coins) {
+            const std::optional<UtxoEntry> found = utxos.find(coin.txid, coin.vout);
+            REQUIRE(found.has_value());
+            CHECK(found->value == COIN_VALUE);
+            CHECK(found->height == SNAPSHOT_HEIGHT);
+            CHECK_FALSE(found->coinbase);
+            CHECK(found->scriptPubKey == coin.script);
+        }
+    }
+}
+
+TEST_CASE("files that are not snapshots are refused before anything is allocated") {
+    ScratchDirectory directory("bitcoin-rpc-utxo-refused");
+    UtxoIndex utxos((directory / "index").string());
+    REQUIRE(utxos.open());
+
+    // A headerless file claiming more coins than it could hold.
+    std::vector<std::uint8_t> stray(4096, 0xee);
+    CHECK_FALSE(utxos.loadSnapshot(write(directory, "stray.dat", stray)));
+    // A header of a version that does not exist.
+    std::vector<std::uint8_t> unknown = snapshot(false, hashOf(1), {{hashOf(2), 0, {0x51}}});
+    unknown[5] = 1;
+    CHECK_FALSE(utxos.loadSnapshot(write(directory, "unknown.dat", unknown)));
+    CHECK(utxos.size() == 0);
+}
+
+TEST_CASE("spent long scripts are reclaimed from the heap") {
+    // 3 MB of long scripts, of which a block spends two thirds.
+    constexpr std::uint64_t COINS = 30000;
+    const Hash256 base = hashOf(1);
+    std::vector<TestCoin> coins;
+    for (std::uint64_t n = 0; n < COINS; ++n) coins.push_back({hashOf(1000 + n), 0, longScript(n)});
+
+    ScratchDirectory directory("bitcoin-rpc-utxo-heap");
+    UtxoIndex utxos((directory / "index").string());
+    REQUIRE(utxos.open());
+    REQUIRE(utxos.loadSnapshot(write(directory, "snapshot.dat", snapshot(false, base, coins))));
+
+    std::vector<TestCoin> spent;
+    for (std::uint64_t n = 0; n < COINS; ++n) {
+        if (n % 3 != 0) spent.push_back(coins[n]);
+    }
+    const Hash256 first = hashOf(2);
+    REQUIRE(utxos.connectBlock(block(first, base, SNAPSHOT_HEIGHT + 1, spent, {})));
+    const auto heapBytes = std::filesystem::file_size(directory / "index" / "scripts.dat");
+
+    // As many new scripts as were spent fit into the space the spent ones left.
+    std::vector<std::vector<std::uint8_t>> created;
+    for (std::uint64_t n = 0; n < spent.size(); ++n) created.push_back(longScript(COINS + n));
+    REQUIRE(utxos.connectBlock(block(hashOf(3), first, SNAPSHOT_HEIGHT + 2, {}, created)));
+    CHECK(std::filesystem::file_size(directory / "index" / "scripts.dat") == heapBytes);
+
+    // Every survivor moved intact; the spent ones are gone.
+    std::size_t wrong = 0;
+    for (std::uint64_t n = 0; n < COINS; ++n) {
+        const std::vector<UtxoEntry> found = utxos.findByScript(coins[n].script);
+        if (found.size() != (n % 3 == 0 ? 1 : 0) || (!found.empty() && found[0].txid != coins[n].txid)) ++wrong;
+    }
+    for (const std::vector<std::uint8_t>& script : created) {
+        if (utxos.findByScript(script).size() != 1) ++wrong;
+    }
+    CHECK(wrong == 0);
+    CHECK(utxos.size() == COINS - spent.size() + created.size() + 2);   // Plus the two coinbase outputs.
+}
@@ -0,0 +1,324 @@
+#include <doctest/doctest.h>
+
+#include "walletsync.hpp"
+#include "hexcodec.hpp"
+#include "jsonwriter.hpp"
+#include "../mockserver.hpp"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+ * WalletSync against a scripted wallet. The node answers `listsinceblock`, `listunspent`,
+ * `gettransaction` and the chain calls from a small model that the tests change between
+ * syncs. Coins the cases care about sit well below the checkpoint, out of reach of the
+ * `listunspent` window, so only the delta logic under test can add or remove them.
+ */
+
+namespace {
+Hash256 hashOf(std::uint64_t seed) {
+    Hash256 hash {};
+    parseHash(fakeHash(seed), hash);
+    return hash;
+}
+
+/**
+ * @brief Serializes a legacy transaction spending `inputs` into `outputs` outputs of 10000 satoshis.
+ */
+std::string rawTransaction(const std::vector<std::pair<Hash256, std::uint32_t>>& inputs, std::size_t outputs) {
+    std::vector<std::uint8_t> bytes {2, 0, 0, 0};
+    const auto put32 = [&](std::uint32_t value) {
+        for (int i = 0; i < 4; ++i) bytes.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    };
+    bytes.push_back(static_cast<std::uint8_t>(inputs.size()));
+    for (const auto& [txid, vout] : inputs) {
+        bytes.insert(bytes.end(), txid.begin(), txid.end());
+        put32(vout);
+        bytes.push_back(0);             // Empty scriptSig.
+        put32(0xfffffffd);
+    }
+    bytes.push_back(static_cast<std::uint8_t>(outputs));
+    for (std::size_t i = 0; i < outputs; ++i) {
+        bytes.insert(bytes.end(), {0x10, 0x27, 0, 0, 0, 0, 0, 0});     // 10000 satoshis.
+        bytes.insert(bytes.end(), {1, 0x51});
+    }
+    put32(0);
+    return encodeHex(bytes);
+}
+
+/**
+ * @class FakeWallet
+ * @brief A wallet and its chain, as far as WalletSync asks about them.
+ */
+class FakeWallet {
+public:
+    struct Tx {
+        Hash256 txid {};
+        std::int32_t height = -1;               ///< -1 while unconfirmed.
+        bool listed = true;                     ///< `listsinceblock` shows it; change-only transactions are not.
+        std::string category = "receive";       ///< Category of its single listed entry.
+        double amount = 0;                      ///< Amount of that entry, negative for sends.
+        double fee = 0;                         ///< Negative for transactions the wallet funded, 0 otherwise.
+        std::string hex;                        ///< Raw transaction for `gettransaction`.
+    };
+
+    struct Coin {
+        Hash256 txid {};
+        std::uint32_t vout = 0;
+        double amount = 0;
+        std::int32_t height = -1;
+    };
+
+    FakeWallet() : server([this](const std::string& method, const Json::Value& params, const std::string& id) {
+        return answer(method, params, id);
+    }) {}
+
+    bool start() { return server.start(); }
+    std::string url() const { return server.url(); }
+
+    /**
+     * @brief Runs `change` on the model while no request reads it.
+     */
+    template<typename Change>
+    void update(Change change) {
+        std::lock_guard<std::mutex> lock(mutex);
+        change();
+    }
+
+    /**
+     * @brief Returns how many `listunspent` calls listed the whole set; the bootstrap makes one.
+     */
+    std::size_t fullListings() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return fullUnspentListings;
+    }
+
+    std::int32_t tip = 100;
+    std::map<std::int32_t, int> forks;          ///< Bumped for heights a reorganization replaced.
+    std::map<Hash256, Tx> txs;
+    std::vector<Coin> coins;
+    std::set<Hash256> removed;                  ///< Reported once in `removed`, then forgotten.
+
+    std::string blockHash(std::int32_t height) const {
+        const auto fork = forks.find(height);
+        return fakeHash(static_cast<std::uint64_t>(height) * 1000 + (fork == forks.end() ? 0 : fork->second));
+    }
+
+private:
+    std::int32_t confirmations(std::int32_t height) const { return height < 0 ? 0 : tip - height + 1; }
+
+    std::string answer(const std::string& method, const Json::Value& params, const std::string& id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Json::Value result;
+        if (method == "getblockcount") {
+            result = tip;
+        } else if (method == "getblockheader") {
+            for (std::int32_t height = 0; height <= tip; ++height) {
+                if (blockHash(height) != params[0].asString()) continue;
+                result["hash"] = blockHash(height);
+                result["height"] = height;
+                result["confirmations"] = confirmations(height);
+            }
+        } else if (method == "listsinceblock") {
+            result = listSinceBlock(params);
+        } else if (method == "listunspent") {
+            const std::int64_t maxConfirmations = params[1].asInt64();
+            if (maxConfirmations >= 9999999) ++fullUnspentListings;
+            result = Json::Value(Json::arrayValue);
+            for (const Coin& coin : coins) {
+                if (confirmations(coin.height) > maxConfirmations) continue;
+                Json::Value& out = result.append(Json::Value(Json::objectValue));
+                out["txid"] = hashToHex(coin.txid);
+                out["vout"] = coin.vout;
+                out["scriptPubKey"] = "51";
+                out["amount"] = coin.amount;
+                out["confirmations"] = confirmations(coin.height);
+                out["spendable"] = true;
+                out["safe"] = true;
+            }
+        } else if (method == "gettransaction") {
+            Hash256 txid {};
+            parseHash(params[0].asString(), txid);
+            const auto found = txs.find(txid);
+            if (found == txs.end()) {
+                return R"({"result":null,"error":{"code":-5,"message":"Invalid or non-wallet transaction id"},"id":)" + id + '}';
+            }
+            const Tx& tx = found->second;
+            result["txid"] = hashToHex(tx.txid);
+            result["confirmations"] = confirmations(tx.height);
+            if (tx.height >= 0) result["blockheight"] = tx.height;
+            if (tx.fee != 0) result["fee"] = tx.fee;
+            result["hex"] = tx.hex;
+        }
+        std::string text;
+        JsonWriter(text).write(result);
+        return envelope(text, id);
+    }
+
+    Json::Value listSinceBlock(const Json::Value& params) {
+        std::int32_t since = -1;
+        for (std::int32_t height = 0; params[0].isString() && height <= tip; ++height) {
+            if (blockHash(height) == params[0].asString()) since = height;
+        }
+        Json::Value result(Json::objectValue);
+        Json::Value& transactions = result["transactions"] = Json::Value(Json::arrayValue);
+        std::int64_t time = 1700000000;
+        for (const auto& [txid, tx] : txs) {
+            ++time;
+            if (!tx.listed || (tx.height >= 0 && tx.height <= since)) continue;
+            Json::Value& entry = transactions.append(Json::Value(Json::objectValue));
+            entry["txid"] = hashToHex(txid);
+            entry["category"] = tx.category;
+            entry["amount"] = tx.amount;
+            entry["vout"] = 0;
+            entry["confirmations"] = confirmations(tx.height);
+            entry["time"] = Json::Int64(time);
+            if (tx.fee != 0) entry["fee"] = tx.fee;
+            if (tx.height >= 0) {
+                entry["blockhash"] = blockHash(tx.height);
+                entry["blockheight"] = tx.height;
+            }
+        }
+        Json::Value& gone = result["removed"] = Json::Value(Json::arrayValue);
+        for (const Hash256& txid : removed) {
+            Json::Value& entry = gone.append(Json::Value(Json::objectValue));
+            entry["txid"] = hashToHex(txid);
+            entry["category"] = "send";
+            entry["amount"] = 0;
+            entry["vout"] = 0;
+        }
+        removed.clear();
+        result["lastblock"] = blockHash(tip - params[1].asInt() + 1);
+        return result;
+    }
+
+    std::mutex mutex;
+    std::size_t fullUnspentListings = 0;
+    MockServer server;
+};
+
+/**
+ * @brief Adds a confirmed receive of one output to the wallet.
+ */
+void receive(FakeWallet& node, const Hash256& txid, std::int32_t height, double amount) {
+    node.txs[txid] = {txid, height, true, "receive", amount, 0, rawTransaction({{hashOf(999), 0}}, 1)};
+    node.coins.push_back({txid, 0, amount, height});
+}
+
+/**
+ * @brief Spends `inputs` into a payment (vout 0) and change (vout 1), both of which the node then lists.
+ */
+void send(FakeWallet& node, const Hash256& txid, std::int32_t height, const std::vector<std::pair<Hash256, std::uint32_t>>& inputs,
+          double change) {
+    node.txs[txid] = {txid, height, true, "send", -0.3, -0.0001, rawTransaction(inputs, 2)};
+    std::erase_if(node.coins, [&](const FakeWallet::Coin& coin) {
+        return std::find(inputs.begin(), inputs.end(), std::pair(coin.txid, coin.vout)) != inputs.end();
+    });
+    node.coins.push_back({txid, 1, change, height});
+}
+
+bool holds(const WalletSync& wallet, const Hash256& txid, std::uint32_t vout) {
+    for (const WalletUtxo& coin : wallet.unspent(0)) {
+        if (coin.txid == txid && coin.vout == vout) return true;
+    }
+    return false;
+}
+}
+
+TEST_CASE("a spend in a disconnected block is rolled back through removed") {
+    FakeWallet node;
+    const Hash256 received = hashOf(1);
+    const Hash256 spent = hashOf(2);
+    receive(node, received, 80, 1.0);
+    REQUIRE(node.start());
+    BitcoinClient client("user", "password", node.url());
+    WalletSync wallet(client);
+    REQUIRE(wallet.bootstrap());
+    REQUIRE(holds(wallet, received, 0));
+
+    node.update([&] {
+        node.tip = 101;
+        send(node, spent, 101, {{received, 0}}, 0.6999);
+    });
+    REQUIRE(wallet.sync());
+    CHECK_FALSE(holds(wallet, received, 0));
+    CHECK(holds(wallet, spent, 1));
+    CHECK(wallet.find(spent)->height == 101);
+
+    // Block 101 is replaced by one without the spend, which does not return to the mempool.
+    node.update([&] {
+        node.forks[101] = 1;
+        node.txs.erase(spent);
+        node.removed.insert(spent);
+        node.coins = {{received, 0, 1.0, 80}};
+    });
+    REQUIRE(wallet.sync());
+    CHECK(wallet.find(spent)->conflicted);
+    CHECK(holds(wallet, received, 0));
+    CHECK_FALSE(holds(wallet, spent, 1));
+    CHECK(wallet.utxoCount() == 1);
+    CHECK(wallet.balance(1) == 100000000);
+    CHECK(node.fullListings() == 1);        // Rolled back locally, not reloaded.
+}
+
+TEST_CASE("a pending transaction that vanishes returns the coins it spent") {
+    FakeWallet node;
+    const Hash256 received = hashOf(1);
+    const Hash256 pending = hashOf(3);
+    receive(node, received, 80, 1.0);
+    REQUIRE(node.start());
+    BitcoinClient client("user", "password", node.url());
+    WalletSync wallet(client);
+    REQUIRE(wallet.bootstrap());
+
+    node.update([&] { send(node, pending, -1, {{received, 0}}, 0.6999); });
+    REQUIRE(wallet.sync());
+    CHECK(wallet.find(pending)->confirmations(wallet.tipHeight()) == 0);
+    CHECK_FALSE(holds(wallet, received, 0));
+    CHECK(holds(wallet, pending, 1));
+
+    // Evicted from the mempool: no longer listed, and its input is unspent again.
+    node.update([&] {
+        node.txs.erase(pending);
+        node.coins = {{received, 0, 1.0, 80}};
+    });
+    REQUIRE(wallet.sync());
+    CHECK(wallet.find(pending)->conflicted);
+    CHECK(holds(wallet, received, 0));
+    CHECK_FALSE(holds(wallet, pending, 1));
+    CHECK(wallet.utxoCount() == 1);
+    CHECK(node.fullListings() == 1);
+}
+
+TEST_CASE("a consolidation that only pays to change is found through its change") {
+    FakeWallet node;
+    const Hash256 first = hashOf(1);
+    const Hash256 second = hashOf(2);
+    const Hash256 consolidation = hashOf(4);
+    receive(node, first, 70, 1.0);
+    receive(node, second, 71, 2.0);
+    REQUIRE(node.start());
+    BitcoinClient client("user", "password", node.url());
+    WalletSync wallet(client);
+    REQUIRE(wallet.bootstrap());
+    REQUIRE(wallet.utxoCount() == 2);
+
+    node.update([&] {
+        node.tip = 101;
+        node.txs[consolidation] = {consolidation, 101, false, "send", 0, -0.0001,
+                                   rawTransaction({{first, 0}, {second, 0}}, 1)};
+        node.coins = {{consolidation, 0, 2.9999, 101}};
+    });
+    REQUIRE(wallet.sync());
+    CHECK_FALSE(holds(wallet, first, 0));
+    CHECK_FALSE(holds(wallet, second, 0));
+    CHECK(holds(wallet, consolidation, 0));
+    CHECK(wallet.utxoCount() == 1);
+    CHECK(wallet.size() == 2);              // The node never listed it, so neither does the history.
+    CHECK(wallet.balance(1) == 299990000);
+    CHECK(node.fullListings() == 1);
+}
@@ -0,0 +1,144 @@
+#include "feeoracle.hpp"
+#include "jsonwriter.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace {
+constexpr std::chrono::milliseconds MIN_MAX_AGE {1000};     ///< Lower bound of `maxAge`, so the thread never spins.
+}
+
+std::string_view feeModeName(FeeMode mode) {
+    return mode == FeeMode::Economical ? "ECONOMICAL" : "CONSERVATIVE";
+}
+
+const FeeEstimate* FeeSnapshot::find(std::int32_t target, FeeMode mode) const {
+    const FeeEstimate* best = nullptr;
+    for (const FeeEstimate& estimate : estimates) {
+        if (estimate.mode == mode && estimate.target <= target) best = &estimate;
+    }
+    return best;
+}
+
+FeeOracle::FeeOracle(BitcoinClient& client, const FeeOracleSettings& settings)
+    : client(client), oracleSettings(settings) {
+    // `FeeSnapshot::find` relies on ascending targets within a mode.
+    std::vector<std::int32_t>& targets = oracleSettings.targets;
+    std::erase_if(targets, [](std::int32_t target) { return target < 1; });
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+    std::vector<FeeMode>& modes = oracleSettings.modes;
+    std::sort(modes.begin(), modes.end());
+    modes.erase(std::unique(modes.begin(), modes.end()), modes.end());
+    oracleSettings.maxAge = std::max(oracleSettings.maxAge, MIN_MAX_AGE);
+}
+
+FeeOracle::~FeeOracle() {
+    stop();
+}
+
+bool FeeOracle::refresh() {
+    std::lock_guard<std::mutex> lock(refreshMutex);
+
+    // One round trip for the tip and every estimate, so they all belong to the same block.
+    RpcBatch batch;
+    batch.call<RpcMethod::getbestblockhash>();
+    for (const FeeMode mode : oracleSettings.modes) {
+        for (const std::int32_t target : oracleSettings.targets) batch.call<RpcMethod::estimatesmartfee>(target, feeModeName(mode));
+    }
+    const std::vector<RpcResult> results = client.sendBatch(batch);
+
+    auto fresh = std::make_shared<FeeSnapshot>();
+    if (!results[0].ok() || !results[0].result.isString() || !parseHash(results[0].result.asString(), fresh->bestBlock)) {
+        Logger::error("Fee oracle: failed to read the best block");
+        return false;
+    }
+    fresh->estimates.reserve(results.size() - 1);
+    std::string text;
+    std::size_t next = 1;
+    for (const FeeMode mode : oracleSettings.modes) {
+        for (const std::int32_t target : oracleSettings.targets) {
+            const RpcResult& answer = results[next++];
+            if (!answer.ok()) {
+                Logger::formattedError("Fee oracle: failed to estimate the fee for {} blocks: {}", target, answer.error["message"].asString());
+                return false;
+            }
+            FeeEstimate estimate {target, answer.result["blocks"].asInt(), mode};
+            // Without enough data the node reports `errors` instead of a fee rate.
+            if (const Json::Value& rate = answer.result["feerate"]; rate.isNumeric()) {
+                text.clear();
+                JsonWriter(text).write(rate);
+                estimate.hasEstimate = parseAmount(text, estimate.feeRate);
+            }
+            fresh->estimates.push_back(estimate);
+        }
+    }
+    fresh->fetched = std::chrono::steady_clock::now();
+
+    Logger::formattedDebug("Fee oracle: refreshed {} estimates at block {}", fresh->estimates.size(), hashToHex(fresh->bestBlock));
+    current.store(std::move(fresh), std::memory_order_release);
+    return true;
+}
+
+bool FeeOracle::tipChanged() {
+    const Json::Value best = client.call<RpcMethod::getbestblockhash>();
+    Hash256 bestBlock {};
+    if (!best.isString() || !parseHash(best.asString(), bestBlock)) return false;
+    const std::shared_ptr<const FeeSnapshot> published = snapshot();
+    return !published || published->bestBlock != bestBlock;
+}
+
+void FeeOracle::onBlockConnected(const Hash256&) {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        blockPending = true;
+    }
+    wake.notify_one();
+}
+
+void FeeOracle::start() {
+    if (worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = false;
+    }
+    worker = std::thread(&FeeOracle::refreshLoop, this);
+}
+
+void FeeOracle::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void FeeOracle::refreshLoop() {
+    const bool polling = oracleSettings.tipPollInterval.count() > 0;
+    const std::chrono::milliseconds interval = polling ? std::min(oracleSettings.tipPollInterval, oracleSettings.maxAge)
+                                                       : oracleSettings.maxAge;
+    bool announced = false;
+    while (true) {
+        const std::shared_ptr<const FeeSnapshot> published = snapshot();
+        const bool stale = !published || std::chrono::steady_clock::now() - published->fetched >= oracleSettings.maxAge;
+        if (announced || stale || (polling && tipChanged())) refresh();
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wake.wait_for(lock, interval, [this] { return stopping || blockPending; });
+        if (stopping) return;
+        announced = std::exchange(blockPending, false);
+    }
+}
+
+std::optional<FeeEstimate> FeeOracle::estimate(std::int32_t target, FeeMode mode) const {
+    const std::shared_ptr<const FeeSnapshot> published = snapshot();
+    if (!published) return std::nullopt;
+    const FeeEstimate* found = published->find(target, mode);
+    if (!found) return std::nullopt;
+    return *found;
+}
+
+Amount FeeOracle::feeRate(std::int32_t target, FeeMode mode) const {
+    const std::optional<FeeEstimate> found = estimate(target, mode);
+    return found && found->hasEstimate ? found->feeRate : 0;
+}
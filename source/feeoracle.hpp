@@ -0,0 +1,200 @@
+#ifndef FEEORACLE_HPP
+#define FEEORACLE_HPP
+
+#if __has_include("bitcoinclient.hpp")
+#   include "bitcoinclient.hpp"
+#else
+#   error "Bitcoin's \"bitcoinclient.hpp\" was not found!"
+#endif
+
+
+#ifdef USE_ZMQ
+#   if __has_include("zmqsubscriber.hpp")
+#       include "zmqsubscriber.hpp"
+#   else
+#       error "Bitcoin's \"zmqsubscriber.hpp\" was not found!"
+#   endif
+#endif
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+/**
+ * @enum FeeMode
+ * @brief The `estimate_mode` of `estimatesmartfee`.
+ */
+enum class FeeMode : std::uint8_t {
+    Conservative,   ///< `CONSERVATIVE`: also considers a longer history; safer, usually higher.
+    Economical      ///< `ECONOMICAL`: reacts faster to a falling fee market.
+};
+
+/**
+ * @brief Returns the name the node expects for a mode.
+ */
+std::string_view feeModeName(FeeMode mode);
+
+/**
+ * @struct FeeEstimate
+ * @brief One prefetched `estimatesmartfee` answer.
+ */
+struct FeeEstimate {
+    std::int32_t target = 0;                ///< Confirmation target that was asked for.
+    std::int32_t blocks = 0;                ///< Target the node's estimate is valid for; may be larger than `target`.
+    FeeMode mode = FeeMode::Conservative;
+    Amount feeRate = 0;                     ///< Fee rate in satoshis per kvB; 0 without an estimate.
+    bool hasEstimate = false;               ///< False when the node had too little data to estimate.
+};
+
+/**
+ * @struct FeeSnapshot
+ * @brief Every estimate of one refresh; immutable once published.
+ */
+struct FeeSnapshot {
+    std::vector<FeeEstimate> estimates;                 ///< Ordered by mode, then by target.
+    Hash256 bestBlock {};                               ///< Tip the estimates were made at.
+    std::chrono::steady_clock::time_point fetched;      ///< When the refresh completed.
+
+    /**
+     * @brief Returns the estimate for the largest prefetched target not above `target`, or `nullptr`.
+     *
+     * A smaller target never asks for a lower fee rate, so the answer errs on the side of
+     * confirming in time.
+     */
+    const FeeEstimate* find(std::int32_t target, FeeMode mode) const;
+};
+
+/**
+ * @struct FeeOracleSettings
+ * @brief What a FeeOracle prefetches and how often.
+ */
+struct FeeOracleSettings {
+    std::vector<std::int32_t> targets {1, 2, 3, 6, 12, 24, 144};               ///< Confirmation targets to prefetch.
+    std::vector<FeeMode> modes {FeeMode::Conservative, FeeMode::Economical};   ///< Modes to prefetch for every target.
+    std::chrono::milliseconds tipPollInterval {5000};   ///< Time between two `getbestblockhash` polls; 0 relies on `onBlockConnected` alone.
+    std::chrono::milliseconds maxAge {60000};           ///< Longest time between two refreshes, to follow the mempool between blocks.
+};
+
+/**
+ * @class FeeOracle
+ * @brief Serves `estimatesmartfee` answers from memory, refreshed in the background.
+ *
+ * Fee estimates only change meaningfully when a block arrives, yet payment code asks for
+ * one on nearly every transaction it builds. The oracle fetches every configured
+ * (target, mode) pair in one batch and publishes the answers as an immutable snapshot.
+ * The background thread refreshes it when the tip changes, seen by polling
+ * `getbestblockhash` or through `onBlockConnected`, and at least every `maxAge`.
+ *
+ * Reads load the current snapshot through an atomic shared pointer: they never wait for a
+ * refresh and never send a request.
+ *
+ * @code
+ * FeeOracle fees(client);
+ * fees.start();
+ * // ... on the payment path:
+ * Amount rate = fees.feeRate(6);                      // sat/kvB; 0 until the first refresh.
+ * @endcode
+ */
+class FeeOracle {
+public:
+    /**
+     * @brief Creates an empty oracle; nothing is fetched until `refresh()` or `start()`.
+     * @param client The client used for all requests; must outlive the oracle.
+     * @param settings What to prefetch and how often.
+     */
+    explicit FeeOracle(BitcoinClient& client, const FeeOracleSettings& settings = {});
+    FeeOracle(const FeeOracle&) = delete;
+    FeeOracle& operator=(const FeeOracle&) = delete;
+
+    /**
+     * @brief Stops the background thread.
+     */
+    ~FeeOracle();
+
+    /**
+     * @brief Fetches every configured estimate and publishes them as a new snapshot.
+     * @return `false` if the request failed; the previous snapshot stays in place.
+     */
+    bool refresh();
+
+    /**
+     * @brief Starts a thread that refreshes now, then on every new tip and at least every `maxAge`.
+     */
+    void start();
+
+    /**
+     * @brief Stops the background thread.
+     */
+    void stop();
+
+    /**
+     * @brief Makes the background thread refresh now; may be called from any thread.
+     */
+    void onBlockConnected(const Hash256& blockHash);
+
+#ifdef USE_ZMQ
+    /**
+     * @brief Routes the `hashblock` feed of a ZmqSubscriber into this oracle.
+     * @param handlers The handlers passed to `ZmqSubscriber::start()`; an existing `onHashBlock` is still called first.
+     */
+    void attach(ZmqHandlers& handlers) {
+        handlers.onHashBlock = [this, previous = std::move(handlers.onHashBlock)](const Hash256& blockHash) {
+            if (previous) previous(blockHash);
+            onBlockConnected(blockHash);
+        };
+    }
+#endif
+
+    /**
+     * @name Queries
+     * @brief Lock-free reads of the published snapshot.
+     */
+    ///@{
+    /**
+     * @brief Returns the current snapshot; null before the first successful refresh.
+     */
+    std::shared_ptr<const FeeSnapshot> snapshot() const { return current.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Returns the estimate for `target`, from the largest prefetched target not above it.
+     * @return The estimate; empty before the first refresh or if no target up to `target` is prefetched.
+     */
+    std::optional<FeeEstimate> estimate(std::int32_t target, FeeMode mode = FeeMode::Conservative) const;
+
+    /**
+     * @brief Returns the fee rate in satoshis per kvB for `target`, or 0 when no estimate is available.
+     */
+    Amount feeRate(std::int32_t target, FeeMode mode = FeeMode::Conservative) const;
+    ///@}
+
+private:
+    /**
+     * @brief Body of the background thread.
+     */
+    void refreshLoop();
+
+    /**
+     * @brief Checks whether the best block differs from the one of the current snapshot.
+     */
+    bool tipChanged();
+
+    BitcoinClient& client;                                  ///< Client used for all requests.
+    FeeOracleSettings oracleSettings;                       ///< Prefetch rules.
+    std::atomic<std::shared_ptr<const FeeSnapshot>> current;    ///< The published snapshot.
+
+    std::mutex refreshMutex;                    ///< Serializes `refresh()`.
+
+    std::mutex wakeMutex;                       ///< Guards the members below.
+    std::condition_variable wake;               ///< Wakes the background thread.
+    bool blockPending = false;                  ///< A new block was announced.
+    bool stopping = false;                      ///< Stops the background thread.
+    std::thread worker;                         ///< Background refresh thread.
+};
+
+#endif // FEEORACLE_HPP
@@ -0,0 +1,238 @@
+#include "headerchain.hpp"
+#include "bitcoinclient.hpp"
+#include "restclient.hpp"
+#include "sha256.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr std::int64_t RPC_BATCH = 1000;       ///< Heights fetched per pair of RPC batches.
+constexpr std::size_t REST_BATCH = 2000;       ///< Headers per `/rest/headers` request; the node's cap.
+constexpr std::int64_t UNWIND_WINDOW = 32;     ///< Heights compared per batch while looking for a fork.
+constexpr std::size_t MEDIAN_SPAN = 11;        ///< Blocks in the median time past.
+constexpr std::size_t PREV_OFFSET = 4;
+constexpr std::size_t TIME_OFFSET = 68;
+
+Hash256 prevOf(const std::uint8_t* header) {
+    Hash256 prev;
+    std::memcpy(prev.data(), header + PREV_OFFSET, prev.size());
+    return prev;
+}
+
+std::uint32_t timeOf(const std::uint8_t* header) {
+    const std::uint8_t* time = header + TIME_OFFSET;
+    return std::uint32_t(time[0]) | std::uint32_t(time[1]) << 8 | std::uint32_t(time[2]) << 16 | std::uint32_t(time[3]) << 24;
+}
+
+std::uint64_t slotKey(const Hash256& hash) {
+    std::uint64_t key;
+    std::memcpy(&key, hash.data(), sizeof(key));
+    return key;
+}
+}
+
+bool HeaderChain::sync(BitcoinClient& client, RestClient* rest) {
+    while (true) {
+        const Json::Value count = client.getBlockCount();
+        if (!count.isIntegral()) return false;
+        const std::int64_t nodeHeight = count.asInt64();
+        if (!unwind(client, nodeHeight)) return false;
+
+        const std::int64_t start = height();
+        if (start >= nodeHeight) return true;
+
+        bool fetched = false;
+        if (rest) {
+            Hash256 from {};
+            if (start >= 0) {
+                from = *hashAt(start);
+            } else {
+                const Json::Value genesis = client.getBlockHash(0);
+                if (!genesis.isString() || !parseHash(genesis.asString(), from)) return false;
+            }
+            fetched = extendRest(*rest, from);
+        } else {
+            fetched = extendRpc(client, nodeHeight);
+        }
+        // A round that made no progress failed for good; otherwise look again, the chain may have moved.
+        if (!fetched || height() == start) return false;
+    }
+}
+
+bool HeaderChain::unwind(BitcoinClient& client, std::int64_t nodeHeight) {
+    std::int64_t top = std::min(height(), nodeHeight);
+    // Most rounds only have to confirm the tip, so the first look is at one height.
+    std::int64_t window = 1;
+    while (top >= 0) {
+        const std::int64_t low = std::max<std::int64_t>(0, top - window + 1);
+        RpcBatch batch;
+        for (std::int64_t at = low; at <= top; ++at) batch.call("getblockhash", Json::Int64(at));
+        const std::vector<RpcResult> results = client.sendBatch(batch);
+        if (results.size() != batch.size()) return false;
+
+        for (std::int64_t at = top; at >= low; --at) {
+            const RpcResult& answer = results[static_cast<std::size_t>(at - low)];
+            Hash256 hash;
+            if (!answer.ok() || !answer.result.isString() || !parseHash(answer.result.asString(), hash)) return false;
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            if (static_cast<std::size_t>(at) < hashes.size() && hashes[static_cast<std::size_t>(at)] == hash) {
+                truncate(at);
+                return true;
+            }
+        }
+        top = low - 1;
+        window = UNWIND_WINDOW;
+    }
+    // Not even the genesis block matches: the node is on another network.
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    truncate(-1);
+    return true;
+}
+
+bool HeaderChain::extendRpc(BitcoinClient& client, std::int64_t nodeHeight) {
+    const std::int64_t from = height() + 1;
+    const std::int64_t to = std::min(nodeHeight, from + RPC_BATCH - 1);
+
+    RpcBatch hashBatch;
+    for (std::int64_t at = from; at <= to; ++at) hashBatch.call("getblockhash", Json::Int64(at));
+    const std::vector<RpcResult> hashResults = client.sendBatch(hashBatch);
+    if (hashResults.size() != hashBatch.size()) return false;
+
+    std::vector<Hash256> fetched(hashResults.size());
+    RpcBatch headerBatch;
+    for (std::size_t index = 0; index < hashResults.size(); ++index) {
+        const RpcResult& answer = hashResults[index];
+        if (!answer.ok() || !answer.result.isString() || !parseHash(answer.result.asString(), fetched[index])) return false;
+        headerBatch.call("getblockheader", answer.result.asString(), false);
+    }
+    const std::vector<RpcResult> headerResults = client.sendBatch(headerBatch);
+    if (headerResults.size() != headerBatch.size()) return false;
+
+    std::vector<std::uint8_t> raw;
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    // Someone else moved the chain meanwhile; the caller looks again.
+    if (static_cast<std::int64_t>(hashes.size()) != from) return true;
+    for (std::size_t index = 0; index < headerResults.size(); ++index) {
+        const RpcResult& answer = headerResults[index];
+        if (!answer.ok() || !answer.result.isString() || !parseHex(answer.result.asString(), raw) || raw.size() != HEADER_SIZE) return false;
+        // A reorganization between the two batches breaks the link; stop here and let the caller unwind.
+        if (!hashes.empty() && prevOf(raw.data()) != hashes.back()) return true;
+        append(raw, fetched[index]);
+    }
+    return true;
+}
+
+bool HeaderChain::extendRest(RestClient& rest, const Hash256& from) {
+    std::vector<std::uint8_t> buffer;
+    std::vector<BlockHeaderView> fetched;
+    if (!rest.getHeaders(hashToHex(from), REST_BATCH, buffer) || !parseHeaders(buffer, fetched) || fetched.empty()) return false;
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    std::size_t first = 0;
+    if (hashes.empty()) {
+        // `from` is the genesis block; its header has nothing to link to.
+        append(fetched.front().raw, from);
+        first = 1;
+    } else if (hashes.back() == from) {
+        first = 1;      // The first header is our tip.
+    } else {
+        return true;    // Someone else moved the chain meanwhile; the caller looks again.
+    }
+
+    // Each header's hash is the next one's prevBlock; only the last one has to be hashed.
+    for (std::size_t index = first; index < fetched.size(); ++index) {
+        const BlockHeaderView& view = fetched[index];
+        if (view.prevBlock != hashes.back()) return false;
+        append(view.raw, index + 1 < fetched.size() ? fetched[index + 1].prevBlock : sha256d(view.raw));
+    }
+    return true;
+}
+
+bool HeaderChain::connect(ByteSpan header) {
+    if (header.size() != HEADER_SIZE) return false;
+    const Hash256 hash = sha256d(header);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (hashes.empty()) return false;
+    if (hashes.back() == hash) return true;     // Already known, from a sync or an earlier notification.
+    if (prevOf(header.data()) != hashes.back()) return false;
+    append(header, hash);
+    return true;
+}
+
+void HeaderChain::append(ByteSpan header, const Hash256& hash) {
+    // Keep the table at most half full.
+    if ((hashes.size() + 1) * 2 > slots.size()) rebuildTable(std::max<std::size_t>(slots.size() * 2, 1024));
+    headers.insert(headers.end(), header.begin(), header.begin() + HEADER_SIZE);
+    hashes.push_back(hash);
+    slots[findSlot(hash)] = static_cast<std::uint32_t>(hashes.size() - 1);
+}
+
+void HeaderChain::truncate(std::int64_t height) {
+    const std::size_t keep = static_cast<std::size_t>(height + 1);
+    if (keep >= hashes.size()) return;
+    headers.resize(keep * HEADER_SIZE);
+    hashes.resize(keep);
+    // Linear probing cannot simply erase; reorganizations are rare enough to rebuild.
+    rebuildTable(slots.size());
+}
+
+std::size_t HeaderChain::findSlot(const Hash256& hash) const {
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t slot = slotKey(hash) & mask;; slot = (slot + 1) & mask) {
+        if (slots[slot] == NONE || hashes[slots[slot]] == hash) return slot;
+    }
+}
+
+void HeaderChain::rebuildTable(std::size_t slotCount) {
+    slots.assign(slotCount, NONE);
+    for (std::size_t height = 0; height < hashes.size(); ++height) {
+        slots[findSlot(hashes[height])] = static_cast<std::uint32_t>(height);
+    }
+}
+
+std::int64_t HeaderChain::height() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return static_cast<std::int64_t>(hashes.size()) - 1;
+}
+
+std::optional<Hash256> HeaderChain::hashAt(std::int64_t height) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (height < 0 || static_cast<std::size_t>(height) >= hashes.size()) return std::nullopt;
+    return hashes[static_cast<std::size_t>(height)];
+}
+
+std::optional<std::int64_t> HeaderChain::heightOf(const Hash256& hash) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (slots.empty()) return std::nullopt;
+    const std::uint32_t height = slots[findSlot(hash)];
+    if (height == NONE) return std::nullopt;
+    return height;
+}
+
+std::optional<RawHeader> HeaderChain::headerAt(std::int64_t height) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (height < 0 || static_cast<std::size_t>(height) >= hashes.size()) return std::nullopt;
+    RawHeader header;
+    std::memcpy(header.data(), headers.data() + static_cast<std::size_t>(height) * HEADER_SIZE, HEADER_SIZE);
+    return header;
+}
+
+std::optional<Hash256> HeaderChain::ancestor(const Hash256& block, std::int64_t height) const {
+    // Every known block is on the active chain, so its ancestors are the chain's own blocks.
+    const std::optional<std::int64_t> blockHeight = heightOf(block);
+    if (!blockHeight || height < 0 || height > *blockHeight) return std::nullopt;
+    return hashAt(height);
+}
+
+std::optional<std::uint32_t> HeaderChain::medianTimePast(std::int64_t height) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (height < 0 || static_cast<std::size_t>(height) >= hashes.size()) return std::nullopt;
+    std::array<std::uint32_t, MEDIAN_SPAN> times;
+    std::size_t count = 0;
+    for (std::int64_t at = height; at >= 0 && count < MEDIAN_SPAN; --at) {
+        times[count++] = timeOf(headers.data() + static_cast<std::size_t>(at) * HEADER_SIZE);
+    }
+    // The same element Bitcoin Core picks, also for fewer than 11 blocks.
+    std::nth_element(times.begin(), times.begin() + count / 2, times.begin() + count);
+    return times[count / 2];
+}
@@ -0,0 +1,130 @@
+#ifndef HEADERCHAIN_HPP
+#define HEADERCHAIN_HPP
+
+#if __has_include("rawblock.hpp")
+#   include "rawblock.hpp"
+#else
+#   error "Bitcoin's \"rawblock.hpp\" was not found!"
+#endif
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <vector>
+
+class BitcoinClient;
+class RestClient;
+
+using RawHeader = std::array<std::uint8_t, 80>;    ///< A serialized block header.
+
+/**
+ * @class HeaderChain
+ * @brief The headers of the node's active chain, held locally so height and hash lookups need no RPC.
+ *
+ * Tools that map heights to hashes and walk ancestry would otherwise call `getblockhash`,
+ * `getblockheader` and `getchaintips` over and over. This class keeps the 80-byte headers
+ * in one contiguous array indexed by height, their hashes in a second array, and an
+ * open-addressing table from hash to height. Mainnet needs about 125 bytes per block.
+ *
+ * `sync()` brings the chain up to the node's tip. It first finds the last block both chains
+ * share and drops everything above it, so it also handles reorganizations. It then fetches
+ * the missing headers in batches of `getblockhash` and `getblockheader` calls, or through
+ * REST `/headers`, which returns 2000 headers per request. REST headers are
+ * checked to link to each other; each one's hash is taken from the next header's
+ * `prevBlock`, and only the last of a batch is hashed. `connect()` appends a single header
+ * from a tip notification without a round trip.
+ *
+ * Only the active chain is kept, so stale blocks are unknown to `heightOf()`. Lookups share
+ * a lock; `sync()` and `connect()` take it exclusively while they change the chain.
+ *
+ * @code
+ * HeaderChain chain;
+ * chain.sync(client, &rest);
+ * handlers.onRawBlock = [&](ByteSpan block) { if (!chain.connect(block.first(80))) chain.sync(client); };
+ * std::optional<std::uint32_t> mtp = chain.medianTimePast(chain.height());
+ * @endcode
+ */
+class HeaderChain {
+public:
+    /**
+     * @brief Brings the chain up to the node's tip, dropping blocks a reorganization removed.
+     * @param client Answers `getblockcount` and `getblockhash`, and serves headers unless `rest` is given.
+     * @param rest Serves headers through `/rest/headers` when not null; the node needs `-rest`.
+     * @return `false` if a request failed or the node's answers do not link up; the chain is left as far as it got.
+     */
+    bool sync(BitcoinClient& client, RestClient* rest = nullptr);
+
+    /**
+     * @brief Appends a header if it extends the tip.
+     * @param header The 80 serialized bytes, such as the start of a `rawblock` notification.
+     * @return `false` if it is malformed or does not build on the tip; call `sync()` then.
+     */
+    bool connect(ByteSpan header);
+
+    /**
+     * @brief Returns the height of the tip, or -1 while the chain is empty.
+     */
+    std::int64_t height() const;
+
+    /**
+     * @brief Returns the hash of the block at `height` in the active chain.
+     */
+    std::optional<Hash256> hashAt(std::int64_t height) const;
+
+    /**
+     * @brief Returns the height of an active-chain block.
+     */
+    std::optional<std::int64_t> heightOf(const Hash256& hash) const;
+
+    /**
+     * @brief Returns the serialized header of the block at `height`.
+     */
+    std::optional<RawHeader> headerAt(std::int64_t height) const;
+
+    /**
+     * @brief Returns the ancestor of an active-chain block at `height`, or nothing if `block` is unknown or lower.
+     */
+    std::optional<Hash256> ancestor(const Hash256& block, std::int64_t height) const;
+
+    /**
+     * @brief Returns the median time past of the block at `height`: the median timestamp of it and its 10 ancestors.
+     */
+    std::optional<std::uint32_t> medianTimePast(std::int64_t height) const;
+
+private:
+    static constexpr std::uint32_t NONE = UINT32_MAX;          ///< Empty table slot.
+    static constexpr std::size_t HEADER_SIZE = 80;
+
+    /**
+     * @brief Adds a header whose hash is already known; `mutex` is held exclusively.
+     */
+    void append(ByteSpan header, const Hash256& hash);
+
+    /**
+     * @brief Drops the blocks above `height`; `mutex` is held exclusively.
+     */
+    void truncate(std::int64_t height);
+
+    /**
+     * @brief Returns the slot of `hash` in the table, or the empty slot where it would go.
+     */
+    std::size_t findSlot(const Hash256& hash) const;
+
+    void rebuildTable(std::size_t slotCount);  ///< Fills a table of `slotCount` slots from `hashes`.
+
+    /**
+     * @brief Drops the blocks that are no longer in the node's active chain of `nodeHeight` blocks.
+     */
+    bool unwind(BitcoinClient& client, std::int64_t nodeHeight);
+
+    bool extendRpc(BitcoinClient& client, std::int64_t nodeHeight);   ///< Fetches one batch of headers over RPC.
+    bool extendRest(RestClient& rest, const Hash256& from);         ///< Fetches one batch of headers over REST.
+
+    mutable std::shared_mutex mutex;
+    std::vector<std::uint8_t> headers;     ///< Serialized headers, `HEADER_SIZE` bytes per height.
+    std::vector<Hash256> hashes;           ///< Hash of each height.
+    std::vector<std::uint32_t> slots;      ///< Heights by hash, linear probing; a power of two in size.
+};
+
+#endif // HEADERCHAIN_HPP
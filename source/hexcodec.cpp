@@ -0,0 +1,219 @@
+#include "hexcodec.hpp"
+#include <array>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#   define HEX_SSE2
+#   include <immintrin.h>
+#   if defined(__GNUC__) || defined(__clang__)
+#       define HEX_AVX2
+#   endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   define HEX_NEON
+#   include <arm_neon.h>
+#endif
+
+namespace {
+/**
+ * @brief Value of every byte as a hex digit, or -1.
+ */
+constexpr std::array<std::int8_t, 256> HEX_VALUES = [] {
+    std::array<std::int8_t, 256> values {};
+    values.fill(-1);
+    for (int i = 0; i < 10; ++i) values['0' + i] = static_cast<std::int8_t>(i);
+    for (int i = 0; i < 6; ++i) {
+        values['a' + i] = static_cast<std::int8_t>(10 + i);
+        values['A' + i] = static_cast<std::int8_t>(10 + i);
+    }
+    return values;
+}();
+
+constexpr char DIGITS[] = "0123456789abcdef";
+
+using DecodeKernel = bool (*)(const char* in, std::size_t bytes, std::uint8_t* out);
+
+bool decodeScalar(const char* in, std::size_t bytes, std::uint8_t* out) {
+    // Invalid digits are -1, so one sign check at the end covers the whole input.
+    int invalid = 0;
+    for (std::size_t i = 0; i < bytes; ++i) {
+        const int high = HEX_VALUES[static_cast<unsigned char>(in[2 * i])];
+        const int low = HEX_VALUES[static_cast<unsigned char>(in[2 * i + 1])];
+        invalid |= high | low;
+        out[i] = static_cast<std::uint8_t>(high << 4 | low);
+    }
+    return invalid >= 0;
+}
+
+void encodeScalar(const std::uint8_t* in, std::size_t bytes, char* out) {
+    for (std::size_t i = 0; i < bytes; ++i) {
+        out[2 * i] = DIGITS[in[i] >> 4];
+        out[2 * i + 1] = DIGITS[in[i] & 0x0F];
+    }
+}
+
+#ifdef HEX_SSE2
+/**
+ * @brief Converts 16 characters to their digit values, clearing lanes of `valid` that are not hex digits.
+ *
+ * Digits and letters are told apart with unsigned range checks (`min(x, n) == x` means `x <= n`);
+ * setting bit 5 folds upper case letters onto lower case ones.
+ */
+inline __m128i nibblesSse2(__m128i chars, __m128i& valid) {
+    const __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    const __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    const __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+    valid = _mm_and_si128(valid, _mm_or_si128(isDigit, isLetter));
+    return _mm_or_si128(_mm_and_si128(isDigit, digit), _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+/**
+ * @brief Joins the digit pairs of 16 nibbles into 8 bytes, one in the low half of every 16-bit lane.
+ */
+inline __m128i pairsSse2(__m128i nibbles) {
+    return _mm_or_si128(_mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00F0)), _mm_srli_epi16(nibbles, 8));
+}
+
+bool decodeSse2(const char* in, std::size_t bytes, std::uint8_t* out) {
+    __m128i valid = _mm_set1_epi8(-1);
+    std::size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i));
+        const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i + 16));
+        const __m128i packed = _mm_packus_epi16(pairsSse2(nibblesSse2(first, valid)), pairsSse2(nibblesSse2(second, valid)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    return _mm_movemask_epi8(valid) == 0xFFFF && decodeScalar(in + 2 * i, bytes - i, out + i);
+}
+
+inline __m128i digitsSse2(__m128i nibbles) {
+    const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+
+void encodeSse2(const std::uint8_t* in, std::size_t bytes, char* out) {
+    std::size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i high = digitsSse2(_mm_and_si128(_mm_srli_epi16(data, 4), _mm_set1_epi8(0x0F)));
+        const __m128i low = digitsSse2(_mm_and_si128(data, _mm_set1_epi8(0x0F)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+    }
+    encodeScalar(in + i, bytes - i, out + 2 * i);
+}
+#endif
+
+#ifdef HEX_AVX2
+__attribute__((target("avx2"))) inline __m256i nibblesAvx2(__m256i chars, __m256i& valid) {
+    const __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    const __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    const __m256i letter = _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    const __m256i isLetter = _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+    valid = _mm256_and_si256(valid, _mm256_or_si256(isDigit, isLetter));
+    return _mm256_or_si256(_mm256_and_si256(isDigit, digit),
+                           _mm256_and_si256(isLetter, _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+}
+
+__attribute__((target("avx2"))) inline __m256i pairsAvx2(__m256i nibbles) {
+    return _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(nibbles, 4), _mm256_set1_epi16(0x00F0)), _mm256_srli_epi16(nibbles, 8));
+}
+
+__attribute__((target("avx2"))) bool decodeAvx2(const char* in, std::size_t bytes, std::uint8_t* out) {
+    __m256i valid = _mm256_set1_epi8(-1);
+    std::size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * i));
+        const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * i + 32));
+        // Packing works within 128-bit lanes; the permutation puts the four 8-byte groups back in order.
+        const __m256i packed = _mm256_packus_epi16(pairsAvx2(nibblesAvx2(first, valid)), pairsAvx2(nibblesAvx2(second, valid)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return _mm256_movemask_epi8(valid) == -1 && decodeSse2(in + 2 * i, bytes - i, out + i);
+}
+#endif
+
+#ifdef HEX_NEON
+inline uint8x16_t nibblesNeon(uint8x16_t chars, uint8x16_t& valid) {
+    const uint8x16_t digit = vsubq_u8(chars, vdupq_n_u8('0'));
+    const uint8x16_t isDigit = vcleq_u8(digit, vdupq_n_u8(9));
+    const uint8x16_t letter = vsubq_u8(vorrq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    const uint8x16_t isLetter = vcleq_u8(letter, vdupq_n_u8(5));
+    valid = vandq_u8(valid, vorrq_u8(isDigit, isLetter));
+    return vbslq_u8(isDigit, digit, vaddq_u8(letter, vdupq_n_u8(10)));
+}
+
+bool decodeNeon(const char* in, std::size_t bytes, std::uint8_t* out) {
+    uint8x16_t valid = vdupq_n_u8(0xFF);
+    std::size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        // The structured load splits the even (high) and odd (low) digits.
+        const uint8x16x2_t chars = vld2q_u8(reinterpret_cast<const std::uint8_t*>(in + 2 * i));
+        const uint8x16_t high = nibblesNeon(chars.val[0], valid);
+        const uint8x16_t low = nibblesNeon(chars.val[1], valid);
+        vst1q_u8(out + i, vorrq_u8(vshlq_n_u8(high, 4), low));
+    }
+    return vminvq_u8(valid) == 0xFF && decodeScalar(in + 2 * i, bytes - i, out + i);
+}
+
+inline uint8x16_t digitsNeon(uint8x16_t nibbles) {
+    const uint8x16_t letters = vandq_u8(vcgtq_u8(nibbles, vdupq_n_u8(9)), vdupq_n_u8('a' - '0' - 10));
+    return vaddq_u8(vaddq_u8(nibbles, vdupq_n_u8('0')), letters);
+}
+
+void encodeNeon(const std::uint8_t* in, std::size_t bytes, char* out) {
+    std::size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const uint8x16_t data = vld1q_u8(in + i);
+        uint8x16x2_t digits;
+        digits.val[0] = digitsNeon(vshrq_n_u8(data, 4));
+        digits.val[1] = digitsNeon(vandq_u8(data, vdupq_n_u8(0x0F)));
+        vst2q_u8(reinterpret_cast<std::uint8_t*>(out + 2 * i), digits);
+    }
+    encodeScalar(in + i, bytes - i, out + 2 * i);
+}
+#endif
+
+struct Kernels {
+    DecodeKernel decode;
+    void (*encode)(const std::uint8_t* in, std::size_t bytes, char* out);
+    std::string_view name;
+};
+
+Kernels selectKernels() {
+#if defined(HEX_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {decodeAvx2, encodeSse2, "avx2"};
+#endif
+#if defined(HEX_SSE2)
+    return {decodeSse2, encodeSse2, "sse2"};
+#elif defined(HEX_NEON)
+    return {decodeNeon, encodeNeon, "neon"};
+#else
+    return {decodeScalar, encodeScalar, "scalar"};
+#endif
+}
+
+const Kernels& kernels() {
+    static const Kernels selected = selectKernels();
+    return selected;
+}
+}
+
+bool decodeHex(std::string_view hex, std::uint8_t* out) {
+    if (hex.size() % 2 != 0) return false;
+    return kernels().decode(hex.data(), hex.size() / 2, out);
+}
+
+void encodeHex(std::span<const std::uint8_t> bytes, char* out) {
+    kernels().encode(bytes.data(), bytes.size(), out);
+}
+
+std::string encodeHex(std::span<const std::uint8_t> bytes) {
+    std::string hex(2 * bytes.size(), '\0');
+    encodeHex(bytes, hex.data());
+    return hex;
+}
+
+std::string_view hexKernel() {
+    return kernels().name;
+}
@@ -0,0 +1,48 @@
+#ifndef HEXCODEC_HPP
+#define HEXCODEC_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+/**
+ * @name Hex codec
+ * @brief Conversion between bytes and hexadecimal text.
+ *
+ * Raw blocks and transactions arrive from RPC as hex strings of up to several megabytes,
+ * so the conversion is vectorized: AVX2 where the CPU supports it (checked once at run
+ * time), SSE2 on other x86-64 CPUs, NEON on AArch64, and a table-driven loop elsewhere
+ * and for the last few bytes. All kernels accept upper and lower case digits and produce
+ * identical results.
+ * @{
+ */
+
+/**
+ * @brief Decodes hexadecimal text.
+ * @param hex The text; its length must be even.
+ * @param[out] out Receives `hex.size() / 2` bytes; unspecified if decoding fails.
+ * @return `false` if the length is odd or a character is not a hex digit.
+ */
+bool decodeHex(std::string_view hex, std::uint8_t* out);
+
+/**
+ * @brief Encodes bytes as lowercase hex digits.
+ * @param bytes The bytes.
+ * @param[out] out Receives `2 * bytes.size()` characters; no terminator is written.
+ */
+void encodeHex(std::span<const std::uint8_t> bytes, char* out);
+
+/**
+ * @brief Encodes bytes as a lowercase hex string.
+ */
+std::string encodeHex(std::span<const std::uint8_t> bytes);
+
+/**
+ * @brief Returns the name of the decoding kernel in use: `avx2`, `sse2`, `neon` or `scalar`.
+ */
+std::string_view hexKernel();
+/** @} */
+
+#endif // HEXCODEC_HPP
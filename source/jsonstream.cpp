@@ -0,0 +1,446 @@
+#include "jsonstream.hpp"
+#include <charconv>
+#include <cstdlib>
+#include <utility>
+
+namespace {
+
+bool isNumberChar(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * @brief Validates a number token against the JSON grammar.
+ */
+bool isValidNumber(std::string_view text) {
+    std::size_t i = 0;
+    const std::size_t n = text.size();
+    if (i < n && text[i] == '-') ++i;
+    if (i >= n) return false;
+    if (text[i] == '0') {
+        ++i;
+    } else if (isDigit(text[i])) {
+        while (i < n && isDigit(text[i])) ++i;
+    } else {
+        return false;
+    }
+    if (i < n && text[i] == '.') {
+        ++i;
+        if (i >= n || !isDigit(text[i])) return false;
+        while (i < n && isDigit(text[i])) ++i;
+    }
+    if (i < n && (text[i] == 'e' || text[i] == 'E')) {
+        ++i;
+        if (i < n && (text[i] == '+' || text[i] == '-')) ++i;
+        if (i >= n || !isDigit(text[i])) return false;
+        while (i < n && isDigit(text[i])) ++i;
+    }
+    return i == n;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+JsonStreamParser::JsonStreamParser(JsonHandler& handler)
+    : handler(handler) {}
+
+void JsonStreamParser::reset() {
+    containers.clear();
+    expect = Expect::Value;
+    token = Token::None;
+    tokenIsKey = false;
+    buffer.clear();
+    escape = 0;
+    codeUnit = 0;
+    highSurrogate = 0;
+    errorMessage.clear();
+}
+
+bool JsonStreamParser::fail(std::string message) {
+    if (errorMessage.empty()) errorMessage = std::move(message);
+    return false;
+}
+
+bool JsonStreamParser::feed(std::string_view chunk) {
+    if (failed()) return false;
+
+    std::size_t pos = 0;
+    while (pos < chunk.size()) {
+        switch (token) {
+        case Token::String:
+            if (!lexString(chunk, pos)) return false;
+            continue;
+        case Token::Number:
+            if (!lexNumber(chunk, pos)) return false;
+            continue;
+        case Token::Literal:
+            if (!lexLiteral(chunk, pos)) return false;
+            continue;
+        case Token::None:
+            break;
+        }
+
+        const char c = chunk[pos++];
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t') continue;
+
+        switch (expect) {
+        case Expect::Value:
+            if (!beginValue(c)) return false;
+            break;
+        case Expect::ValueOrEndArray:
+            if (!(c == ']' ? endContainer(c) : beginValue(c))) return false;
+            break;
+        case Expect::KeyOrEndObject:
+            if (c == '}') {
+                if (!endContainer(c)) return false;
+                break;
+            }
+            [[fallthrough]];
+        case Expect::Key:
+            if (c != '"') return fail("Expected an object key");
+            token = Token::String;
+            tokenIsKey = true;
+            buffer.clear();
+            break;
+        case Expect::Colon:
+            if (c != ':') return fail("Expected ':'");
+            expect = Expect::Value;
+            break;
+        case Expect::CommaOrEnd:
+            if (c == ',') {
+                expect = containers.back() == '{' ? Expect::Key : Expect::Value;
+            } else if (c == '}' || c == ']') {
+                if (!endContainer(c)) return false;
+            } else {
+                return fail("Expected ',' or the end of a container");
+            }
+            break;
+        case Expect::Done:
+            return fail("Unexpected data after the document");
+        }
+    }
+    return true;
+}
+
+bool JsonStreamParser::finish() {
+    if (failed()) return false;
+    if (token == Token::Number && !emitNumber()) return false;
+    if (token != Token::None || expect != Expect::Done) return fail("Unexpected end of the document");
+    return true;
+}
+
+bool JsonStreamParser::beginValue(char c) {
+    switch (c) {
+    case '{':
+        containers.push_back('{');
+        expect = Expect::KeyOrEndObject;
+        return handler.onStartObject() || fail("Aborted by handler");
+    case '[':
+        containers.push_back('[');
+        expect = Expect::ValueOrEndArray;
+        return handler.onStartArray() || fail("Aborted by handler");
+    case '"':
+        token = Token::String;
+        tokenIsKey = false;
+        buffer.clear();
+        return true;
+    case 't':
+        literal = "true";
+        break;
+    case 'f':
+        literal = "false";
+        break;
+    case 'n':
+        literal = "null";
+        break;
+    default:
+        if (c != '-' && !isDigit(c)) return fail("Unexpected character");
+        token = Token::Number;
+        buffer.assign(1, c);
+        return true;
+    }
+    token = Token::Literal;
+    buffer.assign(1, c);
+    return true;
+}
+
+bool JsonStreamParser::valueDone() {
+    expect = containers.empty() ? Expect::Done : Expect::CommaOrEnd;
+    return true;
+}
+
+bool JsonStreamParser::endContainer(char closing) {
+    if (containers.empty() || containers.back() != (closing == '}' ? '{' : '[')) {
+        return fail("Mismatched end of a container");
+    }
+    containers.pop_back();
+    const bool proceed = closing == '}' ? handler.onEndObject() : handler.onEndArray();
+    return (proceed || fail("Aborted by handler")) && valueDone();
+}
+
+bool JsonStreamParser::lexString(std::string_view chunk, std::size_t& pos) {
+    while (pos < chunk.size()) {
+        if (escape != 0) {
+            if (!lexEscape(chunk[pos++])) return false;
+            continue;
+        }
+
+        std::size_t end = pos;
+        while (end < chunk.size()) {
+            const char c = chunk[end];
+            if (c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20) break;
+            ++end;
+        }
+        if (highSurrogate != 0 && end > pos) return fail("Unpaired UTF-16 surrogate");
+
+        // Fast path: a string without escapes that ends in this chunk is passed without copying.
+        if (end < chunk.size() && chunk[end] == '"' && buffer.empty() && highSurrogate == 0) {
+            const std::string_view value = chunk.substr(pos, end - pos);
+            pos = end + 1;
+            token = Token::None;
+            return emitString(value);
+        }
+
+        buffer.append(chunk.data() + pos, end - pos);
+        pos = end;
+        if (pos == chunk.size()) return true;
+
+        const char c = chunk[pos++];
+        if (c == '"') {
+            if (highSurrogate != 0) return fail("Unpaired UTF-16 surrogate");
+            token = Token::None;
+            return emitString(buffer);
+        }
+        if (c != '\\') return fail("Control character in string");
+        escape = 1;
+    }
+    return true;
+}
+
+bool JsonStreamParser::lexEscape(char c) {
+    if (escape == 1) {
+        if (c == 'u') {
+            escape = 2;
+            codeUnit = 0;
+            return true;
+        }
+        if (highSurrogate != 0) return fail("Unpaired UTF-16 surrogate");
+        escape = 0;
+        switch (c) {
+        case '"': buffer.push_back('"'); return true;
+        case '\\': buffer.push_back('\\'); return true;
+        case '/': buffer.push_back('/'); return true;
+        case 'b': buffer.push_back('\b'); return true;
+        case 'f': buffer.push_back('\f'); return true;
+        case 'n': buffer.push_back('\n'); return true;
+        case 'r': buffer.push_back('\r'); return true;
+        case 't': buffer.push_back('\t'); return true;
+        default: return fail("Invalid escape sequence");
+        }
+    }
+
+    const int digit = hexValue(c);
+    if (digit < 0) return fail("Invalid \\u escape");
+    codeUnit = codeUnit * 16 + static_cast<std::uint32_t>(digit);
+    if (++escape < 6) return true;
+
+    escape = 0;
+    if (highSurrogate != 0) {
+        if (codeUnit < 0xDC00 || codeUnit > 0xDFFF) return fail("Unpaired UTF-16 surrogate");
+        appendUtf8(0x10000 + ((highSurrogate - 0xD800) << 10) + (codeUnit - 0xDC00));
+        highSurrogate = 0;
+    } else if (codeUnit >= 0xD800 && codeUnit <= 0xDBFF) {
+        highSurrogate = codeUnit;
+    } else if (codeUnit >= 0xDC00 && codeUnit <= 0xDFFF) {
+        return fail("Unpaired UTF-16 surrogate");
+    } else {
+        appendUtf8(codeUnit);
+    }
+    return true;
+}
+
+void JsonStreamParser::appendUtf8(std::uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        buffer.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        buffer.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        buffer.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        buffer.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        buffer.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        buffer.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        buffer.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        buffer.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        buffer.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        buffer.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+bool JsonStreamParser::lexNumber(std::string_view chunk, std::size_t& pos) {
+    const std::size_t start = pos;
+    while (pos < chunk.size() && isNumberChar(chunk[pos])) ++pos;
+    buffer.append(chunk.data() + start, pos - start);
+    // The number ends at the first other character, which is left for the grammar.
+    return pos == chunk.size() || emitNumber();
+}
+
+bool JsonStreamParser::lexLiteral(std::string_view chunk, std::size_t& pos) {
+    while (pos < chunk.size() && buffer.size() < literal.size()) {
+        if (chunk[pos] != literal[buffer.size()]) return fail("Invalid literal");
+        buffer.push_back(chunk[pos++]);
+    }
+    if (buffer.size() < literal.size()) return true;
+
+    token = Token::None;
+    bool proceed = false;
+    if (literal[0] == 'n') {
+        proceed = handler.onNull();
+    } else {
+        proceed = handler.onBool(literal[0] == 't');
+    }
+    return (proceed || fail("Aborted by handler")) && valueDone();
+}
+
+bool JsonStreamParser::emitString(std::string_view value) {
+    if (tokenIsKey) {
+        expect = Expect::Colon;
+        return handler.onKey(value) || fail("Aborted by handler");
+    }
+    return (handler.onString(value) || fail("Aborted by handler")) && valueDone();
+}
+
+bool JsonStreamParser::emitNumber() {
+    token = Token::None;
+    if (!isValidNumber(buffer)) return fail("Invalid number");
+    return (handler.onNumber(buffer) || fail("Aborted by handler")) && valueDone();
+}
+
+JsonElementStreamer::JsonElementStreamer(std::vector<std::string> path, ElementCallback onElement)
+    : path(std::move(path)), onElement(std::move(onElement)) {}
+
+Json::Value* JsonElementStreamer::slot() {
+    Frame& top = frames.back();
+    if (top.object) return &(*top.value)[top.key];
+    return &top.value->append(Json::Value());
+}
+
+bool JsonElementStreamer::deliver(Json::Value&& value) {
+    ++delivered;
+    return !onElement || onElement(elementKey, std::move(value));
+}
+
+bool JsonElementStreamer::addScalar(Json::Value&& value) {
+    if (frames.empty()) {
+        root = std::move(value);
+        started = true;
+        return true;
+    }
+    const Frame& top = frames.back();
+    if (top.target) {
+        elementKey = top.object ? top.key : std::string();
+        return deliver(std::move(value));
+    }
+    *slot() = std::move(value);
+    return true;
+}
+
+bool JsonElementStreamer::startContainer(bool object) {
+    const Json::Value empty(object ? Json::objectValue : Json::arrayValue);
+    if (frames.empty()) {
+        root = empty;
+        started = true;
+        frames.push_back({&root, object, true, path.empty(), false, {}});
+        return true;
+    }
+
+    const Frame& parent = frames.back();
+    if (parent.target) {
+        // A new element: built on the side, delivered when it closes.
+        elementKey = parent.object ? parent.key : std::string();
+        pendingElement = empty;
+        frames.push_back({&pendingElement, object, false, false, true, {}});
+        return true;
+    }
+
+    const std::size_t depth = frames.size() - 1;
+    const bool onPath = parent.onPath && !parent.element && parent.object
+                        && depth < path.size() && parent.key == path[depth];
+    const bool target = onPath && depth + 1 == path.size();
+    const bool element = parent.element;
+    Json::Value* value = slot();
+    *value = empty;
+    frames.push_back({value, object, onPath, target, element, {}});
+    return true;
+}
+
+bool JsonElementStreamer::endContainer() {
+    const bool element = frames.back().element;
+    frames.pop_back();
+    if (element && !frames.empty() && frames.back().target) {
+        return deliver(std::move(pendingElement));
+    }
+    return true;
+}
+
+bool JsonElementStreamer::onNull() {
+    return addScalar(Json::Value());
+}
+
+bool JsonElementStreamer::onBool(bool value) {
+    return addScalar(Json::Value(value));
+}
+
+bool JsonElementStreamer::onNumber(std::string_view raw) {
+    const bool integral = raw.find_first_of(".eE") == std::string_view::npos;
+    if (integral) {
+        if (raw.front() == '-') {
+            Json::Int64 value = 0;
+            const auto [end, ec] = std::from_chars(raw.data(), raw.data() + raw.size(), value);
+            if (ec == std::errc() && end == raw.data() + raw.size()) return addScalar(Json::Value(value));
+        } else {
+            Json::UInt64 value = 0;
+            const auto [end, ec] = std::from_chars(raw.data(), raw.data() + raw.size(), value);
+            if (ec == std::errc() && end == raw.data() + raw.size()) {
+                return addScalar(value <= static_cast<Json::UInt64>(Json::Value::maxInt64)
+                                 ? Json::Value(static_cast<Json::Int64>(value)) : Json::Value(value));
+            }
+        }
+    }
+    return addScalar(Json::Value(std::strtod(std::string(raw).c_str(), nullptr)));
+}
+
+bool JsonElementStreamer::onString(std::string_view value) {
+    return addScalar(Json::Value(value.data(), value.data() + value.size()));
+}
+
+bool JsonElementStreamer::onKey(std::string_view key) {
+    frames.back().key.assign(key.data(), key.size());
+    return true;
+}
+
+bool JsonElementStreamer::onStartObject() {
+    return startContainer(true);
+}
+
+bool JsonElementStreamer::onEndObject() {
+    return endContainer();
+}
+
+bool JsonElementStreamer::onStartArray() {
+    return startContainer(false);
+}
+
+bool JsonElementStreamer::onEndArray() {
+    return endContainer();
+}
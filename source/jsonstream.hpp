@@ -0,0 +1,188 @@
+#ifndef JSONSTREAM_HPP
+#define JSONSTREAM_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#if __has_include(<json/json.h>)
+#   include <json/json.h>
+#else
+#   error "Bitcoin's <json/json.h> was not found!"
+#endif
+
+/**
+ * @class JsonHandler
+ * @brief Receives the events produced by `JsonStreamParser`.
+ *
+ * Every callback returns `true` to continue parsing or `false` to abort it.
+ * String views passed to the callbacks are only valid for the duration of the call.
+ */
+class JsonHandler {
+public:
+    virtual ~JsonHandler() = default;
+
+    virtual bool onNull() = 0;                            ///< A `null` literal.
+    virtual bool onBool(bool value) = 0;                  ///< A `true` or `false` literal.
+    virtual bool onNumber(std::string_view raw) = 0;      ///< A number, as its exact source text.
+    virtual bool onString(std::string_view value) = 0;    ///< A string value, unescaped.
+    virtual bool onKey(std::string_view key) = 0;         ///< An object member name, unescaped.
+    virtual bool onStartObject() = 0;                     ///< `{`
+    virtual bool onEndObject() = 0;                       ///< `}`
+    virtual bool onStartArray() = 0;                      ///< `[`
+    virtual bool onEndArray() = 0;                        ///< `]`
+};
+
+/**
+ * @class JsonStreamParser
+ * @brief An incremental (push) JSON parser that emits SAX-style events.
+ *
+ * The document can be fed in chunks of any size, split anywhere (even inside a token),
+ * so it can be driven directly by a network write callback. Only the token currently
+ * being parsed and the nesting stack are kept in memory; strings without escapes that
+ * lie entirely within one chunk are passed to the handler without copying.
+ *
+ * Numbers are reported as their source text, so callers can convert amounts exactly
+ * instead of going through `double`.
+ */
+class JsonStreamParser {
+public:
+    /**
+     * @brief Constructs a parser that reports to the given handler.
+     * @param handler The event receiver; must outlive the parser.
+     */
+    explicit JsonStreamParser(JsonHandler& handler);
+
+    /**
+     * @brief Parses the next chunk of the document.
+     * @param chunk The bytes to parse.
+     * @return `false` if the input is malformed or the handler aborted; `true` otherwise.
+     */
+    bool feed(std::string_view chunk);
+
+    /**
+     * @brief Signals the end of input.
+     * @return `true` if exactly one complete document was parsed.
+     */
+    bool finish();
+
+    /**
+     * @brief Prepares the parser for a new document.
+     */
+    void reset();
+
+    /**
+     * @brief Checks whether parsing failed or was aborted.
+     */
+    bool failed() const { return !errorMessage.empty(); }
+
+    /**
+     * @brief Returns a description of the failure, empty if none.
+     */
+    const std::string& error() const { return errorMessage; }
+
+private:
+    enum class Expect : std::uint8_t { Value, ValueOrEndArray, KeyOrEndObject, Key, Colon, CommaOrEnd, Done };
+    enum class Token : std::uint8_t { None, String, Number, Literal };
+
+    bool fail(std::string message);
+    bool beginValue(char c);
+    bool valueDone();
+    bool endContainer(char closing);
+    bool lexString(std::string_view chunk, std::size_t& pos);
+    bool lexEscape(char c);
+    bool lexNumber(std::string_view chunk, std::size_t& pos);
+    bool lexLiteral(std::string_view chunk, std::size_t& pos);
+    bool emitString(std::string_view value);
+    bool emitNumber();
+    void appendUtf8(std::uint32_t codePoint);
+
+    JsonHandler& handler;
+    std::vector<char> containers;       ///< Open containers, `{` or `[`.
+    Expect expect = Expect::Value;
+    Token token = Token::None;
+    bool tokenIsKey = false;
+    std::string buffer;                 ///< The current token, when it cannot be passed without copying.
+    std::string_view literal;           ///< The literal being matched (`true`, `false` or `null`).
+    std::uint8_t escape = 0;            ///< 0: none, 1: after a backslash, 2-5: reading `\\u` hex digits.
+    std::uint32_t codeUnit = 0;
+    std::uint32_t highSurrogate = 0;
+    std::string errorMessage;
+};
+
+/**
+ * @class JsonElementStreamer
+ * @brief Builds a JSON document, but hands the elements of one container to a callback instead.
+ *
+ * The container is selected with a path of object member names from the root
+ * (e.g. `{"result", "tx"}` for the transactions of a `getblock` response). Each of its
+ * elements is built as a small `Json::Value` and passed to the callback as soon as it
+ * is complete, then discarded. Everything outside that container is collected into
+ * `document()`, where the container itself appears empty.
+ */
+class JsonElementStreamer : public JsonHandler {
+public:
+    /**
+     * @brief Receives one element of the streamed container.
+     * @param key The member name if the container is an object; empty for arrays.
+     * @param element The element.
+     * @return `true` to continue, `false` to stop the transfer.
+     */
+    using ElementCallback = std::function<bool(std::string_view key, Json::Value&& element)>;
+
+    /**
+     * @brief Constructs a streamer.
+     * @param path Member names leading from the root to the streamed container.
+     * @param onElement The element callback.
+     */
+    JsonElementStreamer(std::vector<std::string> path, ElementCallback onElement);
+
+    /**
+     * @brief Returns the document without the streamed elements.
+     */
+    Json::Value& document() { return root; }
+
+    /**
+     * @brief Returns the number of elements passed to the callback.
+     */
+    std::size_t elementCount() const { return delivered; }
+
+    bool onNull() override;
+    bool onBool(bool value) override;
+    bool onNumber(std::string_view raw) override;
+    bool onString(std::string_view value) override;
+    bool onKey(std::string_view key) override;
+    bool onStartObject() override;
+    bool onEndObject() override;
+    bool onStartArray() override;
+    bool onEndArray() override;
+
+private:
+    struct Frame {
+        Json::Value* value;     ///< The container being filled.
+        bool object;            ///< Object or array.
+        bool onPath;            ///< Reached by following `path` from the root.
+        bool target;            ///< This is the streamed container.
+        bool element;           ///< Part of an element being built.
+        std::string key;        ///< The pending member name (objects only).
+    };
+
+    Json::Value* slot();
+    bool addScalar(Json::Value&& value);
+    bool startContainer(bool object);
+    bool endContainer();
+    bool deliver(Json::Value&& value);
+
+    std::vector<std::string> path;
+    ElementCallback onElement;
+    Json::Value root;
+    Json::Value pendingElement;
+    std::string elementKey;
+    std::vector<Frame> frames;
+    std::size_t delivered = 0;
+    bool started = false;
+};
+
+#endif // JSONSTREAM_HPP
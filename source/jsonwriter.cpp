@@ -0,0 +1,110 @@
+#include "jsonwriter.hpp"
+#include <cmath>
+
+namespace {
+constexpr std::string_view HEX_DIGITS = "0123456789abcdef";
+}
+
+void JsonWriter::write(double value) {
+    // JSON has no representation for NaN or infinities; jsoncpp writes them as null too.
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    std::array<char, 32> digits;
+    const auto end = std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr;
+    out.append(digits.data(), end);
+}
+
+void JsonWriter::write(std::string_view value) {
+    out += '"';
+    std::size_t plain = 0;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        const auto c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        // Copy the run of characters that need no escaping in one go.
+        out.append(value.data() + plain, i - plain);
+        plain = i + 1;
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            out += "\\u00";
+            out += HEX_DIGITS[c >> 4];
+            out += HEX_DIGITS[c & 0xf];
+        }
+    }
+    out.append(value.data() + plain, value.size() - plain);
+    out += '"';
+}
+
+void JsonWriter::write(const Json::Value& value) {
+    switch (value.type()) {
+    case Json::nullValue:
+        write(nullptr);
+        return;
+    case Json::intValue:
+        write(value.asLargestInt());
+        return;
+    case Json::uintValue:
+        write(value.asLargestUInt());
+        return;
+    case Json::realValue:
+        write(value.asDouble());
+        return;
+    case Json::booleanValue:
+        write(value.asBool());
+        return;
+    case Json::stringValue: {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        value.getString(&begin, &end);
+        write(std::string_view(begin, static_cast<std::size_t>(end - begin)));
+        return;
+    }
+    case Json::arrayValue:
+        out += '[';
+        for (Json::ArrayIndex i = 0; i < value.size(); ++i) {
+            if (i) out += ',';
+            write(value[i]);
+        }
+        out += ']';
+        return;
+    case Json::objectValue:
+        out += '{';
+        for (auto member = value.begin(); member != value.end(); ++member) {
+            if (member != value.begin()) out += ',';
+            const char* end = nullptr;
+            const char* name = member.memberName(&end);
+            write(std::string_view(name, static_cast<std::size_t>(end - name)));
+            out += ':';
+            write(*member);
+        }
+        out += '}';
+        return;
+    }
+}
+
+void JsonWriter::beginRpcRequest(std::uint64_t id) {
+    out += "{\"jsonrpc\":\"1.0\",\"id\":";
+    write(id);
+    out += ",\"method\":";
+}
+
+void JsonWriter::rpcRequestWithParams(std::string_view method, std::uint64_t id, const Json::Value& params) {
+    beginRpcRequest(id);
+    write(method);
+    out += ",\"params\":";
+    if (params.isNull()) {
+        out += "[]";
+    } else {
+        write(params);
+    }
+    out += '}';
+}
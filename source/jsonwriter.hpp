@@ -0,0 +1,203 @@
+#ifndef JSONWRITER_HPP
+#define JSONWRITER_HPP
+
+#if __has_include(<json/json.h>)
+#   include <json/json.h>
+#else
+#   error "Bitcoin's <json/json.h> was not found!"
+#endif
+
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct JsonLiteral
+ * @brief A string literal quoted and escaped for JSON at compile time.
+ *
+ * Used as a template argument, so that method names of JSON-RPC calls are copied into the
+ * payload as they are, without any run-time escaping:
+ *
+ * @code
+ * static constexpr JsonLiteral method("gettxout");
+ * writer.write(method);   // Appends "gettxout", quotes included.
+ * @endcode
+ */
+template<std::size_t N>
+struct JsonLiteral {
+    std::array<char, 6 * (N - 1) + 2> quoted {};    ///< The escaped text between double quotes.
+    std::size_t quotedLength = 0;                   ///< Number of used characters of `quoted`.
+    std::array<char, N> text {};                    ///< The original text, NUL-terminated.
+
+    consteval JsonLiteral(const char (&literal)[N]) {
+        constexpr std::string_view HEX_DIGITS = "0123456789abcdef";
+        quoted[quotedLength++] = '"';
+        for (std::size_t i = 0; i + 1 < N; ++i) {
+            const char c = literal[i];
+            text[i] = c;
+            if (c == '"' || c == '\\') {
+                quoted[quotedLength++] = '\\';
+                quoted[quotedLength++] = c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                for (char e : {'\\', 'u', '0', '0', HEX_DIGITS[(c >> 4) & 0xf], HEX_DIGITS[c & 0xf]}) quoted[quotedLength++] = e;
+            } else {
+                quoted[quotedLength++] = c;
+            }
+        }
+        quoted[quotedLength++] = '"';
+    }
+
+    /**
+     * @brief Returns the JSON representation, quotes included.
+     */
+    constexpr std::string_view json() const { return {quoted.data(), quotedLength}; }
+
+    /**
+     * @brief Returns the original text.
+     */
+    constexpr std::string_view view() const { return {text.data(), N - 1}; }
+};
+
+/**
+ * @class JsonWriter
+ * @brief Appends compact JSON to a string, without building a Json::Value tree.
+ *
+ * The writer owns no memory: everything goes straight into the target string, so a caller
+ * that reuses one string across requests serializes without any heap allocation once it
+ * has grown to size. Numbers are written with `std::to_chars`; strings are escaped as
+ * RFC 8259 requires and passed through otherwise, so UTF-8 text is kept as it is.
+ *
+ * @code
+ * std::string payload;
+ * JsonWriter(payload).rpcRequest(JsonLiteral("getblockhash"), 1, 800000);
+ * // {"jsonrpc":"1.0","id":1,"method":"getblockhash","params":[800000]}
+ * @endcode
+ */
+class JsonWriter {
+public:
+    /**
+     * @brief Creates a writer that appends to `out`.
+     */
+    explicit JsonWriter(std::string& out) : out(out) {}
+
+    void write(std::nullptr_t) { out += "null"; }
+    void write(bool value) { out += value ? "true" : "false"; }
+    void write(double value);
+    void write(std::string_view value);
+    void write(const char* value) { write(std::string_view(value)); }
+    void write(const std::string& value) { write(std::string_view(value)); }
+
+    /**
+     * @brief Writes any Json::Value, recursively.
+     */
+    void write(const Json::Value& value);
+
+    /**
+     * @brief Writes an integer.
+     */
+    template<std::integral T>
+        requires (!std::same_as<T, bool> && !std::same_as<T, char>)
+    void write(T value) {
+        std::array<char, 24> digits;
+        const auto end = std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr;
+        out.append(digits.data(), end);
+    }
+
+    /**
+     * @brief Writes a pre-escaped literal.
+     */
+    template<std::size_t N>
+    void write(const JsonLiteral<N>& literal) { out += literal.json(); }
+
+    /**
+     * @brief Writes a vector as an array.
+     */
+    template<typename T>
+    void write(const std::vector<T>& values) {
+        out += '[';
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            if (i) out += ',';
+            write(values[i]);
+        }
+        out += ']';
+    }
+
+    /**
+     * @brief Writes an optional value, or null when it is empty.
+     *
+     * Bitcoin Core treats a null positional parameter as omitted, so this skips an optional
+     * parameter that later parameters follow.
+     */
+    template<typename T>
+    void write(const std::optional<T>& value) {
+        if (value) write(*value);
+        else write(nullptr);
+    }
+
+    /**
+     * @brief Writes a string-keyed map as an object.
+     */
+    template<typename T>
+    void write(const std::map<std::string, T>& members) {
+        out += '{';
+        bool first = true;
+        for (const auto& [key, value] : members) {
+            if (!first) out += ',';
+            first = false;
+            write(std::string_view(key));
+            out += ':';
+            write(value);
+        }
+        out += '}';
+    }
+
+    /**
+     * @brief Writes the arguments as a JSON array.
+     */
+    template<typename... Args>
+    void array(const Args&... args) {
+        out += '[';
+        bool first = true;
+        ((first ? void(first = false) : void(out += ','), write(args)), ...);
+        out += ']';
+    }
+
+    /**
+     * @brief Writes a JSON-RPC request object with the arguments as positional parameters.
+     * @param method The method name: a string or a JsonLiteral.
+     * @param id The request id echoed back by the server.
+     * @param args Parameters of the call, in positional order.
+     */
+    template<typename Method, typename... Args>
+    void rpcRequest(const Method& method, std::uint64_t id, const Args&... args) {
+        beginRpcRequest(id);
+        write(method);
+        out += ",\"params\":";
+        array(args...);
+        out += '}';
+    }
+
+    /**
+     * @brief Writes a JSON-RPC request object whose parameters are already a Json::Value.
+     * @param method The method name.
+     * @param id The request id echoed back by the server.
+     * @param params A parameter array, or null for none.
+     */
+    void rpcRequestWithParams(std::string_view method, std::uint64_t id, const Json::Value& params);
+
+private:
+    /**
+     * @brief Writes the members of a request object that precede the method name.
+     */
+    void beginRpcRequest(std::uint64_t id);
+
+    std::string& out;   ///< The string appended to.
+};
+
+#endif // JSONWRITER_HPP
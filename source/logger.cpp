@@ -2,17 +2,70 @@
 
 std::mutex Logger::logMutex;
 
-void Logger::error(const std::string& message) {
+#if defined(DEBUG_LOGGING)
+std::atomic<LogLevel> Logger::currentLevel {LogLevel::Debug};
+#else
+std::atomic<LogLevel> Logger::currentLevel {LogLevel::Info};
+#endif
+
+std::atomic<Logger::Sink> Logger::currentSink {&Logger::consoleSink};
+
+void Logger::setLevel(LogLevel level) {
+    currentLevel.store(level, std::memory_order_relaxed);
+}
+
+LogLevel Logger::level() {
+    return currentLevel.load(std::memory_order_relaxed);
+}
+
+void Logger::setSink(Sink sink) {
+    currentSink.store(sink ? sink : &Logger::consoleSink, std::memory_order_release);
+}
+
+void Logger::write(LogLevel level, std::string_view message) {
+    currentSink.load(std::memory_order_acquire)(level, message);
+}
+
+void Logger::consoleSink(LogLevel level, std::string_view message) {
     std::lock_guard<std::mutex> lock(logMutex);
-    std::cerr << "\033[1;31m[ERROR]\033[0m " << message << std::endl;
+    switch (level) {
+    case LogLevel::Error:
+        std::cerr << "\033[1;31m[ERROR]\033[0m " << message << std::endl;
+        break;
+    case LogLevel::Warning:
+        std::cerr << "\033[1;33m[WARNING]\033[0m " << message << '\n';
+        break;
+    case LogLevel::Info:
+        std::cout << "\033[1;32m[INFO]\033[0m " << message << '\n';
+        break;
+    default:
+        std::cout << "\033[1;34m[DEBUG]\033[0m " << message << '\n';
+        break;
+    }
+}
+
+void Logger::error(const std::string& message) {
+    if (enabled(LogLevel::Error)) write(LogLevel::Error, message);
+}
+
+void Logger::warning(const std::string& message) {
+    if (enabled(LogLevel::Warning)) write(LogLevel::Warning, message);
 }
 
 void Logger::info(const std::string& message) {
-    std::lock_guard<std::mutex> lock(logMutex);
-    std::cout << "\033[1;32m[INFO]\033[0m " << message << std::endl;
+    if (enabled(LogLevel::Info)) write(LogLevel::Info, message);
+}
+
+void Logger::debug(const std::string& message) {
+    if (enabled(LogLevel::Debug)) write(LogLevel::Debug, message);
 }
 
 void Logger::json(const std::string& message) {
+    if (!enabled(LogLevel::Debug)) return;
+    if (currentSink.load(std::memory_order_acquire) != &Logger::consoleSink) {
+        write(LogLevel::Debug, message);
+        return;
+    }
     std::lock_guard<std::mutex> lock(logMutex);
-    std::cout << "\033[1;36m[JSON]\033[0m " << message << std::endl;
+    std::cout << "\033[1;36m[JSON]\033[0m " << message << '\n';
 }
@@ -2,10 +2,35 @@
 #define LOGGER_HPP
 
 #include <string>
+#include <string_view>
 #include <mutex>
+#include <atomic>
 #include <format>
 #include <iostream>
 
+/**
+ * @brief Lowest level that is compiled in; calls below it are removed at compile time.
+ *
+ * Defaults to 0 (`LogLevel::Trace`), so every level can still be enabled at runtime.
+ * Define it to e.g. 2 (`LogLevel::Info`) to strip debug and trace logging from a build.
+ */
+#ifndef LOGGER_MIN_LEVEL
+#   define LOGGER_MIN_LEVEL 0
+#endif
+
+/**
+ * @enum LogLevel
+ * @brief Severity of a log message, from the most verbose to the most severe.
+ */
+enum class LogLevel : int {
+    Trace = 0,   ///< Very detailed diagnostics.
+    Debug,       ///< Request/response dumps and other developer diagnostics.
+    Info,        ///< Normal operational messages.
+    Warning,     ///< Recoverable problems.
+    Error,       ///< Failures.
+    Off          ///< Disables all logging.
+};
+
 /**
  * @class Logger
  * @brief A thread-safe logging utility for formatted and colored console output.
@@ -13,21 +38,85 @@
  * Provides static methods to log error, informational, and JSON-formatted messages
  * with appropriate formatting and color coding. Supports variadic templates for
  * formatted messages using `std::format`.
+ *
+ * Messages below the runtime level (see `setLevel`) cost one relaxed atomic load:
+ * they are neither formatted nor do they take the log mutex. Messages below
+ * `LOGGER_MIN_LEVEL` are removed at compile time. Output goes to a sink, which is
+ * the colored console by default and can be replaced with `setSink`.
  */
 class Logger {
+public:
+    /**
+     * @brief Receives every enabled message. Must be thread-safe.
+     */
+    using Sink = void (*)(LogLevel level, std::string_view message);
+
 private:
     /**
      * @brief A mutex to ensure thread-safe logging.
      */
     static std::mutex logMutex;
 
+    /**
+     * @brief The runtime threshold; messages below it are dropped.
+     */
+    static std::atomic<LogLevel> currentLevel;
+
+    /**
+     * @brief The sink that receives enabled messages.
+     */
+    static std::atomic<Sink> currentSink;
+
+    /**
+     * @brief Hands an enabled message to the current sink.
+     */
+    static void write(LogLevel level, std::string_view message);
+
 public:
+    /**
+     * @brief Checks whether messages of the given level are emitted.
+     * @param level The level to check.
+     * @return `true` if the level is compiled in and at or above the runtime threshold.
+     */
+    static bool enabled(LogLevel level) {
+        return static_cast<int>(level) >= LOGGER_MIN_LEVEL
+               && level >= currentLevel.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Sets the runtime threshold (default: `Info`, or `Debug` with `DEBUG_LOGGING`).
+     * @param level The lowest level to emit; `LogLevel::Off` silences the logger.
+     */
+    static void setLevel(LogLevel level);
+
+    /**
+     * @brief Returns the runtime threshold.
+     */
+    static LogLevel level();
+
+    /**
+     * @brief Replaces the output sink.
+     * @param sink The new sink, or nullptr to restore the colored console sink.
+     */
+    static void setSink(Sink sink);
+
+    /**
+     * @brief The default sink: colored console output, serialized by the log mutex.
+     */
+    static void consoleSink(LogLevel level, std::string_view message);
+
     /**
      * @brief Logs an error message in red to the console.
      * @param message The error message to log.
      */
     static void error(const std::string& message);
 
+    /**
+     * @brief Logs a warning message in yellow to the console.
+     * @param message The warning message to log.
+     */
+    static void warning(const std::string& message);
+
     /**
      * @brief Logs an informational message in green to the console.
      * @param message The informational message to log.
@@ -35,11 +124,31 @@ public:
     static void info(const std::string& message);
 
     /**
-     * @brief Logs a JSON-formatted message in cyan to the console.
+     * @brief Logs a debug message in blue to the console.
+     * @param message The debug message to log.
+     */
+    static void debug(const std::string& message);
+
+    /**
+     * @brief Logs a JSON-formatted message in cyan to the console (debug level).
      * @param message The JSON message to log.
      */
     static void json(const std::string& message);
 
+    /**
+     * @brief Logs a formatted message at the given level, formatting only if the level is enabled.
+     * @tparam Level The level of the message.
+     * @tparam Args Variadic template for formatting arguments.
+     * @param fmt The format string (follows `std::format` syntax).
+     * @param args The arguments for the format string.
+     */
+    template<LogLevel Level, typename... Args>
+    static void formatted(const std::format_string<Args...>& fmt, Args&&... args) {
+        if constexpr (static_cast<int>(Level) >= LOGGER_MIN_LEVEL) {
+            if (enabled(Level)) write(Level, std::format(fmt, std::forward<Args>(args)...));
+        }
+    }
+
     /**
      * @brief Logs a formatted error message in red to the console.
      * @tparam Args Variadic template for formatting arguments.
@@ -48,7 +157,18 @@ public:
      */
     template<typename... Args>
     static void formattedError(const std::format_string<Args...>& fmt, Args&&... args) {
-        error(std::format(fmt, std::forward<Args>(args)...));
+        formatted<LogLevel::Error>(fmt, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Logs a formatted warning message in yellow to the console.
+     * @tparam Args Variadic template for formatting arguments.
+     * @param fmt The format string (follows `std::format` syntax).
+     * @param args The arguments for the format string.
+     */
+    template<typename... Args>
+    static void formattedWarning(const std::format_string<Args...>& fmt, Args&&... args) {
+        formatted<LogLevel::Warning>(fmt, std::forward<Args>(args)...);
     }
 
     /**
@@ -59,7 +179,18 @@ public:
      */
     template<typename... Args>
     static void formattedInfo(const std::format_string<Args...>& fmt, Args&&... args) {
-        info(std::format(fmt, std::forward<Args>(args)...));
+        formatted<LogLevel::Info>(fmt, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Logs a formatted debug message in blue to the console.
+     * @tparam Args Variadic template for formatting arguments.
+     * @param fmt The format string (follows `std::format` syntax).
+     * @param args The arguments for the format string.
+     */
+    template<typename... Args>
+    static void formattedDebug(const std::format_string<Args...>& fmt, Args&&... args) {
+        formatted<LogLevel::Debug>(fmt, std::forward<Args>(args)...);
     }
 };
 
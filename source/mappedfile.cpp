@@ -0,0 +1,183 @@
+#include "mappedfile.hpp"
+#include "logger.hpp"
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <cerrno>
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+    handle = std::exchange(other.handle, INVALID);
+    mapping = std::exchange(other.mapping, nullptr);
+    fileSize = std::exchange(other.fileSize, 0);
+    fileMode = other.fileMode;
+    filePath = std::move(other.filePath);
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path, Mode mode, std::size_t minimumSize) {
+    close();
+    const bool writable = mode == Mode::ReadWrite;
+    handle = CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                         FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, writable ? OPEN_ALWAYS : OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID) {
+        Logger::formattedError("Failed to open {} (error {})", path, GetLastError());
+        return false;
+    }
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(handle, &length)) {
+        close();
+        return false;
+    }
+    fileMode = mode;
+    filePath = path;
+    fileSize = static_cast<std::size_t>(length.QuadPart);
+    if (writable && fileSize < minimumSize) return resize(minimumSize);
+    if (!map()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::map() {
+    if (fileSize == 0) return true;
+    const bool writable = fileMode == Mode::ReadWrite;
+    HANDLE section = CreateFileMappingA(handle, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+    if (section == nullptr) {
+        Logger::formattedError("Failed to map {} (error {})", filePath, GetLastError());
+        return false;
+    }
+    mapping = MapViewOfFile(section, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, fileSize);
+    CloseHandle(section);   // The view keeps the section alive.
+    if (mapping == nullptr) {
+        Logger::formattedError("Failed to map {} (error {})", filePath, GetLastError());
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::unmap() {
+    if (mapping != nullptr) UnmapViewOfFile(mapping);
+    mapping = nullptr;
+}
+
+bool MappedFile::resize(std::size_t newSize) {
+    if (handle == INVALID || fileMode != Mode::ReadWrite) return false;
+    unmap();
+    LARGE_INTEGER length;
+    length.QuadPart = static_cast<LONGLONG>(newSize);
+    if (!SetFilePointerEx(handle, length, nullptr, FILE_BEGIN) || !SetEndOfFile(handle)) {
+        Logger::formattedError("Failed to resize {} to {} bytes (error {})", filePath, newSize, GetLastError());
+        map();
+        return false;
+    }
+    fileSize = newSize;
+    return map();
+}
+
+bool MappedFile::sync() {
+    if (mapping == nullptr) return true;
+    return FlushViewOfFile(mapping, fileSize) && FlushFileBuffers(handle);
+}
+
+void MappedFile::close() {
+    unmap();
+    if (handle != INVALID) CloseHandle(handle);
+    handle = INVALID;
+    fileSize = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path, Mode mode, std::size_t minimumSize) {
+    close();
+    const bool writable = mode == Mode::ReadWrite;
+    handle = ::open(path.c_str(), writable ? O_RDWR | O_CREAT | O_CLOEXEC : O_RDONLY | O_CLOEXEC, 0644);
+    if (handle == INVALID) {
+        Logger::formattedError("Failed to open {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    struct stat status {};
+    if (fstat(handle, &status) != 0) {
+        Logger::formattedError("Failed to stat {}: {}", path, std::strerror(errno));
+        close();
+        return false;
+    }
+    fileMode = mode;
+    filePath = path;
+    fileSize = static_cast<std::size_t>(status.st_size);
+    if (writable && fileSize < minimumSize) return resize(minimumSize);
+    if (!map()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::map() {
+    if (fileSize == 0) return true;
+    const int protection = fileMode == Mode::ReadWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* address = mmap(nullptr, fileSize, protection, MAP_SHARED, handle, 0);
+    if (address == MAP_FAILED) {
+        Logger::formattedError("Failed to map {}: {}", filePath, std::strerror(errno));
+        return false;
+    }
+    mapping = address;
+    return true;
+}
+
+void MappedFile::unmap() {
+    if (mapping != nullptr) munmap(mapping, fileSize);
+    mapping = nullptr;
+}
+
+bool MappedFile::resize(std::size_t newSize) {
+    if (handle == INVALID || fileMode != Mode::ReadWrite) return false;
+    unmap();
+    if (ftruncate(handle, static_cast<off_t>(newSize)) != 0) {
+        Logger::formattedError("Failed to resize {} to {} bytes: {}", filePath, newSize, std::strerror(errno));
+        map();
+        return false;
+    }
+    fileSize = newSize;
+    return map();
+}
+
+bool MappedFile::sync() {
+    if (mapping == nullptr) return true;
+    if (msync(mapping, fileSize, MS_SYNC) != 0) {
+        Logger::formattedError("Failed to write {} back: {}", filePath, std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    unmap();
+    if (handle != INVALID) ::close(handle);
+    handle = INVALID;
+    fileSize = 0;
+}
+
+#endif
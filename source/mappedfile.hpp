@@ -0,0 +1,99 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/**
+ * @class MappedFile
+ * @brief A file mapped into memory, readable and optionally writable in place.
+ *
+ * The mapping is shared: writes go to the page cache and reach the file when the kernel
+ * flushes them or when `sync()` is called. Growing the file with `resize()` maps it again,
+ * so pointers obtained from `data()` before the call are invalid afterwards.
+ *
+ * @code
+ * MappedFile file;
+ * if (file.open("blocks.dat", MappedFile::Mode::ReadWrite, 1 << 20)) std::memcpy(file.data(), header, sizeof(header));
+ * @endcode
+ */
+class MappedFile {
+public:
+    /**
+     * @enum Mode
+     * @brief Access to the mapped file.
+     */
+    enum class Mode : std::uint8_t {
+        ReadOnly,       ///< The file must exist; the mapping is read-only.
+        ReadWrite       ///< The file is created if missing.
+    };
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Unmaps and closes the file.
+     */
+    ~MappedFile();
+
+    /**
+     * @brief Opens and maps a file.
+     * @param path The file to map.
+     * @param mode Access to the file.
+     * @param minimumSize In read-write mode, a shorter file is extended with zeros to this size.
+     * @return `false` if the file could not be opened or mapped.
+     */
+    bool open(const std::string& path, Mode mode, std::size_t minimumSize = 0);
+
+    /**
+     * @brief Unmaps and closes the file; a no-op if nothing is open.
+     */
+    void close();
+
+    /**
+     * @brief Changes the size of a read-write file and maps it again; new bytes read as zero.
+     */
+    bool resize(std::size_t newSize);
+
+    /**
+     * @brief Writes the dirty pages back to the file and waits for the write to finish.
+     */
+    bool sync();
+
+    bool isOpen() const { return handle != INVALID; }                                          ///< A file is open.
+    std::size_t size() const { return fileSize; }                                             ///< Size of the file in bytes.
+    std::uint8_t* data() { return static_cast<std::uint8_t*>(mapping); }                      ///< The first byte; null for an empty file.
+    const std::uint8_t* data() const { return static_cast<const std::uint8_t*>(mapping); }    ///< The first byte; null for an empty file.
+    const std::string& path() const { return filePath; }                                      ///< The path given to `open()`.
+
+private:
+#ifdef _WIN32
+    using Handle = void*;
+    static inline Handle const INVALID = reinterpret_cast<Handle>(-1);
+#else
+    using Handle = int;
+    static constexpr Handle INVALID = -1;
+#endif
+
+    /**
+     * @brief Maps `fileSize` bytes of the open file.
+     */
+    bool map();
+
+    /**
+     * @brief Removes the current mapping.
+     */
+    void unmap();
+
+    Handle handle = INVALID;                ///< The open file.
+    void* mapping = nullptr;                ///< Start of the mapping; null when unmapped or empty.
+    std::size_t fileSize = 0;               ///< Bytes mapped.
+    Mode fileMode = Mode::ReadOnly;         ///< Access given to `open()`.
+    std::string filePath;                   ///< Path given to `open()`.
+};
+
+#endif // MAPPEDFILE_HPP
@@ -0,0 +1,660 @@
+#include "mempoolmirror.hpp"
+#include "jsonwriter.hpp"
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+namespace {
+constexpr std::size_t MIN_INDEX_SIZE = 1024;    ///< Initial number of txid table slots.
+
+/**
+ * @brief Returns the txid table slot a txid starts probing at; txids are uniformly distributed already.
+ */
+std::size_t homeSlot(const Hash256& txid, std::size_t mask) {
+    std::uint64_t bits;
+    std::memcpy(&bits, txid.data(), sizeof(bits));
+    return static_cast<std::size_t>(bits) & mask;
+}
+
+/**
+ * @brief Routes every scalar of a parsed `getmempoolentry` result to `decodeField`.
+ */
+bool decodeEntry(const Json::Value& value, std::string& path, MempoolEntryResult& out) {
+    if (value.isObject()) {
+        const std::size_t prefix = path.size();
+        for (auto member = value.begin(); member != value.end(); ++member) {
+            path.resize(prefix);
+            if (prefix != 0) path += '.';
+            path += member.name();
+            if (!decodeEntry(*member, path, out)) return false;
+        }
+        path.resize(prefix);
+        return true;
+    }
+    if (value.isArray()) {
+        for (const Json::Value& element : value) {
+            if (!decodeEntry(element, path, out)) return false;
+        }
+        return true;
+    }
+
+    JsonScalar scalar;
+    std::string text;
+    if (value.isBool()) {
+        scalar.kind = JsonScalar::Kind::Bool;
+        scalar.boolean = value.asBool();
+    } else if (value.isString()) {
+        scalar.kind = JsonScalar::Kind::String;
+        text = value.asString();
+    } else if (value.isNumeric()) {
+        // Back to text, as decodeField parses amounts from their decimal representation.
+        scalar.kind = JsonScalar::Kind::Number;
+        JsonWriter(text).write(value);
+    }
+    scalar.text = text;
+    return decodeField(out, path, scalar);
+}
+
+/**
+ * @class SequenceReader
+ * @brief Picks `mempool_sequence` out of a streamed `getrawmempool false true` response, skipping the txids.
+ */
+class SequenceReader : public JsonHandler {
+public:
+    std::optional<std::uint64_t> sequence;  ///< The value found, if any.
+
+    bool onNull() override { return true; }
+    bool onBool(bool) override { return true; }
+    bool onNumber(std::string_view raw) override {
+        if (depth == 2 && inResult && key == "mempool_sequence") {
+            std::uint64_t value = 0;
+            const auto [ptr, ec] = std::from_chars(raw.data(), raw.data() + raw.size(), value);
+            if (ec == std::errc() && ptr == raw.data() + raw.size()) sequence = value;
+        }
+        return true;
+    }
+    bool onString(std::string_view) override { return true; }
+    bool onKey(std::string_view name) override {
+        if (depth == 1) inResult = name == "result";
+        if (depth == 2) key.assign(name);
+        return true;
+    }
+    bool onStartObject() override { ++depth; return true; }
+    bool onEndObject() override { --depth; return true; }
+    bool onStartArray() override { ++depth; return true; }
+    bool onEndArray() override { --depth; return true; }
+
+private:
+    int depth = 0;
+    bool inResult = false;
+    std::string key;
+};
+
+/**
+ * @class VerboseMempoolReader
+ * @brief Decodes a streamed `getrawmempool true` response entry by entry, without building a DOM.
+ *
+ * Depth 1 is the envelope, depth 2 the result keyed by txid, depth 3 one entry and
+ * depth 4 its `fees` object or its `depends` and `spentby` arrays.
+ */
+class VerboseMempoolReader : public JsonHandler {
+public:
+    using EntryCallback = std::function<void(const Hash256&, const MempoolEntryResult&)>;
+
+    explicit VerboseMempoolReader(EntryCallback onEntry) : onEntry(std::move(onEntry)) {}
+
+    bool succeeded() const { return hasResult && !hasError && valid; }     ///< A well-formed result and no error.
+
+    bool onNull() override { return scalar({JsonScalar::Kind::Null, {}, false}); }
+    bool onBool(bool b) override { return scalar({JsonScalar::Kind::Bool, {}, b}); }
+    bool onNumber(std::string_view raw) override { return scalar({JsonScalar::Kind::Number, raw, false}); }
+    bool onString(std::string_view text) override { return scalar({JsonScalar::Kind::String, text, false}); }
+
+    bool onKey(std::string_view key) override {
+        if (depth == 1) {
+            section = key == "result" ? Section::Result : key == "error" ? Section::Error : Section::Other;
+        } else if (section != Section::Result) {
+            return true;
+        } else if (depth == 2) {
+            if (!parseHash(key, txid)) valid = false;
+        } else if (depth == 3) {
+            member.assign(key);
+            path.assign(key);
+        } else if (depth == 4) {
+            path.assign(member).append(".").append(key);
+        }
+        return true;
+    }
+
+    bool onStartObject() override { return open(); }
+    bool onStartArray() override { return open(); }
+    bool onEndObject() override { return close(); }
+    bool onEndArray() override { return close(); }
+
+private:
+    enum class Section : std::uint8_t { Other, Result, Error };
+
+    bool open() {
+        ++depth;
+        if (depth == 2 && section == Section::Result) hasResult = true;
+        if (depth == 2 && section == Section::Error) hasError = true;
+        if (depth == 3 && section == Section::Result) entry = {};
+        if (depth == 4) path.assign(member);
+        return true;
+    }
+
+    bool close() {
+        if (depth == 3 && section == Section::Result) onEntry(txid, entry);
+        --depth;
+        return true;
+    }
+
+    bool scalar(const JsonScalar& value) {
+        if (section != Section::Result || depth < 3 || depth > 4) return true;
+        if (!decodeField(entry, path, value)) valid = false;
+        return true;
+    }
+
+    EntryCallback onEntry;
+    int depth = 0;
+    Section section = Section::Other;
+    Hash256 txid {};
+    MempoolEntryResult entry;
+    std::string member;     ///< Member of the entry being decoded.
+    std::string path;       ///< Path of the current scalar, relative to the entry.
+    bool hasResult = false;
+    bool hasError = false;
+    bool valid = true;
+};
+}
+
+std::uint32_t MempoolMirror::Table::find(const Hash256& txid) const {
+    if (index.empty()) return NONE;
+    const std::size_t mask = index.size() - 1;
+    for (std::size_t i = homeSlot(txid, mask);; i = (i + 1) & mask) {
+        const std::uint32_t slot = index[i];
+        if (slot == NONE) return NONE;
+        if (entries[slot].tx.txid == txid) return slot;
+    }
+}
+
+std::uint32_t MempoolMirror::Table::insert(const Hash256& txid) {
+    if ((count + 1) * 2 > index.size()) grow();
+
+    std::uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<std::uint32_t>(entries.size());
+        entries.emplace_back();
+    }
+    Entry& entry = entries[slot];
+    entry.tx = {};
+    entry.tx.txid = txid;
+    entry.live = true;
+    ++count;
+
+    const std::size_t mask = index.size() - 1;
+    std::size_t i = homeSlot(txid, mask);
+    while (index[i] != NONE) i = (i + 1) & mask;
+    index[i] = slot;
+    return slot;
+}
+
+void MempoolMirror::Table::erase(std::uint32_t slot) {
+    Entry& entry = entries[slot];
+    for (std::uint32_t parent : entry.parents) std::erase(entries[parent].children, slot);
+    for (std::uint32_t child : entry.children) std::erase(entries[child].parents, slot);
+    byFeeRate.erase({entry.tx.feeRate(), slot});
+    vsize -= entry.tx.vsize;
+
+    // Backward-shift deletion: pull later members of the probe run into the hole,
+    // so lookups never need tombstones.
+    const std::size_t mask = index.size() - 1;
+    std::size_t hole = homeSlot(entry.tx.txid, mask);
+    while (index[hole] != slot) hole = (hole + 1) & mask;
+    for (std::size_t i = (hole + 1) & mask; index[i] != NONE; i = (i + 1) & mask) {
+        const std::size_t home = homeSlot(entries[index[i]].tx.txid, mask);
+        // Move the member unless its home lies cyclically in (hole, i].
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            index[hole] = index[i];
+            hole = i;
+        }
+    }
+    index[hole] = NONE;
+
+    entry.parents.clear();
+    entry.children.clear();
+    entry.live = false;
+    freeSlots.push_back(slot);
+    --count;
+}
+
+void MempoolMirror::Table::link(std::uint32_t parent, std::uint32_t child) {
+    if (parent == child) return;
+    std::vector<std::uint32_t>& children = entries[parent].children;
+    if (std::find(children.begin(), children.end(), child) != children.end()) return;
+    children.push_back(child);
+    entries[child].parents.push_back(parent);
+}
+
+void MempoolMirror::Table::grow() {
+    index.assign(std::max(index.size() * 2, MIN_INDEX_SIZE), NONE);
+    const std::size_t mask = index.size() - 1;
+    for (std::uint32_t slot = 0; slot < entries.size(); ++slot) {
+        if (!entries[slot].live) continue;
+        std::size_t i = homeSlot(entries[slot].tx.txid, mask);
+        while (index[i] != NONE) i = (i + 1) & mask;
+        index[i] = slot;
+    }
+}
+
+MempoolMirror::MempoolMirror(BitcoinClient& client, const MempoolMirrorSettings& settings)
+    : client(client), mirrorSettings(settings) {
+    mirrorSettings.entryBatchSize = std::max<std::size_t>(mirrorSettings.entryBatchSize, 1);
+}
+
+MempoolMirror::~MempoolMirror() {
+    stop();
+}
+
+std::uint32_t MempoolMirror::addEntry(Table& table, const Hash256& txid, const MempoolEntryResult& entry, bool linkRelatives) {
+    std::uint32_t slot = table.find(txid);
+    if (slot == NONE) {
+        slot = table.insert(txid);
+    } else {
+        // Known already: refresh the figures, which `prioritisetransaction` may have changed.
+        table.byFeeRate.erase({table.entries[slot].tx.feeRate(), slot});
+        table.vsize -= table.entries[slot].tx.vsize;
+    }
+
+    MempoolTx& tx = table.entries[slot].tx;
+    tx.baseFee = entry.baseFee;
+    tx.modifiedFee = entry.modifiedFee;
+    tx.vsize = entry.vsize;
+    tx.time = entry.time;
+    tx.height = entry.height;
+    tx.replaceable = entry.bip125Replaceable;
+    table.byFeeRate.insert({tx.feeRate(), slot});
+    table.vsize += tx.vsize;
+
+    if (linkRelatives) {
+        for (const Hash256& parent : entry.depends) {
+            const std::uint32_t relative = table.find(parent);
+            if (relative != NONE) table.link(relative, slot);
+        }
+        for (const Hash256& child : entry.spentBy) {
+            const std::uint32_t relative = table.find(child);
+            if (relative != NONE) table.link(slot, relative);
+        }
+    }
+    return slot;
+}
+
+bool MempoolMirror::bootstrap() {
+    std::lock_guard<std::mutex> lock(syncMutex);
+    return load();
+}
+
+bool MempoolMirror::load() {
+    {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        resyncRequested = false;
+    }
+
+    // Read the sequence first: whatever changes while the mempool streams in is replayed
+    // afterwards, and replaying an addition or removal that the snapshot already shows is harmless.
+    SequenceReader sequenceReader;
+    Json::Value params(Json::arrayValue);
+    params.append(false);
+    params.append(true);
+    if (!client.streamRequest("getrawmempool", params, sequenceReader) || !sequenceReader.sequence) {
+        Logger::error("Mempool mirror: failed to read the mempool sequence");
+        return false;
+    }
+
+    Table loaded;
+    std::vector<std::pair<std::uint32_t, Hash256>> parents;
+    VerboseMempoolReader reader([&](const Hash256& txid, const MempoolEntryResult& entry) {
+        const std::uint32_t slot = addEntry(loaded, txid, entry, false);
+        for (const Hash256& parent : entry.depends) parents.emplace_back(slot, parent);
+    });
+    Json::Value verbose(Json::arrayValue);
+    verbose.append(true);
+    if (!client.streamRequest("getrawmempool", verbose, reader) || !reader.succeeded()) {
+        Logger::error("Mempool mirror: failed to load the mempool");
+        return false;
+    }
+    // Every entry is known by now, so each dependency inside the mempool resolves.
+    for (const auto& [child, parent] : parents) {
+        const std::uint32_t slot = loaded.find(parent);
+        if (slot != NONE) loaded.link(slot, child);
+    }
+
+    const std::size_t count = loaded.count;
+    {
+        std::unique_lock<std::shared_mutex> lock(tableMutex);
+        table = std::move(loaded);
+        mempoolSequence = *sequenceReader.sequence;
+    }
+    bootstrapped = true;
+    Logger::formattedInfo("Mempool mirror loaded {} transactions at mempool sequence {}", count, *sequenceReader.sequence);
+    return true;
+}
+
+bool MempoolMirror::sync() {
+    std::lock_guard<std::mutex> lock(syncMutex);
+    bool resync;
+    {
+        std::lock_guard<std::mutex> eventLock(eventMutex);
+        resync = resyncRequested;
+    }
+    if ((!bootstrapped || resync) && !load()) return false;
+    return mirrorSettings.source == DeltaSource::Poll ? poll() : applyEvents();
+}
+
+bool MempoolMirror::applyEvents() {
+    std::deque<Event> pending;
+    {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        pending.swap(events);
+    }
+    if (pending.empty()) return true;
+
+    std::uint64_t sequence;
+    {
+        std::shared_lock<std::shared_mutex> lock(tableMutex);
+        sequence = mempoolSequence;
+    }
+
+    // Reduce the events to their net effect: removals first, then the additions still standing.
+    std::vector<Hash256> removed;
+    std::vector<Hash256> added;
+    std::set<Hash256> evicted;      // Removed by an `R` event of this batch, so no longer in the node's mempool.
+    bool reloaded = false;
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+        const Event& event = pending[i];
+        if (event.kind == Event::Kind::BlockConnected) {
+            std::vector<Hash256> confirmed;
+            if (!fetchBlockTransactions(event.hash, confirmed)) {
+                // Keep the rest for the next sync, starting from this block.
+                std::lock_guard<std::mutex> lock(eventMutex);
+                events.insert(events.begin(), pending.begin() + static_cast<std::ptrdiff_t>(i), pending.end());
+                break;
+            }
+            // The node advances the mempool sequence once for every mempool transaction the block
+            // removes, but sends no `R` event for them; count those the mirror has.
+            std::uint64_t left = 0;
+            {
+                std::shared_lock<std::shared_mutex> lock(tableMutex);
+                for (const Hash256& txid : confirmed) {
+                    const bool pendingAddition = std::erase(added, txid) != 0;
+                    if (pendingAddition || (table.find(txid) != NONE && !evicted.contains(txid))) ++left;
+                    removed.push_back(txid);
+                }
+            }
+            sequence += left;
+            continue;
+        }
+
+        if (event.sequence < sequence) continue;    // Covered by the bootstrap or an earlier event.
+        if (event.sequence > sequence) {
+            if (reloaded) {
+                Logger::formattedWarning("Mempool mirror: mempool sequence jumped from {} to {} again; resyncing on the next sync",
+                                         sequence, event.sequence);
+                requestResync();
+                return false;
+            }
+            Logger::formattedWarning("Mempool mirror: mempool sequence jumped from {} to {}; events were lost, reloading",
+                                     sequence, event.sequence);
+            if (!load()) return false;
+            reloaded = true;
+            removed.clear();
+            added.clear();
+            evicted.clear();
+            {
+                std::shared_lock<std::shared_mutex> lock(tableMutex);
+                sequence = mempoolSequence;
+            }
+            i = static_cast<std::size_t>(-1);       // Replay the batch against the new snapshot.
+            continue;
+        }
+
+        sequence = event.sequence + 1;
+        if (event.kind == Event::Kind::Added) {
+            added.push_back(event.hash);
+        } else {
+            std::erase(added, event.hash);
+            removed.push_back(event.hash);
+            evicted.insert(event.hash);
+        }
+    }
+
+    std::vector<std::pair<Hash256, MempoolEntryResult>> entries;
+    if (!fetchEntries(added, entries)) return false;
+    apply(removed, entries, sequence);
+    return true;
+}
+
+bool MempoolMirror::poll() {
+    Json::Value params(Json::arrayValue);
+    params.append(false);
+    params.append(true);
+    RpcResult outcome = client.sendCall("getrawmempool", params);
+    if (!outcome.ok() || !outcome.result["txids"].isArray() || !outcome.result["mempool_sequence"].isUInt64()) {
+        Logger::error("Mempool mirror: failed to poll the mempool");
+        return false;
+    }
+    const std::uint64_t sequence = outcome.result["mempool_sequence"].asUInt64();
+
+    std::vector<Hash256> missing;
+    std::vector<Hash256> removed;
+    {
+        std::shared_lock<std::shared_mutex> lock(tableMutex);
+        if (sequence == mempoolSequence) return true;
+
+        std::vector<bool> present(table.entries.size(), false);
+        for (const Json::Value& value : outcome.result["txids"]) {
+            Hash256 txid;
+            if (!value.isString() || !parseHash(value.asString(), txid)) continue;
+            const std::uint32_t slot = table.find(txid);
+            if (slot == NONE) {
+                missing.push_back(txid);
+            } else {
+                present[slot] = true;
+            }
+        }
+        for (std::uint32_t slot = 0; slot < table.entries.size(); ++slot) {
+            if (table.entries[slot].live && !present[slot]) removed.push_back(table.entries[slot].tx.txid);
+        }
+    }
+
+    std::vector<std::pair<Hash256, MempoolEntryResult>> entries;
+    if (!fetchEntries(missing, entries)) return false;
+    apply(removed, entries, sequence);
+    return true;
+}
+
+bool MempoolMirror::fetchEntries(const std::vector<Hash256>& txids, std::vector<std::pair<Hash256, MempoolEntryResult>>& out) {
+    std::string path;
+    for (std::size_t first = 0; first < txids.size(); first += mirrorSettings.entryBatchSize) {
+        const std::size_t last = std::min(txids.size(), first + mirrorSettings.entryBatchSize);
+        RpcBatch batch;
+        for (std::size_t i = first; i < last; ++i) batch.call("getmempoolentry", hashToHex(txids[i]));
+
+        const std::vector<RpcResult> results = client.sendBatch(batch);
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            if (results[i].transportFailure) {
+                Logger::error("Mempool mirror: failed to fetch mempool entries");
+                return false;
+            }
+            // An error means the transaction left the mempool again; its removal follows.
+            if (!results[i].ok()) continue;
+            MempoolEntryResult entry;
+            path.clear();
+            if (decodeEntry(results[i].result, path, entry)) out.emplace_back(txids[first + i], std::move(entry));
+        }
+    }
+    return true;
+}
+
+bool MempoolMirror::fetchBlockTransactions(const Hash256& blockHash, std::vector<Hash256>& txids) {
+    Json::Value params(Json::arrayValue);
+    params.append(hashToHex(blockHash));
+    params.append(1);
+    RpcResult outcome = client.sendCall("getblock", params);
+    if (!outcome.ok() || !outcome.result["tx"].isArray()) {
+        Logger::formattedError("Mempool mirror: failed to fetch block {}", hashToHex(blockHash));
+        return false;
+    }
+    for (const Json::Value& value : outcome.result["tx"]) {
+        Hash256 txid;
+        if (value.isString() && parseHash(value.asString(), txid)) txids.push_back(txid);
+    }
+    return true;
+}
+
+void MempoolMirror::apply(const std::vector<Hash256>& removed, const std::vector<std::pair<Hash256, MempoolEntryResult>>& added,
+                          std::uint64_t sequence) {
+    std::unique_lock<std::shared_mutex> lock(tableMutex);
+    for (const Hash256& txid : removed) {
+        const std::uint32_t slot = table.find(txid);
+        if (slot != NONE) table.erase(slot);
+    }
+    for (const auto& [txid, entry] : added) addEntry(table, txid, entry, true);
+    mempoolSequence = sequence;
+}
+
+void MempoolMirror::queue(const Event& event) {
+    {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        events.push_back(event);
+    }
+    eventArrived.notify_one();
+}
+
+void MempoolMirror::onTransactionAdded(const Hash256& txid, std::uint64_t mempoolSequence) {
+    queue({Event::Kind::Added, txid, mempoolSequence});
+}
+
+void MempoolMirror::onTransactionRemoved(const Hash256& txid, std::uint64_t mempoolSequence) {
+    queue({Event::Kind::Removed, txid, mempoolSequence});
+}
+
+void MempoolMirror::onBlockConnected(const Hash256& blockHash) {
+    queue({Event::Kind::BlockConnected, blockHash, 0});
+}
+
+void MempoolMirror::requestResync() {
+    {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        resyncRequested = true;
+    }
+    eventArrived.notify_one();
+}
+
+void MempoolMirror::start() {
+    if (worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        stopping = false;
+    }
+    worker = std::thread(&MempoolMirror::syncLoop, this);
+}
+
+void MempoolMirror::stop() {
+    {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        stopping = true;
+    }
+    eventArrived.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void MempoolMirror::syncLoop() {
+    while (true) {
+        sync();
+
+        std::unique_lock<std::mutex> lock(eventMutex);
+        const bool woken = eventArrived.wait_for(lock, mirrorSettings.syncInterval,
+                                                 [this] { return stopping || resyncRequested || !events.empty(); });
+        if (stopping) return;
+        // Let a burst of events gather, so that its additions are fetched in one batch.
+        if (woken) eventArrived.wait_for(lock, mirrorSettings.eventCoalescing, [this] { return stopping; });
+        if (stopping) return;
+    }
+}
+
+std::size_t MempoolMirror::size() const {
+    std::shared_lock<std::shared_mutex> lock(tableMutex);
+    return table.count;
+}
+
+std::uint64_t MempoolMirror::totalVsize() const {
+    std::shared_lock<std::shared_mutex> lock(tableMutex);
+    return table.vsize;
+}
+
+std::uint64_t MempoolMirror::sequence() const {
+    std::shared_lock<std::shared_mutex> lock(tableMutex);
+    return mempoolSequence;
+}
+
+bool MempoolMirror::contains(const Hash256& txid) const {
+    std::shared_lock<std::shared_mutex> lock(tableMutex);
+    return table.find(txid) != NONE;
+}
+
+std::optional<MempoolTx> MempoolMirror::find(const Hash256& txid) const {
+    std::shared_lock<std::shared_mutex> lock(tableMutex);
+    const std::uint32_t slot = table.find(txid);
+    if (slot == NONE) return std::nullopt;
+    return table.entries[slot].tx;
+}
+
+void MempoolMirror::collectRelatives(const Hash256& txid, bool up, std::vector<MempoolTx>& out) const {
+    std::shared_lock<std::shared_mutex> lock(tableMutex);
+    const std::uint32_t start = table.find(txid);
+    if (start == NONE) return;
+
+    // Breadth-first, so nearer relatives come first.
+    std::vector<std::uint32_t> frontier {start};
+    std::unordered_set<std::uint32_t> seen {start};
+    for (std::size_t next = 0; next < frontier.size(); ++next) {
+        const Entry& entry = table.entries[frontier[next]];
+        for (std::uint32_t relative : up ? entry.parents : entry.children) {
+            if (!seen.insert(relative).second) continue;
+            frontier.push_back(relative);
+            out.push_back(table.entries[relative].tx);
+        }
+    }
+}
+
+std::vector<MempoolTx> MempoolMirror::ancestors(const Hash256& txid) const {
+    std::vector<MempoolTx> out;
+    collectRelatives(txid, true, out);
+    return out;
+}
+
+std::vector<MempoolTx> MempoolMirror::descendants(const Hash256& txid) const {
+    std::vector<MempoolTx> out;
+    collectRelatives(txid, false, out);
+    return out;
+}
+
+std::uint64_t MempoolMirror::vsizeAbove(Amount feeRate) const {
+    std::shared_lock<std::shared_mutex> lock(tableMutex);
+    std::uint64_t total = 0;
+    for (auto it = table.byFeeRate.lower_bound({feeRate, 0}); it != table.byFeeRate.end(); ++it) {
+        total += table.entries[it->second].tx.vsize;
+    }
+    return total;
+}
+
+void MempoolMirror::forEachByFeeRate(const std::function<bool(const MempoolTx&)>& visit) const {
+    std::shared_lock<std::shared_mutex> lock(tableMutex);
+    for (auto it = table.byFeeRate.rbegin(); it != table.byFeeRate.rend(); ++it) {
+        if (!visit(table.entries[it->second].tx)) return;
+    }
+}
@@ -0,0 +1,302 @@
+#ifndef MEMPOOLMIRROR_HPP
+#define MEMPOOLMIRROR_HPP
+
+#if __has_include("bitcoinclient.hpp")
+#   include "bitcoinclient.hpp"
+#else
+#   error "Bitcoin's \"bitcoinclient.hpp\" was not found!"
+#endif
+
+
+#ifdef USE_ZMQ
+#   if __has_include("zmqsubscriber.hpp")
+#       include "zmqsubscriber.hpp"
+#   else
+#       error "Bitcoin's \"zmqsubscriber.hpp\" was not found!"
+#   endif
+#endif
+
+#include <cstdint>
+#include <vector>
+#include <set>
+#include <deque>
+#include <optional>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <functional>
+
+/**
+ * @struct MempoolTx
+ * @brief What the mirror keeps about one mempool transaction.
+ */
+struct MempoolTx {
+    Hash256 txid {};                ///< Internal byte order.
+    Amount baseFee = 0;             ///< Fee paid, in satoshis.
+    Amount modifiedFee = 0;         ///< Fee including `prioritisetransaction` deltas; what miners sort by.
+    std::uint32_t vsize = 0;        ///< Virtual size in vbytes.
+    std::int64_t time = 0;          ///< Unix time the transaction entered the mempool.
+    std::int32_t height = 0;        ///< Block height when it entered the mempool.
+    bool replaceable = false;       ///< Signals BIP 125 replaceability.
+
+    /**
+     * @brief Returns the modified fee rate in satoshis per kvB.
+     */
+    Amount feeRate() const { return vsize ? modifiedFee * 1000 / vsize : 0; }
+};
+
+/**
+ * @enum DeltaSource
+ * @brief Where a MempoolMirror learns about changes after the bootstrap.
+ */
+enum class DeltaSource : std::uint8_t {
+    Events,     ///< ZMQ `sequence` events, fed through the `on...` members or `attach()`.
+    Poll        ///< `getrawmempool false true`, compared against the mirror when the sequence moved.
+};
+
+/**
+ * @struct MempoolMirrorSettings
+ * @brief How a MempoolMirror stays in sync.
+ */
+struct MempoolMirrorSettings {
+    DeltaSource source = DeltaSource::Events;               ///< Change feed.
+    std::chrono::milliseconds syncInterval {1000};          ///< Longest time between two syncs of the background thread.
+    std::chrono::milliseconds eventCoalescing {50};         ///< Delay after an event, so that a burst is fetched as one batch.
+    std::size_t entryBatchSize = 500;                       ///< `getmempoolentry` calls per batch.
+};
+
+/**
+ * @class MempoolMirror
+ * @brief A local copy of the node's mempool that is loaded once and then kept up to date by deltas.
+ *
+ * The bootstrap streams `getrawmempool true` straight into the table, so even a mempool of
+ * hundreds of megabytes of JSON is never held as a document. After that, only changes are
+ * fetched: additions are looked up with batched `getmempoolentry` calls, removals and
+ * confirmed blocks are applied locally. Changes come either from the ZMQ `sequence` feed
+ * or from polling `getrawmempool` with `mempool_sequence`. The mempool sequence number
+ * tells the mirror when it missed something; it then bootstraps again.
+ *
+ * Entries live in one dense array, looked up by binary txid through an open-addressing
+ * table and ordered by modified fee rate in a separate index. Parent and child links
+ * follow `depends` and `spentby`, so ancestor and descendant sets are walked locally.
+ *
+ * Queries take a shared lock and may run on any thread; syncs take the exclusive lock only
+ * to apply an already fetched change, never across an RPC call.
+ *
+ * @code
+ * MempoolMirror mirror(client, {DeltaSource::Poll});
+ * mirror.start();
+ * // ... on any thread:
+ * std::uint64_t vbytesAhead = mirror.vsizeAbove(20000);   // Competing vbytes at 20 sat/vB and more.
+ * @endcode
+ */
+class MempoolMirror {
+public:
+    /**
+     * @brief Creates an empty mirror; nothing is fetched until `bootstrap()`, `sync()` or `start()`.
+     * @param client The client used for all requests; must outlive the mirror.
+     * @param settings How the mirror stays in sync.
+     */
+    explicit MempoolMirror(BitcoinClient& client, const MempoolMirrorSettings& settings = {});
+    MempoolMirror(const MempoolMirror&) = delete;
+    MempoolMirror& operator=(const MempoolMirror&) = delete;
+
+    /**
+     * @brief Stops the background thread.
+     */
+    ~MempoolMirror();
+
+    /**
+     * @brief Loads the whole mempool, replacing the current contents.
+     * @return `false` if a request failed; the previous contents are kept.
+     */
+    bool bootstrap();
+
+    /**
+     * @brief Applies the pending changes: queued events or one poll. Bootstraps first if needed.
+     * @return `false` if a request failed; the next sync tries again.
+     */
+    bool sync();
+
+    /**
+     * @brief Starts a thread that bootstraps and then syncs every `syncInterval`, or soon after an event.
+     */
+    void start();
+
+    /**
+     * @brief Stops the background thread.
+     */
+    void stop();
+
+    /**
+     * @name Change feed
+     * @brief Queue one `sequence` event; applied by the next `sync()`.
+     *
+     * May be called from any thread, also before the bootstrap: events already covered by
+     * the bootstrap are skipped by their mempool sequence number. Block disconnections need
+     * no call, the node announces the transactions it returns to the mempool as additions.
+     */
+    ///@{
+    void onTransactionAdded(const Hash256& txid, std::uint64_t mempoolSequence);
+    void onTransactionRemoved(const Hash256& txid, std::uint64_t mempoolSequence);
+    void onBlockConnected(const Hash256& blockHash);
+    ///@}
+
+    /**
+     * @brief Makes the next `sync()` bootstrap again, e.g. after the feed lost messages.
+     */
+    void requestResync();
+
+#ifdef USE_ZMQ
+    /**
+     * @brief Routes the `sequence` feed and its resyncs of a ZmqSubscriber into this mirror.
+     * @param handlers The handlers passed to `ZmqSubscriber::start()`; `onSequence` and `onMempoolResync` are replaced.
+     */
+    void attach(ZmqHandlers& handlers) {
+        handlers.onSequence = [this](const SequenceEvent& event) {
+            switch (event.label) {
+            case SequenceEvent::Label::TxAdded: onTransactionAdded(event.hash, event.mempoolSequence.value_or(0)); break;
+            case SequenceEvent::Label::TxRemoved: onTransactionRemoved(event.hash, event.mempoolSequence.value_or(0)); break;
+            case SequenceEvent::Label::BlockConnected: onBlockConnected(event.hash); break;
+            case SequenceEvent::Label::BlockDisconnected: break;    // Its transactions come back as `A` events.
+            }
+        };
+        handlers.onMempoolResync = [this](const Json::Value&) { requestResync(); };
+    }
+#endif
+
+    /**
+     * @name Queries
+     * @brief Thread-safe reads of the mirrored state.
+     */
+    ///@{
+    std::size_t size() const;                                       ///< Number of transactions.
+    std::uint64_t totalVsize() const;                               ///< Sum of all virtual sizes.
+    std::uint64_t sequence() const;                                 ///< Mempool sequence number the mirror is at.
+    bool contains(const Hash256& txid) const;                       ///< Checks whether a transaction is in the mempool.
+    std::optional<MempoolTx> find(const Hash256& txid) const;       ///< Looks up one transaction.
+    std::vector<MempoolTx> ancestors(const Hash256& txid) const;    ///< All unconfirmed ancestors, nearest first.
+    std::vector<MempoolTx> descendants(const Hash256& txid) const;  ///< All descendants, nearest first.
+
+    /**
+     * @brief Returns the virtual size of all transactions paying at least `feeRate` (sat/kvB).
+     */
+    std::uint64_t vsizeAbove(Amount feeRate) const;
+
+    /**
+     * @brief Visits the transactions from the highest fee rate down.
+     * @param visit Receives each transaction; returning `false` stops the walk. Must not call back into the mirror.
+     */
+    void forEachByFeeRate(const std::function<bool(const MempoolTx&)>& visit) const;
+    ///@}
+
+private:
+    static constexpr std::uint32_t NONE = UINT32_MAX;   ///< Marks an empty slot or a missing entry.
+
+    /**
+     * @struct Entry
+     * @brief One slot of the dense entry array.
+     */
+    struct Entry {
+        MempoolTx tx;
+        std::vector<std::uint32_t> parents;     ///< Entries this one spends from.
+        std::vector<std::uint32_t> children;    ///< Entries spending from this one.
+        bool live = false;                      ///< The slot holds a transaction.
+    };
+
+    /**
+     * @struct Table
+     * @brief The mirrored mempool; bootstraps build a new one and swap it in.
+     */
+    struct Table {
+        std::vector<Entry> entries;                             ///< Dense storage; freed slots are reused.
+        std::vector<std::uint32_t> freeSlots;                   ///< Indices of dead entries.
+        std::vector<std::uint32_t> index;                       ///< Open-addressing txid table of entry indices; size is a power of two.
+        std::size_t count = 0;                                  ///< Live entries.
+        std::uint64_t vsize = 0;                                ///< Sum of live virtual sizes.
+        std::set<std::pair<Amount, std::uint32_t>> byFeeRate;   ///< (fee rate, entry) of every live entry.
+
+        std::uint32_t find(const Hash256& txid) const;          ///< Returns the entry of a txid, or `NONE`.
+        std::uint32_t insert(const Hash256& txid);              ///< Allocates an entry for a txid not in the table yet.
+        void erase(std::uint32_t slot);                         ///< Frees an entry and unlinks it from its relatives.
+        void link(std::uint32_t parent, std::uint32_t child);   ///< Records a spend, once.
+        void grow();                                            ///< Doubles the txid table.
+    };
+
+    /**
+     * @struct Event
+     * @brief One queued change.
+     */
+    struct Event {
+        enum class Kind : std::uint8_t { Added, Removed, BlockConnected } kind;
+        Hash256 hash;
+        std::uint64_t sequence;
+    };
+
+    /**
+     * @brief Streams the whole mempool into a new table and swaps it in; `syncMutex` must be held.
+     */
+    bool load();
+
+    /**
+     * @brief Applies the queued events.
+     */
+    bool applyEvents();
+
+    /**
+     * @brief Compares `getrawmempool false true` with the mirror and applies the difference.
+     */
+    bool poll();
+
+    /**
+     * @brief Fetches the entries of new transactions with batched `getmempoolentry` calls.
+     * @param txids The transactions to look up.
+     * @param[out] out The entries found; transactions that already left the mempool are skipped.
+     */
+    bool fetchEntries(const std::vector<Hash256>& txids, std::vector<std::pair<Hash256, MempoolEntryResult>>& out);
+
+    /**
+     * @brief Fetches the txids of a block (`getblock <hash> 1`).
+     */
+    bool fetchBlockTransactions(const Hash256& blockHash, std::vector<Hash256>& txids);
+
+    /**
+     * @brief Removes and then adds transactions under the exclusive lock, and moves the sequence to `sequence`.
+     */
+    void apply(const std::vector<Hash256>& removed, const std::vector<std::pair<Hash256, MempoolEntryResult>>& added,
+               std::uint64_t sequence);
+
+    /**
+     * @brief Adds or updates one transaction and links it to the relatives already in the table.
+     */
+    static std::uint32_t addEntry(Table& table, const Hash256& txid, const MempoolEntryResult& entry, bool linkRelatives);
+
+    /**
+     * @brief Body of the background thread.
+     */
+    void syncLoop();
+
+    void queue(const Event& event);
+    void collectRelatives(const Hash256& txid, bool up, std::vector<MempoolTx>& out) const;
+
+    BitcoinClient& client;                      ///< Client used for all requests.
+    MempoolMirrorSettings mirrorSettings;       ///< Sync rules.
+
+    mutable std::shared_mutex tableMutex;       ///< Guards `table` and `mempoolSequence`.
+    Table table;                                ///< The mirrored mempool.
+    std::uint64_t mempoolSequence = 0;          ///< Sequence number the mirror is at.
+
+    std::mutex syncMutex;                       ///< Serializes `bootstrap()` and `sync()`.
+    bool bootstrapped = false;                  ///< A bootstrap has succeeded; guarded by `syncMutex`.
+
+    std::mutex eventMutex;                      ///< Guards the members below.
+    std::condition_variable eventArrived;       ///< Wakes the background thread.
+    std::deque<Event> events;                   ///< Changes not applied yet.
+    bool resyncRequested = false;               ///< The next sync must bootstrap.
+    bool stopping = false;                      ///< Stops the background thread.
+    std::thread worker;                         ///< Background sync thread.
+};
+
+#endif // MEMPOOLMIRROR_HPP
@@ -0,0 +1,281 @@
+#include "merkle.hpp"
+#include "sha256.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+namespace {
+constexpr std::size_t PARALLEL_CHUNK = 64;              ///< Items a thread claims at a time.
+constexpr std::size_t MIN_TRANSACTIONS_PER_THREAD = 256;
+constexpr std::size_t MIN_PROOFS_PER_THREAD = 16;
+constexpr std::uint32_t MAX_PROOF_TRANSACTIONS = 4000000 / 240;     ///< Maximum block weight over minimum transaction weight.
+
+/**
+ * @brief Tag and size of the BIP 141 witness commitment output: OP_RETURN, a 36-byte push, 0xaa21a9ed.
+ */
+constexpr std::uint8_t WITNESS_COMMITMENT_TAG[] = {0x6a, 0x24, 0xaa, 0x21, 0xa9, 0xed};
+constexpr std::size_t WITNESS_COMMITMENT_SIZE = 38;
+
+/**
+ * @brief Runs `function(i)` for `i` in `[0, count)` on up to `threads` threads, the caller included.
+ *
+ * Threads claim chunks as they go, so uneven items (a few huge transactions) do not leave
+ * threads idle. Fewer threads are used than would each get `minimumPerThread` items.
+ */
+template<typename Function>
+void parallelFor(std::size_t count, unsigned threads, std::size_t minimumPerThread, const Function& function) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t workerCount = std::min<std::size_t>(threads, count / minimumPerThread);
+    if (workerCount <= 1) {
+        for (std::size_t i = 0; i < count; ++i) function(i);
+        return;
+    }
+
+    std::atomic<std::size_t> nextChunk {0};
+    const auto drain = [&] {
+        while (true) {
+            const std::size_t begin = nextChunk.fetch_add(PARALLEL_CHUNK, std::memory_order_relaxed);
+            if (begin >= count) return;
+            const std::size_t end = std::min(count, begin + PARALLEL_CHUNK);
+            for (std::size_t i = begin; i < end; ++i) function(i);
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount - 1);
+    for (std::size_t i = 1; i < workerCount; ++i) workers.emplace_back(drain);
+    drain();
+    for (std::thread& worker : workers) worker.join();
+}
+
+/**
+ * @brief Returns the double SHA-256 of two hashes concatenated: one merkle node.
+ */
+Hash256 hashPair(const Hash256& left, const Hash256& right) {
+    std::uint8_t pair[64];
+    std::memcpy(pair, left.data(), 32);
+    std::memcpy(pair + 32, right.data(), 32);
+    Hash256 node;
+    sha256d64(node.data(), pair, 1);
+    return node;
+}
+
+/**
+ * @brief Walks a partial merkle tree depth first, as serialized by `gettxoutproof`.
+ */
+class PartialMerkleTree {
+public:
+    PartialMerkleTree(std::uint32_t transactions, std::span<const Hash256> hashes, ByteSpan flags, std::vector<Hash256>& matched)
+        : transactions(transactions), hashes(hashes), flags(flags), matched(matched) {}
+
+    /**
+     * @brief Computes the root, collecting the matched txids; false if the tree is malformed.
+     */
+    bool extract(Hash256& root) {
+        int height = 0;
+        while (width(height) > 1) ++height;
+        root = traverse(height, 0);
+        // Every hash and every flag byte must be used, except for the padding bits of the last byte.
+        return !malformed && hashesUsed == hashes.size() && (flagsUsed + 7) / 8 == flags.size();
+    }
+
+private:
+    std::size_t width(int height) const { return (transactions + (std::size_t(1) << height) - 1) >> height; }
+
+    bool flag(std::size_t index) const { return (flags[index / 8] >> (index % 8)) & 1; }
+
+    Hash256 traverse(int height, std::size_t position) {
+        if (malformed || flagsUsed >= 8 * flags.size()) {
+            malformed = true;
+            return {};
+        }
+        const bool parentOfMatch = flag(flagsUsed++);
+        if (height == 0 || !parentOfMatch) {
+            if (hashesUsed >= hashes.size()) {
+                malformed = true;
+                return {};
+            }
+            const Hash256& hash = hashes[hashesUsed++];
+            if (height == 0 && parentOfMatch) matched.push_back(hash);
+            return hash;
+        }
+
+        const Hash256 left = traverse(height - 1, 2 * position);
+        Hash256 right = left;
+        if (2 * position + 1 < width(height - 1)) {
+            right = traverse(height - 1, 2 * position + 1);
+            // An explicit right child equal to the left one would let one tree stand for two.
+            if (right == left) malformed = true;
+        }
+        return hashPair(left, right);
+    }
+
+    std::uint32_t transactions;
+    std::span<const Hash256> hashes;
+    ByteSpan flags;
+    std::vector<Hash256>& matched;
+    std::size_t hashesUsed = 0;
+    std::size_t flagsUsed = 0;
+    bool malformed = false;
+};
+
+/**
+ * @brief Returns the witness commitment of a coinbase: the payload of its last commitment output.
+ */
+std::optional<ByteSpan> witnessCommitment(const TxView& coinbase) {
+    for (auto output = coinbase.outputs.rbegin(); output != coinbase.outputs.rend(); ++output) {
+        const ByteSpan script = output->scriptPubKey;
+        if (script.size() >= WITNESS_COMMITMENT_SIZE
+            && std::equal(std::begin(WITNESS_COMMITMENT_TAG), std::end(WITNESS_COMMITMENT_TAG), script.begin())) {
+            return script.subspan(sizeof(WITNESS_COMMITMENT_TAG), 32);
+        }
+    }
+    return std::nullopt;
+}
+
+bool hasWitnessData(const BlockView& block) {
+    return std::any_of(block.transactions.begin(), block.transactions.end(), [](const TxView& tx) {
+        return std::any_of(tx.inputs.begin(), tx.inputs.end(), [](const TxInView& input) {
+            // A stack of zero items serializes as a single zero byte.
+            return input.witness.size() > 1;
+        });
+    });
+}
+
+BlockCheck verifyWitnessCommitment(const BlockView& block, const TransactionHashes& hashes) {
+    const TxView& coinbase = block.transactions.front();
+    const auto commitment = witnessCommitment(coinbase);
+    if (!commitment) {
+        return hasWitnessData(block) ? BlockCheck::WitnessMismatch : BlockCheck::Valid;
+    }
+
+    // The coinbase witness carries the reserved value the commitment is hashed with.
+    std::vector<ByteSpan> items;
+    if (coinbase.inputs.empty() || !parseWitness(coinbase.inputs.front().witness, items)
+        || items.size() != 1 || items.front().size() != 32) {
+        return BlockCheck::WitnessMismatch;
+    }
+
+    std::vector<Hash256> leaves = hashes.wtxids;
+    leaves.front().fill(0);     // The coinbase cannot commit to its own wtxid.
+    const Hash256 witnessRoot = computeMerkleRoot(std::move(leaves));
+
+    std::uint8_t preimage[64];
+    std::memcpy(preimage, witnessRoot.data(), 32);
+    std::memcpy(preimage + 32, items.front().data(), 32);
+    Hash256 expected;
+    sha256d64(expected.data(), preimage, 1);
+    return std::equal(expected.begin(), expected.end(), commitment->begin()) ? BlockCheck::Valid : BlockCheck::WitnessMismatch;
+}
+}
+
+Hash256 computeTxid(const TxView& tx) {
+    if (!tx.hasWitness) return sha256d(tx.raw);
+
+    // Version, inputs and outputs, lock time: the serialization without marker, flag and witnesses.
+    Sha256 hasher;
+    const auto first = hasher.write(tx.raw.first(4)).write(tx.ioBytes).write(tx.raw.last(4)).finalize();
+    return hasher.write(first).finalize();
+}
+
+Hash256 computeWtxid(const TxView& tx) {
+    return sha256d(tx.raw);
+}
+
+Hash256 computeBlockHash(const BlockHeaderView& header) {
+    return sha256d(header.raw);
+}
+
+Hash256 computeMerkleRoot(std::vector<Hash256> leaves, bool* mutated) {
+    if (leaves.empty()) return {};
+
+    bool duplicatePairs = false;
+    std::size_t count = leaves.size();
+    while (count > 1) {
+        if (mutated) {
+            for (std::size_t i = 0; i + 1 < count; i += 2) duplicatePairs |= leaves[i] == leaves[i + 1];
+        }
+        if (count % 2 != 0) {
+            if (leaves.size() == count) leaves.emplace_back();
+            leaves[count] = leaves[count - 1];
+            ++count;
+        }
+        // Each node overwrites the first half of the pair before it: the level is hashed in place.
+        sha256d64(leaves.front().data(), leaves.front().data(), count / 2);
+        count /= 2;
+    }
+    if (mutated) *mutated = duplicatePairs;
+    return leaves.front();
+}
+
+void computeTransactionHashes(const BlockView& block, TransactionHashes& out, unsigned threads) {
+    const std::size_t count = block.transactions.size();
+    out.txids.resize(count);
+    out.wtxids.resize(count);
+    parallelFor(count, threads, MIN_TRANSACTIONS_PER_THREAD, [&](std::size_t i) {
+        const TxView& tx = block.transactions[i];
+        out.txids[i] = computeTxid(tx);
+        out.wtxids[i] = tx.hasWitness ? computeWtxid(tx) : out.txids[i];
+    });
+}
+
+std::string_view blockCheckName(BlockCheck check) {
+    switch (check) {
+        case BlockCheck::Valid: return "valid";
+        case BlockCheck::Empty: return "no transactions";
+        case BlockCheck::HashMismatch: return "block hash mismatch";
+        case BlockCheck::MerkleMismatch: return "merkle root mismatch";
+        case BlockCheck::MerkleMutated: return "mutated merkle tree";
+        case BlockCheck::WitnessMismatch: return "witness commitment mismatch";
+    }
+    return "unknown";
+}
+
+BlockCheck verifyBlock(const BlockView& block, const Hash256* expectedHash, unsigned threads, TransactionHashes* hashes) {
+    if (block.transactions.empty()) return BlockCheck::Empty;
+    if (expectedHash && computeBlockHash(block.header) != *expectedHash) return BlockCheck::HashMismatch;
+
+    TransactionHashes local;
+    TransactionHashes& computed = hashes ? *hashes : local;
+    computeTransactionHashes(block, computed, threads);
+
+    bool mutated = false;
+    if (computeMerkleRoot(computed.txids, &mutated) != block.header.merkleRoot) return BlockCheck::MerkleMismatch;
+    if (mutated) return BlockCheck::MerkleMutated;
+    return verifyWitnessCommitment(block, computed);
+}
+
+bool verifyTxOutProof(ByteSpan proof, TxOutProofResult& out) {
+    out.valid = false;
+    out.matched.clear();
+
+    ByteReader reader(proof);
+    if (!parseBlockHeader(reader, out.header)) return false;
+    const std::uint32_t transactions = reader.readU32();
+    const std::uint64_t hashCount = reader.readCompactSize(std::min<std::uint64_t>(transactions, reader.remaining() / 32));
+    std::vector<Hash256> hashes(static_cast<std::size_t>(hashCount));
+    for (Hash256& hash : hashes) hash = reader.readHash();
+    const ByteSpan flags = reader.readVarBytes();
+    if (!reader.atEnd() || transactions == 0 || transactions > MAX_PROOF_TRANSACTIONS || 8 * flags.size() < hashes.size()) {
+        return false;
+    }
+
+    Hash256 root;
+    PartialMerkleTree tree(transactions, hashes, flags, out.matched);
+    if (!tree.extract(root) || root != out.header.merkleRoot) {
+        out.matched.clear();
+        return false;
+    }
+    out.blockHash = computeBlockHash(out.header);
+    out.valid = true;
+    return true;
+}
+
+std::size_t verifyTxOutProofs(std::span<const ByteSpan> proofs, std::vector<TxOutProofResult>& results, unsigned threads) {
+    results.resize(proofs.size());
+    std::atomic<std::size_t> valid {0};
+    parallelFor(proofs.size(), threads, MIN_PROOFS_PER_THREAD, [&](std::size_t i) {
+        if (verifyTxOutProof(proofs[i], results[i])) valid.fetch_add(1, std::memory_order_relaxed);
+    });
+    return valid.load();
+}
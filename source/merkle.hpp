@@ -0,0 +1,132 @@
+#ifndef MERKLE_HPP
+#define MERKLE_HPP
+
+#if __has_include("rawblock.hpp")
+#   include "rawblock.hpp"
+#else
+#   error "Bitcoin's \"rawblock.hpp\" was not found!"
+#endif
+
+#include <span>
+#include <string_view>
+#include <vector>
+
+/**
+ * @name Local hashing
+ * @brief Txids, block hashes and merkle trees computed from raw data instead of trusted from RPC.
+ *
+ * All hashes are in internal byte order; `hashToHex` gives the form RPC displays.
+ * Functions taking a `threads` count split the work across that many threads, 0 meaning one
+ * per core; small inputs are hashed on the calling thread.
+ * @{
+ */
+
+/**
+ * @brief Returns the txid: the double SHA-256 of the serialization without witnesses.
+ */
+Hash256 computeTxid(const TxView& tx);
+
+/**
+ * @brief Returns the wtxid: the double SHA-256 of the full serialization; the txid without witnesses.
+ */
+Hash256 computeWtxid(const TxView& tx);
+
+/**
+ * @brief Returns the block hash: the double SHA-256 of the 80-byte header.
+ */
+Hash256 computeBlockHash(const BlockHeaderView& header);
+
+/**
+ * @brief Computes the merkle root of a list of hashes, one level at a time with batched hashing.
+ * @param leaves The leaves; consumed as scratch space.
+ * @param[out] mutated If given, set when a level pairs two identical hashes: another list
+ *        (CVE-2012-2459) has the same root, so the root does not commit to the list.
+ * @return The root; all zero for an empty list.
+ */
+Hash256 computeMerkleRoot(std::vector<Hash256> leaves, bool* mutated = nullptr);
+
+/**
+ * @struct TransactionHashes
+ * @brief The txids and wtxids of the transactions of a block, in block order.
+ */
+struct TransactionHashes {
+    std::vector<Hash256> txids;
+    std::vector<Hash256> wtxids;
+};
+
+/**
+ * @brief Hashes every transaction of a block.
+ * @param block The block.
+ * @param[out] out Receives one txid and wtxid per transaction; its vectors are reused.
+ * @param threads Threads to hash with (0: one per core).
+ */
+void computeTransactionHashes(const BlockView& block, TransactionHashes& out, unsigned threads = 1);
+
+/**
+ * @enum BlockCheck
+ * @brief The outcome of verifyBlock.
+ */
+enum class BlockCheck {
+    Valid,              ///< Every check passed.
+    Empty,              ///< The block has no transactions.
+    HashMismatch,       ///< The header does not hash to the expected block hash.
+    MerkleMismatch,     ///< The transactions do not hash to the header's merkle root.
+    MerkleMutated,      ///< The merkle tree contains duplicated pairs.
+    WitnessMismatch     ///< The witness data does not match the coinbase's commitment, or is not committed to.
+};
+
+/**
+ * @brief Returns a short description of a check outcome, for logging.
+ */
+std::string_view blockCheckName(BlockCheck check);
+
+/**
+ * @brief Checks that a block's contents are the ones its header commits to.
+ *
+ * Verifies the block hash (if one is expected), the merkle root over the txids and, for
+ * blocks with witness data, the BIP 141 witness commitment. Proof of work, scripts and
+ * consensus rules are not checked: this establishes that the bytes received are the block
+ * with the expected hash, so nothing decoded from them needs to be fetched again.
+ *
+ * @param block The block.
+ * @param expectedHash The block hash it should have, or null to skip that check.
+ * @param threads Threads to hash the transactions with (0: one per core).
+ * @param[out] hashes If given, receives the transaction hashes computed along the way.
+ */
+BlockCheck verifyBlock(const BlockView& block, const Hash256* expectedHash, unsigned threads = 1,
+                       TransactionHashes* hashes = nullptr);
+
+/**
+ * @struct TxOutProofResult
+ * @brief The contents of a `gettxoutproof` proof.
+ */
+struct TxOutProofResult {
+    bool valid = false;             ///< The proof is well-formed and its merkle branch leads to the header's root.
+    BlockHeaderView header;         ///< The block header; its `raw` points into the proof.
+    Hash256 blockHash {};           ///< Hash of the header.
+    std::vector<Hash256> matched;   ///< Txids the proof proves, in block order.
+};
+
+/**
+ * @brief Verifies a serialized `gettxoutproof` proof locally, instead of with `verifytxoutproof`.
+ *
+ * Unlike the RPC, this cannot know whether the block is in the active chain: check
+ * `blockHash` against a chain you trust.
+ *
+ * @param proof The serialized proof (decode the RPC's hex with `decodeHex`).
+ * @param[out] out The proof's contents; its vectors are reused.
+ * @return `out.valid`.
+ */
+bool verifyTxOutProof(ByteSpan proof, TxOutProofResult& out);
+
+/**
+ * @brief Verifies many proofs in parallel.
+ * @param proofs The serialized proofs.
+ * @param[out] results One result per proof, in order.
+ * @param threads Threads to verify with (0: one per core).
+ * @return The number of valid proofs.
+ */
+std::size_t verifyTxOutProofs(std::span<const ByteSpan> proofs, std::vector<TxOutProofResult>& results, unsigned threads = 0);
+/** @} */
+
+#endif // MERKLE_HPP
@@ -0,0 +1,345 @@
+#include "metrics.hpp"
+#include <bit>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <memory>
+
+namespace {
+std::atomic<std::size_t> nextStripe {0};
+
+/**
+ * @brief Bucket bounds of the exported histograms, in microseconds.
+ */
+constexpr std::array<std::uint64_t, 17> EXPORT_BOUNDS = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 5000000, 10000000, 30000000
+};
+
+/**
+ * @brief Returns the stripe the calling thread records into; threads are spread round-robin.
+ */
+std::size_t threadStripe() {
+    thread_local const std::size_t stripe = nextStripe.fetch_add(1, std::memory_order_relaxed) % LatencyHistogram::STRIPES;
+    return stripe;
+}
+
+void raiseMax(std::atomic<std::uint64_t>& max, std::uint64_t value) {
+    std::uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+std::uint64_t hashName(std::string_view name) {
+    std::uint64_t hash = 14695981039346656037ull;   // FNV-1a
+    for (const char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string escapeLabel(std::string_view value) {
+    std::string out;
+    out.reserve(value.size());
+    for (const char c : value) {
+        if (c == '\\' || c == '"') out += '\\';
+        if (c == '\n') {
+            out += "\\n";
+            continue;
+        }
+        out += c;
+    }
+    return out;
+}
+
+double seconds(std::uint64_t micros) {
+    return static_cast<double>(micros) / 1e6;
+}
+
+/**
+ * @brief Writes the header of a metric family.
+ */
+void writeFamily(std::string& out, std::string_view prefix, std::string_view name, std::string_view type, std::string_view help) {
+    out += std::format("# HELP {}_{} {}\n# TYPE {}_{} {}\n", prefix, name, help, prefix, name, type);
+}
+
+/**
+ * @brief Writes the samples of one histogram; `labels` is empty or ends with a comma.
+ */
+void writeHistogram(std::string& out, std::string_view prefix, std::string_view name, std::string_view labels,
+                    const HistogramSnapshot& histogram) {
+    for (const std::uint64_t bound : EXPORT_BOUNDS) {
+        out += std::format("{}_{}_bucket{{{}le=\"{}\"}} {}\n", prefix, name, labels, seconds(bound), histogram.countAtOrBelow(bound));
+    }
+    out += std::format("{}_{}_bucket{{{}le=\"+Inf\"}} {}\n", prefix, name, labels, histogram.count);
+    const std::string braced = labels.empty() ? std::string() : std::format("{{{}}}", labels.substr(0, labels.size() - 1));
+    out += std::format("{}_{}_sum{} {}\n", prefix, name, braced, seconds(histogram.sum));
+    out += std::format("{}_{}_count{} {}\n", prefix, name, braced, histogram.count);
+}
+}
+
+std::uint64_t HistogramSnapshot::percentile(double fraction) const {
+    if (count == 0) return 0;
+    const double clamped = std::clamp(fraction, 0.0, 1.0);
+    const auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(clamped * static_cast<double>(count))));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= target) return std::min(LatencyHistogram::bucketLimit(i), max);
+    }
+    return max;
+}
+
+std::uint64_t HistogramSnapshot::countAtOrBelow(std::uint64_t limit) const {
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < counts.size() && LatencyHistogram::bucketLimit(i) <= limit; ++i) total += counts[i];
+    return total;
+}
+
+void HistogramSnapshot::merge(const HistogramSnapshot& other) {
+    if (counts.size() < other.counts.size()) counts.resize(other.counts.size());
+    for (std::size_t i = 0; i < other.counts.size(); ++i) counts[i] += other.counts[i];
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+}
+
+std::size_t LatencyHistogram::bucketOf(std::uint64_t micros) {
+    if (micros < SUB_BUCKETS) return static_cast<std::size_t>(micros);
+    // Shift the value into [SUB_BUCKETS, 2 * SUB_BUCKETS); the shift selects the octave, the rest the bucket in it.
+    const auto shift = static_cast<unsigned>(std::bit_width(micros)) - 1 - SUB_BUCKET_BITS;
+    const std::size_t index = SUB_BUCKETS * (shift + 1) + static_cast<std::size_t>((micros >> shift) - SUB_BUCKETS);
+    return std::min(index, BUCKETS - 1);
+}
+
+std::uint64_t LatencyHistogram::bucketLimit(std::size_t index) {
+    if (index < SUB_BUCKETS) return index;
+    if (index >= BUCKETS - 1) return std::numeric_limits<std::uint64_t>::max();
+    const std::size_t shift = index / SUB_BUCKETS - 1;
+    const std::uint64_t base = index % SUB_BUCKETS + SUB_BUCKETS;
+    return ((base + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t micros) {
+    Stripe& stripe = stripes[threadStripe()];
+    stripe.counts[bucketOf(micros)].fetch_add(1, std::memory_order_relaxed);
+    stripe.sum.fetch_add(micros, std::memory_order_relaxed);
+    raiseMax(stripe.max, micros);
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const {
+    HistogramSnapshot result;
+    result.counts.assign(BUCKETS, 0);
+    for (const Stripe& stripe : stripes) {
+        for (std::size_t i = 0; i < BUCKETS; ++i) {
+            const std::uint64_t count = stripe.counts[i].load(std::memory_order_relaxed);
+            result.counts[i] += count;
+            result.count += count;
+        }
+        result.sum += stripe.sum.load(std::memory_order_relaxed);
+        result.max = std::max(result.max, stripe.max.load(std::memory_order_relaxed));
+    }
+    return result;
+}
+
+std::string_view callFailureName(CallFailure failure) {
+    switch (failure) {
+    case CallFailure::None: return "none";
+    case CallFailure::ConnectFailed: return "connect_failed";
+    case CallFailure::TimedOut: return "timed_out";
+    case CallFailure::Aborted: return "aborted";
+    case CallFailure::CircuitOpen: return "circuit_open";
+    case CallFailure::Transport: return "transport";
+    case CallFailure::Parse: return "parse";
+    case CallFailure::Rpc: break;
+    }
+    return "rpc";
+}
+
+CallFailure callFailureOf(TransferError error) {
+    switch (error) {
+    case TransferError::None: return CallFailure::None;
+    case TransferError::ConnectFailed: return CallFailure::ConnectFailed;
+    case TransferError::TimedOut: return CallFailure::TimedOut;
+    case TransferError::Aborted: return CallFailure::Aborted;
+    case TransferError::CircuitOpen: return CallFailure::CircuitOpen;
+    case TransferError::Failed: break;
+    }
+    return CallFailure::Transport;
+}
+
+std::uint64_t MethodMetrics::errors() const {
+    std::uint64_t total = 0;
+    for (const std::uint64_t count : failures) total += count;
+    return total;
+}
+
+/**
+ * @brief The counters of one method.
+ */
+struct Metrics::Series {
+    struct alignas(64) Counters {
+        std::atomic<std::uint64_t> calls {0};
+        std::atomic<std::uint64_t> requestBytes {0};
+        std::atomic<std::uint64_t> responseBytes {0};
+        std::array<std::atomic<std::uint64_t>, CALL_FAILURE_KINDS> failures {};
+    };
+
+    explicit Series(std::string_view name) : method(name) {}
+
+    void record(const CallSample& sample) {
+        Counters& stripe = counters[threadStripe()];
+        stripe.calls.fetch_add(1, std::memory_order_relaxed);
+        stripe.requestBytes.fetch_add(sample.requestBytes, std::memory_order_relaxed);
+        stripe.responseBytes.fetch_add(sample.responseBytes, std::memory_order_relaxed);
+        if (sample.failure != CallFailure::None) {
+            stripe.failures[static_cast<std::size_t>(sample.failure)].fetch_add(1, std::memory_order_relaxed);
+        }
+        latency.record(sample.latency);
+        if (sample.serverTime.count() > 0) serverTime.record(sample.serverTime);
+    }
+
+    MethodMetrics snapshot() const {
+        MethodMetrics result;
+        result.method = method;
+        for (const Counters& stripe : counters) {
+            result.calls += stripe.calls.load(std::memory_order_relaxed);
+            result.requestBytes += stripe.requestBytes.load(std::memory_order_relaxed);
+            result.responseBytes += stripe.responseBytes.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < CALL_FAILURE_KINDS; ++i) result.failures[i] += stripe.failures[i].load(std::memory_order_relaxed);
+        }
+        result.latency = latency.snapshot();
+        result.serverTime = serverTime.snapshot();
+        return result;
+    }
+
+    const std::string method;
+    std::array<Counters, LatencyHistogram::STRIPES> counters;
+    LatencyHistogram latency;
+    LatencyHistogram serverTime;
+};
+
+Metrics::Metrics() = default;
+
+Metrics::~Metrics() {
+    for (std::atomic<Series*>& slot : table) delete slot.load();
+    delete overflow.load();
+}
+
+Metrics::Series* Metrics::series(std::string_view method) {
+    const std::uint64_t hash = hashName(method);
+    for (std::size_t probe = 0; probe < MAX_METHODS; ++probe) {
+        std::atomic<Series*>& slot = table[(hash + probe) % MAX_METHODS];
+        Series* existing = slot.load(std::memory_order_acquire);
+        if (!existing) {
+            auto created = std::make_unique<Series>(method);
+            if (slot.compare_exchange_strong(existing, created.get(), std::memory_order_acq_rel)) return created.release();
+            // Another thread claimed the slot first; `existing` now holds its series.
+        }
+        if (existing->method == method) return existing;
+    }
+
+    Series* other = overflow.load(std::memory_order_acquire);
+    if (!other) {
+        auto created = std::make_unique<Series>("other");
+        if (overflow.compare_exchange_strong(other, created.get(), std::memory_order_acq_rel)) return created.release();
+    }
+    return other;
+}
+
+void Metrics::recordCall(std::string_view method, const CallSample& sample) {
+    series(method)->record(sample);
+}
+
+void Metrics::recordTransfer(const TransferInfo& transfer) {
+    TransferStripe& stripe = transferStripes[threadStripe()];
+    stripe.transfers.fetch_add(1, std::memory_order_relaxed);
+    (transfer.reused ? stripe.reusedConnections : stripe.newConnections).fetch_add(1, std::memory_order_relaxed);
+    poolWait.record(transfer.poolWait);
+    if (!transfer.reused) connectTime.record(transfer.connect);
+    if (firstTransfer.load(std::memory_order_relaxed) < 0) {
+        std::int64_t unset = -1;
+        firstTransfer.compare_exchange_strong(unset, (transfer.poolWait + transfer.total).count(), std::memory_order_relaxed);
+    }
+}
+
+void Metrics::recordQueueWait(RequestPriority priority, std::chrono::nanoseconds wait) {
+    queueWait[static_cast<std::size_t>(priority)].record(wait);
+}
+
+MetricsSnapshot Metrics::snapshot() const {
+    MetricsSnapshot result;
+    for (const std::atomic<Series*>& slot : table) {
+        if (const Series* entry = slot.load(std::memory_order_acquire)) result.methods.push_back(entry->snapshot());
+    }
+    if (const Series* other = overflow.load(std::memory_order_acquire)) result.methods.push_back(other->snapshot());
+    std::sort(result.methods.begin(), result.methods.end(),
+              [](const MethodMetrics& a, const MethodMetrics& b) { return a.method < b.method; });
+
+    for (const TransferStripe& stripe : transferStripes) {
+        result.transport.transfers += stripe.transfers.load(std::memory_order_relaxed);
+        result.transport.newConnections += stripe.newConnections.load(std::memory_order_relaxed);
+        result.transport.reusedConnections += stripe.reusedConnections.load(std::memory_order_relaxed);
+    }
+    result.transport.poolWait = poolWait.snapshot();
+    result.transport.connect = connectTime.snapshot();
+    for (std::size_t lane = 0; lane < REQUEST_PRIORITIES; ++lane) result.transport.queueWait[lane] = queueWait[lane].snapshot();
+    result.transport.firstTransfer = std::chrono::microseconds(std::max<std::int64_t>(firstTransfer.load(std::memory_order_relaxed), 0));
+    return result;
+}
+
+std::string Metrics::toPrometheus(std::string_view prefix) const {
+    const MetricsSnapshot totals = snapshot();
+    std::vector<std::string> labels;
+    labels.reserve(totals.methods.size());
+    for (const MethodMetrics& method : totals.methods) labels.push_back(std::format("method=\"{}\",", escapeLabel(method.method)));
+
+    std::string out;
+    const auto counter = [&](std::string_view name, std::string_view help, auto value) {
+        writeFamily(out, prefix, name, "counter", help);
+        for (std::size_t i = 0; i < totals.methods.size(); ++i) {
+            const std::string_view label(labels[i].data(), labels[i].size() - 1);
+            out += std::format("{}_{}{{{}}} {}\n", prefix, name, label, value(totals.methods[i]));
+        }
+    };
+    counter("calls_total", "RPC calls made, by method.", [](const MethodMetrics& m) { return m.calls; });
+    counter("request_bytes_total", "Bytes of serialized requests, by method.", [](const MethodMetrics& m) { return m.requestBytes; });
+    counter("response_bytes_total", "Bytes of response bodies, by method.", [](const MethodMetrics& m) { return m.responseBytes; });
+
+    writeFamily(out, prefix, "errors_total", "counter", "Failed RPC calls, by method and cause.");
+    for (std::size_t i = 0; i < totals.methods.size(); ++i) {
+        for (std::size_t kind = 1; kind < CALL_FAILURE_KINDS; ++kind) {
+            if (totals.methods[i].failures[kind] == 0) continue;
+            out += std::format("{}_errors_total{{{}type=\"{}\"}} {}\n", prefix, labels[i],
+                               callFailureName(static_cast<CallFailure>(kind)), totals.methods[i].failures[kind]);
+        }
+    }
+
+    writeFamily(out, prefix, "call_duration_seconds", "histogram", "Duration of RPC calls, retries included, by method.");
+    for (std::size_t i = 0; i < totals.methods.size(); ++i) {
+        writeHistogram(out, prefix, "call_duration_seconds", labels[i], totals.methods[i].latency);
+    }
+    writeFamily(out, prefix, "server_duration_seconds", "histogram", "Time from sending a request to its first response byte, by method.");
+    for (std::size_t i = 0; i < totals.methods.size(); ++i) {
+        writeHistogram(out, prefix, "server_duration_seconds", labels[i], totals.methods[i].serverTime);
+    }
+
+    const TransportMetrics& transport = totals.transport;
+    writeFamily(out, prefix, "transfers_total", "counter", "HTTP transfers performed.");
+    out += std::format("{}_transfers_total {}\n", prefix, transport.transfers);
+    writeFamily(out, prefix, "connections_total", "counter", "HTTP transfers by whether they opened a connection or reused one.");
+    out += std::format("{}_connections_total{{reused=\"false\"}} {}\n", prefix, transport.newConnections);
+    out += std::format("{}_connections_total{{reused=\"true\"}} {}\n", prefix, transport.reusedConnections);
+    writeFamily(out, prefix, "pool_wait_seconds", "histogram", "Time spent acquiring a pooled connection.");
+    writeHistogram(out, prefix, "pool_wait_seconds", "", transport.poolWait);
+    writeFamily(out, prefix, "connect_duration_seconds", "histogram", "Setup time of new connections, TLS included.");
+    writeHistogram(out, prefix, "connect_duration_seconds", "", transport.connect);
+    writeFamily(out, prefix, "queue_wait_seconds", "histogram", "Time requests waited for admission, by priority.");
+    for (std::size_t lane = 0; lane < REQUEST_PRIORITIES; ++lane) {
+        const std::string label = std::format("priority=\"{}\",", requestPriorityName(static_cast<RequestPriority>(lane)));
+        writeHistogram(out, prefix, "queue_wait_seconds", label, transport.queueWait[lane]);
+    }
+    writeFamily(out, prefix, "first_transfer_seconds", "gauge", "Duration of the first transfer, connection setup included; 0 before it.");
+    out += std::format("{}_first_transfer_seconds {}\n", prefix, seconds(static_cast<std::uint64_t>(transport.firstTransfer.count())));
+    return out;
+}
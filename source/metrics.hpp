@@ -0,0 +1,250 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#if __has_include("network.hpp")
+#   include "network.hpp"
+#else
+#   error "Bitcoin's \"network.hpp\" was not found!"
+#endif
+
+#if __has_include("admission.hpp")
+#   include "admission.hpp"
+#else
+#   error "Bitcoin's \"admission.hpp\" was not found!"
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct HistogramSnapshot
+ * @brief The recorded values of a LatencyHistogram at one point in time, in microseconds.
+ */
+struct HistogramSnapshot {
+    std::vector<std::uint64_t> counts;  ///< Values per bucket; see `LatencyHistogram::bucketLimit`.
+    std::uint64_t count = 0;            ///< Number of values.
+    std::uint64_t sum = 0;              ///< Sum of all values.
+    std::uint64_t max = 0;              ///< Largest value.
+
+    double mean() const { return count ? static_cast<double>(sum) / static_cast<double>(count) : 0; }
+
+    /**
+     * @brief Returns the value below which `fraction` of the values lie, to the precision of the buckets.
+     * @param fraction Between 0 and 1; 0.99 gives the 99th percentile.
+     */
+    std::uint64_t percentile(double fraction) const;
+
+    /**
+     * @brief Returns the number of values in buckets that end at or below `limit`.
+     */
+    std::uint64_t countAtOrBelow(std::uint64_t limit) const;
+
+    /**
+     * @brief Adds the values of another snapshot.
+     */
+    void merge(const HistogramSnapshot& other);
+};
+
+/**
+ * @class LatencyHistogram
+ * @brief A lock-free histogram of durations with log-linear buckets, in the manner of HdrHistogram.
+ *
+ * Every power of two is split into 16 buckets, so a value is known to within about 6%
+ * from 1 µs up to several minutes; longer durations share the last bucket. Recording is one
+ * relaxed increment. Each thread records into one of a few stripes picked when it first
+ * records, so threads timing the same method rarely write to the same cache lines;
+ * `snapshot()` adds the stripes up.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;                              ///< log2 of the buckets per power of two.
+    static constexpr std::size_t SUB_BUCKETS = std::size_t(1) << SUB_BUCKET_BITS;
+    static constexpr std::size_t OCTAVES = 24;                                  ///< Powers of two above the linear range.
+    static constexpr std::size_t BUCKETS = SUB_BUCKETS * (OCTAVES + 1);
+    static constexpr std::size_t STRIPES = 4;
+
+    void record(std::uint64_t micros);
+    void record(std::chrono::nanoseconds duration) {
+        record(static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 0) / 1000));
+    }
+
+    HistogramSnapshot snapshot() const;
+
+    static std::size_t bucketOf(std::uint64_t micros);          ///< The bucket counting a value.
+    static std::uint64_t bucketLimit(std::size_t index);        ///< The largest value counted in a bucket.
+
+private:
+    struct alignas(64) Stripe {
+        std::array<std::atomic<std::uint64_t>, BUCKETS> counts {};
+        std::atomic<std::uint64_t> sum {0};
+        std::atomic<std::uint64_t> max {0};
+    };
+
+    std::array<Stripe, STRIPES> stripes;
+};
+
+/**
+ * @enum CallFailure
+ * @brief Why an RPC call failed, as counted by Metrics.
+ */
+enum class CallFailure : std::uint8_t {
+    None,           ///< The call succeeded.
+    ConnectFailed,  ///< No connection could be made.
+    TimedOut,       ///< A timeout or deadline expired.
+    Aborted,        ///< The response consumer stopped the transfer.
+    CircuitOpen,    ///< Refused by the circuit breaker.
+    Transport,      ///< Any other transport failure.
+    Parse,          ///< The response was not valid JSON-RPC.
+    Rpc             ///< The node answered with an error.
+};
+
+inline constexpr std::size_t CALL_FAILURE_KINDS = 8;
+
+/**
+ * @brief Returns the label of a failure kind, as used in exported metrics (`timed_out`, `rpc`, ...).
+ */
+std::string_view callFailureName(CallFailure failure);
+
+/**
+ * @brief Maps a transport error to the failure kind it is counted as.
+ */
+CallFailure callFailureOf(TransferError error);
+
+/**
+ * @struct CallSample
+ * @brief The measurements of one finished call.
+ */
+struct CallSample {
+    std::chrono::nanoseconds latency {0};       ///< From serializing the request to having its result, retries included.
+    std::chrono::nanoseconds serverTime {0};    ///< From the request being sent to the first response byte; 0 if unknown.
+    std::size_t requestBytes = 0;               ///< Size of the serialized request.
+    std::size_t responseBytes = 0;              ///< Size of the response body.
+    CallFailure failure = CallFailure::None;
+};
+
+/**
+ * @struct MethodMetrics
+ * @brief Totals of one RPC method.
+ */
+struct MethodMetrics {
+    std::string method;
+    std::uint64_t calls = 0;
+    std::array<std::uint64_t, CALL_FAILURE_KINDS> failures {};     ///< Indexed by CallFailure; `None` stays 0.
+    std::uint64_t requestBytes = 0;
+    std::uint64_t responseBytes = 0;
+    HistogramSnapshot latency;                                      ///< Whole calls.
+    HistogramSnapshot serverTime;                                   ///< Time to first byte, where known.
+
+    std::uint64_t errors() const;   ///< Failed calls of any kind.
+};
+
+/**
+ * @struct TransportMetrics
+ * @brief Totals of the HTTP transfers of a Network.
+ */
+struct TransportMetrics {
+    std::uint64_t transfers = 0;
+    std::uint64_t newConnections = 0;       ///< Transfers that had to open a connection.
+    std::uint64_t reusedConnections = 0;    ///< Transfers that went over a kept-alive connection.
+    HistogramSnapshot poolWait;             ///< Time spent acquiring a pooled handle.
+    HistogramSnapshot connect;              ///< Connection setup, TLS included, of new connections.
+    std::array<HistogramSnapshot, REQUEST_PRIORITIES> queueWait;    ///< Time spent waiting for AdmissionControl, by RequestPriority.
+    std::chrono::microseconds firstTransfer {0};                    ///< The first transfer recorded, pool wait and connection setup included; 0 before it.
+};
+
+/**
+ * @struct MetricsSnapshot
+ * @brief Everything a Metrics instance recorded, at one point in time.
+ */
+struct MetricsSnapshot {
+    std::vector<MethodMetrics> methods;     ///< Sorted by method name.
+    TransportMetrics transport;
+};
+
+/**
+ * @class Metrics
+ * @brief Per-method call statistics and transport statistics of one or more clients.
+ *
+ * Recording never takes a lock. Methods are kept in a fixed open-addressing table that
+ * grows by appending with compare-and-swap, so the first call of a method allocates its
+ * series and every later call only hashes the name; methods beyond the table's capacity
+ * are counted as `other`. Counters only grow; take two snapshots to get rates.
+ *
+ * @code
+ * auto metrics = std::make_shared<Metrics>();
+ * client.setMetrics(metrics);
+ * ...
+ * std::string text = metrics->toPrometheus();   // Serve on /metrics.
+ * @endcode
+ */
+class Metrics {
+public:
+    static constexpr std::size_t MAX_METHODS = 512;     ///< Distinct methods tracked by name.
+
+    Metrics();
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+    ~Metrics();
+
+    /**
+     * @brief Records one finished RPC call. Thread-safe and lock-free.
+     * @param method The RPC method, or `batch` for a batch request.
+     * @param sample Its measurements.
+     */
+    void recordCall(std::string_view method, const CallSample& sample);
+
+    /**
+     * @brief Records one HTTP transfer. Thread-safe and lock-free.
+     */
+    void recordTransfer(const TransferInfo& transfer);
+
+    /**
+     * @brief Records how long a request waited for admission. Thread-safe and lock-free.
+     */
+    void recordQueueWait(RequestPriority priority, std::chrono::nanoseconds wait);
+
+    /**
+     * @brief Returns the totals recorded so far.
+     *
+     * Values recorded while the snapshot is taken may be partly included.
+     */
+    MetricsSnapshot snapshot() const;
+
+    /**
+     * @brief Renders the totals in the Prometheus text exposition format.
+     *
+     * Latencies are exported as histograms in seconds, with fixed bucket bounds from 100 µs
+     * to 30 s; a value is counted in the first bound at or above its histogram bucket.
+     *
+     * @param prefix Prepended to every metric name.
+     */
+    std::string toPrometheus(std::string_view prefix = "bitcoin_rpc") const;
+
+private:
+    struct Series;
+
+    Series* series(std::string_view method);
+
+    std::array<std::atomic<Series*>, MAX_METHODS> table {};     ///< Open addressing by name hash; slots are never cleared.
+    std::atomic<Series*> overflow {nullptr};                    ///< `other`, created when the table is full.
+
+    struct alignas(64) TransferStripe {
+        std::atomic<std::uint64_t> transfers {0};
+        std::atomic<std::uint64_t> newConnections {0};
+        std::atomic<std::uint64_t> reusedConnections {0};
+    };
+
+    std::array<TransferStripe, LatencyHistogram::STRIPES> transferStripes;
+    LatencyHistogram poolWait;
+    LatencyHistogram connectTime;
+    std::array<LatencyHistogram, REQUEST_PRIORITIES> queueWait;
+    std::atomic<std::int64_t> firstTransfer {-1};              ///< In microseconds; -1 until the first transfer.
+};
+
+#endif // METRICS_HPP
@@ -1,10 +1,346 @@
 #include "network.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
 #include <curl/curl.h>
 #include <format>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <utility>
+
+namespace {
+std::atomic<std::uint64_t> nextPoolId {1};
+
+/**
+ * @brief Returns the `scheme://host[:port]` prefix of a URL without copying it.
+ */
+std::string_view endpointView(std::string_view url) {
+    const auto scheme = url.find("://");
+    const auto start = scheme == std::string_view::npos ? 0 : scheme + 3;
+    const auto end = url.find_first_of("/?#", start);
+    return url.substr(0, end);
+}
+
+constexpr std::size_t MAX_PRESIZE = 64 << 20;   ///< Largest `Content-Length` reserved before the body arrives.
+
+thread_local TransferError lastTransferError = TransferError::None;              ///< Outcome of the thread's last transfer.
+thread_local std::optional<DeadlineScope::Clock::time_point> threadDeadline;     ///< Innermost DeadlineScope of the thread.
+thread_local TransferInfo lastTransferInfo;                                      ///< Timings of the thread's last transfer.
+
+/**
+ * @brief Reads one of curl's transfer timers.
+ */
+std::chrono::microseconds transferTime(CURL* curl, CURLINFO info) {
+    curl_off_t micros = 0;
+    curl_easy_getinfo(curl, info, &micros);
+    return std::chrono::microseconds(micros);
+}
+
+/**
+ * @brief Maps a curl result to the failure classes callers act on.
+ */
+TransferError classify(CURL* curl, CURLcode res) {
+    switch (res) {
+    case CURLE_OK:
+        return TransferError::None;
+    case CURLE_COULDNT_RESOLVE_PROXY:
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_CONNECT:
+        return TransferError::ConnectFailed;
+    case CURLE_WRITE_ERROR:
+    case CURLE_ABORTED_BY_CALLBACK:
+        return TransferError::Aborted;
+    case CURLE_OPERATION_TIMEDOUT: {
+        // A connect timeout fires before any byte of the request went out.
+        long requestSize = 0;
+        curl_easy_getinfo(curl, CURLINFO_REQUEST_SIZE, &requestSize);
+        return requestSize == 0 ? TransferError::ConnectFailed : TransferError::TimedOut;
+    }
+    default:
+        return TransferError::Failed;
+    }
+}
+
+/**
+ * @brief Returns a curl header list for `headers`, reusing the one built for the previous request of this thread.
+ *
+ * Every request of a client carries the same headers, so in steady state no list is built
+ * or freed. The list stays valid until the thread's next call.
+ */
+curl_slist* threadHeaderList(const std::map<std::string, std::string>& headers) {
+    struct Cache {
+        std::map<std::string, std::string> headers;
+        curl_slist* list = nullptr;
+        ~Cache() { curl_slist_free_all(list); }
+    };
+    thread_local Cache cache;
+
+    if (cache.list && cache.headers == headers) return cache.list;
+    curl_slist_free_all(cache.list);
+    cache.list = nullptr;
+    cache.headers = headers;
+    std::string line;
+    for (const auto& [key, value] : headers) {
+        line.assign(key).append(": ").append(value);
+        cache.list = curl_slist_append(cache.list, line.c_str());
+    }
+    return cache.list;
+}
+}
+
+/**
+ * @brief The slots of one thread, for every pool and endpoint it used.
+ *
+ * Destroyed at thread exit, when the parked handles go back to their pools.
+ */
+struct ConnectionPool::ThreadCache {
+    struct Entry {
+        std::uint64_t poolId;
+        std::string endpoint;
+        std::weak_ptr<State> state;
+        std::shared_ptr<ThreadSlot> slot;
+    };
+
+    std::vector<Entry> entries;
+
+    ~ThreadCache() {
+        for (Entry& entry : entries) retire(entry);
+    }
+
+    static void retire(Entry& entry) {
+        std::shared_ptr<State> owner = entry.state.lock();
+        CURL* handle = entry.slot->handle.exchange(nullptr);
+        if (!owner) {
+            if (handle) curl_easy_cleanup(handle);
+            return;
+        }
+        {
+            std::lock_guard lock(owner->mutex);
+            // A destroyed pool has already cleaned up the handles it could reach.
+            if (!owner->closed) {
+                Endpoint& endpoint = *entry.slot->endpoint;
+                std::erase(endpoint.slots, entry.slot);
+                if (handle) endpoint.idle.push_back({handle, Clock::now()});
+                handle = nullptr;
+            }
+        }
+        if (handle) curl_easy_cleanup(handle);
+        owner->handleReleased.notify_one();
+    }
+
+    /**
+     * @brief Drops the entries of pools that no longer exist.
+     */
+    void prune() {
+        std::erase_if(entries, [](Entry& entry) {
+            if (!entry.state.expired()) return false;
+            if (CURL* handle = entry.slot->handle.exchange(nullptr)) curl_easy_cleanup(handle);
+            return true;
+        });
+    }
+};
+
+ConnectionPool::Lease::Lease(ConnectionPool* owner, ThreadSlot* slot, CURL* handle)
+    : owner(owner), slot(slot), handle(handle) {}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : owner(std::exchange(other.owner, nullptr)),
+    slot(std::exchange(other.slot, nullptr)),
+    handle(std::exchange(other.handle, nullptr)) {}
+
+ConnectionPool::Lease& ConnectionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        owner = std::exchange(other.owner, nullptr);
+        slot = std::exchange(other.slot, nullptr);
+        handle = std::exchange(other.handle, nullptr);
+    }
+    return *this;
+}
+
+ConnectionPool::Lease::~Lease() {
+    release();
+}
+
+void ConnectionPool::Lease::release() {
+    if (owner && handle) owner->release(slot, handle, true);
+    owner = nullptr;
+    handle = nullptr;
+}
+
+void ConnectionPool::Lease::discard() {
+    if (owner && handle) owner->release(slot, handle, false);
+    owner = nullptr;
+    handle = nullptr;
+}
+
+ConnectionPool::State::State() {
+    Network::globalInit();
+    if ((share = curl_share_init())) {
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, &ConnectionPool::lockShare);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, &ConnectionPool::unlockShare);
+        curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    }
+}
+
+ConnectionPool::State::~State() {
+    // Every handle is gone by now: the pool and the thread caches clean up the ones they hold.
+    if (share) curl_share_cleanup(share);
+}
+
+void ConnectionPool::lockShare(CURL*, curl_lock_data data, curl_lock_access, void* state) {
+    static_cast<State*>(state)->shareLocks[data].lock();
+}
+
+void ConnectionPool::unlockShare(CURL*, curl_lock_data data, void* state) {
+    static_cast<State*>(state)->shareLocks[data].unlock();
+}
+
+ConnectionPool::ConnectionPool(const PoolSettings& settings)
+    : poolSettings(settings), poolId(nextPoolId.fetch_add(1)), state(std::make_shared<State>()) {
+    if (poolSettings.maxConnections == 0) poolSettings.maxConnections = 1;
+}
+
+ConnectionPool::~ConnectionPool() {
+    std::lock_guard lock(state->mutex);
+    state->closed = true;
+    for (auto& [key, endpoint] : state->endpoints) {
+        for (auto& idle : endpoint->idle) curl_easy_cleanup(idle.handle);
+        endpoint->idle.clear();
+        for (auto& slot : endpoint->slots) {
+            if (CURL* handle = slot->handle.exchange(nullptr)) curl_easy_cleanup(handle);
+        }
+    }
+}
+
+std::string ConnectionPool::endpointOf(const std::string& url) {
+    return std::string(endpointView(url));
+}
+
+void ConnectionPool::evictExpired(Endpoint& endpoint, Clock::time_point now) {
+    // Idle handles are kept in release order, so the expired ones are at the front.
+    auto firstFresh = endpoint.idle.begin();
+    while (firstFresh != endpoint.idle.end() && now - firstFresh->lastUsed > poolSettings.idleTimeout) {
+        curl_easy_cleanup(firstFresh->handle);
+        --endpoint.total;
+        ++firstFresh;
+    }
+    endpoint.idle.erase(endpoint.idle.begin(), firstFresh);
+}
+
+ConnectionPool::ThreadSlot& ConnectionPool::threadSlot(const std::string& url) {
+    thread_local ThreadCache cache;
+    const std::string_view key = endpointView(url);
+    for (const ThreadCache::Entry& entry : cache.entries) {
+        if (entry.poolId == poolId && entry.endpoint == key) return *entry.slot;
+    }
+
+    // First request of this thread to this endpoint.
+    cache.prune();
+    auto slot = std::make_shared<ThreadSlot>();
+    {
+        std::lock_guard lock(state->mutex);
+        std::unique_ptr<Endpoint>& endpoint = state->endpoints[std::string(key)];
+        if (!endpoint) endpoint = std::make_unique<Endpoint>();
+        slot->endpoint = endpoint.get();
+        endpoint->slots.push_back(slot);
+    }
+    cache.entries.push_back({poolId, std::string(key), state, slot});
+    return *slot;
+}
+
+CURL* ConnectionPool::acquireShared(Endpoint& endpoint, bool& fresh) {
+    CURL* handle = nullptr;
+    const auto take = [&] {
+        evictExpired(endpoint, Clock::now());
+        if (!endpoint.idle.empty()) {
+            handle = endpoint.idle.back().handle;
+            endpoint.idle.pop_back();
+            return true;
+        }
+        if (endpoint.total < poolSettings.maxConnections) {
+            ++endpoint.total;
+            fresh = true;
+            return true;
+        }
+        // At the limit: reclaim a handle parked by another thread.
+        for (const auto& other : endpoint.slots) {
+            if ((handle = other->handle.exchange(nullptr))) return true;
+        }
+        return false;
+    };
+
+    std::unique_lock lock(state->mutex);
+    if (!take()) {
+        // Registering as a waiter before re-scanning the slots pairs with the check in release():
+        // either the releasing thread sees the waiter, or the waiter sees the parked handle.
+        state->waiters.fetch_add(1);
+        state->handleReleased.wait(lock, take);
+        state->waiters.fetch_sub(1);
+    }
+    return handle;
+}
+
+ConnectionPool::Lease ConnectionPool::acquire(const std::string& url) {
+    ThreadSlot& slot = threadSlot(url);
+
+    bool fresh = false;
+    CURL* handle = slot.handle.exchange(nullptr);
+    if (!handle) handle = acquireShared(*slot.endpoint, fresh);
+
+    if (!fresh) {
+        curl_easy_reset(handle);
+    } else if (!(handle = curl_easy_init())) {
+        release(&slot, nullptr, false);
+        return {};
+    } else if (state->share) {
+        // `curl_easy_reset` keeps the share, so a handle joins it once.
+        curl_easy_setopt(handle, CURLOPT_SHARE, state->share);
+    }
+
+    // Keep the connection warm while it sits in the pool, and let curl drop it
+    // by itself once it has been idle for longer than the pool would keep it.
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_MAXAGE_CONN, static_cast<long>(poolSettings.idleTimeout.count()));
+    // Timeouts must not rely on signals in a multi-threaded process.
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    return Lease(this, &slot, handle);
+}
+
+void ConnectionPool::release(ThreadSlot* slot, CURL* handle, bool reusable) {
+    if (handle && reusable) {
+        // Park the handle for the next request of this thread, unless a nested lease already did.
+        CURL* empty = nullptr;
+        if (slot->handle.compare_exchange_strong(empty, handle)) {
+            if (state->waiters.load() != 0) {
+                // Wake a blocked thread so it can reclaim the handle just parked.
+                { std::lock_guard lock(state->mutex); }
+                state->handleReleased.notify_all();
+            }
+            return;
+        }
+    }
+    {
+        std::lock_guard lock(state->mutex);
+        Endpoint& endpoint = *slot->endpoint;
+        if (handle && reusable) {
+            endpoint.idle.push_back({handle, Clock::now()});
+        } else {
+            if (handle) curl_easy_cleanup(handle);
+            --endpoint.total;
+        }
+    }
+    state->handleReleased.notify_one();
+}
+
+Network::Network(const PoolSettings& settings)
+    : pool(std::make_shared<ConnectionPool>(settings)) {}
+
+Network::Network(std::shared_ptr<ConnectionPool> sharedPool)
+    : pool(std::move(sharedPool)) {}
 
 std::string Network::buildQueryString(const std::map<std::string, std::string>& params) const {
-    std::shared_lock lock(networkMutex);
     std::string queryString;
     for (const auto& [key, value] : params) {
         queryString += std::format("{}={}&", key, value);
@@ -19,25 +355,166 @@ size_t Network::WriteCallback(void* contents, size_t size, size_t nmemb, std::st
     return totalSize;
 }
 
+std::string_view describeTransferError(TransferError error) {
+    switch (error) {
+    case TransferError::None: return "no error";
+    case TransferError::ConnectFailed: return "could not connect";
+    case TransferError::TimedOut: return "timed out";
+    case TransferError::Aborted: return "aborted by the receiver";
+    case TransferError::CircuitOpen: return "endpoint circuit open";
+    case TransferError::Failed: break;
+    }
+    return "transfer failed";
+}
+
+DeadlineScope::DeadlineScope(Clock::time_point deadline)
+    : previous(threadDeadline) {
+    if (!threadDeadline || deadline < *threadDeadline) threadDeadline = deadline;
+}
+
+DeadlineScope::~DeadlineScope() {
+    threadDeadline = previous;
+}
+
+std::optional<DeadlineScope::Clock::time_point> DeadlineScope::current() {
+    return threadDeadline;
+}
+
+std::chrono::milliseconds DeadlineScope::limit(std::chrono::milliseconds timeout) {
+    if (!threadDeadline) return timeout;
+    const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(*threadDeadline - Clock::now());
+    if (remaining.count() <= 0) return std::chrono::milliseconds(-1);
+    return timeout.count() == 0 ? remaining : std::min(timeout, remaining);
+}
+
+TransferError Network::lastError() {
+    return lastTransferError;
+}
+
+void Network::applyTransport(CURL* curl, const TransportSettings& settings) {
+    // An empty string advertises every encoding this libcurl build can decode.
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, settings.compression ? "" : nullptr);
+
+    long version = CURL_HTTP_VERSION_NONE;
+    switch (settings.httpVersion) {
+    case HttpVersion::Default: break;
+    case HttpVersion::Http1: version = CURL_HTTP_VERSION_1_1; break;
+    case HttpVersion::Http2Tls: version = CURL_HTTP_VERSION_2TLS; break;
+    case HttpVersion::Http2PriorKnowledge: version = CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE; break;
+    }
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, version);
+
+    if (settings.unixSocket.empty()) return;
+    // libcurl copies the path; pooled handles are reset before every transfer, which clears it again.
+    if (settings.unixSocket.front() == '@') {
+        curl_easy_setopt(curl, CURLOPT_ABSTRACT_UNIX_SOCKET, settings.unixSocket.c_str() + 1);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_UNIX_SOCKET_PATH, settings.unixSocket.c_str());
+    }
+}
+
+bool Network::globalInit() {
+    static const bool initialized = curl_global_init(CURL_GLOBAL_DEFAULT) == CURLE_OK;
+    return initialized;
+}
+
+bool Network::supportsHttp2() {
+    return (curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP2) != 0;
+}
+
+bool Network::supportsUnixSockets() {
+    return (curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_UNIX_SOCKETS) != 0;
+}
+
+bool Network::prepareTransfer(CURL* curl) const {
+    applyTransport(curl, transferSettings);
+    const std::chrono::milliseconds total = DeadlineScope::limit(requestTimeouts.total);
+    if (total.count() < 0) {
+        lastTransferError = TransferError::TimedOut;
+        Logger::error("Request deadline expired before the transfer started");
+        return false;
+    }
+    std::chrono::milliseconds connect = requestTimeouts.connect;
+    if (total.count() > 0 && (connect.count() == 0 || connect > total)) connect = total;
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(connect.count()));
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(total.count()));
+    return true;
+}
+
+const TransferInfo& Network::lastTransfer() {
+    return lastTransferInfo;
+}
+
+ConnectionPool::Lease Network::acquire(const std::string& url) {
+    const auto start = std::chrono::steady_clock::now();
+    ConnectionPool::Lease lease = pool->acquire(url);
+    lastTransferInfo = TransferInfo {};
+    lastTransferInfo.poolWait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    return lease;
+}
+
+CURLcode Network::perform(CURL* curl) const {
+    const CURLcode res = curl_easy_perform(curl);
+    lastTransferError = classify(curl, res);
+
+    // Timers are cumulative from the start of the transfer; a reused connection has no connect phase.
+    TransferInfo& info = lastTransferInfo;
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    info.reused = connects == 0;
+    info.connect = info.reused ? std::chrono::microseconds(0)
+                               : std::max(transferTime(curl, CURLINFO_CONNECT_TIME_T), transferTime(curl, CURLINFO_APPCONNECT_TIME_T));
+    const std::chrono::microseconds firstByte = transferTime(curl, CURLINFO_STARTTRANSFER_TIME_T);
+    if (firstByte.count() > 0) info.serverTime = firstByte - transferTime(curl, CURLINFO_PRETRANSFER_TIME_T);
+    info.total = transferTime(curl, CURLINFO_TOTAL_TIME_T);
+    if (metrics) metrics->recordTransfer(info);
+    return res;
+}
+
+size_t Network::PresizeCallback(char* buffer, size_t size, size_t nitems, std::string* outBuffer) {
+    const size_t totalSize = size * nitems;
+    constexpr std::string_view NAME = "content-length:";
+    const std::string_view line(buffer, totalSize);
+    if (line.size() <= NAME.size()) return totalSize;
+    for (std::size_t i = 0; i < NAME.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(line[i])) != NAME[i]) return totalSize;
+    }
+
+    std::string_view value = line.substr(NAME.size());
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+    std::size_t length = 0;
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), length);
+    if (error == std::errc() && end != value.data()) {
+        outBuffer->reserve(outBuffer->size() + std::min(length, MAX_PRESIZE));
+    }
+    return totalSize;
+}
+
 bool Network::sendRequest(const std::string& url, std::string& response, bool verbose) {
-    std::shared_lock lock(networkMutex);
-    Logger::formattedInfo("Constructed URL: {}", url);
+    Logger::formattedDebug("Constructed URL: {}", url);
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
+    ConnectionPool::Lease lease = acquire(url);
+    if (!lease) {
         Logger::error("Failed to initialize CURL");
         return false;
     }
+    CURL* curl = lease.get();
 
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, PresizeCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response);
     if (verbose) curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+    if (!prepareTransfer(curl)) return false;
 
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_cleanup(curl);
+    CURLcode res = perform(curl);
+    // The handle goes back to the pool; it must not keep a pointer to `response`.
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, nullptr);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, nullptr);
 
     if (res != CURLE_OK) {
+        lease.discard();
         Logger::formattedError("CURL error: {}", curl_easy_strerror(res));
         return false;
     }
@@ -45,51 +522,64 @@ bool Network::sendRequest(const std::string& url, std::string& response, bool ve
     return true;
 }
 
-bool Network::sendPostRequest(
-    const std::string& url,
-    const std::string& postData,
-    std::string& response,
-    const std::string& user,
-    const std::string& password,
-    const std::map<std::string, std::string>& headers,
-    bool verbose
-    ) {
-    std::shared_lock lock(networkMutex);
-    Logger::formattedInfo("Sending POST request to: {}", url);
+bool Network::streamGetRequest(const std::string& url, const DataCallback& onData, bool verbose) {
+    Logger::formattedDebug("Streaming GET request to: {}", url);
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
+    ConnectionPool::Lease lease = acquire(url);
+    if (!lease) {
         Logger::error("Failed to initialize CURL");
         return false;
     }
+    CURL* curl = lease.get();
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, StreamCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, const_cast<DataCallback*>(&onData));
+    if (verbose) curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+    if (!prepareTransfer(curl)) return false;
+
+    CURLcode res = perform(curl);
+
+    if (res != CURLE_OK) {
+        // An HTTP error status leaves the connection usable; anything else may not.
+        if (res != CURLE_HTTP_RETURNED_ERROR) lease.discard();
+        Logger::formattedError("CURL error: {}", curl_easy_strerror(res));
+        return false;
+    }
+
+    return true;
+}
 
+size_t Network::StreamCallback(void* contents, size_t size, size_t nmemb, DataCallback* onData) {
+    size_t totalSize = size * nmemb;
+    return (*onData)(std::string_view(static_cast<const char*>(contents), totalSize)) ? totalSize : 0;
+}
+
+bool Network::performPost(CURL* curl, const std::string& url, const std::string& postData,
+                          const std::string& user, const std::string& password,
+                          const std::map<std::string, std::string>& headers, bool verbose) {
     // Set URL and authentication
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     if (!user.empty() || !password.empty()) {
-        curl_easy_setopt(curl, CURLOPT_USERPWD, (user + ":" + password).c_str());
+        curl_easy_setopt(curl, CURLOPT_USERNAME, user.c_str());
+        curl_easy_setopt(curl, CURLOPT_PASSWORD, password.c_str());
     }
 
     // Set POST data
     curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postData.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(postData.size()));
 
     // Set headers
-    struct curl_slist* curlHeaders = nullptr;
-    for (const auto& [key, value] : headers) {
-        curlHeaders = curl_slist_append(curlHeaders, (key + ": " + value).c_str());
-    }
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, curlHeaders);
-
-    // Set callback for response
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, threadHeaderList(headers));
 
     // Enable verbose output if requested
     if (verbose) curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
 
     // Perform the request
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(curlHeaders); // Free headers
-    curl_easy_cleanup(curl);
+    CURLcode res = perform(curl);
+    // The header list belongs to this thread; the handle goes back to the pool.
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
 
     if (res != CURLE_OK) {
         Logger::formattedError("CURL error: {}", curl_easy_strerror(res));
@@ -98,3 +588,66 @@ bool Network::sendPostRequest(
 
     return true;
 }
+
+bool Network::sendPostRequest(
+    const std::string& url,
+    const std::string& postData,
+    std::string& response,
+    const std::string& user,
+    const std::string& password,
+    const std::map<std::string, std::string>& headers,
+    bool verbose
+    ) {
+    Logger::formattedDebug("Sending POST request to: {}", url);
+
+    ConnectionPool::Lease lease = acquire(url);
+    if (!lease) {
+        Logger::error("Failed to initialize CURL");
+        return false;
+    }
+
+    // Set callback for response
+    curl_easy_setopt(lease.get(), CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(lease.get(), CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(lease.get(), CURLOPT_HEADERFUNCTION, PresizeCallback);
+    curl_easy_setopt(lease.get(), CURLOPT_HEADERDATA, &response);
+
+    if (!prepareTransfer(lease.get())) return false;
+    const bool success = performPost(lease.get(), url, postData, user, password, headers, verbose);
+    curl_easy_setopt(lease.get(), CURLOPT_HEADERFUNCTION, nullptr);
+    curl_easy_setopt(lease.get(), CURLOPT_HEADERDATA, nullptr);
+    if (!success) {
+        lease.discard();
+        return false;
+    }
+    return true;
+}
+
+bool Network::streamPostRequest(
+    const std::string& url,
+    const std::string& postData,
+    const DataCallback& onData,
+    const std::string& user,
+    const std::string& password,
+    const std::map<std::string, std::string>& headers,
+    bool verbose
+    ) {
+    Logger::formattedDebug("Streaming POST request to: {}", url);
+
+    ConnectionPool::Lease lease = acquire(url);
+    if (!lease) {
+        Logger::error("Failed to initialize CURL");
+        return false;
+    }
+
+    // Set callback for response
+    curl_easy_setopt(lease.get(), CURLOPT_WRITEFUNCTION, StreamCallback);
+    curl_easy_setopt(lease.get(), CURLOPT_WRITEDATA, const_cast<DataCallback*>(&onData));
+    if (!prepareTransfer(lease.get())) return false;
+
+    if (!performPost(lease.get(), url, postData, user, password, headers, verbose)) {
+        lease.discard();
+        return false;
+    }
+    return true;
+}
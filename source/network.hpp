@@ -2,24 +2,310 @@
 #define NETWORK_HPP
 
 #include <string>
+#include <array>
 #include <map>
-#include <shared_mutex>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <curl/curl.h>
+
+/**
+ * @struct PoolSettings
+ * @brief Tunables for the keep-alive connection pool used by `Network`.
+ */
+struct PoolSettings {
+    std::size_t maxConnections = 8;          ///< Maximum number of CURL handles per endpoint.
+    std::chrono::seconds idleTimeout {60};   ///< Idle handles (and their connections) older than this are closed.
+};
+
+/**
+ * @struct RequestTimeouts
+ * @brief Time limits applied to every transfer of a `Network`.
+ */
+struct RequestTimeouts {
+    std::chrono::milliseconds connect {10000};  ///< Limit for establishing a connection; 0 uses curl's default (300 s).
+    std::chrono::milliseconds total {0};        ///< Limit for a whole transfer; 0 means none.
+};
+
+/**
+ * @enum HttpVersion
+ * @brief The HTTP version asked for when connecting.
+ */
+enum class HttpVersion : std::uint8_t {
+    Default,                ///< Whatever libcurl prefers.
+    Http1,                  ///< HTTP/1.1 only.
+    Http2Tls,               ///< HTTP/2 over TLS when the server offers it (ALPN), HTTP/1.1 otherwise.
+    Http2PriorKnowledge     ///< HTTP/2 without upgrade (h2c), for proxies known to speak it on plain TCP.
+};
+
+/**
+ * @struct TransportSettings
+ * @brief Wire-level options applied to every transfer of a `Network`.
+ *
+ * All options are meant for nodes reached through a proxy: bitcoind itself neither
+ * compresses responses nor speaks HTTP/2, and it only listens on TCP. A proxy on the same
+ * host, such as nginx or socat, can accept requests on a Unix domain socket and forward
+ * them to the node's RPC port.
+ */
+struct TransportSettings {
+    bool compression = false;                       ///< Ask for every content encoding libcurl can decode (gzip, deflate, br, zstd).
+    HttpVersion httpVersion = HttpVersion::Default; ///< HTTP version to negotiate.
+    std::string unixSocket;                         ///< Socket to connect to instead of the URL's host, which still names the `Host` header; `@name` is a Linux abstract socket. Empty uses TCP.
+};
+
+/**
+ * @enum TransferError
+ * @brief Why the last transfer of a thread failed.
+ */
+enum class TransferError : std::uint8_t {
+    None,           ///< The transfer succeeded.
+    ConnectFailed,  ///< No connection was made, so nothing reached the server; safe to retry any request.
+    TimedOut,       ///< A timeout or the deadline expired after the request may have been sent.
+    Aborted,        ///< The response consumer stopped the transfer.
+    CircuitOpen,    ///< Refused without sending, because the endpoint is failing (see CircuitBreaker).
+    Failed          ///< Any other failure.
+};
+
+/**
+ * @struct TransferInfo
+ * @brief Timings of one HTTP transfer, as reported by `Network::lastTransfer()`.
+ */
+struct TransferInfo {
+    std::chrono::microseconds poolWait {0};     ///< Time spent acquiring a pooled handle.
+    std::chrono::microseconds connect {0};      ///< Connection setup, TLS included; 0 for a reused connection.
+    std::chrono::microseconds serverTime {0};   ///< From the request being sent to the first response byte.
+    std::chrono::microseconds total {0};        ///< The whole transfer, pool wait excluded.
+    bool reused = false;                        ///< The transfer went over a kept-alive connection.
+};
+
+class Metrics;
+
+/**
+ * @brief Returns a short description of a transfer error, for logs and error messages.
+ */
+std::string_view describeTransferError(TransferError error);
+
+/**
+ * @class DeadlineScope
+ * @brief Bounds every request made by the current thread while the scope is alive.
+ *
+ * The deadline is propagated rather than passed around: transfers, retries and backoff
+ * waits started inside the scope, however deep in the call stack, give up once it has
+ * passed. Nested scopes can only shorten the deadline, never extend it.
+ *
+ * @code
+ * DeadlineScope deadline(std::chrono::milliseconds(250));
+ * Json::Value fee = client.estimateSmartFee(6);   // Null if no answer within 250 ms.
+ * @endcode
+ */
+class DeadlineScope {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Sets a deadline `budget` from now.
+     */
+    explicit DeadlineScope(Clock::duration budget) : DeadlineScope(Clock::now() + budget) {}
+
+    /**
+     * @brief Sets an absolute deadline.
+     */
+    explicit DeadlineScope(Clock::time_point deadline);
+    DeadlineScope(const DeadlineScope&) = delete;
+    DeadlineScope& operator=(const DeadlineScope&) = delete;
+
+    /**
+     * @brief Restores the enclosing deadline.
+     */
+    ~DeadlineScope();
+
+    /**
+     * @brief Returns the deadline of the current thread, if any.
+     */
+    static std::optional<Clock::time_point> current();
+
+    /**
+     * @brief Combines a per-transfer timeout with the current deadline.
+     * @param timeout The configured limit; 0 means none.
+     * @return The limit to apply (0 for none), or a negative value if the deadline has already passed.
+     */
+    static std::chrono::milliseconds limit(std::chrono::milliseconds timeout);
+
+private:
+    std::optional<Clock::time_point> previous;  ///< The enclosing deadline, restored on destruction.
+};
+
+/**
+ * @class ConnectionPool
+ * @brief A bounded pool of reusable CURL easy handles, grouped per endpoint.
+ *
+ * A CURL easy handle keeps its TCP connection (and DNS cache) alive between transfers,
+ * so reusing handles lets consecutive requests to the same node skip the TCP handshake
+ * and slow start. Handles are checked out with `acquire()` and returned automatically
+ * when the returned `Lease` goes out of scope. When all handles of an endpoint are in
+ * use, `acquire()` blocks until one is released.
+ *
+ * Each thread keeps the handle it used last for an endpoint in a slot of its own, so a
+ * thread issuing request after request takes and returns its handle with one uncontended
+ * atomic exchange and never touches the pool lock. The lock is only taken to create
+ * handles, to take them from the shared idle list, or to reclaim handles parked in the
+ * slots of other threads once the endpoint is at its limit. Parked handles are returned
+ * to the pool when their thread exits.
+ *
+ * The handles of a pool share one DNS cache, so a host is resolved once per pool rather
+ * than once per handle.
+ */
+class ConnectionPool {
+private:
+    struct Endpoint;
+    struct ThreadSlot;
+
+public:
+    /**
+     * @class Lease
+     * @brief RAII ownership of a pooled CURL handle for the duration of one request.
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(ConnectionPool* owner, ThreadSlot* slot, CURL* handle);
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        /**
+         * @brief Returns the leased handle, or nullptr if the lease is empty.
+         */
+        CURL* get() const { return handle; }
+
+        /**
+         * @brief Checks whether the lease holds a handle.
+         */
+        explicit operator bool() const { return handle != nullptr; }
+
+        /**
+         * @brief Drops the handle instead of returning it to the pool.
+         *
+         * Used after transport errors, where the underlying connection is in an unknown state.
+         */
+        void discard();
+
+    private:
+        void release();
+
+        ConnectionPool* owner = nullptr;
+        ThreadSlot* slot = nullptr;
+        CURL* handle = nullptr;
+    };
+
+    /**
+     * @brief Constructs a pool with the given limits.
+     * @param settings Pool size and idle timeout.
+     */
+    explicit ConnectionPool(const PoolSettings& settings = {});
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+    ~ConnectionPool();
+
+    /**
+     * @brief Checks out a handle for the endpoint of the given URL.
+     *
+     * The handle has been reset with `curl_easy_reset`, which clears all options
+     * but keeps the live connection cache. Thread-safe.
+     *
+     * @param url The request URL; handles are shared by all URLs with the same scheme, host and port.
+     * @return A lease owning the handle; empty if a new handle could not be created.
+     */
+    Lease acquire(const std::string& url);
+
+    /**
+     * @brief Returns the settings the pool was created with.
+     */
+    const PoolSettings& settings() const { return poolSettings; }
+
+    /**
+     * @brief Extracts the endpoint key (`scheme://host[:port]`) from a URL.
+     */
+    static std::string endpointOf(const std::string& url);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct IdleHandle {
+        CURL* handle;
+        Clock::time_point lastUsed;
+    };
+
+    /**
+     * @brief A handle parked by one thread for one endpoint; empty while leased or reclaimed.
+     */
+    struct ThreadSlot {
+        std::atomic<CURL*> handle {nullptr};
+        Endpoint* endpoint = nullptr;
+    };
+
+    struct Endpoint {
+        std::vector<IdleHandle> idle;                       ///< Handles ready for reuse, most recently used last.
+        std::size_t total = 0;                              ///< Idle, parked and leased handles.
+        std::vector<std::shared_ptr<ThreadSlot>> slots;     ///< Slots of the threads that used this endpoint.
+    };
+
+    /**
+     * @brief The state shared with the per-thread caches, which may outlive the pool.
+     */
+    struct State {
+        State();
+        ~State();
+
+        std::mutex mutex;                                                   ///< Guards everything but `waiters`.
+        std::condition_variable handleReleased;                             ///< Signals handles returned to the idle list.
+        std::unordered_map<std::string, std::unique_ptr<Endpoint>> endpoints;
+        std::atomic<std::size_t> waiters {0};                               ///< Threads blocked in `acquire()`.
+        bool closed = false;                                                ///< The pool was destroyed.
+        CURLSH* share = nullptr;                                            ///< DNS cache shared by the pool's handles.
+        std::array<std::mutex, CURL_LOCK_DATA_LAST> shareLocks;             ///< Guard the shared data, by `curl_lock_data`.
+    };
+
+    struct ThreadCache;
+
+    ThreadSlot& threadSlot(const std::string& url);
+    CURL* acquireShared(Endpoint& endpoint, bool& fresh);
+    void release(ThreadSlot* slot, CURL* handle, bool reusable);
+    void evictExpired(Endpoint& endpoint, Clock::time_point now);
+    static void lockShare(CURL* handle, curl_lock_data data, curl_lock_access access, void* state);
+    static void unlockShare(CURL* handle, curl_lock_data data, void* state);
+
+    PoolSettings poolSettings;
+    std::uint64_t poolId;                   ///< Identifies the pool in the per-thread caches.
+    std::shared_ptr<State> state;
+};
 
 /**
  * @class Network
  * @brief A thread-safe utility class for handling network requests and query string construction.
  *
  * Provides functionality to send HTTP requests using `libcurl` and to build
- * query strings from key-value parameter pairs. Ensures thread safety with `std::shared_mutex`.
+ * query strings from key-value parameter pairs. Requests are performed on handles
+ * borrowed from a `ConnectionPool`, so connections to the same endpoint are kept alive
+ * and reused. The class holds no other mutable state, so any number of threads may send
+ * requests through one instance at the same time.
  */
 class Network {
 private:
     /**
-     * @brief Mutex for ensuring thread-safe operations in the `Network` class.
-     *
-     * Allows multiple readers but only one writer at a time.
+     * @brief Pool of keep-alive CURL handles shared by all requests of this instance.
      */
-    mutable std::shared_mutex networkMutex;
+    std::shared_ptr<ConnectionPool> pool;
 
     /**
      * @brief Callback function to handle data received from CURL.
@@ -35,6 +321,144 @@ private:
     static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* outBuffer);
 
 public:
+    /**
+     * @brief Header callback that reserves room for the body announced by `Content-Length`.
+     *
+     * Lets the write callback append the whole body without growing the string step by
+     * step. Announced sizes are trusted only up to a limit, so a hostile server cannot make
+     * the client reserve arbitrary amounts of memory.
+     *
+     * @param buffer One header line, not NUL-terminated.
+     * @param size Always 1.
+     * @param nitems Length of the header line.
+     * @param outBuffer The string the body will be written to.
+     * @return The number of bytes consumed (always `size * nitems`).
+     */
+    static size_t PresizeCallback(char* buffer, size_t size, size_t nitems, std::string* outBuffer);
+
+    /**
+     * @brief Receives the response body chunk by chunk as it arrives.
+     * @return `true` to continue the transfer, `false` to abort it.
+     */
+    using DataCallback = std::function<bool(std::string_view chunk)>;
+
+private:
+    /**
+     * @brief Callback function that forwards data received from CURL to a `DataCallback`.
+     * @return The number of bytes consumed; 0 aborts the transfer.
+     */
+    static size_t StreamCallback(void* contents, size_t size, size_t nmemb, DataCallback* onData);
+
+    /**
+     * @brief Applies the transport options and the connect and total limits to a pooled handle.
+     * @return `false` if the deadline has already passed; the transfer must not start.
+     */
+    bool prepareTransfer(CURL* curl) const;
+
+    /**
+     * @brief Checks out a pooled handle for `url`, timing the wait for the thread's TransferInfo.
+     */
+    ConnectionPool::Lease acquire(const std::string& url);
+
+    /**
+     * @brief Performs a prepared transfer and records its outcome as the thread's last error and TransferInfo.
+     * @return The result of `curl_easy_perform`.
+     */
+    CURLcode perform(CURL* curl) const;
+
+    RequestTimeouts requestTimeouts;        ///< Limits applied to every transfer.
+    TransportSettings transferSettings;     ///< Wire-level options applied to every transfer.
+    std::shared_ptr<Metrics> metrics;       ///< Receives every TransferInfo; null when not collecting.
+
+    /**
+     * @brief Performs a POST on a pooled handle; the body is delivered by the already configured write callback.
+     */
+    bool performPost(CURL* curl, const std::string& url, const std::string& postData,
+                     const std::string& user, const std::string& password,
+                     const std::map<std::string, std::string>& headers, bool verbose);
+
+public:
+    /**
+     * @brief Constructs a Network instance.
+     * @param settings Connection pool settings (default: 8 handles per endpoint, 60 s idle timeout).
+     */
+    explicit Network(const PoolSettings& settings = {});
+
+    /**
+     * @brief Constructs a Network instance that borrows its handles from an existing pool.
+     * @param sharedPool The pool, shared with other instances talking to the same nodes.
+     */
+    explicit Network(std::shared_ptr<ConnectionPool> sharedPool);
+
+    /**
+     * @brief Sets the time limits of all later transfers; must be called before the instance is shared.
+     */
+    void setTimeouts(const RequestTimeouts& timeouts) { requestTimeouts = timeouts; }
+
+    /**
+     * @brief Returns the time limits applied to every transfer.
+     */
+    const RequestTimeouts& timeouts() const { return requestTimeouts; }
+
+    /**
+     * @brief Sets the wire-level options of all later transfers; must be called before the instance is shared.
+     */
+    void setTransportSettings(const TransportSettings& settings) { transferSettings = settings; }
+
+    /**
+     * @brief Returns the wire-level options applied to every transfer.
+     */
+    const TransportSettings& transportSettings() const { return transferSettings; }
+
+    /**
+     * @brief Records the timings of every later transfer in `sink`; must be called before the instance is shared.
+     * @param sink The metrics to feed, or `nullptr` to stop.
+     */
+    void setMetrics(std::shared_ptr<Metrics> sink) { metrics = std::move(sink); }
+
+    /**
+     * @brief Applies wire-level options to a handle.
+     *
+     * With compression enabled, libcurl decodes the body before it reaches the write or
+     * stream callback, so streaming parsers work on compressed responses unchanged.
+     *
+     * @param curl The handle of the next transfer.
+     * @param settings The options.
+     */
+    static void applyTransport(CURL* curl, const TransportSettings& settings);
+
+    /**
+     * @brief Initializes libcurl for the process, once; thread-safe.
+     *
+     * libcurl initializes itself on the first handle created if nobody did, which is not
+     * thread-safe when several threads race to create one. Pools and async engines call
+     * this when they are constructed, so it only has to be called explicitly before other
+     * uses of libcurl. The process never cleans libcurl up.
+     *
+     * @return `false` if the initialization failed.
+     */
+    static bool globalInit();
+
+    /**
+     * @brief Checks whether the linked libcurl can negotiate HTTP/2.
+     */
+    static bool supportsHttp2();
+
+    /**
+     * @brief Checks whether the linked libcurl can connect over Unix domain sockets.
+     */
+    static bool supportsUnixSockets();
+
+    /**
+     * @brief Returns why the calling thread's last transfer failed, or `TransferError::None`.
+     */
+    static TransferError lastError();
+
+    /**
+     * @brief Returns the timings of the calling thread's last transfer.
+     */
+    static const TransferInfo& lastTransfer();
+
     /**
      * @brief Constructs a query string from a map of key-value pairs.
      *
@@ -83,6 +507,52 @@ public:
         const std::string& password = "",
         const std::map<std::string, std::string>& headers = {},
         bool verbose = false);
+
+    /**
+     * @brief Sends an HTTP POST request and streams the response body to a callback.
+     *
+     * Identical to `sendPostRequest`, except that the body is never buffered: every chunk
+     * received by curl is handed to `onData` immediately.
+     *
+     * @param url The URL to which the POST request is sent.
+     * @param postData The data to be sent in the body of the POST request.
+     * @param onData Receives the response body in chunks; returning `false` aborts the transfer.
+     * @param user Optional username for HTTP authentication (default is empty).
+     * @param password Optional password for HTTP authentication (default is empty).
+     * @param headers Optional map of custom HTTP headers to include in the request (default is empty).
+     * @param verbose If true, enables verbose logging for debugging purposes (default is false).
+     * @return bool True if the whole response was received and consumed, false otherwise.
+     */
+    bool streamPostRequest(
+        const std::string& url, const std::string& postData,
+        const DataCallback& onData,
+        const std::string& user = "",
+        const std::string& password = "",
+        const std::map<std::string, std::string>& headers = {},
+        bool verbose = false);
+
+    /**
+     * @brief Sends an HTTP GET request and streams the response body to a callback.
+     *
+     * Unlike `sendRequest`, HTTP error statuses (4xx, 5xx) are reported as failures,
+     * and their bodies are not passed to `onData`.
+     *
+     * @param url The full URL to which the request will be sent.
+     * @param onData Receives the response body in chunks; returning `false` aborts the transfer.
+     * @param verbose If true, enables verbose logging for debugging purposes (default is false).
+     * @return bool True if the whole response was received and consumed, false otherwise.
+     */
+    bool streamGetRequest(const std::string& url, const DataCallback& onData, bool verbose = false);
+
+    /**
+     * @brief Returns the connection pool used by this instance.
+     */
+    ConnectionPool& connectionPool() { return *pool; }
+
+    /**
+     * @brief Returns the connection pool, for other instances to share.
+     */
+    const std::shared_ptr<ConnectionPool>& sharedPool() const { return pool; }
 };
 
 #endif // NETWORK_HPP
@@ -0,0 +1,190 @@
+#include "rawblock.hpp"
+#include "hexcodec.hpp"
+#include <cstring>
+
+namespace {
+constexpr std::size_t HEADER_SIZE = 80;
+constexpr std::size_t MIN_INPUT_SIZE = 32 + 4 + 1 + 4;     ///< Outpoint, empty script and sequence.
+constexpr std::size_t MIN_OUTPUT_SIZE = 8 + 1;             ///< Value and empty script.
+constexpr std::size_t MIN_TX_SIZE = 4 + 1 + 1 + 4;         ///< Version, two empty counts and lock time.
+}
+
+bool ByteReader::take(std::size_t count) {
+    if (failedState || data.size() - offset < count) {
+        failedState = true;
+        return false;
+    }
+    return true;
+}
+
+std::uint8_t ByteReader::readU8() {
+    if (!take(1)) return 0;
+    return data[offset++];
+}
+
+std::uint32_t ByteReader::readU32() {
+    if (!take(4)) return 0;
+    const std::uint8_t* p = data.data() + offset;
+    offset += 4;
+    return std::uint32_t(p[0]) | std::uint32_t(p[1]) << 8 | std::uint32_t(p[2]) << 16 | std::uint32_t(p[3]) << 24;
+}
+
+std::uint64_t ByteReader::readU64() {
+    const std::uint64_t low = readU32();
+    const std::uint64_t high = readU32();
+    return low | high << 32;
+}
+
+Hash256 ByteReader::readHash() {
+    Hash256 hash {};
+    if (!take(hash.size())) return hash;
+    std::memcpy(hash.data(), data.data() + offset, hash.size());
+    offset += hash.size();
+    return hash;
+}
+
+std::uint64_t ByteReader::readCompactSize(std::uint64_t limit) {
+    const std::uint8_t first = readU8();
+    std::uint64_t value = first;
+    std::uint64_t minimum = 0;
+    if (first == 0xfd) {
+        if (!take(2)) return 0;
+        value = std::uint64_t(data[offset]) | std::uint64_t(data[offset + 1]) << 8;
+        offset += 2;
+        minimum = 0xfd;
+    } else if (first == 0xfe) {
+        value = readU32();
+        minimum = 0x10000;
+    } else if (first == 0xff) {
+        value = readU64();
+        minimum = 0x100000000ULL;
+    }
+    // Bitcoin Core rejects non-canonical encodings.
+    if (failedState || value < minimum || value > limit) {
+        failedState = true;
+        return 0;
+    }
+    return value;
+}
+
+ByteSpan ByteReader::readBytes(std::size_t count) {
+    if (!take(count)) return {};
+    ByteSpan bytes = data.subspan(offset, count);
+    offset += count;
+    return bytes;
+}
+
+bool parseBlockHeader(ByteReader& reader, BlockHeaderView& header) {
+    const std::size_t begin = reader.position();
+    header.version = reader.readI32();
+    header.prevBlock = reader.readHash();
+    header.merkleRoot = reader.readHash();
+    header.time = reader.readU32();
+    header.bits = reader.readU32();
+    header.nonce = reader.readU32();
+    if (reader.failed()) return false;
+    header.raw = reader.since(begin);
+    return true;
+}
+
+bool parseTransaction(ByteReader& reader, TxView& tx) {
+    const std::size_t begin = reader.position();
+    tx.version = reader.readI32();
+
+    // An empty input list followed by a non-zero flag byte is the segwit marker.
+    std::size_t ioBegin = reader.position();
+    std::uint64_t inputCount = reader.readCompactSize(reader.remaining() / MIN_INPUT_SIZE);
+    std::uint8_t flags = 0;
+    if (inputCount == 0 && !reader.failed()) {
+        flags = reader.readU8();
+        if (flags != 0) {
+            ioBegin = reader.position();
+            inputCount = reader.readCompactSize(reader.remaining() / MIN_INPUT_SIZE);
+        }
+    }
+
+    tx.inputs.resize(inputCount);
+    for (TxInView& input : tx.inputs) {
+        input.prevTxid = reader.readHash();
+        input.prevIndex = reader.readU32();
+        input.scriptSig = reader.readVarBytes();
+        input.sequence = reader.readU32();
+        input.witness = {};
+    }
+
+    // Without the marker, the zero read above was the output count of a transaction with no inputs.
+    const std::uint64_t outputCount = (inputCount == 0 && flags == 0)
+        ? 0 : reader.readCompactSize(reader.remaining() / MIN_OUTPUT_SIZE);
+    tx.outputs.resize(outputCount);
+    for (TxOutView& output : tx.outputs) {
+        output.value = reader.readI64();
+        output.scriptPubKey = reader.readVarBytes();
+    }
+    tx.ioBytes = reader.since(ioBegin);
+
+    tx.hasWitness = false;
+    if (flags & 1) {
+        for (TxInView& input : tx.inputs) {
+            const std::size_t witnessBegin = reader.position();
+            const std::uint64_t items = reader.readCompactSize();
+            for (std::uint64_t i = 0; i < items && !reader.failed(); ++i) reader.readVarBytes();
+            input.witness = reader.since(witnessBegin);
+            if (items != 0) tx.hasWitness = true;
+        }
+        // A witness flag without any witness data is invalid, as are unknown flags.
+        if (!tx.hasWitness) return false;
+    }
+    if (flags & ~1) return false;
+
+    tx.lockTime = reader.readU32();
+    if (reader.failed()) return false;
+    tx.raw = reader.since(begin);
+    return true;
+}
+
+bool parseTransaction(ByteSpan data, TxView& tx) {
+    ByteReader reader(data);
+    return parseTransaction(reader, tx) && reader.atEnd();
+}
+
+bool parseBlock(ByteSpan data, BlockView& block) {
+    ByteReader reader(data);
+    if (!parseBlockHeader(reader, block.header)) return false;
+
+    const std::uint64_t count = reader.readCompactSize(reader.remaining() / MIN_TX_SIZE);
+    if (reader.failed()) return false;
+    block.transactions.resize(count);
+    for (TxView& tx : block.transactions) {
+        if (!parseTransaction(reader, tx)) return false;
+    }
+    return reader.atEnd();
+}
+
+bool parseHeaders(ByteSpan data, std::vector<BlockHeaderView>& headers) {
+    if (data.size() % HEADER_SIZE != 0) return false;
+    headers.resize(data.size() / HEADER_SIZE);
+    ByteReader reader(data);
+    for (BlockHeaderView& header : headers) {
+        if (!parseBlockHeader(reader, header)) return false;
+    }
+    return true;
+}
+
+bool parseWitness(ByteSpan witness, std::vector<ByteSpan>& items) {
+    items.clear();
+    if (witness.empty()) return true;
+    ByteReader reader(witness);
+    const std::uint64_t count = reader.readCompactSize();
+    for (std::uint64_t i = 0; i < count && !reader.failed(); ++i) items.push_back(reader.readVarBytes());
+    return reader.atEnd();
+}
+
+bool DecodedTransaction::decode(std::string_view hex) {
+    buffer.resize(hex.size() / 2);
+    return decodeHex(hex, buffer.data()) && parseTransaction(ByteSpan(buffer), tx);
+}
+
+bool DecodedBlock::decode(std::string_view hex) {
+    buffer.resize(hex.size() / 2);
+    return decodeHex(hex, buffer.data()) && parseBlock(ByteSpan(buffer), block);
+}
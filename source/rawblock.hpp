@@ -0,0 +1,215 @@
+#ifndef RAWBLOCK_HPP
+#define RAWBLOCK_HPP
+
+#if __has_include("rpctypes.hpp")
+#   include "rpctypes.hpp"
+#else
+#   error "Bitcoin's \"rpctypes.hpp\" was not found!"
+#endif
+
+#include <span>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief A view of serialized bytes; the views below never own their data.
+ */
+using ByteSpan = std::span<const std::uint8_t>;
+
+/**
+ * @class ByteReader
+ * @brief Reads Bitcoin's little-endian wire format from a byte buffer without copying.
+ *
+ * Reads past the end, or non-canonical compact sizes, put the reader in a failed state;
+ * every later read then returns zero / empty views, so parsers may check `failed()` once.
+ */
+class ByteReader {
+public:
+    explicit ByteReader(ByteSpan data) : data(data) {}
+
+    std::uint8_t readU8();                  ///< Reads one byte.
+    std::uint32_t readU32();                ///< Reads a little-endian 32-bit integer.
+    std::uint64_t readU64();                ///< Reads a little-endian 64-bit integer.
+    std::int32_t readI32() { return static_cast<std::int32_t>(readU32()); }  ///< Reads a signed 32-bit integer.
+    std::int64_t readI64() { return static_cast<std::int64_t>(readU64()); }  ///< Reads a signed 64-bit integer.
+    Hash256 readHash();                     ///< Reads 32 bytes in internal byte order.
+
+    /**
+     * @brief Reads a CompactSize length prefix.
+     * @param limit Values above the limit fail the reader (default: the bytes left, for lengths of byte strings).
+     */
+    std::uint64_t readCompactSize(std::uint64_t limit);
+    std::uint64_t readCompactSize() { return readCompactSize(remaining()); }
+
+    ByteSpan readBytes(std::size_t count);                  ///< Returns a view of the next `count` bytes.
+    ByteSpan readVarBytes() { return readBytes(readCompactSize()); }  ///< Reads a length-prefixed byte string.
+
+    std::size_t position() const { return offset; }         ///< Bytes consumed so far.
+    std::size_t remaining() const { return failedState ? 0 : data.size() - offset; }  ///< Bytes left.
+    bool failed() const { return failedState; }             ///< A read went past the end or was malformed.
+    bool atEnd() const { return !failedState && offset == data.size(); }  ///< Everything was consumed.
+
+    /**
+     * @brief Returns a view of the bytes in `[begin, position())`.
+     */
+    ByteSpan since(std::size_t begin) const { return data.subspan(begin, offset - begin); }
+
+private:
+    bool take(std::size_t count);
+
+    ByteSpan data;
+    std::size_t offset = 0;
+    bool failedState = false;
+};
+
+/**
+ * @struct BlockHeaderView
+ * @brief The decoded fields of an 80-byte block header.
+ */
+struct BlockHeaderView {
+    std::int32_t version = 0;
+    Hash256 prevBlock {};               ///< Hash of the previous block, internal byte order.
+    Hash256 merkleRoot {};              ///< Merkle root of the transactions, internal byte order.
+    std::uint32_t time = 0;
+    std::uint32_t bits = 0;
+    std::uint32_t nonce = 0;
+    ByteSpan raw;                       ///< The 80 serialized bytes.
+};
+
+/**
+ * @struct TxInView
+ * @brief One transaction input.
+ */
+struct TxInView {
+    Hash256 prevTxid {};                ///< Txid of the spent output, internal byte order.
+    std::uint32_t prevIndex = 0;        ///< Index of the spent output.
+    ByteSpan scriptSig;
+    std::uint32_t sequence = 0;
+    ByteSpan witness;                   ///< Serialized witness stack (item count and items); empty without witness.
+};
+
+/**
+ * @struct TxOutView
+ * @brief One transaction output.
+ */
+struct TxOutView {
+    Amount value = 0;                   ///< Value in satoshis.
+    ByteSpan scriptPubKey;
+};
+
+/**
+ * @struct TxView
+ * @brief A transaction decoded in place.
+ *
+ * `raw` covers the full serialization (with witnesses). The legacy serialization that the
+ * txid commits to is `version || ioBytes || lockTime`, where `ioBytes` are the inputs and
+ * outputs as serialized, counts included.
+ */
+struct TxView {
+    std::int32_t version = 0;
+    std::vector<TxInView> inputs;
+    std::vector<TxOutView> outputs;
+    std::uint32_t lockTime = 0;
+    bool hasWitness = false;            ///< Serialized with the segwit marker and flag.
+    ByteSpan raw;                       ///< The whole serialized transaction.
+    ByteSpan ioBytes;                   ///< Serialized inputs and outputs.
+};
+
+/**
+ * @struct BlockView
+ * @brief A block decoded in place. Reusing one instance across blocks reuses its vectors.
+ */
+struct BlockView {
+    BlockHeaderView header;
+    std::vector<TxView> transactions;
+};
+
+/**
+ * @name Deserializers
+ * @brief Decode wire-format data into views of the input buffer.
+ *
+ * The buffer must outlive the views. Each function returns `false` on truncated or malformed
+ * input, in which case the output is left in an unspecified state.
+ * @{
+ */
+bool parseBlockHeader(ByteReader& reader, BlockHeaderView& header);
+bool parseTransaction(ByteReader& reader, TxView& tx);
+bool parseTransaction(ByteSpan data, TxView& tx);       ///< Also requires the whole buffer to be consumed.
+bool parseBlock(ByteSpan data, BlockView& block);       ///< Also requires the whole buffer to be consumed.
+bool parseHeaders(ByteSpan data, std::vector<BlockHeaderView>& headers);  ///< Concatenated headers, as returned by `/rest/headers`.
+
+/**
+ * @brief Splits a serialized witness stack into its items.
+ */
+bool parseWitness(ByteSpan witness, std::vector<ByteSpan>& items);
+/** @} */
+
+/**
+ * @class DecodedTransaction
+ * @brief A transaction decoded from the hex RPC returns, owning the bytes its view points into.
+ *
+ * Decodes the hex of `getrawtransaction <txid> false` locally, instead of sending it back
+ * to the node's `decoderawtransaction`. Decoding into the same instance again reuses its buffers.
+ * Moving keeps the view valid; copying is not allowed, since a copy's view would point
+ * into the original.
+ *
+ * @code
+ * DecodedTransaction tx;
+ * for (const std::string& hex : rawTransactions) {
+ *     if (tx.decode(hex)) total += tx.view().outputs.size();
+ * }
+ * @endcode
+ */
+class DecodedTransaction {
+public:
+    DecodedTransaction() = default;
+    DecodedTransaction(DecodedTransaction&&) noexcept = default;
+    DecodedTransaction& operator=(DecodedTransaction&&) noexcept = default;
+    DecodedTransaction(const DecodedTransaction&) = delete;
+    DecodedTransaction& operator=(const DecodedTransaction&) = delete;
+
+    /**
+     * @brief Replaces the contents with the transaction serialized in `hex`.
+     * @return `false` if the text is not hex or not exactly one valid transaction; the view is then unusable.
+     */
+    bool decode(std::string_view hex);
+
+    const TxView& view() const { return tx; }           ///< The decoded fields.
+    ByteSpan bytes() const { return buffer; }           ///< The serialized transaction.
+
+private:
+    std::vector<std::uint8_t> buffer;
+    TxView tx;
+};
+
+/**
+ * @class DecodedBlock
+ * @brief A block decoded from the hex of `getblock <hash> 0`, owning the bytes its views point into.
+ *
+ * The same rules as for DecodedTransaction apply.
+ */
+class DecodedBlock {
+public:
+    DecodedBlock() = default;
+    DecodedBlock(DecodedBlock&&) noexcept = default;
+    DecodedBlock& operator=(DecodedBlock&&) noexcept = default;
+    DecodedBlock(const DecodedBlock&) = delete;
+    DecodedBlock& operator=(const DecodedBlock&) = delete;
+
+    /**
+     * @brief Replaces the contents with the block serialized in `hex`.
+     * @return `false` if the text is not hex or not exactly one valid block; the views are then unusable.
+     */
+    bool decode(std::string_view hex);
+
+    const BlockView& view() const { return block; }     ///< The header and transactions.
+    ByteSpan bytes() const { return buffer; }           ///< The serialized block.
+
+private:
+    std::vector<std::uint8_t> buffer;
+    BlockView block;
+};
+
+#endif // RAWBLOCK_HPP
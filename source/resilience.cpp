@@ -0,0 +1,65 @@
+#include "resilience.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <random>
+
+std::chrono::milliseconds backoffDelay(const RetryPolicy& policy, std::uint32_t retry) {
+    thread_local std::minstd_rand generator(std::random_device{}());
+    const std::int64_t base = std::max<std::int64_t>(policy.baseDelay.count(), 0);
+    const std::int64_t cap = std::max<std::int64_t>(policy.maxDelay.count(), 0);
+    // Shifting by 30 or more overflows long before any sensible cap is reached.
+    const std::int64_t ceiling = retry >= 30 ? cap : std::min(cap, base << retry);
+    std::uniform_int_distribution<std::int64_t> jitter(0, ceiling);
+    return std::chrono::milliseconds(jitter(generator));
+}
+
+CircuitBreaker::CircuitBreaker(const BreakerSettings& settings)
+    : breakerSettings(settings) {
+    breakerSettings.failureThreshold = std::max<std::uint32_t>(breakerSettings.failureThreshold, 1);
+}
+
+bool CircuitBreaker::allow() {
+    const Clock::rep until = openUntil.load(std::memory_order_acquire);
+    if (until == 0) return true;
+    if (Clock::now().time_since_epoch().count() < until) return false;
+
+    // Half-open: exactly one caller gets to probe the endpoint.
+    bool expected = false;
+    return probing.compare_exchange_strong(expected, true, std::memory_order_acq_rel);
+}
+
+void CircuitBreaker::recordSuccess() {
+    if (failures.load(std::memory_order_relaxed) != 0) failures.store(0, std::memory_order_relaxed);
+    if (openUntil.load(std::memory_order_relaxed) == 0) return;
+
+    openUntil.store(0, std::memory_order_release);
+    probing.store(false, std::memory_order_release);
+    Logger::info("Endpoint recovered; circuit closed");
+}
+
+void CircuitBreaker::recordFailure() {
+    const std::uint32_t count = failures.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (probing.load(std::memory_order_acquire)) {
+        // The probe failed: stay away for another open period.
+        open();
+        probing.store(false, std::memory_order_release);
+        return;
+    }
+    if (count >= breakerSettings.failureThreshold && openUntil.load(std::memory_order_relaxed) == 0) {
+        open();
+        Logger::formattedWarning("Endpoint failed {} times in a row; circuit opened for {} ms",
+                                 count, breakerSettings.openDuration.count());
+    }
+}
+
+void CircuitBreaker::open() {
+    const auto until = Clock::now() + breakerSettings.openDuration;
+    openUntil.store(std::max<Clock::rep>(until.time_since_epoch().count(), 1), std::memory_order_release);
+    opened.fetch_add(1, std::memory_order_relaxed);
+}
+
+CircuitBreaker::State CircuitBreaker::state() const {
+    const Clock::rep until = openUntil.load(std::memory_order_acquire);
+    if (until == 0) return State::Closed;
+    return Clock::now().time_since_epoch().count() < until ? State::Open : State::HalfOpen;
+}
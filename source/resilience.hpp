@@ -0,0 +1,111 @@
+#ifndef RESILIENCE_HPP
+#define RESILIENCE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @struct RetryPolicy
+ * @brief How often and how patiently a failed request is retried.
+ *
+ * Only transport failures are retried, never RPC errors. Read-only methods are retried
+ * after any transport failure; other methods only when the connection could not be made,
+ * since the node may otherwise already have acted on the request.
+ */
+struct RetryPolicy {
+    std::uint32_t maxAttempts = 1;                  ///< Attempts per call, the first one included; 1 disables retries.
+    std::chrono::milliseconds baseDelay {50};       ///< Backoff ceiling before the first retry; doubles with every retry.
+    std::chrono::milliseconds maxDelay {2000};      ///< Upper bound of the backoff ceiling.
+};
+
+/**
+ * @brief Returns a jittered wait before a retry.
+ *
+ * The wait is drawn uniformly from `[0, min(maxDelay, baseDelay * 2^retry)]` ("full jitter"),
+ * so clients that failed together do not retry together.
+ *
+ * @param policy The retry policy.
+ * @param retry The number of retries already made.
+ */
+std::chrono::milliseconds backoffDelay(const RetryPolicy& policy, std::uint32_t retry);
+
+/**
+ * @struct BreakerSettings
+ * @brief When a CircuitBreaker opens and how long it stays open.
+ */
+struct BreakerSettings {
+    std::uint32_t failureThreshold = 5;             ///< Consecutive transport failures that open the circuit.
+    std::chrono::milliseconds openDuration {5000};  ///< Time requests are refused before one probe is let through.
+};
+
+/**
+ * @class CircuitBreaker
+ * @brief Stops sending requests to an endpoint that keeps failing.
+ *
+ * After `failureThreshold` consecutive failures the circuit opens: requests are refused
+ * at once instead of each waiting for its own timeout, which keeps a dead node from tying
+ * up every caller. Once `openDuration` has passed, a single request is let through as a
+ * probe; its success closes the circuit, its failure opens it again.
+ *
+ * All members are lock-free; a healthy endpoint costs one atomic load per request.
+ */
+class CircuitBreaker {
+public:
+    /**
+     * @enum State
+     * @brief The position of the breaker.
+     */
+    enum class State : std::uint8_t {
+        Closed,     ///< Requests flow normally.
+        Open,       ///< Requests are refused.
+        HalfOpen    ///< The open period is over; the next request is a probe.
+    };
+
+    /**
+     * @brief Creates a closed breaker.
+     */
+    explicit CircuitBreaker(const BreakerSettings& settings = {});
+
+    /**
+     * @brief Checks whether a request may be sent now.
+     * @return `false` if the circuit is open, or half-open with a probe already in flight.
+     */
+    bool allow();
+
+    /**
+     * @brief Records a successful exchange; closes the circuit.
+     */
+    void recordSuccess();
+
+    /**
+     * @brief Records a transport failure; may open the circuit.
+     */
+    void recordFailure();
+
+    /**
+     * @brief Returns the current position of the breaker.
+     */
+    State state() const;
+
+    /**
+     * @brief Returns how often the circuit has opened.
+     */
+    std::uint64_t openCount() const { return opened.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Opens the circuit for `openDuration` from now.
+     */
+    void open();
+
+    BreakerSettings breakerSettings;                ///< Thresholds.
+    std::atomic<std::uint32_t> failures {0};        ///< Consecutive failures.
+    std::atomic<Clock::rep> openUntil {0};          ///< End of the open period; 0 while closed.
+    std::atomic<bool> probing {false};              ///< A half-open probe is in flight.
+    std::atomic<std::uint64_t> opened {0};          ///< Number of times the circuit opened.
+};
+
+#endif // RESILIENCE_HPP
@@ -0,0 +1,424 @@
+#include "responsearchive.hpp"
+#include "responsecache.hpp"
+#include "hexcodec.hpp"
+#include "jsonwriter.hpp"
+#include "logger.hpp"
+#include "sha256.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+
+namespace {
+constexpr std::size_t HEADER_SIZE = 4096;                       ///< Bytes before the first record; one page.
+constexpr std::uint64_t MAGIC = 0x3130564843524152;             ///< "RARCHV01" on little-endian hosts.
+constexpr std::uint32_t FORMAT_VERSION = 1;                     ///< Layout of the files.
+constexpr std::size_t MIN_RECORD_BYTES = 1 << 24;               ///< Size of a new record file.
+constexpr std::uint64_t MIN_SLOTS = 1 << 14;                    ///< Slots of a new key table.
+constexpr std::uint64_t MIN_HEIGHTS = 1 << 16;                  ///< Heights of a new height table.
+constexpr std::uint64_t EMPTY = 0;                              ///< Empty slot; no record starts inside the header.
+
+/**
+ * @brief Returns the slots of a key table holding `count` records at a load factor of at most 0.5.
+ */
+std::uint64_t slotsFor(std::uint64_t count) {
+    std::uint64_t slots = MIN_SLOTS;
+    while (count * 2 > slots) slots *= 2;
+    return slots;
+}
+
+std::uint64_t alignRecord(std::uint64_t bytes) {
+    return (bytes + 7) & ~std::uint64_t(7);
+}
+
+/**
+ * @brief Checks for the height form of `getblockstats` and `getblockhash`, which the height table answers.
+ */
+bool isHeightCall(const std::string& method, const Json::Value& params) {
+    if (!params.isArray() || params.empty() || !params[Json::ArrayIndex(0)].isIntegral()) return false;
+    if (params[Json::ArrayIndex(0)].asInt64() < 0) return false;
+    return method == "getblockstats" || (method == "getblockhash" && params.size() == 1);
+}
+
+bool parseResult(const char* begin, const char* end, Json::Value& result) {
+    thread_local const std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+    return reader->parse(begin, end, &result, nullptr);
+}
+}
+
+struct ResponseArchive::Header {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t dirty;                ///< Set while changes may not have reached the disk.
+    std::uint64_t end;                  ///< Offset past the last record.
+    std::uint64_t recordCount;
+    std::uint64_t keySlots;             ///< Slots of `keys.idx`.
+    std::uint64_t heightCount;          ///< Heights with a block in `heights.idx`.
+};
+
+struct ResponseArchive::Record {
+    Digest key;                         ///< Digest of the call.
+    Hash256 block;                      ///< The block the result belongs to.
+    std::int64_t height;                ///< Its height, or -1 if it is not indexed by height.
+    std::uint32_t size;                 ///< Bytes of the payload that follows, before padding to 8.
+    Encoding encoding;
+    std::array<std::uint8_t, 3> padding;
+};
+
+ResponseArchive::ResponseArchive(std::string directory, const ArchiveSettings& settings)
+    : directory(std::move(directory)), archiveSettings(settings) {
+    static_assert(sizeof(Header) <= HEADER_SIZE);
+    static_assert(sizeof(Record) == 72, "records are an on-disk format");
+    archiveSettings.minConfirmations = std::max<std::int64_t>(archiveSettings.minConfirmations, 1);
+}
+
+ResponseArchive::~ResponseArchive() {
+    close();
+}
+
+ResponseArchive::Header& ResponseArchive::header() {
+    return *reinterpret_cast<Header*>(records.data());
+}
+
+const ResponseArchive::Header& ResponseArchive::header() const {
+    return *reinterpret_cast<const Header*>(records.data());
+}
+
+const ResponseArchive::Record& ResponseArchive::record(std::uint64_t offset) const {
+    return *reinterpret_cast<const Record*>(records.data() + offset);
+}
+
+bool ResponseArchive::open() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    std::error_code error;
+    const std::filesystem::path data = std::filesystem::path(directory) / "archive.dat";
+    const bool create = !std::filesystem::exists(data, error) || std::filesystem::file_size(data, error) == 0;
+    if (archiveSettings.readOnly) {
+        if (create) {
+            Logger::formattedError("There is no response archive in {}", directory);
+            return false;
+        }
+        return mapFiles(false);
+    }
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        Logger::formattedError("Failed to create {}: {}", directory, error.message());
+        return false;
+    }
+    return mapFiles(create);
+}
+
+bool ResponseArchive::mapFiles(bool create) {
+    const std::filesystem::path base(directory);
+    const MappedFile::Mode mode = archiveSettings.readOnly ? MappedFile::Mode::ReadOnly : MappedFile::Mode::ReadWrite;
+    if (!records.open((base / "archive.dat").string(), mode, create ? MIN_RECORD_BYTES : 0)
+        || !keys.open((base / "keys.idx").string(), mode)
+        || !heights.open((base / "heights.idx").string(), mode)) {
+        close();
+        return false;
+    }
+
+    if (create) {
+        Header& fresh = header();
+        std::memset(&fresh, 0, sizeof(Header));
+        fresh.magic = MAGIC;
+        fresh.version = FORMAT_VERSION;
+        fresh.end = HEADER_SIZE;
+        beginWrite();
+        return rebuildTables(MIN_SLOTS) && flush();
+    }
+
+    if (records.size() < HEADER_SIZE || header().magic != MAGIC || header().version != FORMAT_VERSION) {
+        Logger::formattedError("{} is not a response archive of this version or byte order", records.path());
+        close();
+        return false;
+    }
+    if (header().end < HEADER_SIZE || header().end > records.size()) {
+        Logger::formattedError("The response archive in {} is truncated", directory);
+        close();
+        return false;
+    }
+
+    // The tables only cache what the records say; a dirty archive may have torn ones.
+    const bool usable = !header().dirty && header().keySlots >= MIN_SLOTS
+        && keys.size() == header().keySlots * sizeof(std::uint64_t);
+    if (usable) return true;
+    if (archiveSettings.readOnly) {
+        Logger::formattedError("The tables of the response archive in {} need a rebuild; open it writable once", directory);
+        close();
+        return false;
+    }
+    Logger::formattedWarning("Rebuilding the tables of the response archive in {}", directory);
+    beginWrite();
+    return rebuildTables(slotsFor(header().recordCount)) && flush();
+}
+
+void ResponseArchive::beginWrite() {
+    if (writing) return;
+    header().dirty = 1;
+    records.sync();
+    writing = true;
+}
+
+bool ResponseArchive::writeFailed() {
+    damaged = true;
+    Logger::formattedError("A write to the response archive in {} failed; its tables are rebuilt when it is opened again", directory);
+    return false;
+}
+
+bool ResponseArchive::flush() {
+    if (!records.isOpen() || !writing) return true;
+    if (damaged) return false;
+    if (!keys.sync() || !heights.sync() || !records.sync()) return false;
+    // Only once everything else is on disk may the dirty mark go.
+    header().dirty = 0;
+    if (!records.sync()) return false;
+    writing = false;
+    return true;
+}
+
+void ResponseArchive::close() {
+    if (records.isOpen() && !archiveSettings.readOnly) flush();
+    records.close();
+    keys.close();
+    heights.close();
+}
+
+bool ResponseArchive::rebuildTables(std::uint64_t keySlots) {
+    // Count the whole records first; those past a torn append are dropped.
+    Header& state = header();
+    std::uint64_t count = 0;
+    std::uint64_t offset = HEADER_SIZE;
+    while (offset < state.end) {
+        if (state.end - offset < sizeof(Record) || alignRecord(sizeof(Record) + record(offset).size) > state.end - offset) {
+            Logger::formattedWarning("Dropping {} bytes of a partial record from the response archive in {}",
+                                     state.end - offset, directory);
+            state.end = offset;
+            break;
+        }
+        offset += alignRecord(sizeof(Record) + record(offset).size);
+        ++count;
+    }
+    state.recordCount = count;
+    keySlots = std::max(keySlots, slotsFor(count));
+
+    if (keys.size() != keySlots * sizeof(std::uint64_t) && !keys.resize(keySlots * sizeof(std::uint64_t))) return false;
+    std::memset(keys.data(), 0, keys.size());
+    if (heights.size() != 0) std::memset(heights.data(), 0, heights.size());
+    state.keySlots = keySlots;
+    state.heightCount = 0;
+    for (offset = HEADER_SIZE; offset < state.end; offset += alignRecord(sizeof(Record) + record(offset).size)) {
+        const std::int64_t height = record(offset).height;
+        if (!indexKey(offset) || (height >= 0 && !indexHeight(height, offset))) return false;
+    }
+    return true;
+}
+
+bool ResponseArchive::indexKey(std::uint64_t offset) {
+    auto* slots = reinterpret_cast<std::uint64_t*>(keys.data());
+    const std::uint64_t mask = header().keySlots - 1;
+    const Digest& digest = record(offset).key;
+    std::uint64_t bits;
+    std::memcpy(&bits, digest.data(), sizeof(bits));
+    std::uint64_t i = bits & mask;
+    while (slots[i] != EMPTY) i = (i + 1) & mask;
+    slots[i] = offset;
+    return true;
+}
+
+bool ResponseArchive::indexHeight(std::int64_t height, std::uint64_t offset) {
+    const std::uint64_t entries = heights.size() / sizeof(std::uint64_t);
+    if (static_cast<std::uint64_t>(height) >= entries) {
+        std::uint64_t grown = std::max(entries, MIN_HEIGHTS);
+        while (grown <= static_cast<std::uint64_t>(height)) grown *= 2;
+        if (!heights.resize(grown * sizeof(std::uint64_t))) return false;
+    }
+    std::uint64_t& slot = reinterpret_cast<std::uint64_t*>(heights.data())[height];
+    if (slot == EMPTY) ++header().heightCount;
+    slot = offset;
+    return true;
+}
+
+std::uint64_t ResponseArchive::findRecord(const Digest& digest) const {
+    if (!records.isOpen() || header().keySlots == 0) return EMPTY;
+    const auto* slots = reinterpret_cast<const std::uint64_t*>(keys.data());
+    const std::uint64_t mask = header().keySlots - 1;
+    std::uint64_t bits;
+    std::memcpy(&bits, digest.data(), sizeof(bits));
+    for (std::uint64_t i = bits & mask; slots[i] != EMPTY; i = (i + 1) & mask) {
+        if (record(slots[i]).key == digest) return slots[i];
+    }
+    return EMPTY;
+}
+
+bool ResponseArchive::resolveHeight(const std::string& method, Json::Value& params) const {
+    if (!isHeightCall(method, params)) return true;
+    const std::optional<Hash256> block = hashAt(params[Json::ArrayIndex(0)].asInt64());
+    if (!block) return false;
+    params[Json::ArrayIndex(0)] = hashToHex(*block);
+    return true;
+}
+
+bool ResponseArchive::decodeRecord(const Record& entry, Json::Value& result) const {
+    const auto* payload = reinterpret_cast<const char*>(&entry + 1);
+    if (entry.encoding == Encoding::Hex) {
+        result = encodeHex({reinterpret_cast<const std::uint8_t*>(payload), entry.size});
+        return true;
+    }
+    return parseResult(payload, payload + entry.size, result);
+}
+
+ResponseArchive::Digest ResponseArchive::digestOf(const std::string& method, const Json::Value& params) {
+    const std::string key = ResponseCache::makeKey(method, params);
+    const auto hash = Sha256().write({reinterpret_cast<const std::uint8_t*>(key.data()), key.size()}).finalize();
+    Digest digest;
+    std::copy_n(hash.begin(), digest.size(), digest.begin());
+    return digest;
+}
+
+bool ResponseArchive::isArchivable(const std::string& method, const Json::Value& params) {
+    // Transactions are left to ResponseCache; they are not tied to a block the archive can index.
+    if (method == "getrawtransaction") return false;
+    return ResponseCache::isCacheable(method, params) || isHeightCall(method, params);
+}
+
+std::optional<Json::Value> ResponseArchive::lookup(const std::string& method, const Json::Value& params) {
+    if (!isArchivable(method, params)) return std::nullopt;
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (!records.isOpen()) return std::nullopt;
+
+    if (method == "getblockhash") {
+        const std::optional<Hash256> block = hashAt(params[Json::ArrayIndex(0)].asInt64());
+        if (!block) {
+            ++misses;
+            return std::nullopt;
+        }
+        ++hits;
+        return Json::Value(hashToHex(*block));
+    }
+
+    Json::Value keyed = params;
+    const std::uint64_t offset = resolveHeight(method, keyed) ? findRecord(digestOf(method, keyed)) : EMPTY;
+    Json::Value result;
+    if (offset == EMPTY || !decodeRecord(record(offset), result)) {
+        ++misses;
+        return std::nullopt;
+    }
+    ++hits;
+    return result;
+}
+
+void ResponseArchive::store(const std::string& method, const Json::Value& params, const Json::Value& result) {
+    if (archiveSettings.readOnly || result.isNull() || method == "getblockhash" || !isArchivable(method, params)) return;
+
+    Hash256 block {};
+    std::int64_t height = -1;
+    Json::Value keyed = params;
+    const Json::Value& first = params[Json::ArrayIndex(0)];
+    if (first.isString()) {
+        if (!parseHash(first.asString(), block)) return;
+    } else if (!result.isObject() || !result["blockhash"].isString() || !parseHash(result["blockhash"].asString(), block)) {
+        // A height-keyed getblockstats without the blockhash field cannot be told apart from a later reorg.
+        return;
+    } else {
+        keyed[Json::ArrayIndex(0)] = hashToHex(block);
+    }
+
+    if ((method == "getblock" || method == "getblockheader") && result.isObject()) {
+        // Verbose results carry a confirmation count that only says something once the block is deep.
+        const std::int64_t confirmations = result["confirmations"].asInt64();
+        if (result["height"].isIntegral() && confirmations > 0) noteTip(result["height"].asInt64() + confirmations - 1);
+        if (confirmations < archiveSettings.minConfirmations) return;
+        if (result["height"].isIntegral()) height = result["height"].asInt64();
+    } else if (method == "getblockstats" && result.isObject() && result["height"].isIntegral()) {
+        // Stats are immutable by hash at any depth, but only indexed by height once the tip is far enough above.
+        const std::int64_t statsHeight = result["height"].asInt64();
+        if (statsHeight >= 0 && tip.load() - statsHeight + 1 >= archiveSettings.minConfirmations) height = statsHeight;
+    }
+
+    Encoding encoding = Encoding::Json;
+    std::string payload;
+    if (result.isString()) {
+        const std::string& hex = result.asString();
+        payload.resize(hex.size() / 2);
+        if (hex.size() % 2 != 0 || !decodeHex(hex, reinterpret_cast<std::uint8_t*>(payload.data()))) return;
+        encoding = Encoding::Hex;
+    } else {
+        JsonWriter(payload).write(result);
+    }
+
+    const Digest digest = digestOf(method, keyed);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!records.isOpen() || damaged) return;
+    const std::uint64_t existing = findRecord(digest);
+    if (existing == EMPTY) {
+        append(digest, block, height, encoding, payload);
+    } else if (height >= 0 && record(existing).height < 0) {
+        // Archived while still shallow: the record gains its height, so rebuilt tables index it as well.
+        beginWrite();
+        reinterpret_cast<Record*>(records.data() + existing)->height = height;
+        if (!indexHeight(height, existing)) writeFailed();
+    }
+}
+
+void ResponseArchive::noteTip(std::int64_t height) {
+    std::int64_t known = tip.load();
+    while (height > known && !tip.compare_exchange_weak(known, height)) {}
+}
+
+bool ResponseArchive::append(const Digest& digest, const Hash256& block, std::int64_t height, Encoding encoding,
+                             const std::string& payload) {
+    beginWrite();
+    const std::uint64_t offset = header().end;
+    const std::uint64_t length = alignRecord(sizeof(Record) + payload.size());
+    if (offset + length > records.size()) {
+        std::size_t grown = std::max<std::size_t>(records.size(), MIN_RECORD_BYTES);
+        while (grown < offset + length) grown *= 2;
+        if (!records.resize(grown)) return writeFailed();
+    }
+
+    auto& entry = *reinterpret_cast<Record*>(records.data() + offset);
+    std::memset(&entry, 0, length);
+    entry.key = digest;
+    entry.block = block;
+    entry.height = height;
+    entry.size = static_cast<std::uint32_t>(payload.size());
+    entry.encoding = encoding;
+    std::memcpy(&entry + 1, payload.data(), payload.size());
+
+    Header& state = header();
+    state.end = offset + length;
+    ++state.recordCount;
+    if (state.recordCount * 2 > state.keySlots) {
+        if (!rebuildTables(state.keySlots * 2)) return writeFailed();
+        return true;
+    }
+    if (!indexKey(offset) || (height >= 0 && !indexHeight(height, offset))) return writeFailed();
+    return true;
+}
+
+std::optional<Hash256> ResponseArchive::blockHash(std::int64_t height) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return hashAt(height);
+}
+
+std::optional<Hash256> ResponseArchive::hashAt(std::int64_t height) const {
+    if (!records.isOpen() || height < 0 || static_cast<std::uint64_t>(height) >= heights.size() / sizeof(std::uint64_t)) {
+        return std::nullopt;
+    }
+    const std::uint64_t offset = reinterpret_cast<const std::uint64_t*>(heights.data())[height];
+    if (offset == EMPTY) return std::nullopt;
+    return record(offset).block;
+}
+
+ArchiveStats ResponseArchive::stats() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    ArchiveStats current;
+    current.hits = hits.load(std::memory_order_relaxed);
+    current.misses = misses.load(std::memory_order_relaxed);
+    if (!records.isOpen()) return current;
+    current.records = header().recordCount;
+    current.heights = header().heightCount;
+    current.bytes = header().end;
+    return current;
+}
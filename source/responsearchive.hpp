@@ -0,0 +1,217 @@
+#ifndef RESPONSEARCHIVE_HPP
+#define RESPONSEARCHIVE_HPP
+
+#if __has_include("mappedfile.hpp")
+#   include "mappedfile.hpp"
+#else
+#   error "Bitcoin's \"mappedfile.hpp\" was not found!"
+#endif
+
+#if __has_include("rpctypes.hpp")
+#   include "rpctypes.hpp"
+#else
+#   error "Bitcoin's \"rpctypes.hpp\" was not found!"
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+
+/**
+ * @struct ArchiveSettings
+ * @brief What a ResponseArchive accepts.
+ */
+struct ArchiveSettings {
+    bool readOnly = false;                  ///< Serve archived results only; misses are not appended and the files are mapped read-only.
+    std::int64_t minConfirmations = 100;    ///< Verbose blocks and headers are archived, and blocks indexed by height, only once this deep.
+};
+
+/**
+ * @struct ArchiveStats
+ * @brief Counters of a ResponseArchive.
+ */
+struct ArchiveStats {
+    std::uint64_t hits = 0;         ///< Lookups answered from the archive.
+    std::uint64_t misses = 0;       ///< Lookups that went to the node.
+    std::uint64_t records = 0;      ///< Results archived.
+    std::uint64_t heights = 0;      ///< Heights whose block is known.
+    std::uint64_t bytes = 0;        ///< Size of the record file in use.
+};
+
+/**
+ * @class ResponseArchive
+ * @brief An append-only, memory-mapped archive of immutable block results, shared across runs.
+ *
+ * Analytics jobs replay the same history again and again. Without an archive every run
+ * fetches the same `getblock` and `getblockstats` results from the node; with one, only the
+ * first run does, and later runs read the mapped files. A BitcoinClient given an archive with
+ * `setResponseArchive()` looks there first and appends what it had to fetch.
+ *
+ * The archive lives in a directory of three files:
+ *  - `archive.dat`: a header, then records appended one after another. A record holds the
+ *    digest of its call, the block it belongs to, the block's height if known, and the
+ *    result. Hex results (raw blocks and headers) are stored as bytes, the rest as compact JSON.
+ *  - `keys.idx`: an open-addressing table of record offsets keyed by call digest.
+ *  - `heights.idx`: the offset of a record of each height's block, so height-keyed calls
+ *    resolve to a block hash without the node.
+ *
+ * Archived calls are those ResponseCache considers immutable (`getblock`, `getblockheader`,
+ * `getblockstats`, `getblockfilter` by hash), plus `getblockstats` by height once that height
+ * is indexed. Verbose blocks and headers are only archived `minConfirmations` deep; they are
+ * served as archived, so their `confirmations` is a lower bound. Stats carry no confirmation
+ * count, so they are judged against the highest tip the archive has seen: from `getblockcount`
+ * and verbose block results passing through the client, or from `noteTip()`. Only deep blocks
+ * and stats fill the height index, which makes it safe against all but very deep reorganizations.
+ *
+ * Both tables are derived from the records. Appends mark the archive dirty until the next
+ * `flush()`; a dirty archive rebuilds its tables from the records when it is opened again.
+ * Records use the host's byte order; the files are not portable between architectures.
+ *
+ * @code
+ * auto archive = std::make_shared<ResponseArchive>("/var/lib/bitcoin-rpc/archive");
+ * if (archive->open()) client.setResponseArchive(archive);
+ * const std::int64_t tip = client.getBlockCount().asInt64();     // Also tells the archive how deep each height is.
+ * for (std::int64_t height = 0; height <= tip; ++height) process(client.call<RpcMethod::getblockstats>(height));
+ * @endcode
+ */
+class ResponseArchive {
+public:
+    /**
+     * @brief Creates an archive stored in `directory`; nothing is opened until `open()`.
+     */
+    explicit ResponseArchive(std::string directory, const ArchiveSettings& settings = {});
+    ResponseArchive(const ResponseArchive&) = delete;
+    ResponseArchive& operator=(const ResponseArchive&) = delete;
+
+    /**
+     * @brief Flushes and closes the archive.
+     */
+    ~ResponseArchive();
+
+    /**
+     * @brief Opens the archive, creating empty files on first use unless read-only.
+     * @return `false` if a file could not be mapped or is not an archive of this version.
+     */
+    bool open();
+
+    /**
+     * @brief Flushes and unmaps the files.
+     */
+    void close();
+
+    /**
+     * @brief Writes all appended records to disk and clears the dirty mark.
+     */
+    bool flush();
+
+    /**
+     * @brief Checks whether a call may be answered from the archive at all.
+     */
+    static bool isArchivable(const std::string& method, const Json::Value& params);
+
+    /**
+     * @brief Looks a call up.
+     * @return The archived result, or nothing.
+     */
+    std::optional<Json::Value> lookup(const std::string& method, const Json::Value& params);
+
+    /**
+     * @brief Appends the result of a call if it is safe to archive and not archived yet.
+     * @param method The RPC method of the call.
+     * @param params The parameters of the call.
+     * @param result The `result` member returned by the node.
+     */
+    void store(const std::string& method, const Json::Value& params, const Json::Value& result);
+
+    /**
+     * @brief Records that the chain reached `height`, so stats that far below it may be indexed by height.
+     */
+    void noteTip(std::int64_t height);
+
+    /**
+     * @brief Returns the hash of the block at `height` if a record of it is archived.
+     */
+    std::optional<Hash256> blockHash(std::int64_t height) const;
+
+    /**
+     * @brief Returns the current counters.
+     */
+    ArchiveStats stats() const;
+
+    /**
+     * @brief Returns the settings the archive was created with.
+     */
+    const ArchiveSettings& settings() const { return archiveSettings; }
+
+private:
+    struct Header;
+    struct Record;
+
+    /**
+     * @enum Encoding
+     * @brief How a record's result is stored.
+     */
+    enum class Encoding : std::uint8_t {
+        Json,       ///< Compact JSON text.
+        Hex         ///< The bytes of a hex string result.
+    };
+
+    using Digest = std::array<std::uint8_t, 24>;   ///< Leading bytes of SHA-256 of the cache key of a call.
+
+    /**
+     * @brief Returns the digest of the cache key of a call.
+     */
+    static Digest digestOf(const std::string& method, const Json::Value& params);
+
+    /**
+     * @brief Maps the files, creating them if `create` is set.
+     */
+    bool mapFiles(bool create);
+
+    Header& header();
+    const Header& header() const;
+    const Record& record(std::uint64_t offset) const;
+    std::optional<Hash256> hashAt(std::int64_t height) const;     ///< `blockHash()` with `mutex` already held.
+
+    /**
+     * @brief Rewrites a call keyed by height into its hash-keyed form; fails if the height is not indexed.
+     */
+    bool resolveHeight(const std::string& method, Json::Value& params) const;
+
+    /**
+     * @brief Returns the offset of the record of a call, or 0.
+     */
+    std::uint64_t findRecord(const Digest& digest) const;
+
+    /**
+     * @brief Converts a record back into the result the node returned.
+     */
+    bool decodeRecord(const Record& entry, Json::Value& result) const;
+
+    /**
+     * @brief Appends one record and indexes it; `mutex` is held exclusively.
+     */
+    bool append(const Digest& digest, const Hash256& block, std::int64_t height, Encoding encoding, const std::string& payload);
+
+    bool indexKey(std::uint64_t offset);
+    bool indexHeight(std::int64_t height, std::uint64_t offset);
+    bool rebuildTables(std::uint64_t keySlots);     ///< Fills both tables from the records.
+    void beginWrite();                              ///< Marks the archive dirty before its first append since the last flush.
+    bool writeFailed();                             ///< Stops appending after a failed write; returns `false`.
+
+    std::string directory;                  ///< Where the files live.
+    ArchiveSettings archiveSettings;        ///< Write rules.
+    mutable std::shared_mutex mutex;        ///< Readers share; appends are exclusive.
+    MappedFile records;                     ///< Header and records.
+    MappedFile keys;                        ///< Offsets by call digest.
+    MappedFile heights;                     ///< Offsets by height.
+    bool writing = false;                   ///< The dirty mark is set on disk.
+    bool damaged = false;                   ///< A write failed; nothing more is appended.
+    std::atomic<std::int64_t> tip {-1};     ///< Highest chain height seen; -1 until one is.
+    std::atomic<std::uint64_t> hits {0};
+    std::atomic<std::uint64_t> misses {0};
+};
+
+#endif // RESPONSEARCHIVE_HPP
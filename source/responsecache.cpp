@@ -0,0 +1,193 @@
+#include "responsecache.hpp"
+#include "jsonwriter.hpp"
+#include "rpcmethods.hpp"
+#include <algorithm>
+
+namespace {
+constexpr std::size_t JSON_NODE_OVERHEAD = 48;  ///< Approximate size of one map node of an object or array member.
+
+/**
+ * @brief Reads an optional positional verbosity / verbose flag.
+ * @return The verbosity, `fallback` if the parameter is absent, or -1 if it has an unexpected type.
+ */
+int verbosityAt(const Json::Value& params, Json::ArrayIndex index, int fallback) {
+    if (params.size() <= index || params[index].isNull()) return fallback;
+    const Json::Value& value = params[index];
+    if (value.isBool()) return value.asBool() ? 1 : 0;
+    if (value.isIntegral()) return value.asInt();
+    return -1;
+}
+
+bool isBlockHash(const Json::Value& value) {
+    return value.isString() && value.asString().size() == 64;
+}
+}
+
+ResponseCache::ResponseCache(const CacheSettings& settings)
+    : cacheSettings(settings) {
+    cacheSettings.minConfirmations = std::max<std::int64_t>(cacheSettings.minConfirmations, 1);
+}
+
+bool ResponseCache::isCacheable(const std::string& method, const Json::Value& params) {
+    if ((rpcMethodTraits(method) & RPC_IMMUTABLE) == 0 || !params.isArray() || params.empty()) return false;
+    const Json::Value& first = params[Json::ArrayIndex(0)];
+
+    if (method == "getblock") return isBlockHash(first) && verbosityAt(params, 1, 1) >= 0;
+    if (method == "getblockheader") return isBlockHash(first) && verbosityAt(params, 1, 1) >= 0;
+    // Both also accept a height, which is not stable across reorgs.
+    if (method == "getblockstats" || method == "getblockfilter") return isBlockHash(first);
+    // Only the verbose form tells whether the transaction is confirmed.
+    if (method == "getrawtransaction") return first.isString() && verbosityAt(params, 1, 0) >= 1;
+    return false;
+}
+
+std::string ResponseCache::makeKey(const std::string& method, const Json::Value& params) {
+    std::string key = method + ' ';
+    JsonWriter(key).write(params);
+    return key;
+}
+
+std::optional<Json::Value> ResponseCache::lookup(const std::string& key) {
+    std::shared_ptr<const Json::Value> value;
+    std::int64_t height = -1;
+    std::int64_t tipHeight = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(key);
+        if (found == index.end() || (found->second->height >= 0 && chainTip.height < 0)) {
+            ++counters.misses;
+            return std::nullopt;
+        }
+        entries.splice(entries.begin(), entries, found->second);
+        value = found->second->value;
+        height = found->second->height;
+        tipHeight = chainTip.height;
+        ++counters.hits;
+    }
+
+    // Copy outside the lock: a verbose block can be megabytes of JSON.
+    Json::Value result = *value;
+    if (height >= 0) {
+        result["confirmations"] = Json::Int64(std::max<std::int64_t>(tipHeight - height + 1, 1));
+    }
+    return result;
+}
+
+void ResponseCache::store(const std::string& key, const std::string& method, const Json::Value& result, std::uint64_t generation) {
+    if (result.isNull()) return;
+
+    std::int64_t height = -1;
+    std::int64_t confirmations = 0;
+    const bool chainDependent = result.isObject() && method != "getblockstats" && method != "getblockfilter";
+    if (chainDependent) {
+        const Json::Value& depth = result["confirmations"];
+        if (!depth.isIntegral()) return;  // An unconfirmed transaction.
+        confirmations = depth.asInt64();
+        if (confirmations < cacheSettings.minConfirmations) return;
+        if (result["height"].isIntegral()) {
+            height = result["height"].asInt64();
+        } else if (!result["blockhash"].isString()) {
+            return;
+        }
+    }
+
+    auto value = std::make_shared<const Json::Value>(result);
+    const std::size_t bytes = key.size() + sizeof(Entry) + footprint(*value);
+    if (bytes > cacheSettings.memoryBudget) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (generation != invalidationGeneration.load(std::memory_order_relaxed)) return;
+    if (chainDependent && height < 0) {
+        // Transactions do not report their block height; derive it from the confirmations.
+        if (chainTip.height < 0) return;
+        height = chainTip.height - confirmations + 1;
+    }
+
+    if (auto found = index.find(key); found != index.end()) erase(found->second);
+    entries.push_front(Entry{key, std::move(value), bytes, height});
+    index.emplace(key, entries.begin());
+    totalBytes += bytes;
+
+    while (totalBytes > cacheSettings.memoryBudget) {
+        erase(std::prev(entries.end()));
+        ++counters.evictions;
+    }
+}
+
+ChainTip ResponseCache::tip() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return chainTip;
+}
+
+bool ResponseCache::beginTipCheck() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tipCheckRunning) return false;
+    if (chainTip.height >= 0 && std::chrono::steady_clock::now() - lastTipCheck < cacheSettings.tipCheckInterval) return false;
+    tipCheckRunning = true;
+    return true;
+}
+
+void ResponseCache::finishTipCheck() {
+    std::lock_guard<std::mutex> lock(mutex);
+    tipCheckRunning = false;
+    lastTipCheck = std::chrono::steady_clock::now();
+}
+
+void ResponseCache::advanceTip(const ChainTip& newTip, std::int64_t forkHeight) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto entry = entries.begin(); entry != entries.end();) {
+        auto next = std::next(entry);
+        if (entry->height >= 0 && entry->height >= forkHeight) {
+            erase(entry);
+            ++counters.invalidations;
+        }
+        entry = next;
+    }
+    chainTip = newTip;
+    invalidationGeneration.fetch_add(1, std::memory_order_release);
+}
+
+CacheStats ResponseCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    CacheStats snapshot = counters;
+    snapshot.entries = entries.size();
+    snapshot.bytes = totalBytes;
+    return snapshot;
+}
+
+void ResponseCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    totalBytes = 0;
+    invalidationGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void ResponseCache::erase(EntryList::iterator entry) {
+    totalBytes -= entry->bytes;
+    index.erase(entry->key);
+    entries.erase(entry);
+}
+
+std::size_t ResponseCache::footprint(const Json::Value& value) {
+    std::size_t bytes = sizeof(Json::Value);
+    switch (value.type()) {
+    case Json::stringValue: {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        if (value.getString(&begin, &end)) bytes += static_cast<std::size_t>(end - begin) + sizeof(unsigned);
+        break;
+    }
+    case Json::arrayValue:
+    case Json::objectValue:
+        for (auto member = value.begin(); member != value.end(); ++member) {
+            const char* end = nullptr;
+            const char* name = member.memberName(&end);
+            bytes += JSON_NODE_OVERHEAD + (name ? static_cast<std::size_t>(end - name) : 0) + footprint(*member);
+        }
+        break;
+    default:
+        break;
+    }
+    return bytes;
+}
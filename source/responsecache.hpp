@@ -0,0 +1,194 @@
+#ifndef RESPONSECACHE_HPP
+#define RESPONSECACHE_HPP
+
+#if __has_include(<json/json.h>)
+#   include <json/json.h>
+#else
+#   error "Bitcoin's <json/json.h> was not found!"
+#endif
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+/**
+ * @struct CacheSettings
+ * @brief Limits and freshness rules of a ResponseCache.
+ */
+struct CacheSettings {
+    std::size_t memoryBudget = 64 * 1024 * 1024;            ///< Approximate upper bound of the memory held by cached results, in bytes.
+    std::int64_t minConfirmations = 6;                      ///< Verbose blocks and transactions are cached only once this deep.
+    std::chrono::milliseconds tipCheckInterval {2000};      ///< Minimum time between two `getbestblockhash` polls.
+    std::int64_t maxReorgDepth = 100;                       ///< Deeper reorgs drop every height-dependent entry.
+};
+
+/**
+ * @struct CacheStats
+ * @brief Counters of a ResponseCache.
+ */
+struct CacheStats {
+    std::uint64_t hits = 0;             ///< Lookups answered from the cache.
+    std::uint64_t misses = 0;           ///< Lookups of cacheable calls that went to the node.
+    std::uint64_t evictions = 0;        ///< Entries dropped to stay within the memory budget.
+    std::uint64_t invalidations = 0;    ///< Entries dropped because of a reorg.
+    std::size_t entries = 0;            ///< Entries currently cached.
+    std::size_t bytes = 0;              ///< Approximate memory held by the cached results.
+};
+
+/**
+ * @struct ChainTip
+ * @brief The best block as last seen by the cache.
+ */
+struct ChainTip {
+    std::string hash;           ///< Hash of the best block; empty until the first tip check.
+    std::int64_t height = -1;   ///< Height of the best block; -1 until the first tip check.
+};
+
+/**
+ * @class ResponseCache
+ * @brief An in-process LRU cache of RPC results that never change once confirmed.
+ *
+ * Only calls keyed by a block hash or a txid are cached:
+ * - `getblock`, `getblockheader`, `getblockfilter` and `getblockstats` by hash;
+ * - `getrawtransaction` in verbose mode, once the transaction is confirmed.
+ *
+ * Raw (hex) blocks and headers, block filters and block statistics are fully determined by
+ * the block hash and are cached unconditionally. Verbose blocks, headers and transactions
+ * also carry `confirmations` (and `nextblockhash`), which depend on the active chain: they
+ * are cached only once `minConfirmations` deep, remember the height of their block, and get
+ * `confirmations` rewritten from the tracked tip when served. When the tip moves, the owner
+ * reports the last common ancestor with `advanceTip()` and every height-dependent entry
+ * from that height up is dropped.
+ *
+ * All members are thread-safe. Cached results are shared and copied outside the lock.
+ */
+class ResponseCache {
+public:
+    /**
+     * @brief Creates an empty cache.
+     * @param settings Memory budget and freshness rules.
+     */
+    explicit ResponseCache(const CacheSettings& settings = {});
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    /**
+     * @brief Checks whether a call may be answered from the cache at all.
+     * @param method The RPC method.
+     * @param params The parameters of the call.
+     * @return `true` for the immutable, hash-keyed calls listed in the class description.
+     */
+    static bool isCacheable(const std::string& method, const Json::Value& params);
+
+    /**
+     * @brief Builds the cache key of a call.
+     */
+    static std::string makeKey(const std::string& method, const Json::Value& params);
+
+    /**
+     * @brief Looks a call up and marks it as recently used.
+     * @param key The key built by `makeKey()`.
+     * @return A copy of the cached result with an up-to-date `confirmations`, or nothing.
+     */
+    std::optional<Json::Value> lookup(const std::string& key);
+
+    /**
+     * @brief Stores the result of a call if it is safe to cache.
+     *
+     * Results fetched before the last reorg are rejected, so a stale answer never outlives
+     * the invalidation that should have removed it.
+     *
+     * @param key The key built by `makeKey()`.
+     * @param method The RPC method of the call.
+     * @param result The `result` member returned by the node.
+     * @param generation The value of `generation()` read before the call was sent.
+     */
+    void store(const std::string& key, const std::string& method, const Json::Value& result, std::uint64_t generation);
+
+    /**
+     * @brief Returns a counter that changes whenever entries are invalidated.
+     */
+    std::uint64_t generation() const { return invalidationGeneration.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Returns the best block as last reported by `advanceTip()`.
+     */
+    ChainTip tip() const;
+
+    /**
+     * @brief Claims the next tip check if it is due.
+     * @return `true` if the caller should poll the node and then call `finishTipCheck()`.
+     */
+    bool beginTipCheck();
+
+    /**
+     * @brief Releases the tip check claimed by `beginTipCheck()`.
+     */
+    void finishTipCheck();
+
+    /**
+     * @brief Records a new best block.
+     * @param newTip The new best block.
+     * @param forkHeight Height of the last block shared by the old and the new chain;
+     *        height-dependent entries at or above it are dropped. Pass 0 to drop all of them.
+     */
+    void advanceTip(const ChainTip& newTip, std::int64_t forkHeight);
+
+    /**
+     * @brief Returns the settings the cache was created with.
+     */
+    const CacheSettings& settings() const { return cacheSettings; }
+
+    /**
+     * @brief Returns the current counters.
+     */
+    CacheStats stats() const;
+
+    /**
+     * @brief Drops every entry.
+     */
+    void clear();
+
+private:
+    /**
+     * @struct Entry
+     * @brief One cached result.
+     */
+    struct Entry {
+        std::string key;                                ///< Key of the entry in `index`.
+        std::shared_ptr<const Json::Value> value;       ///< The cached result.
+        std::size_t bytes = 0;                          ///< Approximate memory held by `value`.
+        std::int64_t height = -1;                       ///< Height of the containing block; -1 if the result does not depend on the chain.
+    };
+
+    using EntryList = std::list<Entry>;
+
+    /**
+     * @brief Estimates the heap memory held by a JSON value.
+     */
+    static std::size_t footprint(const Json::Value& value);
+
+    /**
+     * @brief Removes an entry; the caller holds `mutex`.
+     */
+    void erase(EntryList::iterator entry);
+
+    CacheSettings cacheSettings;                                        ///< Budget and freshness rules.
+    mutable std::mutex mutex;                                           ///< Guards everything below.
+    EntryList entries;                                                  ///< Entries, most recently used first.
+    std::unordered_map<std::string, EntryList::iterator> index;         ///< Entries by key.
+    std::size_t totalBytes = 0;                                         ///< Sum of `Entry::bytes`.
+    ChainTip chainTip;                                                  ///< Best block as last seen.
+    std::chrono::steady_clock::time_point lastTipCheck {};              ///< When the tip was last polled.
+    bool tipCheckRunning = false;                                       ///< A thread is polling the tip.
+    CacheStats counters;                                                ///< Hit, miss and eviction counters.
+    std::atomic<std::uint64_t> invalidationGeneration {0};              ///< Bumped by every invalidation.
+};
+
+#endif // RESPONSECACHE_HPP
@@ -0,0 +1,112 @@
+#include "restclient.hpp"
+#include "logger.hpp"
+#include <format>
+
+namespace {
+constexpr std::size_t MIN_UTXO_SIZE = 4 + 4 + 8 + 1;   ///< Dummy version, height, value and empty script.
+
+/**
+ * @brief Checks that a hash or txid is 64 hex digits, so it can be put into a URL as is.
+ */
+bool isHexHash(const std::string& hash) {
+    Hash256 parsed;
+    return parseHash(hash, parsed);
+}
+}
+
+RestClient::RestClient(const std::string& url, const PoolSettings& settings)
+    : baseUrl(url), network(settings) {
+    if (baseUrl.empty() || baseUrl.back() != '/') baseUrl += '/';
+    baseUrl += "rest/";
+}
+
+bool RestClient::fetch(const std::string& path, std::vector<std::uint8_t>& out) {
+    out.clear();
+    const bool success = network.streamGetRequest(baseUrl + path, [&out](std::string_view chunk) {
+        out.insert(out.end(), chunk.begin(), chunk.end());
+        return true;
+    });
+    if (!success) {
+        Logger::formattedError("Failed to fetch REST resource: {}", path);
+        out.clear();
+    }
+    return success;
+}
+
+bool RestClient::getBlock(const std::string& blockHash, std::vector<std::uint8_t>& out) {
+    if (!isHexHash(blockHash)) {
+        Logger::formattedError("Invalid block hash: {}", blockHash);
+        return false;
+    }
+    return fetch(std::format("block/{}.bin", blockHash), out);
+}
+
+bool RestClient::getHeaders(const std::string& blockHash, std::size_t count, std::vector<std::uint8_t>& out) {
+    if (!isHexHash(blockHash)) {
+        Logger::formattedError("Invalid block hash: {}", blockHash);
+        return false;
+    }
+    return fetch(std::format("headers/{}.bin?count={}", blockHash, count), out);
+}
+
+bool RestClient::getTransaction(const std::string& txid, std::vector<std::uint8_t>& out) {
+    if (!isHexHash(txid)) {
+        Logger::formattedError("Invalid txid: {}", txid);
+        return false;
+    }
+    return fetch(std::format("tx/{}.bin", txid), out);
+}
+
+bool RestClient::getBlockHashByHeight(std::int64_t height, Hash256& hash) {
+    std::vector<std::uint8_t> out;
+    if (!fetch(std::format("blockhashbyheight/{}.bin", height), out)) return false;
+    ByteReader reader(out);
+    hash = reader.readHash();
+    return reader.atEnd();
+}
+
+bool RestClient::getUtxos(const std::vector<RestOutPoint>& outpoints, bool checkMempool,
+                          std::vector<std::uint8_t>& out, UtxoSetView& result) {
+    std::string path = checkMempool ? "getutxos/checkmempool" : "getutxos";
+    for (const RestOutPoint& outpoint : outpoints) {
+        if (!isHexHash(outpoint.txid)) {
+            Logger::formattedError("Invalid txid: {}", outpoint.txid);
+            return false;
+        }
+        path += std::format("/{}-{}", outpoint.txid, outpoint.index);
+    }
+    path += ".bin";
+
+    if (!fetch(path, out)) return false;
+    if (!parseUtxos(out, outpoints.size(), result)) {
+        Logger::error("Malformed getutxos response");
+        return false;
+    }
+    return true;
+}
+
+bool RestClient::parseUtxos(ByteSpan data, std::size_t requested, UtxoSetView& result) {
+    ByteReader reader(data);
+    result.chainHeight = reader.readI32();
+    result.chainTip = reader.readHash();
+
+    const ByteSpan bitmap = reader.readVarBytes();
+    if (reader.failed() || bitmap.size() != (requested + 7) / 8) return false;
+    result.found.assign(requested, false);
+    std::size_t flagged = 0;
+    for (std::size_t i = 0; i < requested; ++i) {
+        result.found[i] = (bitmap[i / 8] >> (i % 8)) & 1;
+        flagged += result.found[i];
+    }
+
+    const std::uint64_t count = reader.readCompactSize(reader.remaining() / MIN_UTXO_SIZE);
+    if (count != flagged) return false;
+    result.utxos.resize(count);
+    for (UtxoView& utxo : result.utxos) {
+        reader.readU32();  // Always-zero transaction version, kept for compatibility.
+        utxo.height = reader.readU32();
+        utxo.value = reader.readI64();
+        utxo.scriptPubKey = reader.readVarBytes();
+    }
+    return reader.atEnd();
+}
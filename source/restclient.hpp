@@ -0,0 +1,149 @@
+#ifndef RESTCLIENT_HPP
+#define RESTCLIENT_HPP
+
+#if __has_include("network.hpp")
+#   include "network.hpp"
+#else
+#   error "Bitcoin's \"network.hpp\" was not found!"
+#endif
+
+
+#if __has_include("rawblock.hpp")
+#   include "rawblock.hpp"
+#else
+#   error "Bitcoin's \"rawblock.hpp\" was not found!"
+#endif
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @struct RestOutPoint
+ * @brief A transaction output to look up with `getutxos`.
+ */
+struct RestOutPoint {
+    std::string txid;           ///< Txid in hex, as displayed.
+    std::uint32_t index = 0;    ///< Output index.
+};
+
+/**
+ * @struct UtxoView
+ * @brief One unspent output returned by `getutxos`.
+ */
+struct UtxoView {
+    std::uint32_t height = 0;   ///< Height of the block containing the output; 0x7FFFFFFF for mempool outputs.
+    Amount value = 0;           ///< Value in satoshis.
+    ByteSpan scriptPubKey;      ///< Locking script, a view of the response buffer.
+};
+
+/**
+ * @struct UtxoSetView
+ * @brief The decoded answer of `getutxos`.
+ */
+struct UtxoSetView {
+    std::int32_t chainHeight = 0;       ///< Height of the active chain tip.
+    Hash256 chainTip {};                ///< Hash of the active chain tip, internal byte order.
+    std::vector<bool> found;            ///< One flag per requested outpoint: whether it is unspent.
+    std::vector<UtxoView> utxos;        ///< The unspent outputs, in request order, for the flagged outpoints only.
+};
+
+/**
+ * @class RestClient
+ * @brief Fetches blocks, headers and UTXOs from bitcoind's binary REST interface.
+ *
+ * The REST interface (enabled with `-rest`) serves raw serialized data without hex encoding
+ * or JSON, which halves the bytes on the wire and skips all JSON parsing. Responses are
+ * written into caller-supplied buffers, so a buffer reused across calls stops allocating once
+ * it reaches the largest response size, and can be decoded in place with `parseBlock` and
+ * friends.
+ *
+ * The REST interface is unauthenticated and read-only. Hashes and txids are passed in hex,
+ * as displayed by the RPC interface.
+ *
+ * @code
+ * RestClient rest("http://127.0.0.1:8332/");
+ * std::vector<std::uint8_t> buffer;
+ * BlockView block;
+ * if (rest.getBlock(blockHash, buffer) && parseBlock(buffer, block)) {
+ *     std::cout << block.transactions.size() << std::endl;
+ * }
+ * @endcode
+ */
+class RestClient {
+public:
+    /**
+     * @brief Creates a client for the REST interface of a node.
+     * @param url Base URL of the node (default: http://127.0.0.1:8332/).
+     * @param settings Connection pool settings.
+     */
+    explicit RestClient(const std::string& url = "http://127.0.0.1:8332/", const PoolSettings& settings = {});
+
+    /**
+     * @brief Fetches a serialized block (`/rest/block/<hash>.bin`).
+     * @param blockHash The hash of the block.
+     * @param[out] out Receives the block; its capacity is reused.
+     * @return `true` on success; `false` on failure or if the block is unknown.
+     */
+    bool getBlock(const std::string& blockHash, std::vector<std::uint8_t>& out);
+
+    /**
+     * @brief Fetches up to `count` consecutive 80-byte headers starting at a block (`/rest/headers/<hash>.bin`).
+     * @param blockHash The hash of the first block.
+     * @param count The maximum number of headers (the node caps it at 2000).
+     * @param[out] out Receives the concatenated headers.
+     * @return `true` on success; `false` otherwise.
+     */
+    bool getHeaders(const std::string& blockHash, std::size_t count, std::vector<std::uint8_t>& out);
+
+    /**
+     * @brief Fetches a serialized transaction (`/rest/tx/<txid>.bin`); needs `-txindex` for confirmed transactions.
+     * @param txid The transaction ID.
+     * @param[out] out Receives the transaction.
+     * @return `true` on success; `false` otherwise.
+     */
+    bool getTransaction(const std::string& txid, std::vector<std::uint8_t>& out);
+
+    /**
+     * @brief Looks up the hash of the active-chain block at a height (`/rest/blockhashbyheight/<height>.bin`).
+     * @param height The block height.
+     * @param[out] hash Receives the hash, internal byte order.
+     * @return `true` on success; `false` otherwise.
+     */
+    bool getBlockHashByHeight(std::int64_t height, Hash256& hash);
+
+    /**
+     * @brief Looks up unspent outputs (`/rest/getutxos[/checkmempool]/<txid>-<n>/....bin`).
+     * @param outpoints The outputs to look up (the node accepts at most 15 per request).
+     * @param checkMempool Whether to account for the mempool.
+     * @param[out] out Receives the raw response, which `result` points into.
+     * @param[out] result The decoded response.
+     * @return `true` on success; `false` otherwise.
+     */
+    bool getUtxos(const std::vector<RestOutPoint>& outpoints, bool checkMempool,
+                  std::vector<std::uint8_t>& out, UtxoSetView& result);
+
+    /**
+     * @brief Returns the network instance used for the transfers.
+     */
+    Network& transport() { return network; }
+
+private:
+    /**
+     * @brief Fetches a REST resource into a buffer.
+     * @param path The resource path below `/rest/`.
+     * @param[out] out Receives the body.
+     * @return `true` on success; `false` otherwise.
+     */
+    bool fetch(const std::string& path, std::vector<std::uint8_t>& out);
+
+    /**
+     * @brief Decodes a `getutxos` response.
+     */
+    static bool parseUtxos(ByteSpan data, std::size_t requested, UtxoSetView& result);
+
+    std::string baseUrl;    ///< Base URL of the REST interface, ending in `/rest/`.
+    Network network;        ///< Network instance for handling HTTP requests.
+};
+
+#endif // RESTCLIENT_HPP
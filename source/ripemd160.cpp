@@ -0,0 +1,105 @@
+#include "ripemd160.hpp"
+#include "sha256.hpp"
+#include <cstring>
+
+namespace {
+constexpr std::uint8_t LEFT_WORDS[80] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+    7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8,
+    3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12,
+    1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2,
+    4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13,
+};
+
+constexpr std::uint8_t RIGHT_WORDS[80] = {
+    5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12,
+    6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2,
+    15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13,
+    8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14,
+    12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11,
+};
+
+constexpr std::uint8_t LEFT_SHIFTS[80] = {
+    11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8,
+    7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12,
+    11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5,
+    11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12,
+    9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6,
+};
+
+constexpr std::uint8_t RIGHT_SHIFTS[80] = {
+    8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6,
+    9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11,
+    9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5,
+    15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8,
+    8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11,
+};
+
+constexpr std::uint32_t LEFT_CONSTANTS[5] = {0x00000000, 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xa953fd4e};
+constexpr std::uint32_t RIGHT_CONSTANTS[5] = {0x50a28be6, 0x5c4dd124, 0x6d703ef3, 0x7a6d76e9, 0x00000000};
+
+inline std::uint32_t rotl(std::uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+/**
+ * @brief The boolean function of round `round`; the right line runs them in reverse order.
+ */
+inline std::uint32_t mix(int round, std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+    switch (round) {
+    case 0: return x ^ y ^ z;
+    case 1: return (x & y) | (~x & z);
+    case 2: return (x | ~y) ^ z;
+    case 3: return (x & z) | (y & ~z);
+    default: return x ^ (y | ~z);
+    }
+}
+
+void transform(std::uint32_t* state, const std::uint8_t* block) {
+    std::uint32_t w[16];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = std::uint32_t(block[4 * i]) | std::uint32_t(block[4 * i + 1]) << 8 | std::uint32_t(block[4 * i + 2]) << 16
+             | std::uint32_t(block[4 * i + 3]) << 24;
+    }
+
+    std::uint32_t al = state[0], bl = state[1], cl = state[2], dl = state[3], el = state[4];
+    std::uint32_t ar = al, br = bl, cr = cl, dr = dl, er = el;
+    for (int j = 0; j < 80; ++j) {
+        const int round = j / 16;
+        std::uint32_t t = rotl(al + mix(round, bl, cl, dl) + w[LEFT_WORDS[j]] + LEFT_CONSTANTS[round], LEFT_SHIFTS[j]) + el;
+        al = el; el = dl; dl = rotl(cl, 10); cl = bl; bl = t;
+        t = rotl(ar + mix(4 - round, br, cr, dr) + w[RIGHT_WORDS[j]] + RIGHT_CONSTANTS[round], RIGHT_SHIFTS[j]) + er;
+        ar = er; er = dr; dr = rotl(cr, 10); cr = br; br = t;
+    }
+    const std::uint32_t t = state[1] + cl + dr;
+    state[1] = state[2] + dl + er;
+    state[2] = state[3] + el + ar;
+    state[3] = state[4] + al + br;
+    state[4] = state[0] + bl + cr;
+    state[0] = t;
+}
+}
+
+std::array<std::uint8_t, 20> ripemd160(std::span<const std::uint8_t> data) {
+    std::uint32_t state[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    const std::size_t blocks = data.size() / 64;
+    for (std::size_t i = 0; i < blocks; ++i) transform(state, data.data() + 64 * i);
+
+    // Pad to 56 bytes modulo 64, then append the length in bits, little-endian.
+    std::uint8_t tail[128] = {};
+    const std::size_t rest = data.size() % 64;
+    std::memcpy(tail, data.data() + 64 * blocks, rest);
+    tail[rest] = 0x80;
+    const std::size_t tailSize = rest < 56 ? 64 : 128;
+    const std::uint64_t bits = std::uint64_t(data.size()) * 8;
+    for (int i = 0; i < 8; ++i) tail[tailSize - 8 + i] = static_cast<std::uint8_t>(bits >> (8 * i));
+    for (std::size_t offset = 0; offset < tailSize; offset += 64) transform(state, tail + offset);
+
+    std::array<std::uint8_t, 20> digest;
+    for (int word = 0; word < 5; ++word) {
+        for (int i = 0; i < 4; ++i) digest[4 * word + i] = static_cast<std::uint8_t>(state[word] >> (8 * i));
+    }
+    return digest;
+}
+
+std::array<std::uint8_t, 20> hash160(std::span<const std::uint8_t> data) {
+    return ripemd160(Sha256().write(data).finalize());
+}
@@ -0,0 +1,19 @@
+#ifndef RIPEMD160_HPP
+#define RIPEMD160_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <span>
+
+/**
+ * @brief Returns `RIPEMD160(data)`.
+ */
+std::array<std::uint8_t, 20> ripemd160(std::span<const std::uint8_t> data);
+
+/**
+ * @brief Returns `RIPEMD160(SHA256(data))`, the hash in P2PKH, P2SH and P2WPKH outputs.
+ */
+std::array<std::uint8_t, 20> hash160(std::span<const std::uint8_t> data);
+
+#endif // RIPEMD160_HPP
@@ -0,0 +1,118 @@
+#ifndef RPCBATCH_HPP
+#define RPCBATCH_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#if __has_include(<json/json.h>)
+#   include <json/json.h>
+#else
+#   error "Bitcoin's <json/json.h> was not found!"
+#endif
+
+#if __has_include("rpcmethods.hpp")
+#   include "rpcmethods.hpp"
+#else
+#   error "Bitcoin's \"rpcmethods.hpp\" was not found!"
+#endif
+
+/**
+ * @struct RpcResult
+ * @brief The outcome of one call inside a JSON-RPC batch.
+ */
+struct RpcResult {
+    Json::Value result;   ///< The `result` member of the response (null on error).
+    Json::Value error;    ///< The `error` member of the response; null if the call succeeded.
+    bool transportFailure = false;  ///< No well-formed answer was received from the node (connection failure, garbage body).
+
+    /**
+     * @brief Checks whether the call succeeded.
+     */
+    bool ok() const { return error.isNull(); }
+};
+
+/**
+ * @class RpcBatch
+ * @brief Collects several JSON-RPC calls to be sent to the node in one HTTP request.
+ *
+ * Calls are queued with `add()` or `call()` and later sent with `BitcoinClient::sendBatch()`,
+ * which returns one `RpcResult` per call, in the order the calls were added.
+ *
+ * @code
+ * RpcBatch batch;
+ * for (int height = 0; height < 100; ++height) batch.call("getblockhash", height);
+ * auto hashes = client.sendBatch(batch);
+ * @endcode
+ */
+class RpcBatch {
+public:
+    /**
+     * @brief A queued call.
+     */
+    struct Call {
+        std::string method;   ///< The RPC method name.
+        Json::Value params;   ///< The positional parameters (null or array).
+    };
+
+    /**
+     * @brief Queues a call with pre-built parameters.
+     * @param method The RPC method to call.
+     * @param params The parameters for the RPC method (default: empty).
+     * @return The index of the call's result in the vector returned by `BitcoinClient::sendBatch()`.
+     */
+    std::size_t add(const std::string& method, const Json::Value& params = Json::Value()) {
+        calls.push_back({method, params});
+        return calls.size() - 1;
+    }
+
+    /**
+     * @brief Queues a call, building the parameter array from the arguments.
+     * @tparam Args Types of the parameters (anything `Json::Value::append` accepts).
+     * @param method The RPC method to call.
+     * @param args Parameters of the call, in positional order.
+     * @return The index of the call's result in the vector returned by `BitcoinClient::sendBatch()`.
+     */
+    template<typename... Args>
+    std::size_t call(const std::string& method, Args&&... args) {
+        Json::Value params;
+        (params.append(std::forward<Args>(args)), ...);
+        return add(method, params);
+    }
+
+    /**
+     * @brief Queues a call of a method from the method table.
+     * @tparam Method The method.
+     * @param args Parameters of the call, in positional order (as for `BitcoinClient::call`).
+     * @return The index of the call's result in the vector returned by `BitcoinClient::sendBatch()`.
+     */
+    template<RpcMethod Method, typename... Args>
+    std::size_t call(const Args&... args) {
+        return add(std::string(rpcMethodName(Method)), toJsonParams(args...));
+    }
+
+    /**
+     * @brief Returns the queued calls.
+     */
+    const std::vector<Call>& entries() const { return calls; }
+
+    /**
+     * @brief Returns the number of queued calls.
+     */
+    std::size_t size() const { return calls.size(); }
+
+    /**
+     * @brief Checks whether no call has been queued.
+     */
+    bool empty() const { return calls.empty(); }
+
+    /**
+     * @brief Removes all queued calls.
+     */
+    void clear() { calls.clear(); }
+
+private:
+    std::vector<Call> calls;
+};
+
+#endif // RPCBATCH_HPP
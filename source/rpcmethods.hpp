@@ -0,0 +1,368 @@
+#ifndef RPCMETHODS_HPP
+#define RPCMETHODS_HPP
+
+#if __has_include("jsonwriter.hpp")
+#   include "jsonwriter.hpp"
+#else
+#   error "Bitcoin's \"jsonwriter.hpp\" was not found!"
+#endif
+
+#if __has_include("rpctypes.hpp")
+#   include "rpctypes.hpp"
+#else
+#   error "Bitcoin's \"rpctypes.hpp\" was not found!"
+#endif
+
+#include <array>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @enum RpcTraits
+ * @brief What the client may assume about an RPC method; combined as bit flags.
+ */
+enum RpcTraits : std::uint8_t {
+    RPC_STATEFUL = 0,           ///< None of the below: the call changes node state.
+    RPC_READ_ONLY = 1 << 0,     ///< Only reads chain, mempool or utility state; every synchronized node gives the same answer.
+    RPC_IDEMPOTENT = 1 << 1,    ///< Repeating the call has no further effect, so it is retried after an ambiguous failure.
+    RPC_IMMUTABLE = 1 << 2,     ///< Answers about a block or transaction by hash never change; ResponseCache may keep them.
+    RPC_WALLET = 1 << 3,        ///< Served by the wallet selected by the endpoint.
+    RPC_HEAVY = 1 << 4,         ///< Keeps a node worker busy for seconds or more; AdmissionControl caps how many run at once.
+};
+
+constexpr RpcTraits operator|(RpcTraits a, RpcTraits b) {
+    return static_cast<RpcTraits>(static_cast<std::uint8_t>(a) | static_cast<std::uint8_t>(b));
+}
+
+/**
+ * @name Trait shorthands used by the method table
+ * @{
+ */
+inline constexpr RpcTraits RPC_QUERY = RPC_READ_ONLY | RPC_IDEMPOTENT;             ///< Chain, mempool or utility read.
+inline constexpr RpcTraits RPC_CHAIN_DATA = RPC_QUERY | RPC_IMMUTABLE;             ///< Block or transaction lookup by hash.
+inline constexpr RpcTraits RPC_NODE_QUERY = RPC_IDEMPOTENT;                        ///< Read of node-specific state (peers, memory, ...).
+inline constexpr RpcTraits RPC_WALLET_QUERY = RPC_WALLET | RPC_IDEMPOTENT;         ///< Wallet read, or a wallet call that is safe to repeat.
+/** @} */
+
+/**
+ * @brief The table of every RPC method the client knows, as `X(name, traits)`.
+ *
+ * This is the single description of the RPC interface: `RpcMethod`, the method names, their
+ * traits, and with them the cache, retry and replica-routing decisions are generated from it.
+ * Wallet methods, broadcasts, block templates and submissions, network and node-administration
+ * calls are never `RPC_READ_ONLY`: their answer depends on the node that serves them, or they
+ * change its state. `getmininginfo` and `getnetworkhashps` only summarize the chain, so they are.
+ */
+#define BITCOIN_RPC_METHODS(X) \
+    /* Blockchain */ \
+    X(getbestblockhash, RPC_QUERY) \
+    X(getblock, RPC_CHAIN_DATA) \
+    X(getblockchaininfo, RPC_QUERY) \
+    X(getblockcount, RPC_QUERY) \
+    X(getblockfilter, RPC_CHAIN_DATA) \
+    X(getblockhash, RPC_QUERY) \
+    X(getblockheader, RPC_CHAIN_DATA) \
+    X(getblockstats, RPC_CHAIN_DATA) \
+    X(getchaintips, RPC_QUERY) \
+    X(getchaintxstats, RPC_QUERY) \
+    X(getdeploymentinfo, RPC_QUERY) \
+    X(getdifficulty, RPC_QUERY) \
+    X(getmempoolancestors, RPC_QUERY) \
+    X(getmempooldescendants, RPC_QUERY) \
+    X(getmempoolentry, RPC_QUERY) \
+    X(getmempoolinfo, RPC_QUERY) \
+    X(getrawmempool, RPC_QUERY) \
+    X(gettxout, RPC_QUERY) \
+    X(gettxoutproof, RPC_QUERY) \
+    X(gettxoutsetinfo, RPC_QUERY | RPC_HEAVY) \
+    X(gettxspendingprevout, RPC_QUERY) \
+    X(preciousblock, RPC_IDEMPOTENT) \
+    X(pruneblockchain, RPC_STATEFUL) \
+    X(savemempool, RPC_IDEMPOTENT) \
+    X(scantxoutset, RPC_HEAVY) \
+    X(verifychain, RPC_NODE_QUERY | RPC_HEAVY) \
+    X(verifytxoutproof, RPC_QUERY) \
+    /* Control */ \
+    X(getmemoryinfo, RPC_NODE_QUERY) \
+    X(getrpcinfo, RPC_NODE_QUERY) \
+    X(help, RPC_NODE_QUERY) \
+    X(logging, RPC_STATEFUL) \
+    X(stop, RPC_STATEFUL) \
+    X(uptime, RPC_NODE_QUERY) \
+    /* Generating and mining */ \
+    X(generateblock, RPC_STATEFUL) \
+    X(generatetoaddress, RPC_STATEFUL) \
+    X(generatetodescriptor, RPC_STATEFUL) \
+    X(getblocktemplate, RPC_NODE_QUERY) \
+    X(getmininginfo, RPC_QUERY) \
+    X(getnetworkhashps, RPC_QUERY) \
+    X(prioritisetransaction, RPC_STATEFUL) \
+    X(submitblock, RPC_IDEMPOTENT) \
+    X(submitheader, RPC_IDEMPOTENT) \
+    /* Network */ \
+    X(addnode, RPC_STATEFUL) \
+    X(clearbanned, RPC_IDEMPOTENT) \
+    X(disconnectnode, RPC_STATEFUL) \
+    X(getaddednodeinfo, RPC_NODE_QUERY) \
+    X(getconnectioncount, RPC_NODE_QUERY) \
+    X(getnettotals, RPC_NODE_QUERY) \
+    X(getnetworkinfo, RPC_NODE_QUERY) \
+    X(getnodeaddresses, RPC_NODE_QUERY) \
+    X(getpeerinfo, RPC_NODE_QUERY) \
+    X(listbanned, RPC_NODE_QUERY) \
+    X(ping, RPC_NODE_QUERY) \
+    X(setban, RPC_STATEFUL) \
+    X(setnetworkactive, RPC_IDEMPOTENT) \
+    X(getzmqnotifications, RPC_NODE_QUERY) \
+    /* Raw transactions */ \
+    X(analyzepsbt, RPC_QUERY) \
+    X(combinepsbt, RPC_IDEMPOTENT) \
+    X(combinerawtransaction, RPC_IDEMPOTENT) \
+    X(converttopsbt, RPC_IDEMPOTENT) \
+    X(createpsbt, RPC_QUERY) \
+    X(createrawtransaction, RPC_QUERY) \
+    X(decodepsbt, RPC_QUERY) \
+    X(decoderawtransaction, RPC_QUERY) \
+    X(decodescript, RPC_QUERY) \
+    X(finalizepsbt, RPC_IDEMPOTENT) \
+    X(fundrawtransaction, RPC_WALLET) \
+    X(getrawtransaction, RPC_CHAIN_DATA) \
+    X(joinpsbts, RPC_IDEMPOTENT) \
+    X(sendrawtransaction, RPC_IDEMPOTENT) \
+    X(signrawtransactionwithkey, RPC_IDEMPOTENT) \
+    X(testmempoolaccept, RPC_QUERY) \
+    X(utxoupdatepsbt, RPC_IDEMPOTENT) \
+    /* Utilities */ \
+    X(createmultisig, RPC_QUERY) \
+    X(deriveaddresses, RPC_QUERY) \
+    X(estimatesmartfee, RPC_QUERY) \
+    X(getdescriptorinfo, RPC_QUERY) \
+    X(getindexinfo, RPC_NODE_QUERY) \
+    X(signmessagewithprivkey, RPC_IDEMPOTENT) \
+    X(validateaddress, RPC_QUERY) \
+    X(verifymessage, RPC_QUERY) \
+    /* Wallet management */ \
+    X(createwallet, RPC_STATEFUL) \
+    X(listwalletdir, RPC_NODE_QUERY) \
+    X(listwallets, RPC_NODE_QUERY) \
+    X(loadwallet, RPC_STATEFUL) \
+    X(unloadwallet, RPC_WALLET) \
+    /* Wallet */ \
+    X(abandontransaction, RPC_WALLET_QUERY) \
+    X(abortrescan, RPC_WALLET) \
+    X(addmultisigaddress, RPC_WALLET) \
+    X(backupwallet, RPC_WALLET) \
+    X(bumpfee, RPC_WALLET) \
+    X(dumpprivkey, RPC_WALLET_QUERY) \
+    X(dumpwallet, RPC_WALLET) \
+    X(encryptwallet, RPC_WALLET) \
+    X(getaddressesbylabel, RPC_WALLET_QUERY) \
+    X(getaddressinfo, RPC_WALLET_QUERY) \
+    X(getbalance, RPC_WALLET_QUERY) \
+    X(getbalances, RPC_WALLET_QUERY) \
+    X(getnewaddress, RPC_WALLET) \
+    X(getrawchangeaddress, RPC_WALLET) \
+    X(getreceivedbyaddress, RPC_WALLET_QUERY) \
+    X(getreceivedbylabel, RPC_WALLET_QUERY) \
+    X(gettransaction, RPC_WALLET_QUERY) \
+    X(getunconfirmedbalance, RPC_WALLET_QUERY) \
+    X(getwalletinfo, RPC_WALLET_QUERY) \
+    X(importaddress, RPC_WALLET) \
+    X(importdescriptors, RPC_WALLET | RPC_HEAVY) \
+    X(importmulti, RPC_WALLET | RPC_HEAVY) \
+    X(importprivkey, RPC_WALLET) \
+    X(importprunedfunds, RPC_WALLET) \
+    X(importpubkey, RPC_WALLET) \
+    X(importwallet, RPC_WALLET | RPC_HEAVY) \
+    X(keypoolrefill, RPC_WALLET_QUERY) \
+    X(listaddressgroupings, RPC_WALLET_QUERY) \
+    X(listlabels, RPC_WALLET_QUERY) \
+    X(listlockunspent, RPC_WALLET_QUERY) \
+    X(listreceivedbyaddress, RPC_WALLET_QUERY) \
+    X(listreceivedbylabel, RPC_WALLET_QUERY) \
+    X(listsinceblock, RPC_WALLET_QUERY) \
+    X(listtransactions, RPC_WALLET_QUERY) \
+    X(listunspent, RPC_WALLET_QUERY) \
+    X(lockunspent, RPC_WALLET) \
+    X(psbtbumpfee, RPC_WALLET) \
+    X(removeprunedfunds, RPC_WALLET) \
+    X(rescanblockchain, RPC_WALLET | RPC_HEAVY) \
+    X(send, RPC_WALLET) \
+    X(sendmany, RPC_WALLET) \
+    X(sendtoaddress, RPC_WALLET) \
+    X(sethdseed, RPC_WALLET) \
+    X(setlabel, RPC_WALLET_QUERY) \
+    X(settxfee, RPC_WALLET_QUERY) \
+    X(setwalletflag, RPC_WALLET) \
+    X(signmessage, RPC_WALLET_QUERY) \
+    X(signrawtransactionwithwallet, RPC_WALLET_QUERY) \
+    X(upgradewallet, RPC_WALLET) \
+    X(walletcreatefundedpsbt, RPC_WALLET) \
+    X(walletlock, RPC_WALLET_QUERY) \
+    X(walletpassphrase, RPC_WALLET_QUERY) \
+    X(walletpassphrasechange, RPC_WALLET) \
+    X(walletprocesspsbt, RPC_WALLET_QUERY)
+
+/**
+ * @brief Results that have a typed decoder, as `X(name, result type)`; see `BitcoinClient::callTyped`.
+ */
+#define BITCOIN_RPC_TYPED_RESULTS(X) \
+    X(getblockheader, BlockHeaderResult) \
+    X(gettxout, TxOutResult) \
+    X(getmempoolentry, MempoolEntryResult) \
+    X(getblockstats, BlockStatsResult) \
+    X(estimatesmartfee, SmartFeeResult) \
+    X(getblockchaininfo, BlockchainInfoResult)
+
+/**
+ * @enum RpcMethod
+ * @brief One enumerator per entry of `BITCOIN_RPC_METHODS`, named like the RPC.
+ */
+enum class RpcMethod : std::uint16_t {
+#define BITCOIN_RPC_ENUMERATOR(name, traits) name,
+    BITCOIN_RPC_METHODS(BITCOIN_RPC_ENUMERATOR)
+#undef BITCOIN_RPC_ENUMERATOR
+};
+
+/**
+ * @struct RpcMethodInfo
+ * @brief One row of the method table.
+ */
+struct RpcMethodInfo {
+    std::string_view name;      ///< The RPC name; static storage, so it can be kept without copying.
+    RpcTraits traits;
+};
+
+/**
+ * @brief The method table, indexed by RpcMethod.
+ */
+inline constexpr RpcMethodInfo RPC_METHOD_TABLE[] = {
+#define BITCOIN_RPC_ROW(name, traits) {#name, traits},
+    BITCOIN_RPC_METHODS(BITCOIN_RPC_ROW)
+#undef BITCOIN_RPC_ROW
+};
+
+inline constexpr std::size_t RPC_METHOD_COUNT = std::size(RPC_METHOD_TABLE);
+
+/**
+ * @brief The method table sorted by name, for lookups of methods given as strings.
+ */
+inline constexpr std::array<RpcMethodInfo, RPC_METHOD_COUNT> RPC_METHODS_BY_NAME = [] {
+    std::array<RpcMethodInfo, RPC_METHOD_COUNT> sorted {};
+    std::copy(std::begin(RPC_METHOD_TABLE), std::end(RPC_METHOD_TABLE), sorted.begin());
+    std::ranges::sort(sorted, {}, &RpcMethodInfo::name);
+    return sorted;
+}();
+
+static_assert(std::ranges::adjacent_find(RPC_METHODS_BY_NAME, {}, &RpcMethodInfo::name) == RPC_METHODS_BY_NAME.end(),
+              "BITCOIN_RPC_METHODS lists a method twice");
+
+/**
+ * @brief Returns the RPC name of a method.
+ */
+constexpr std::string_view rpcMethodName(RpcMethod method) {
+    return RPC_METHOD_TABLE[static_cast<std::size_t>(method)].name;
+}
+
+/**
+ * @brief Returns the traits of a method.
+ */
+constexpr RpcTraits rpcMethodTraits(RpcMethod method) {
+    return RPC_METHOD_TABLE[static_cast<std::size_t>(method)].traits;
+}
+
+/**
+ * @brief Returns the traits of a method given by name; `RPC_STATEFUL` for methods not in the table.
+ */
+constexpr RpcTraits rpcMethodTraits(std::string_view method) {
+    const auto found = std::ranges::lower_bound(RPC_METHODS_BY_NAME, method, {}, &RpcMethodInfo::name);
+    return found != RPC_METHODS_BY_NAME.end() && found->name == method ? found->traits : RPC_STATEFUL;
+}
+
+/**
+ * @brief Checks whether a method may be served by any synchronized replica.
+ */
+constexpr bool isReadOnlyMethod(std::string_view method) {
+    return (rpcMethodTraits(method) & RPC_READ_ONLY) != 0;
+}
+
+/**
+ * @brief Checks whether a method may be repeated after a failure that left its outcome unknown.
+ */
+constexpr bool isIdempotentMethod(std::string_view method) {
+    return (rpcMethodTraits(method) & RPC_IDEMPOTENT) != 0;
+}
+
+/**
+ * @brief Checks whether a method ties up a node worker for long; see `RPC_HEAVY`.
+ */
+constexpr bool isHeavyMethod(std::string_view method) {
+    return (rpcMethodTraits(method) & RPC_HEAVY) != 0;
+}
+
+/**
+ * @struct RpcMethodLiteral
+ * @brief The JSON-escaped name of a method, to copy into request payloads as is.
+ */
+template<RpcMethod Method>
+struct RpcMethodLiteral;
+
+#define BITCOIN_RPC_LITERAL(name, traits) \
+    template<> struct RpcMethodLiteral<RpcMethod::name> { static constexpr JsonLiteral value {#name}; };
+BITCOIN_RPC_METHODS(BITCOIN_RPC_LITERAL)
+#undef BITCOIN_RPC_LITERAL
+
+/**
+ * @struct RpcTypedResult
+ * @brief The typed result struct of a method; only defined for `BITCOIN_RPC_TYPED_RESULTS`.
+ */
+template<RpcMethod Method>
+struct RpcTypedResult;
+
+#define BITCOIN_RPC_TYPED_RESULT(name, result) \
+    template<> struct RpcTypedResult<RpcMethod::name> { using type = result; };
+BITCOIN_RPC_TYPED_RESULTS(BITCOIN_RPC_TYPED_RESULT)
+#undef BITCOIN_RPC_TYPED_RESULT
+
+/**
+ * @name Parameter conversion
+ * @brief Builds a Json::Value parameter array from the arguments `JsonWriter::rpcRequest` accepts.
+ *
+ * Needed where calls are kept as Json::Value: cache keys, batches and streamed requests.
+ * @{
+ */
+template<typename T>
+Json::Value toJsonParam(const T& value) { return Json::Value(value); }
+
+inline Json::Value toJsonParam(std::string_view value) { return Json::Value(value.data(), value.data() + value.size()); }
+
+template<typename T>
+Json::Value toJsonParam(const std::optional<T>& value) { return value ? toJsonParam(*value) : Json::Value(); }
+
+template<typename T>
+Json::Value toJsonParam(const std::vector<T>& values) {
+    Json::Value array(Json::arrayValue);
+    for (const T& value : values) array.append(toJsonParam(value));
+    return array;
+}
+
+template<typename T>
+Json::Value toJsonParam(const std::map<std::string, T>& members) {
+    Json::Value object(Json::objectValue);
+    for (const auto& [key, value] : members) object[key] = toJsonParam(value);
+    return object;
+}
+
+template<typename... Args>
+Json::Value toJsonParams(const Args&... args) {
+    Json::Value params(Json::arrayValue);
+    (params.append(toJsonParam(args)), ...);
+    return params;
+}
+/** @} */
+
+#endif // RPCMETHODS_HPP
@@ -0,0 +1,288 @@
+#include "rpctypes.hpp"
+#include "hexcodec.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+template<typename T>
+bool toInteger(const JsonScalar& value, T& out) {
+    if (value.kind != JsonScalar::Kind::Number) return false;
+    const char* end = value.text.data() + value.text.size();
+    const auto [ptr, ec] = std::from_chars(value.text.data(), end, out);
+    return ec == std::errc() && ptr == end;
+}
+
+bool toDouble(const JsonScalar& value, double& out) {
+    if (value.kind != JsonScalar::Kind::Number) return false;
+    const char* end = value.text.data() + value.text.size();
+    const auto [ptr, ec] = std::from_chars(value.text.data(), end, out);
+    return ec == std::errc() && ptr == end;
+}
+
+bool toAmount(const JsonScalar& value, Amount& out) {
+    return value.kind == JsonScalar::Kind::Number && parseAmount(value.text, out);
+}
+
+bool toHash(const JsonScalar& value, Hash256& out) {
+    return value.kind == JsonScalar::Kind::String && parseHash(value.text, out);
+}
+
+bool toBool(const JsonScalar& value, bool& out) {
+    if (value.kind != JsonScalar::Kind::Bool) return false;
+    out = value.boolean;
+    return true;
+}
+
+bool toString(const JsonScalar& value, std::string& out) {
+    if (value.kind != JsonScalar::Kind::String) return false;
+    out.assign(value.text);
+    return true;
+}
+
+bool toCompactBits(const JsonScalar& value, std::uint32_t& out) {
+    if (value.kind != JsonScalar::Kind::String) return false;
+    const char* end = value.text.data() + value.text.size();
+    const auto [ptr, ec] = std::from_chars(value.text.data(), end, out, 16);
+    return ec == std::errc() && ptr == end;
+}
+
+} // namespace
+
+bool parseHash(std::string_view hex, Hash256& out) {
+    if (hex.size() != 64 || !decodeHex(hex, out.data())) return false;
+    std::reverse(out.begin(), out.end());
+    return true;
+}
+
+std::string hashToHex(const Hash256& hash) {
+    Hash256 displayed;
+    std::reverse_copy(hash.begin(), hash.end(), displayed.begin());
+    return encodeHex(displayed);
+}
+
+bool parseHex(std::string_view hex, std::vector<std::uint8_t>& out) {
+    if (hex.size() % 2 != 0) return false;
+    out.resize(hex.size() / 2);
+    return decodeHex(hex, out.data());
+}
+
+bool parseAmount(std::string_view raw, Amount& out) {
+    if (raw.find_first_of("eE") != std::string_view::npos) {
+        // RPC never formats amounts in exponent notation, but accept it for robustness.
+        double value = 0.0;
+        const auto [ptr, ec] = std::from_chars(raw.data(), raw.data() + raw.size(), value);
+        if (ec != std::errc() || ptr != raw.data() + raw.size() || !std::isfinite(value)) return false;
+        const double scaled = std::round(value * static_cast<double>(COIN));
+        if (std::fabs(scaled) >= static_cast<double>(std::numeric_limits<Amount>::max())) return false;
+        out = static_cast<Amount>(scaled);
+        return true;
+    }
+
+    std::size_t i = 0;
+    const bool negative = !raw.empty() && raw[0] == '-';
+    if (negative) ++i;
+
+    Amount whole = 0;
+    const std::size_t wholeStart = i;
+    while (i < raw.size() && raw[i] >= '0' && raw[i] <= '9') {
+        if (whole > (std::numeric_limits<Amount>::max() / COIN - 9) / 10) return false;
+        whole = whole * 10 + (raw[i++] - '0');
+    }
+    if (i == wholeStart) return false;
+
+    Amount fraction = 0;
+    int decimals = 0;
+    if (i < raw.size() && raw[i] == '.') {
+        ++i;
+        const std::size_t fractionStart = i;
+        for (; i < raw.size() && raw[i] >= '0' && raw[i] <= '9'; ++i) {
+            if (decimals < 8) {
+                fraction = fraction * 10 + (raw[i] - '0');
+                ++decimals;
+            } else if (raw[i] != '0') {
+                return false;                       // Finer than one satoshi.
+            }
+        }
+        if (i == fractionStart) return false;
+    }
+    if (i != raw.size()) return false;
+
+    for (; decimals < 8; ++decimals) fraction *= 10;
+    const Amount amount = whole * COIN + fraction;
+    out = negative ? -amount : amount;
+    return true;
+}
+
+ScriptType scriptTypeFromName(std::string_view name) {
+    if (name == "witness_v0_keyhash") return ScriptType::WitnessV0KeyHash;
+    if (name == "witness_v1_taproot") return ScriptType::WitnessV1Taproot;
+    if (name == "pubkeyhash") return ScriptType::PubKeyHash;
+    if (name == "scripthash") return ScriptType::ScriptHash;
+    if (name == "witness_v0_scripthash") return ScriptType::WitnessV0ScriptHash;
+    if (name == "pubkey") return ScriptType::PubKey;
+    if (name == "multisig") return ScriptType::MultiSig;
+    if (name == "nulldata") return ScriptType::NullData;
+    if (name == "witness_unknown") return ScriptType::WitnessUnknown;
+    if (name == "anchor") return ScriptType::Anchor;
+    return ScriptType::NonStandard;
+}
+
+bool decodeField(BlockHeaderResult& out, std::string_view path, const JsonScalar& value) {
+    if (path == "hash") return toHash(value, out.hash);
+    if (path == "confirmations") return toInteger(value, out.confirmations);
+    if (path == "height") return toInteger(value, out.height);
+    if (path == "version") return toInteger(value, out.version);
+    if (path == "merkleroot") return toHash(value, out.merkleRoot);
+    if (path == "time") return toInteger(value, out.time);
+    if (path == "mediantime") return toInteger(value, out.medianTime);
+    if (path == "nonce") return toInteger(value, out.nonce);
+    if (path == "bits") return toCompactBits(value, out.bits);
+    if (path == "difficulty") return toDouble(value, out.difficulty);
+    if (path == "chainwork") return toHash(value, out.chainWork);
+    if (path == "nTx") return toInteger(value, out.transactionCount);
+    if (path == "previousblockhash") return toHash(value, out.previousBlockHash);
+    if (path == "nextblockhash") return (out.hasNextBlock = toHash(value, out.nextBlockHash));
+    return true;
+}
+
+bool decodeField(TxOutResult& out, std::string_view path, const JsonScalar& value) {
+    if (path == "bestblock") return toHash(value, out.bestBlock);
+    if (path == "confirmations") return toInteger(value, out.confirmations);
+    if (path == "value") return toAmount(value, out.value);
+    if (path == "coinbase") return toBool(value, out.coinbase);
+    if (path == "scriptPubKey.hex") {
+        return value.kind == JsonScalar::Kind::String && parseHex(value.text, out.scriptPubKey);
+    }
+    if (path == "scriptPubKey.type") {
+        out.type = scriptTypeFromName(value.text);
+        return value.kind == JsonScalar::Kind::String;
+    }
+    return true;
+}
+
+bool decodeField(MempoolEntryResult& out, std::string_view path, const JsonScalar& value) {
+    if (path == "vsize") return toInteger(value, out.vsize);
+    if (path == "weight") return toInteger(value, out.weight);
+    if (path == "time") return toInteger(value, out.time);
+    if (path == "height") return toInteger(value, out.height);
+    if (path == "descendantcount") return toInteger(value, out.descendantCount);
+    if (path == "descendantsize") return toInteger(value, out.descendantSize);
+    if (path == "ancestorcount") return toInteger(value, out.ancestorCount);
+    if (path == "ancestorsize") return toInteger(value, out.ancestorSize);
+    if (path == "wtxid") return toHash(value, out.wtxid);
+    if (path == "fees.base") return toAmount(value, out.baseFee);
+    if (path == "fees.modified") return toAmount(value, out.modifiedFee);
+    if (path == "fees.ancestor") return toAmount(value, out.ancestorFees);
+    if (path == "fees.descendant") return toAmount(value, out.descendantFees);
+    if (path == "bip125-replaceable") return toBool(value, out.bip125Replaceable);
+    if (path == "unbroadcast") return toBool(value, out.unbroadcast);
+    if (path == "depends" || path == "spentby") {
+        Hash256 hash;
+        if (!toHash(value, hash)) return false;
+        (path == "depends" ? out.depends : out.spentBy).push_back(hash);
+    }
+    return true;
+}
+
+bool decodeField(BlockStatsResult& out, std::string_view path, const JsonScalar& value) {
+    if (path == "blockhash") return toHash(value, out.blockHash);
+    if (path == "height") return toInteger(value, out.height);
+    if (path == "time") return toInteger(value, out.time);
+    if (path == "mediantime") return toInteger(value, out.medianTime);
+    if (path == "avgfee") return toInteger(value, out.averageFee);
+    if (path == "avgfeerate") return toInteger(value, out.averageFeeRate);
+    if (path == "maxfee") return toInteger(value, out.maxFee);
+    if (path == "maxfeerate") return toInteger(value, out.maxFeeRate);
+    if (path == "medianfee") return toInteger(value, out.medianFee);
+    if (path == "minfee") return toInteger(value, out.minFee);
+    if (path == "minfeerate") return toInteger(value, out.minFeeRate);
+    if (path == "totalfee") return toInteger(value, out.totalFee);
+    if (path == "subsidy") return toInteger(value, out.subsidy);
+    if (path == "total_out") return toInteger(value, out.totalOut);
+    if (path == "feerate_percentiles") {
+        return value.index < out.feeRatePercentiles.size() && toInteger(value, out.feeRatePercentiles[value.index]);
+    }
+    if (path == "avgtxsize") return toInteger(value, out.averageTxSize);
+    if (path == "maxtxsize") return toInteger(value, out.maxTxSize);
+    if (path == "mediantxsize") return toInteger(value, out.medianTxSize);
+    if (path == "mintxsize") return toInteger(value, out.minTxSize);
+    if (path == "total_size") return toInteger(value, out.totalSize);
+    if (path == "total_weight") return toInteger(value, out.totalWeight);
+    if (path == "swtotal_size") return toInteger(value, out.segwitTotalSize);
+    if (path == "swtotal_weight") return toInteger(value, out.segwitTotalWeight);
+    if (path == "swtxs") return toInteger(value, out.segwitTxs);
+    if (path == "txs") return toInteger(value, out.txs);
+    if (path == "ins") return toInteger(value, out.inputs);
+    if (path == "outs") return toInteger(value, out.outputs);
+    if (path == "utxo_increase") return toInteger(value, out.utxoIncrease);
+    if (path == "utxo_size_inc") return toInteger(value, out.utxoSizeIncrease);
+    return true;
+}
+
+bool decodeField(SmartFeeResult& out, std::string_view path, const JsonScalar& value) {
+    if (path == "feerate") return (out.hasEstimate = toAmount(value, out.feeRate));
+    if (path == "blocks") return toInteger(value, out.blocks);
+    return true;
+}
+
+bool decodeField(BlockchainInfoResult& out, std::string_view path, const JsonScalar& value) {
+    if (path == "chain") {
+        out.chain.assign(value.text);
+        return value.kind == JsonScalar::Kind::String;
+    }
+    if (path == "blocks") return toInteger(value, out.blocks);
+    if (path == "headers") return toInteger(value, out.headers);
+    if (path == "bestblockhash") return toHash(value, out.bestBlockHash);
+    if (path == "difficulty") return toDouble(value, out.difficulty);
+    if (path == "time") return toInteger(value, out.time);
+    if (path == "mediantime") return toInteger(value, out.medianTime);
+    if (path == "verificationprogress") return toDouble(value, out.verificationProgress);
+    if (path == "initialblockdownload") return toBool(value, out.initialBlockDownload);
+    if (path == "chainwork") return toHash(value, out.chainWork);
+    if (path == "size_on_disk") return toInteger(value, out.sizeOnDisk);
+    if (path == "pruned") return toBool(value, out.pruned);
+    if (path == "pruneheight") return toInteger(value, out.pruneHeight);
+    return true;
+}
+
+bool decodeField(WalletEntryResult& out, std::string_view path, const JsonScalar& value) {
+    if (path == "txid") return toHash(value, out.txid);
+    if (path == "address") return toString(value, out.address);
+    if (path == "label") return toString(value, out.label);
+    if (path == "amount") return toAmount(value, out.amount);
+    if (path == "fee") return toAmount(value, out.fee);
+    if (path == "vout") return toInteger(value, out.vout);
+    if (path == "confirmations") return toInteger(value, out.confirmations);
+    if (path == "blockhash") return toHash(value, out.blockHash);
+    if (path == "blockheight") return toInteger(value, out.blockHeight);
+    if (path == "time") return toInteger(value, out.time);
+    if (path == "timereceived") return toInteger(value, out.timeReceived);
+    if (path == "abandoned") return toBool(value, out.abandoned);
+    if (path == "involvesWatchonly") return toBool(value, out.involvesWatchOnly);
+    if (path == "category") {
+        if (value.text == "send") out.category = WalletCategory::Send;
+        else if (value.text == "receive") out.category = WalletCategory::Receive;
+        else if (value.text == "generate") out.category = WalletCategory::Generate;
+        else if (value.text == "immature") out.category = WalletCategory::Immature;
+        else if (value.text == "orphan") out.category = WalletCategory::Orphan;
+        else return false;
+        return value.kind == JsonScalar::Kind::String;
+    }
+    return true;
+}
+
+bool decodeField(UnspentOutputResult& out, std::string_view path, const JsonScalar& value) {
+    if (path == "txid") return toHash(value, out.txid);
+    if (path == "vout") return toInteger(value, out.vout);
+    if (path == "address") return toString(value, out.address);
+    if (path == "scriptPubKey") return value.kind == JsonScalar::Kind::String && parseHex(value.text, out.scriptPubKey);
+    if (path == "amount") return toAmount(value, out.amount);
+    if (path == "confirmations") return toInteger(value, out.confirmations);
+    if (path == "spendable") return toBool(value, out.spendable);
+    if (path == "solvable") return toBool(value, out.solvable);
+    if (path == "safe") return toBool(value, out.safe);
+    return true;
+}
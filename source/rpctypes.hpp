@@ -0,0 +1,396 @@
+#ifndef RPCTYPES_HPP
+#define RPCTYPES_HPP
+
+#if __has_include("jsonstream.hpp")
+#   include "jsonstream.hpp"
+#else
+#   error "Bitcoin's \"jsonstream.hpp\" was not found!"
+#endif
+
+#include <array>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * @brief A 256-bit hash (block hash, txid, ...) in internal byte order.
+ *
+ * RPC displays hashes byte-reversed; `parseHash` and `hashToHex` convert between the two.
+ */
+using Hash256 = std::array<std::uint8_t, 32>;
+
+/**
+ * @brief An amount in satoshis.
+ */
+using Amount = std::int64_t;
+
+/**
+ * @brief Number of satoshis in one bitcoin.
+ */
+inline constexpr Amount COIN = 100000000;
+
+/**
+ * @brief Parses a hash as displayed by RPC (64 hex digits, byte-reversed).
+ * @param hex The hexadecimal text.
+ * @param[out] out The hash in internal byte order.
+ * @return `true` on success.
+ */
+bool parseHash(std::string_view hex, Hash256& out);
+
+/**
+ * @brief Formats a hash the way RPC displays it.
+ * @param hash The hash in internal byte order.
+ * @return 64 lowercase hex digits in display order.
+ */
+std::string hashToHex(const Hash256& hash);
+
+/**
+ * @brief Converts a JSON amount in BTC (e.g. `0.00012345`) to satoshis without floating point.
+ * @param raw The number as it appears in the JSON text.
+ * @param[out] out The amount in satoshis.
+ * @return `true` if the text is a valid amount with at most 8 decimals.
+ */
+bool parseAmount(std::string_view raw, Amount& out);
+
+/**
+ * @brief Decodes a hexadecimal string into bytes.
+ * @param hex The hexadecimal text (even length).
+ * @param[out] out The decoded bytes; replaced, not appended to.
+ * @return `true` on success.
+ */
+bool parseHex(std::string_view hex, std::vector<std::uint8_t>& out);
+
+/**
+ * @enum ScriptType
+ * @brief The `type` of a scriptPubKey as reported by RPC.
+ */
+enum class ScriptType : std::uint8_t {
+    NonStandard, PubKey, PubKeyHash, ScriptHash, MultiSig, NullData,
+    WitnessV0KeyHash, WitnessV0ScriptHash, WitnessV1Taproot, WitnessUnknown, Anchor
+};
+
+/**
+ * @brief Maps an RPC script type name (e.g. `witness_v0_keyhash`) to ScriptType.
+ */
+ScriptType scriptTypeFromName(std::string_view name);
+
+/**
+ * @struct BlockHeaderResult
+ * @brief Result of `getblockheader <hash> true`.
+ */
+struct BlockHeaderResult {
+    Hash256 hash {};
+    Hash256 previousBlockHash {};       ///< Zero for the genesis block.
+    Hash256 nextBlockHash {};           ///< Zero if `hasNextBlock` is false.
+    Hash256 merkleRoot {};
+    Hash256 chainWork {};
+    std::int64_t confirmations = 0;     ///< -1 if the block is not on the active chain.
+    std::int32_t height = 0;
+    std::int32_t version = 0;
+    std::uint32_t time = 0;
+    std::uint32_t medianTime = 0;
+    std::uint32_t nonce = 0;
+    std::uint32_t bits = 0;
+    std::uint32_t transactionCount = 0;
+    double difficulty = 0.0;
+    bool hasNextBlock = false;
+};
+
+/**
+ * @struct TxOutResult
+ * @brief Result of `gettxout` for an unspent output.
+ */
+struct TxOutResult {
+    Hash256 bestBlock {};
+    std::int64_t confirmations = 0;
+    Amount value = 0;
+    ScriptType type = ScriptType::NonStandard;
+    bool coinbase = false;
+    std::vector<std::uint8_t> scriptPubKey;
+};
+
+/**
+ * @struct MempoolEntryResult
+ * @brief Result of `getmempoolentry`.
+ */
+struct MempoolEntryResult {
+    Hash256 wtxid {};
+    std::uint32_t vsize = 0;
+    std::uint32_t weight = 0;
+    std::int64_t time = 0;
+    std::int32_t height = 0;
+    std::uint32_t descendantCount = 0;
+    std::uint64_t descendantSize = 0;
+    std::uint32_t ancestorCount = 0;
+    std::uint64_t ancestorSize = 0;
+    Amount baseFee = 0;
+    Amount modifiedFee = 0;
+    Amount ancestorFees = 0;
+    Amount descendantFees = 0;
+    bool bip125Replaceable = false;
+    bool unbroadcast = false;
+    std::vector<Hash256> depends;       ///< Unconfirmed parents.
+    std::vector<Hash256> spentBy;       ///< Unconfirmed children.
+};
+
+/**
+ * @struct BlockStatsResult
+ * @brief Result of `getblockstats` (all statistics). Fees are in satoshis, fee rates in sat/vB.
+ */
+struct BlockStatsResult {
+    Hash256 blockHash {};
+    std::int32_t height = 0;
+    std::uint32_t time = 0;
+    std::uint32_t medianTime = 0;
+    Amount averageFee = 0;
+    Amount averageFeeRate = 0;
+    Amount maxFee = 0;
+    Amount maxFeeRate = 0;
+    Amount medianFee = 0;
+    Amount minFee = 0;
+    Amount minFeeRate = 0;
+    Amount totalFee = 0;
+    Amount subsidy = 0;
+    Amount totalOut = 0;
+    std::array<Amount, 5> feeRatePercentiles {};   ///< 10th, 25th, 50th, 75th and 90th percentile.
+    std::uint64_t averageTxSize = 0;
+    std::uint64_t maxTxSize = 0;
+    std::uint64_t medianTxSize = 0;
+    std::uint64_t minTxSize = 0;
+    std::uint64_t totalSize = 0;
+    std::uint64_t totalWeight = 0;
+    std::uint64_t segwitTotalSize = 0;
+    std::uint64_t segwitTotalWeight = 0;
+    std::uint32_t segwitTxs = 0;
+    std::uint32_t txs = 0;
+    std::uint32_t inputs = 0;
+    std::uint32_t outputs = 0;
+    std::int64_t utxoIncrease = 0;
+    std::int64_t utxoSizeIncrease = 0;
+};
+
+/**
+ * @struct SmartFeeResult
+ * @brief Result of `estimatesmartfee`.
+ */
+struct SmartFeeResult {
+    Amount feeRate = 0;         ///< Estimated fee rate in satoshis per kvB; 0 if no estimate is available.
+    std::int32_t blocks = 0;    ///< Confirmation target the estimate is valid for.
+    bool hasEstimate = false;   ///< False when the node returned `errors` instead of a fee rate.
+};
+
+/**
+ * @struct BlockchainInfoResult
+ * @brief Result of `getblockchaininfo`.
+ */
+struct BlockchainInfoResult {
+    std::string chain;                  ///< `main`, `test`, `testnet4`, `signet` or `regtest`.
+    Hash256 bestBlockHash {};
+    Hash256 chainWork {};
+    std::int32_t blocks = 0;
+    std::int32_t headers = 0;
+    std::uint32_t time = 0;
+    std::uint32_t medianTime = 0;
+    double difficulty = 0.0;
+    double verificationProgress = 0.0;
+    std::uint64_t sizeOnDisk = 0;
+    std::int32_t pruneHeight = 0;
+    bool initialBlockDownload = false;
+    bool pruned = false;
+};
+
+/**
+ * @enum WalletCategory
+ * @brief The `category` of a wallet transaction entry.
+ */
+enum class WalletCategory : std::uint8_t {
+    Send, Receive, Generate, Immature, Orphan
+};
+
+/**
+ * @struct WalletEntryResult
+ * @brief One element of `transactions` or `removed` of `listsinceblock`, or of `listtransactions`.
+ *
+ * The node lists one entry per wallet output, or per paid output for sends; change outputs
+ * are not listed.
+ */
+struct WalletEntryResult {
+    Hash256 txid {};
+    Hash256 blockHash {};                       ///< Zero while unconfirmed.
+    std::string address;                        ///< Empty for outputs without an address.
+    std::string label;
+    Amount amount = 0;                          ///< Negative for sends.
+    Amount fee = 0;                             ///< Negative; only set on sends.
+    std::int64_t confirmations = 0;             ///< Negative if the transaction conflicts with the active chain.
+    std::int32_t blockHeight = -1;              ///< -1 while unconfirmed.
+    std::int64_t time = 0;
+    std::int64_t timeReceived = 0;
+    std::uint32_t vout = 0;
+    WalletCategory category = WalletCategory::Receive;
+    bool abandoned = false;
+    bool involvesWatchOnly = false;
+};
+
+/**
+ * @struct UnspentOutputResult
+ * @brief One element of `listunspent`.
+ */
+struct UnspentOutputResult {
+    Hash256 txid {};
+    std::uint32_t vout = 0;
+    std::string address;                        ///< Empty for outputs without an address.
+    std::vector<std::uint8_t> scriptPubKey;
+    Amount amount = 0;
+    std::int64_t confirmations = 0;
+    bool spendable = false;
+    bool solvable = false;
+    bool safe = false;                          ///< Unconfirmed outputs from others, or replaceable ones, are not.
+};
+
+/**
+ * @struct JsonScalar
+ * @brief A scalar JSON value as seen by a typed decoder.
+ */
+struct JsonScalar {
+    enum class Kind : std::uint8_t { Null, Bool, Number, String } kind = Kind::Null;
+    std::string_view text;      ///< Source text of numbers, unescaped content of strings.
+    bool boolean = false;       ///< Value of booleans.
+    std::size_t index = 0;      ///< Position within the enclosing array, 0 outside arrays.
+};
+
+/**
+ * @name Field binders
+ * @brief Store one scalar of a result into the matching struct member.
+ *
+ * `path` is the dot-separated member path relative to `result` (e.g. `fees.base`);
+ * array elements use the path of the array. Unknown members are ignored.
+ * @return `false` if a known member has an invalid value.
+ */
+///@{
+bool decodeField(BlockHeaderResult& out, std::string_view path, const JsonScalar& value);
+bool decodeField(TxOutResult& out, std::string_view path, const JsonScalar& value);
+bool decodeField(MempoolEntryResult& out, std::string_view path, const JsonScalar& value);
+bool decodeField(BlockStatsResult& out, std::string_view path, const JsonScalar& value);
+bool decodeField(SmartFeeResult& out, std::string_view path, const JsonScalar& value);
+bool decodeField(BlockchainInfoResult& out, std::string_view path, const JsonScalar& value);
+bool decodeField(WalletEntryResult& out, std::string_view path, const JsonScalar& value);
+bool decodeField(UnspentOutputResult& out, std::string_view path, const JsonScalar& value);
+///@}
+
+/**
+ * @class TypedResultDecoder
+ * @brief Decodes a JSON-RPC response straight into a result struct, without building a DOM.
+ *
+ * Used as the JsonHandler of `BitcoinClient::streamRequest`. The envelope's `error`
+ * member is captured separately; every scalar inside `result` is routed to
+ * `decodeField(T&, path, scalar)`.
+ *
+ * @tparam T The result struct.
+ */
+template<typename T>
+class TypedResultDecoder : public JsonHandler {
+public:
+    /**
+     * @brief Returns the decoded result, if the response had a non-null `result` and no error.
+     */
+    std::optional<T> take() {
+        if (!valid || !hasResult || hasError) return std::nullopt;
+        return std::move(value);
+    }
+
+    bool isMalformed() const { return !valid; }                       ///< A known member had an unexpected value.
+    bool hasRpcError() const { return hasError; }                     ///< The node returned an error.
+    std::int64_t rpcErrorCode() const { return errorCode; }           ///< The error `code`.
+    const std::string& rpcErrorMessage() const { return errorMessage; } ///< The error `message`.
+
+    bool onNull() override { return scalar({JsonScalar::Kind::Null, {}, false}); }
+    bool onBool(bool b) override { return scalar({JsonScalar::Kind::Bool, {}, b}); }
+    bool onNumber(std::string_view raw) override { return scalar({JsonScalar::Kind::Number, raw, false}); }
+    bool onString(std::string_view text) override { return scalar({JsonScalar::Kind::String, text, false}); }
+
+    bool onKey(std::string_view key) override {
+        if (frames.size() == 1) {
+            // A member of the envelope: paths below it are relative to that member.
+            section = key == "result" ? Section::Result : key == "error" ? Section::Error : Section::Other;
+            path.clear();
+            return true;
+        }
+        const std::size_t prefix = frames.back().pathLength;
+        path.resize(prefix);
+        if (prefix != 0) path.push_back('.');
+        path.append(key.data(), key.size());
+        return true;
+    }
+
+    bool onStartObject() override { return open(true); }
+    bool onStartArray() override { return open(false); }
+    bool onEndObject() override { return close(); }
+    bool onEndArray() override { return close(); }
+
+private:
+    enum class Section : std::uint8_t { Other, Result, Error };
+
+    struct Frame {
+        bool object;
+        std::size_t pathLength;   ///< Length of the path of this container.
+        std::size_t index;        ///< Next element index (arrays only).
+    };
+
+    bool open(bool object) {
+        if (frames.size() == 1) {
+            if (section == Section::Result) hasResult = true;
+            if (section == Section::Error) hasError = true;
+        }
+        if (!frames.empty() && !frames.back().object) {
+            path.resize(frames.back().pathLength);
+            ++frames.back().index;
+        }
+        frames.push_back({object, frames.empty() ? 0 : path.size(), 0});
+        return true;
+    }
+
+    bool close() {
+        frames.pop_back();
+        return true;
+    }
+
+    bool scalar(JsonScalar value) {
+        if (frames.empty()) return true;                    // Not an envelope; ignored.
+        if (frames.size() == 1) {
+            // A scalar member of the envelope itself: `"result": null`, `"error": null`, `"id": 1`.
+            if (section == Section::Result && value.kind != JsonScalar::Kind::Null) {
+                hasResult = true;
+                valid = false;                              // A struct result cannot be a scalar.
+            }
+            return true;
+        }
+
+        Frame& top = frames.back();
+        if (!top.object) {
+            path.resize(top.pathLength);
+            value.index = top.index++;
+        }
+        if (section == Section::Error) {
+            if (path == "code") errorCode = std::strtoll(std::string(value.text).c_str(), nullptr, 10);
+            if (path == "message") errorMessage.assign(value.text);
+            return true;
+        }
+        if (section == Section::Result && !decodeField(this->value, path, value)) valid = false;
+        return true;
+    }
+
+    T value {};
+    std::vector<Frame> frames;
+    std::string path;             ///< Dot-separated path of the current member, relative to `result` or `error`.
+    Section section = Section::Other;
+    bool hasResult = false;
+    bool hasError = false;
+    bool valid = true;
+    std::int64_t errorCode = 0;
+    std::string errorMessage;
+};
+
+#endif // RPCTYPES_HPP
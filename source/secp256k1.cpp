@@ -0,0 +1,350 @@
+#include "secp256k1.hpp"
+#include <algorithm>
+#include <memory>
+
+namespace {
+using Wide = unsigned __int128;
+
+/**
+ * @struct FieldElement
+ * @brief An integer modulo p = 2^256 - 2^32 - 977, as four little-endian 64-bit limbs, always fully reduced.
+ */
+struct FieldElement {
+    std::uint64_t limb[4] {};
+};
+
+constexpr std::uint64_t PRIME[4] = {0xfffffffefffffc2f, ~0ull, ~0ull, ~0ull};
+constexpr std::uint64_t REDUCTION = 0x1000003d1;        ///< 2^256 mod p.
+
+constexpr std::array<std::uint8_t, 32> GROUP_ORDER = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe,
+    0xba, 0xae, 0xdc, 0xe6, 0xaf, 0x48, 0xa0, 0x3b, 0xbf, 0xd2, 0x5e, 0x8c, 0xd0, 0x36, 0x41, 0x41,
+};
+
+constexpr FieldElement GENERATOR_X {{0x59f2815b16f81798, 0x029bfcdb2dce28d9, 0x55a06295ce870b07, 0x79be667ef9dcbbac}};
+constexpr FieldElement GENERATOR_Y {{0x9c47d08ffb10d4b8, 0xfd17b448a6855419, 0x5da4fbfc0e1108a8, 0x483ada7726a3c465}};
+constexpr FieldElement CURVE_B {{7, 0, 0, 0}};
+
+bool isZero(const FieldElement& a) {
+    return (a.limb[0] | a.limb[1] | a.limb[2] | a.limb[3]) == 0;
+}
+
+bool operator==(const FieldElement& a, const FieldElement& b) {
+    return std::equal(a.limb, a.limb + 4, b.limb);
+}
+
+bool isOdd(const FieldElement& a) {
+    return a.limb[0] & 1;
+}
+
+bool atLeastPrime(const FieldElement& a) {
+    return a.limb[3] == ~0ull && a.limb[2] == ~0ull && a.limb[1] == ~0ull && a.limb[0] >= PRIME[0];
+}
+
+/**
+ * @brief Subtracts p from a value in `[p, 2^256)`, or from one that wrapped past 2^256, by adding 2^256 - p.
+ */
+void subtractPrime(FieldElement& a) {
+    Wide carry = Wide(a.limb[0]) + REDUCTION;
+    a.limb[0] = static_cast<std::uint64_t>(carry);
+    for (int i = 1; i < 4; ++i) {
+        carry = (carry >> 64) + a.limb[i];
+        a.limb[i] = static_cast<std::uint64_t>(carry);
+    }
+}
+
+FieldElement add(const FieldElement& a, const FieldElement& b) {
+    FieldElement r;
+    Wide carry = 0;
+    for (int i = 0; i < 4; ++i) {
+        carry += Wide(a.limb[i]) + b.limb[i];
+        r.limb[i] = static_cast<std::uint64_t>(carry);
+        carry >>= 64;
+    }
+    if (carry != 0 || atLeastPrime(r)) subtractPrime(r);
+    return r;
+}
+
+FieldElement subtract(const FieldElement& a, const FieldElement& b) {
+    FieldElement r;
+    std::uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+        const Wide difference = Wide(a.limb[i]) - b.limb[i] - borrow;
+        r.limb[i] = static_cast<std::uint64_t>(difference);
+        borrow = (difference >> 64) != 0;
+    }
+    if (borrow != 0) {
+        Wide carry = 0;
+        for (int i = 0; i < 4; ++i) {
+            carry += Wide(r.limb[i]) + PRIME[i];
+            r.limb[i] = static_cast<std::uint64_t>(carry);
+            carry >>= 64;
+        }
+    }
+    return r;
+}
+
+FieldElement negate(const FieldElement& a) {
+    return subtract(FieldElement {}, a);
+}
+
+FieldElement multiply(const FieldElement& a, const FieldElement& b) {
+    std::uint64_t product[8] = {};
+    for (int i = 0; i < 4; ++i) {
+        Wide carry = 0;
+        for (int j = 0; j < 4; ++j) {
+            carry += Wide(a.limb[i]) * b.limb[j] + product[i + j];
+            product[i + j] = static_cast<std::uint64_t>(carry);
+            carry >>= 64;
+        }
+        product[i + 4] = static_cast<std::uint64_t>(carry);
+    }
+
+    // 2^256 ≡ 2^32 + 977, so the high half folds into the low half multiplied by that.
+    std::uint64_t folded[4];
+    Wide carry = 0;
+    for (int i = 0; i < 4; ++i) {
+        carry += Wide(product[i]) + Wide(product[i + 4]) * REDUCTION;
+        folded[i] = static_cast<std::uint64_t>(carry);
+        carry >>= 64;
+    }
+    FieldElement r;
+    carry = Wide(folded[0]) + Wide(static_cast<std::uint64_t>(carry)) * REDUCTION;
+    r.limb[0] = static_cast<std::uint64_t>(carry);
+    for (int i = 1; i < 4; ++i) {
+        carry = (carry >> 64) + folded[i];
+        r.limb[i] = static_cast<std::uint64_t>(carry);
+    }
+    if ((carry >> 64) != 0 || atLeastPrime(r)) subtractPrime(r);
+    return r;
+}
+
+FieldElement square(const FieldElement& a) {
+    return multiply(a, a);
+}
+
+FieldElement squareTimes(FieldElement a, int count) {
+    for (int i = 0; i < count; ++i) a = square(a);
+    return a;
+}
+
+/**
+ * @brief Returns `a^(2^223 - 1)` and the shorter runs of ones the exponents of p need.
+ */
+struct OnesChain {
+    FieldElement x2, x3, x22, x223;
+};
+
+OnesChain onesChain(const FieldElement& a) {
+    OnesChain chain;
+    chain.x2 = multiply(square(a), a);
+    chain.x3 = multiply(square(chain.x2), a);
+    const FieldElement x6 = multiply(squareTimes(chain.x3, 3), chain.x3);
+    const FieldElement x9 = multiply(squareTimes(x6, 3), chain.x3);
+    const FieldElement x11 = multiply(squareTimes(x9, 2), chain.x2);
+    chain.x22 = multiply(squareTimes(x11, 11), x11);
+    const FieldElement x44 = multiply(squareTimes(chain.x22, 22), chain.x22);
+    const FieldElement x88 = multiply(squareTimes(x44, 44), x44);
+    const FieldElement x176 = multiply(squareTimes(x88, 88), x88);
+    const FieldElement x220 = multiply(squareTimes(x176, 44), x44);
+    chain.x223 = multiply(squareTimes(x220, 3), chain.x3);
+    return chain;
+}
+
+/**
+ * @brief Returns `a^(p - 2)`, the inverse of a non-zero `a`.
+ */
+FieldElement invert(const FieldElement& a) {
+    const OnesChain chain = onesChain(a);
+    FieldElement r = multiply(squareTimes(chain.x223, 23), chain.x22);
+    r = multiply(squareTimes(r, 5), a);
+    r = multiply(squareTimes(r, 3), chain.x2);
+    return multiply(squareTimes(r, 2), a);
+}
+
+/**
+ * @brief Returns `a^((p + 1) / 4)`, a square root of `a` if one exists.
+ */
+FieldElement squareRoot(const FieldElement& a) {
+    const OnesChain chain = onesChain(a);
+    FieldElement r = multiply(squareTimes(chain.x223, 23), chain.x22);
+    r = multiply(squareTimes(r, 6), chain.x2);
+    return squareTimes(r, 2);
+}
+
+bool fromBytes(const std::uint8_t* in, FieldElement& out) {
+    for (int i = 0; i < 4; ++i) {
+        std::uint64_t value = 0;
+        for (int j = 0; j < 8; ++j) value = value << 8 | in[8 * (3 - i) + j];
+        out.limb[i] = value;
+    }
+    return !atLeastPrime(out);
+}
+
+void toBytes(const FieldElement& a, std::uint8_t* out) {
+    for (int i = 0; i < 4; ++i) {
+        std::uint64_t value = a.limb[i];
+        for (int j = 7; j >= 0; --j, value >>= 8) out[8 * (3 - i) + j] = static_cast<std::uint8_t>(value);
+    }
+}
+
+struct AffinePoint {
+    FieldElement x, y;
+};
+
+/**
+ * @struct JacobianPoint
+ * @brief The point `(x / z^2, y / z^3)`, or infinity.
+ */
+struct JacobianPoint {
+    FieldElement x, y, z;
+    bool infinity = true;
+};
+
+JacobianPoint doublePoint(const JacobianPoint& p) {
+    if (p.infinity || isZero(p.y)) return {};
+    const FieldElement a = square(p.x);
+    const FieldElement b = square(p.y);
+    const FieldElement c = square(b);
+    const FieldElement xb = add(p.x, b);
+    FieldElement d = subtract(subtract(square(xb), a), c);
+    d = add(d, d);
+    const FieldElement e = add(add(a, a), a);
+    const FieldElement f = square(e);
+
+    JacobianPoint r;
+    r.infinity = false;
+    r.x = subtract(f, add(d, d));
+    FieldElement c8 = add(c, c);
+    c8 = add(c8, c8);
+    c8 = add(c8, c8);
+    r.y = subtract(multiply(e, subtract(d, r.x)), c8);
+    const FieldElement yz = multiply(p.y, p.z);
+    r.z = add(yz, yz);
+    return r;
+}
+
+JacobianPoint addPoint(const JacobianPoint& p, const AffinePoint& q) {
+    if (p.infinity) return {q.x, q.y, {{1, 0, 0, 0}}, false};
+    const FieldElement zz = square(p.z);
+    const FieldElement u2 = multiply(q.x, zz);
+    const FieldElement s2 = multiply(q.y, multiply(p.z, zz));
+    const FieldElement h = subtract(u2, p.x);
+    const FieldElement r = subtract(s2, p.y);
+    if (isZero(h)) return isZero(r) ? doublePoint(p) : JacobianPoint {};
+
+    const FieldElement hh = square(h);
+    const FieldElement hhh = multiply(h, hh);
+    const FieldElement v = multiply(p.x, hh);
+    JacobianPoint sum;
+    sum.infinity = false;
+    sum.x = subtract(subtract(square(r), hhh), add(v, v));
+    sum.y = subtract(multiply(r, subtract(v, sum.x)), multiply(p.y, hhh));
+    sum.z = multiply(p.z, h);
+    return sum;
+}
+
+AffinePoint toAffine(const JacobianPoint& p) {
+    const FieldElement zInverse = invert(p.z);
+    const FieldElement zInverse2 = square(zInverse);
+    return {multiply(p.x, zInverse2), multiply(p.y, multiply(zInverse2, zInverse))};
+}
+
+constexpr int WINDOWS = 64;     ///< Four-bit windows of a scalar.
+
+/**
+ * @brief `table[w][d - 1] = d·16^w·G` for every window `w` and digit `d` in 1..15.
+ */
+using GeneratorTable = std::array<std::array<AffinePoint, 15>, WINDOWS>;
+
+const GeneratorTable& generatorTable() {
+    static const std::unique_ptr<GeneratorTable> table = [] {
+        auto built = std::make_unique<GeneratorTable>();
+        AffinePoint base {GENERATOR_X, GENERATOR_Y};
+        for (int window = 0; window < WINDOWS; ++window) {
+            JacobianPoint multiple;
+            for (int digit = 0; digit < 15; ++digit) {
+                multiple = addPoint(multiple, base);
+                (*built)[window][digit] = toAffine(multiple);
+            }
+            base = toAffine(addPoint(multiple, base));
+        }
+        return built;
+    }();
+    return *table;
+}
+
+/**
+ * @brief Returns `scalar·G` for a big-endian scalar.
+ */
+JacobianPoint multiplyGenerator(std::span<const std::uint8_t, 32> scalar) {
+    const GeneratorTable& table = generatorTable();
+    JacobianPoint r;
+    for (int window = 0; window < WINDOWS; ++window) {
+        const int digit = (scalar[31 - window / 2] >> (4 * (window % 2))) & 0x0f;
+        if (digit != 0) r = addPoint(r, table[window][digit - 1]);
+    }
+    return r;
+}
+
+bool belowGroupOrder(std::span<const std::uint8_t, 32> scalar) {
+    return std::lexicographical_compare(scalar.begin(), scalar.end(), GROUP_ORDER.begin(), GROUP_ORDER.end());
+}
+
+/**
+ * @brief Finds the point with X coordinate `x` and the given Y parity.
+ */
+bool liftX(const std::uint8_t* x, bool odd, AffinePoint& out) {
+    if (!fromBytes(x, out.x)) return false;
+    const FieldElement rhs = add(multiply(square(out.x), out.x), CURVE_B);
+    out.y = squareRoot(rhs);
+    if (!(square(out.y) == rhs)) return false;
+    if (isOdd(out.y) != odd) out.y = negate(out.y);
+    return true;
+}
+
+bool decodePublicKey(const PublicKey& key, AffinePoint& out) {
+    if (key[0] != 0x02 && key[0] != 0x03) return false;
+    return liftX(key.data() + 1, key[0] == 0x03, out);
+}
+
+/**
+ * @brief Computes `point + tweak·G`.
+ */
+bool tweakPoint(const AffinePoint& point, std::span<const std::uint8_t, 32> tweak, AffinePoint& out) {
+    if (!belowGroupOrder(tweak)) return false;
+    const JacobianPoint sum = addPoint(multiplyGenerator(tweak), point);
+    if (sum.infinity) return false;
+    out = toAffine(sum);
+    return true;
+}
+}
+
+bool isValidPublicKey(const PublicKey& key) {
+    AffinePoint point;
+    return decodePublicKey(key, point);
+}
+
+bool decompressPublicKey(const PublicKey& key, std::array<std::uint8_t, 65>& out) {
+    AffinePoint point;
+    if (!decodePublicKey(key, point)) return false;
+    out[0] = 0x04;
+    toBytes(point.x, out.data() + 1);
+    toBytes(point.y, out.data() + 33);
+    return true;
+}
+
+bool tweakPublicKey(const PublicKey& key, std::span<const std::uint8_t, 32> tweak, PublicKey& out) {
+    AffinePoint point;
+    if (!decodePublicKey(key, point) || !tweakPoint(point, tweak, point)) return false;
+    out[0] = isOdd(point.y) ? 0x03 : 0x02;
+    toBytes(point.x, out.data() + 1);
+    return true;
+}
+
+bool tweakXOnlyPublicKey(const XOnlyPublicKey& key, std::span<const std::uint8_t, 32> tweak, XOnlyPublicKey& out) {
+    AffinePoint point;
+    if (!liftX(key.data(), false, point) || !tweakPoint(point, tweak, point)) return false;
+    toBytes(point.x, out.data());
+    return true;
+}
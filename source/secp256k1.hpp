@@ -0,0 +1,46 @@
+#ifndef SECP256K1_HPP
+#define SECP256K1_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+/**
+ * @name secp256k1 public keys
+ * @brief The public-key arithmetic that watch-only derivation and snapshot loading need.
+ *
+ * Only public data goes through these functions, so they are written for speed, not to hide
+ * timings. Fixed-base multiplication uses a precomputed table of 960 points, built on first
+ * use, and needs 64 point additions and one field inversion.
+ * @{
+ */
+
+using PublicKey = std::array<std::uint8_t, 33>;         ///< SEC1 compressed: 0x02 or 0x03, then X.
+using XOnlyPublicKey = std::array<std::uint8_t, 32>;    ///< BIP340: X of the point with even Y.
+
+/**
+ * @brief Checks whether a compressed key encodes a point on the curve.
+ */
+bool isValidPublicKey(const PublicKey& key);
+
+/**
+ * @brief Rebuilds the 65-byte uncompressed form of a key: 0x04, X, then Y.
+ * @return `false` if the key is not on the curve.
+ */
+bool decompressPublicKey(const PublicKey& key, std::array<std::uint8_t, 65>& out);
+
+/**
+ * @brief Computes `key + tweak·G`, as BIP32 public child derivation does.
+ * @param tweak A big-endian scalar.
+ * @return `false` if the key is invalid, `tweak` is not below the group order or the sum is the point at infinity.
+ */
+bool tweakPublicKey(const PublicKey& key, std::span<const std::uint8_t, 32> tweak, PublicKey& out);
+
+/**
+ * @brief Computes the X coordinate of `lift_x(key) + tweak·G`, as BIP341 output keys do.
+ * @return `false` if `key` is not on the curve, `tweak` is not below the group order or the sum is the point at infinity.
+ */
+bool tweakXOnlyPublicKey(const XOnlyPublicKey& key, std::span<const std::uint8_t, 32> tweak, XOnlyPublicKey& out);
+/** @} */
+
+#endif // SECP256K1_HPP
@@ -0,0 +1,314 @@
+#include "sha256.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#   if defined(__GNUC__) || defined(__clang__)
+#       define SHA256_X86
+#       include <immintrin.h>
+#       include <cpuid.h>
+#   endif
+#endif
+
+namespace {
+constexpr std::array<std::uint32_t, 64> ROUND_CONSTANTS = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+constexpr std::array<std::uint32_t, 8> INITIAL_STATE = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+/**
+ * @brief The second block of a 64-byte message: the end marker and a length of 512 bits.
+ */
+constexpr std::array<std::uint8_t, 64> PADDING_64 = [] {
+    std::array<std::uint8_t, 64> block {};
+    block[0] = 0x80;
+    block[62] = 0x02;
+    return block;
+}();
+
+inline std::uint32_t readBigEndian(const std::uint8_t* in) {
+    return std::uint32_t(in[0]) << 24 | std::uint32_t(in[1]) << 16 | std::uint32_t(in[2]) << 8 | in[3];
+}
+
+inline void writeBigEndian(std::uint8_t* out, std::uint32_t value) {
+    out[0] = static_cast<std::uint8_t>(value >> 24);
+    out[1] = static_cast<std::uint8_t>(value >> 16);
+    out[2] = static_cast<std::uint8_t>(value >> 8);
+    out[3] = static_cast<std::uint8_t>(value);
+}
+
+inline std::uint32_t rotr(std::uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+using Transform = void (*)(std::uint32_t* state, const std::uint8_t* blocks, std::size_t count);
+using Batch64 = void (*)(std::uint8_t* out, const std::uint8_t* in, std::size_t count);
+
+void transformScalar(std::uint32_t* state, const std::uint8_t* blocks, std::size_t count) {
+    for (; count > 0; --count, blocks += 64) {
+        std::uint32_t w[16];
+        for (int i = 0; i < 16; ++i) w[i] = readBigEndian(blocks + 4 * i);
+
+        std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int round = 0; round < 64; ++round) {
+            if (round >= 16) {
+                const std::uint32_t w15 = w[(round - 15) & 15];
+                const std::uint32_t w2 = w[(round - 2) & 15];
+                w[round & 15] += (rotr(w2, 17) ^ rotr(w2, 19) ^ (w2 >> 10)) + w[(round - 7) & 15]
+                    + (rotr(w15, 7) ^ rotr(w15, 18) ^ (w15 >> 3));
+            }
+            const std::uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + (g ^ (e & (f ^ g)))
+                + ROUND_CONSTANTS[round] + w[round & 15];
+            const std::uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) | (c & (a | b)));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+/**
+ * @brief Double-hashes 64-byte inputs one at a time with any transform.
+ */
+template<Transform transform>
+void sha256d64Serial(std::uint8_t* out, const std::uint8_t* in, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        std::array<std::uint32_t, 8> state = INITIAL_STATE;
+        transform(state.data(), in + 64 * i, 1);
+        transform(state.data(), PADDING_64.data(), 1);
+
+        // The second message is the 32-byte digest, padded to one block.
+        std::uint8_t block[64] = {};
+        for (int word = 0; word < 8; ++word) writeBigEndian(block + 4 * word, state[word]);
+        block[32] = 0x80;
+        block[62] = 0x01;
+
+        state = INITIAL_STATE;
+        transform(state.data(), block, 1);
+        for (int word = 0; word < 8; ++word) writeBigEndian(out + 32 * i + 4 * word, state[word]);
+    }
+}
+
+#ifdef SHA256_X86
+/**
+ * @brief Compresses blocks with the SHA extensions; based on Intel's reference sequence.
+ *
+ * The instructions keep the state as the word pairs ABEF and CDGH and run two rounds per
+ * `sha256rnds2`; `sha256msg1`/`sha256msg2` extend the message schedule four words at a time.
+ */
+__attribute__((target("sha,sse4.1"))) void transformShaNi(std::uint32_t* state, const std::uint8_t* blocks, std::size_t count) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    const __m128i dcba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+    const __m128i hgfe = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4));
+    const __m128i cdab = _mm_shuffle_epi32(dcba, 0xB1);
+    const __m128i efgh = _mm_shuffle_epi32(hgfe, 0x1B);
+    __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xF0);
+
+    for (; count > 0; --count, blocks += 64) {
+        const __m128i savedAbef = abef;
+        const __m128i savedCdgh = cdgh;
+        __m128i schedule[4];
+
+#pragma GCC unroll 16
+        for (int quad = 0; quad < 16; ++quad) {
+            __m128i& current = schedule[quad & 3];
+            if (quad < 4) {
+                current = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16 * quad)), byteSwap);
+            }
+            const __m128i words = _mm_add_epi32(current,
+                                                _mm_loadu_si128(reinterpret_cast<const __m128i*>(ROUND_CONSTANTS.data() + 4 * quad)));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, words);
+            if (quad >= 3 && quad < 15) {
+                __m128i& next = schedule[(quad + 1) & 3];
+                next = _mm_sha256msg2_epu32(_mm_add_epi32(next, _mm_alignr_epi8(current, schedule[(quad + 3) & 3], 4)), current);
+            }
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(words, 0x0E));
+            if (quad >= 1 && quad < 13) {
+                schedule[(quad + 3) & 3] = _mm_sha256msg1_epu32(schedule[(quad + 3) & 3], current);
+            }
+        }
+
+        abef = _mm_add_epi32(abef, savedAbef);
+        cdgh = _mm_add_epi32(cdgh, savedCdgh);
+    }
+
+    const __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+    const __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, dchg, 0xF0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+
+__attribute__((target("avx2"))) inline __m256i rotrAvx2(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+/**
+ * @brief Compresses one block in each of eight lanes; `w` holds the message words, lane by lane.
+ */
+__attribute__((target("avx2"))) void transformAvx2(__m256i* state, __m256i* w) {
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int round = 0; round < 64; ++round) {
+        if (round >= 16) {
+            const __m256i w15 = w[(round - 15) & 15];
+            const __m256i w2 = w[(round - 2) & 15];
+            const __m256i sigma0 = _mm256_xor_si256(_mm256_xor_si256(rotrAvx2(w15, 7), rotrAvx2(w15, 18)), _mm256_srli_epi32(w15, 3));
+            const __m256i sigma1 = _mm256_xor_si256(_mm256_xor_si256(rotrAvx2(w2, 17), rotrAvx2(w2, 19)), _mm256_srli_epi32(w2, 10));
+            w[round & 15] = _mm256_add_epi32(_mm256_add_epi32(w[round & 15], sigma0), _mm256_add_epi32(sigma1, w[(round - 7) & 15]));
+        }
+        const __m256i bigSigma1 = _mm256_xor_si256(_mm256_xor_si256(rotrAvx2(e, 6), rotrAvx2(e, 11)), rotrAvx2(e, 25));
+        const __m256i choose = _mm256_xor_si256(g, _mm256_and_si256(e, _mm256_xor_si256(f, g)));
+        const __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(h, bigSigma1), _mm256_add_epi32(choose, w[round & 15])),
+                                            _mm256_set1_epi32(static_cast<int>(ROUND_CONSTANTS[round])));
+        const __m256i bigSigma0 = _mm256_xor_si256(_mm256_xor_si256(rotrAvx2(a, 2), rotrAvx2(a, 13)), rotrAvx2(a, 22));
+        const __m256i majority = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        h = g; g = f; f = e; e = _mm256_add_epi32(d, t1);
+        d = c; c = b; b = a; a = _mm256_add_epi32(t1, _mm256_add_epi32(bigSigma0, majority));
+    }
+    state[0] = _mm256_add_epi32(state[0], a); state[1] = _mm256_add_epi32(state[1], b);
+    state[2] = _mm256_add_epi32(state[2], c); state[3] = _mm256_add_epi32(state[3], d);
+    state[4] = _mm256_add_epi32(state[4], e); state[5] = _mm256_add_epi32(state[5], f);
+    state[6] = _mm256_add_epi32(state[6], g); state[7] = _mm256_add_epi32(state[7], h);
+}
+
+/**
+ * @brief Double-hashes eight 64-byte inputs per pass, one per 32-bit lane.
+ */
+__attribute__((target("avx2"))) void sha256d64Avx2(std::uint8_t* out, const std::uint8_t* in, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const std::uint8_t* group = in + 64 * i;
+        __m256i w[16];
+        for (int word = 0; word < 16; ++word) {
+            int lanes[8];
+            for (int lane = 0; lane < 8; ++lane) lanes[lane] = static_cast<int>(readBigEndian(group + 64 * lane + 4 * word));
+            w[word] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes));
+        }
+
+        __m256i state[8];
+        for (int word = 0; word < 8; ++word) state[word] = _mm256_set1_epi32(static_cast<int>(INITIAL_STATE[word]));
+        transformAvx2(state, w);
+
+        for (int word = 0; word < 16; ++word) w[word] = _mm256_setzero_si256();
+        w[0] = _mm256_set1_epi32(static_cast<int>(0x80000000));
+        w[15] = _mm256_set1_epi32(512);
+        transformAvx2(state, w);
+
+        for (int word = 0; word < 8; ++word) {
+            w[word] = state[word];
+            state[word] = _mm256_set1_epi32(static_cast<int>(INITIAL_STATE[word]));
+        }
+        for (int word = 8; word < 16; ++word) w[word] = _mm256_setzero_si256();
+        w[8] = _mm256_set1_epi32(static_cast<int>(0x80000000));
+        w[15] = _mm256_set1_epi32(256);
+        transformAvx2(state, w);
+
+        // Inputs are all read by now, so writing over them is safe.
+        std::uint32_t words[8][8];
+        for (int word = 0; word < 8; ++word) _mm256_storeu_si256(reinterpret_cast<__m256i*>(words[word]), state[word]);
+        for (int lane = 0; lane < 8; ++lane) {
+            for (int word = 0; word < 8; ++word) writeBigEndian(out + 32 * (i + lane) + 4 * word, words[word][lane]);
+        }
+    }
+    sha256d64Serial<transformScalar>(out + 32 * i, in + 64 * i, count - i);
+}
+
+bool hasShaExtensions() {
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+    const bool sha = (ebx & (1u << 29)) != 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    const bool sse41 = (ecx & (1u << 19)) != 0;
+    return sha && sse41;
+}
+#endif
+
+struct Kernels {
+    Transform transform;
+    Batch64 batch64;
+    std::string_view name;
+};
+
+Kernels selectKernels() {
+#ifdef SHA256_X86
+    // Eight AVX2 lanes outrun SHA-NI hashing one input at a time, so batches prefer AVX2.
+    const bool shaNi = hasShaExtensions();
+    __builtin_cpu_init();
+    const bool avx2 = __builtin_cpu_supports("avx2");
+    if (shaNi && avx2) return {transformShaNi, sha256d64Avx2, "shani+avx2"};
+    if (shaNi) return {transformShaNi, sha256d64Serial<transformShaNi>, "shani"};
+    if (avx2) return {transformScalar, sha256d64Avx2, "scalar+avx2"};
+#endif
+    return {transformScalar, sha256d64Serial<transformScalar>, "scalar"};
+}
+
+const Kernels& kernels() {
+    static const Kernels selected = selectKernels();
+    return selected;
+}
+}
+
+void Sha256::reset() {
+    state = INITIAL_STATE;
+    length = 0;
+}
+
+Sha256& Sha256::write(std::span<const std::uint8_t> data) {
+    const Transform transform = kernels().transform;
+    std::size_t used = length % 64;
+    length += data.size();
+
+    if (used != 0) {
+        const std::size_t take = std::min(64 - used, data.size());
+        std::memcpy(pending.data() + used, data.data(), take);
+        data = data.subspan(take);
+        if (used + take < 64) return *this;
+        transform(state.data(), pending.data(), 1);
+    }
+
+    const std::size_t blocks = data.size() / 64;
+    if (blocks > 0) transform(state.data(), data.data(), blocks);
+    const std::size_t rest = data.size() % 64;
+    if (rest > 0) std::memcpy(pending.data(), data.data() + 64 * blocks, rest);
+    return *this;
+}
+
+std::array<std::uint8_t, Sha256::OUTPUT_SIZE> Sha256::finalize() {
+    const std::uint64_t bits = length * 8;
+    std::uint8_t trailer[72] = {0x80};
+    // Pad to 56 bytes modulo 64, then append the length in bits.
+    const std::size_t padding = 1 + (119 - length % 64) % 64;
+    for (int i = 0; i < 8; ++i) trailer[padding + i] = static_cast<std::uint8_t>(bits >> (56 - 8 * i));
+    write(std::span<const std::uint8_t>(trailer, padding + 8));
+
+    std::array<std::uint8_t, OUTPUT_SIZE> digest;
+    for (int word = 0; word < 8; ++word) writeBigEndian(digest.data() + 4 * word, state[word]);
+    reset();
+    return digest;
+}
+
+std::array<std::uint8_t, 32> sha256d(std::span<const std::uint8_t> data) {
+    Sha256 hasher;
+    const auto first = hasher.write(data).finalize();
+    return hasher.write(first).finalize();
+}
+
+void sha256d64(std::uint8_t* out, const std::uint8_t* in, std::size_t count) {
+    kernels().batch64(out, in, count);
+}
+
+std::string_view sha256Kernel() {
+    return kernels().name;
+}
@@ -0,0 +1,81 @@
+#ifndef SHA256_HPP
+#define SHA256_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+/**
+ * @class Sha256
+ * @brief An incremental SHA-256 hasher.
+ *
+ * Compression uses the SHA extensions (SHA-NI) on x86-64 CPUs that have them, checked once
+ * at run time, and portable code elsewhere.
+ *
+ * @code
+ * Sha256 hasher;
+ * hasher.write(first).write(second);
+ * std::array<std::uint8_t, 32> digest = hasher.finalize();
+ * @endcode
+ */
+class Sha256 {
+public:
+    static constexpr std::size_t OUTPUT_SIZE = 32;
+
+    Sha256() { reset(); }
+
+    /**
+     * @brief Appends data to the message.
+     */
+    Sha256& write(std::span<const std::uint8_t> data);
+
+    /**
+     * @brief Returns the digest of the message written so far and resets the hasher.
+     */
+    std::array<std::uint8_t, OUTPUT_SIZE> finalize();
+
+    /**
+     * @brief Starts a new message.
+     */
+    void reset();
+
+private:
+    std::array<std::uint32_t, 8> state;
+    std::array<std::uint8_t, 64> pending;   ///< Bytes of the current, incomplete block.
+    std::uint64_t length = 0;               ///< Bytes written so far.
+};
+
+/**
+ * @name Double SHA-256
+ * @brief The hash Bitcoin uses for txids, block hashes and merkle nodes.
+ * @{
+ */
+
+/**
+ * @brief Returns `SHA256(SHA256(data))`.
+ */
+std::array<std::uint8_t, 32> sha256d(std::span<const std::uint8_t> data);
+
+/**
+ * @brief Double-hashes `count` independent 64-byte inputs, such as the pairs of one merkle tree level.
+ *
+ * Inputs are hashed eight at a time in AVX2 lanes where available, otherwise one by one.
+ * `out` may alias `in`; hashing a merkle level in place (output `i` over input pair `i`)
+ * is supported.
+ *
+ * @param[out] out Receives `32 * count` bytes.
+ * @param in `64 * count` bytes.
+ * @param count The number of inputs.
+ */
+void sha256d64(std::uint8_t* out, const std::uint8_t* in, std::size_t count);
+
+/**
+ * @brief Returns the names of the implementations in use: `shani` or `scalar`, followed by `+avx2`
+ * when batches are hashed with AVX2.
+ */
+std::string_view sha256Kernel();
+/** @} */
+
+#endif // SHA256_HPP
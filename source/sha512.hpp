@@ -0,0 +1,50 @@
+#ifndef SHA512_HPP
+#define SHA512_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <span>
+
+/**
+ * @class Sha512
+ * @brief An incremental SHA-512 hasher, as BIP32 key derivation needs it.
+ *
+ * @code
+ * Sha512 hasher;
+ * std::array<std::uint8_t, 64> digest = hasher.write(data).finalize();
+ * @endcode
+ */
+class Sha512 {
+public:
+    static constexpr std::size_t OUTPUT_SIZE = 64;
+
+    Sha512() { reset(); }
+
+    /**
+     * @brief Appends data to the message.
+     */
+    Sha512& write(std::span<const std::uint8_t> data);
+
+    /**
+     * @brief Returns the digest of the message written so far and resets the hasher.
+     */
+    std::array<std::uint8_t, OUTPUT_SIZE> finalize();
+
+    /**
+     * @brief Starts a new message.
+     */
+    void reset();
+
+private:
+    std::array<std::uint64_t, 8> state;
+    std::array<std::uint8_t, 128> pending;  ///< Bytes of the current, incomplete block.
+    std::uint64_t length = 0;               ///< Bytes written so far.
+};
+
+/**
+ * @brief Returns `HMAC-SHA512(key, data)`.
+ */
+std::array<std::uint8_t, 64> hmacSha512(std::span<const std::uint8_t> key, std::span<const std::uint8_t> data);
+
+#endif // SHA512_HPP
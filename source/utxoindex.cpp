@@ -0,0 +1,862 @@
+#include "utxoindex.hpp"
+#include "jsonwriter.hpp"
+#include "secp256k1.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+constexpr std::size_t HEADER_SIZE = 4096;                       ///< Bytes before the first record; one page.
+constexpr std::uint64_t MAGIC = 0x3130584449585455;             ///< "UTXIDX01" on little-endian hosts.
+constexpr std::uint32_t FORMAT_VERSION = 1;                     ///< Layout of the files.
+constexpr std::size_t INLINE_SCRIPT = 40;                       ///< Longest script kept inside its record.
+constexpr std::uint32_t NONE = UINT32_MAX;                      ///< Empty table slot, end of a chain.
+constexpr std::uint32_t LIVE = 1;                               ///< Record flag of an unspent output.
+constexpr std::uint64_t MIN_RECORDS = 1 << 16;                  ///< Records allocated by a new index.
+constexpr std::uint64_t MIN_SLOTS = 1 << 16;                    ///< Slots of a new table.
+constexpr std::size_t MIN_HEAP = 1 << 20;                       ///< Bytes of a new script heap.
+constexpr std::size_t MAX_SCRIPT_SIZE = 10000;                  ///< Longer scripts are unspendable.
+constexpr std::uint8_t OP_RETURN = 0x6a;
+constexpr std::uint8_t SNAPSHOT_MAGIC[] = {'u', 't', 'x', 'o', 0xff};     ///< Start of a `dumptxoutset` file since Bitcoin Core 28.
+constexpr std::uint16_t SNAPSHOT_VERSION = 2;                   ///< The only version that follows the magic.
+constexpr std::uint64_t MIN_COIN_BYTES = 4;                     ///< Smallest snapshot coin: vout, code, amount and script, a byte each.
+constexpr std::uint64_t MIN_LEGACY_COIN_BYTES = 39;             ///< The same before Bitcoin Core 28, with the whole outpoint in front.
+constexpr std::uint64_t SNAPSHOT_REPORT_INTERVAL = 10000000;    ///< Coins between two progress messages.
+
+/**
+ * @brief Scrambles 64 bits (the splitmix64 finalizer).
+ */
+std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+std::uint64_t outpointHash(const Hash256& txid, std::uint32_t vout) {
+    std::uint64_t bits;
+    std::memcpy(&bits, txid.data(), sizeof(bits));
+    return mix(bits ^ (vout * 0x9e3779b97f4a7c15));
+}
+
+/**
+ * @brief Returns the 64-bit fingerprint that keys the script table; equal fingerprints are told apart by the script bytes.
+ */
+std::uint64_t scriptFingerprint(ByteSpan script) {
+    std::uint64_t hash = 0xcbf29ce484222325;    // FNV-1a
+    for (std::uint8_t byte : script) hash = (hash ^ byte) * 0x100000001b3;
+    return mix(hash);
+}
+
+bool isUnspendable(ByteSpan script) {
+    return (!script.empty() && script[0] == OP_RETURN) || script.size() > MAX_SCRIPT_SIZE;
+}
+
+/**
+ * @brief Returns the first slot of the table larger than `count` at a load factor of at most 0.7.
+ */
+std::uint64_t slotsFor(std::uint64_t count) {
+    std::uint64_t slots = MIN_SLOTS;
+    while (count * 10 > slots * 7) slots *= 2;
+    return slots;
+}
+
+/**
+ * @brief Removes the member at `hole` from a linear-probing table, pulling later members of its run back.
+ */
+template<typename Home>
+void eraseSlot(std::uint32_t* slots, std::size_t mask, std::size_t hole, const Home& homeOf) {
+    for (std::size_t i = (hole + 1) & mask; slots[i] != NONE; i = (i + 1) & mask) {
+        const std::size_t home = homeOf(slots[i]) & mask;
+        // Move the member unless its home lies cyclically in (hole, i].
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    slots[hole] = NONE;
+}
+
+bool toAmount(const Json::Value& value, Amount& out) {
+    // jsoncpp keeps amounts as doubles; the shortest round-trip text is the amount as the node wrote it.
+    std::string text;
+    JsonWriter(text).write(value);
+    return value.isNumeric() && parseAmount(text, out);
+}
+
+/**
+ * @struct ParsedOutput
+ * @brief An output read from a verbose block: one created, or one spent (`prevout`).
+ */
+struct ParsedOutput {
+    Hash256 txid {};
+    std::uint32_t vout = 0;
+    std::uint32_t code = 0;
+    Amount value = 0;
+    std::vector<std::uint8_t> script;
+};
+
+/**
+ * @struct ParsedBlock
+ * @brief The changes a `getblock <hash> 3` result makes to the UTXO set, checked before any is applied.
+ */
+struct ParsedBlock {
+    Hash256 hash {};
+    Hash256 previous {};                    ///< Zero for the genesis block.
+    std::int64_t height = 0;
+    std::vector<std::size_t> firstSpent;    ///< Per transaction, its first entry in `spent`; one extra entry ends the last.
+    std::vector<std::size_t> firstCreated;  ///< Per transaction, its first entry in `created`; one extra entry ends the last.
+    std::vector<ParsedOutput> spent;        ///< Outputs spent by inputs, in block order; `prevout` fields only if requested.
+    std::vector<ParsedOutput> created;      ///< Spendable outputs created, in block order.
+};
+
+bool parseOutput(const Json::Value& output, ParsedOutput& out) {
+    return parseHex(output["scriptPubKey"]["hex"].asString(), out.script) && toAmount(output["value"], out.value);
+}
+
+bool parseVerboseBlock(const Json::Value& block, bool withPrevouts, ParsedBlock& out) {
+    if (!block.isObject() || !parseHash(block["hash"].asString(), out.hash) || !block["tx"].isArray()
+        || !block["height"].isIntegral()
+        || (block.isMember("previousblockhash") && !parseHash(block["previousblockhash"].asString(), out.previous))) {
+        return false;
+    }
+    out.height = block["height"].asInt64();
+    for (const Json::Value& tx : block["tx"]) {
+        out.firstSpent.push_back(out.spent.size());
+        out.firstCreated.push_back(out.created.size());
+        Hash256 txid;
+        if (!parseHash(tx["txid"].asString(), txid) || !tx["vin"].isArray() || !tx["vout"].isArray()) return false;
+        const bool coinbase = tx["vin"].size() != 0 && tx["vin"][0].isMember("coinbase");
+        if (!coinbase) {
+            for (const Json::Value& input : tx["vin"]) {
+                ParsedOutput& spent = out.spent.emplace_back();
+                if (!parseHash(input["txid"].asString(), spent.txid)) return false;
+                spent.vout = input["vout"].asUInt();
+                if (!withPrevouts) continue;
+                const Json::Value& prevout = input["prevout"];
+                if (!prevout.isObject() || !parseOutput(prevout, spent)) return false;
+                spent.code = static_cast<std::uint32_t>(prevout["height"].asInt64() * 2 + (prevout["generated"].asBool() ? 1 : 0));
+            }
+        }
+        // The genesis coinbase is not spendable and so not part of the UTXO set.
+        if (out.height == 0) continue;
+        for (const Json::Value& output : tx["vout"]) {
+            ParsedOutput created;
+            if (!parseOutput(output, created)) return false;
+            if (isUnspendable(created.script)) continue;
+            created.txid = txid;
+            created.vout = output["n"].asUInt();
+            created.code = static_cast<std::uint32_t>(out.height * 2 + (coinbase ? 1 : 0));
+            out.created.push_back(std::move(created));
+        }
+    }
+    out.firstSpent.push_back(out.spent.size());
+    out.firstCreated.push_back(out.created.size());
+    return true;
+}
+
+/**
+ * @brief Reads Bitcoin Core's VARINT, the MSB base-128 encoding used inside coins.
+ */
+std::uint64_t readVarInt(ByteReader& reader) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < 10; ++i) {
+        const std::uint8_t byte = reader.readU8();
+        if (reader.failed()) return 0;
+        value = (value << 7) | (byte & 0x7f);
+        if (!(byte & 0x80)) return value;
+        ++value;
+    }
+    reader.readBytes(reader.remaining() + 1);       // Too long: put the reader in its failed state.
+    return 0;
+}
+
+/**
+ * @brief Reverses Bitcoin Core's CompressAmount.
+ */
+Amount decompressAmount(std::uint64_t x) {
+    if (x == 0) return 0;
+    --x;
+    int exponent = static_cast<int>(x % 10);
+    x /= 10;
+    std::uint64_t n;
+    if (exponent < 9) {
+        const std::uint64_t digit = x % 9 + 1;
+        x /= 9;
+        n = x * 10 + digit;
+    } else {
+        n = x + 1;
+    }
+    while (exponent-- > 0) n *= 10;
+    return static_cast<Amount>(n);
+}
+
+/**
+ * @brief Reads a script in Bitcoin Core's ScriptCompression format.
+ */
+bool readCompressedScript(ByteReader& reader, std::vector<std::uint8_t>& script) {
+    const std::uint64_t kind = readVarInt(reader);
+    script.clear();
+    switch (kind) {
+    case 0: {   // P2PKH
+        const ByteSpan hash = reader.readBytes(20);
+        script = {0x76, 0xa9, 20};
+        script.insert(script.end(), hash.begin(), hash.end());
+        script.insert(script.end(), {0x88, 0xac});
+        break;
+    }
+    case 1: {   // P2SH
+        const ByteSpan hash = reader.readBytes(20);
+        script = {0xa9, 20};
+        script.insert(script.end(), hash.begin(), hash.end());
+        script.push_back(0x87);
+        break;
+    }
+    case 2:
+    case 3: {   // P2PK, compressed key
+        const ByteSpan x = reader.readBytes(32);
+        script = {33, static_cast<std::uint8_t>(kind)};
+        script.insert(script.end(), x.begin(), x.end());
+        script.push_back(0xac);
+        break;
+    }
+    case 4:
+    case 5: {   // P2PK, uncompressed key stored as its x coordinate
+        const ByteSpan x = reader.readBytes(32);
+        if (reader.failed()) return false;
+        script.resize(67);
+        script[0] = 65;
+        script[66] = 0xac;
+        PublicKey compressed {static_cast<std::uint8_t>(kind == 5 ? 0x03 : 0x02)};
+        std::copy(x.begin(), x.end(), compressed.begin() + 1);
+        std::array<std::uint8_t, 65> uncompressed;
+        // Core keeps such a coin with an empty script if the key is invalid.
+        if (decompressPublicKey(compressed, uncompressed)) {
+            std::copy(uncompressed.begin(), uncompressed.end(), script.begin() + 1);
+        } else {
+            script.clear();
+        }
+        break;
+    }
+    default: {
+        if (kind - 6 > MAX_SCRIPT_SIZE) {
+            // Core skips oversized scripts and stores OP_RETURN instead.
+            reader.readBytes(static_cast<std::size_t>(kind - 6));
+            script = {OP_RETURN};
+            break;
+        }
+        const ByteSpan raw = reader.readBytes(static_cast<std::size_t>(kind - 6));
+        script.assign(raw.begin(), raw.end());
+    }
+    }
+    return !reader.failed();
+}
+}
+
+struct UtxoIndex::Header {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t dirty;                ///< Set while changes may not have reached the disk.
+    std::uint64_t recordCapacity;       ///< Records the file has room for.
+    std::uint64_t recordCount;          ///< Records ever allocated, live or free.
+    std::uint64_t liveCount;            ///< Unspent outputs.
+    std::uint64_t freeHead;             ///< First free record; free records chain through `nextSameScript`.
+    std::uint64_t heapUsed;             ///< Bytes of `scripts.dat` in use.
+    std::uint64_t heapGarbage;          ///< Bytes of spent scripts in the heap, until `reclaimHeap()` compacts it.
+    std::uint64_t scriptHeads;          ///< Occupied slots of the script table.
+    std::int64_t tipHeight;             ///< -1 if empty or not resolved yet.
+    Amount totalValue;
+    Hash256 tipHash;
+};
+
+struct UtxoIndex::Record {
+    Hash256 txid;
+    std::uint32_t vout;
+    std::uint32_t code;                 ///< `height * 2 + coinbase`.
+    Amount value;
+    std::uint64_t fingerprint;          ///< Key of the script table.
+    std::uint32_t prevSameScript;       ///< Neighbours in the chain of the script.
+    std::uint32_t nextSameScript;
+    std::uint32_t scriptLength;
+    std::uint32_t flags;
+    std::array<std::uint8_t, INLINE_SCRIPT> script;     ///< The script, or its heap offset if longer than `INLINE_SCRIPT`.
+};
+
+UtxoIndex::UtxoIndex(std::string directory) : directory(std::move(directory)) {
+    static_assert(sizeof(Header) <= HEADER_SIZE);
+    static_assert(sizeof(Record) == 112, "records are an on-disk format");
+}
+
+UtxoIndex::~UtxoIndex() {
+    close();
+}
+
+UtxoIndex::Header& UtxoIndex::header() {
+    return *reinterpret_cast<Header*>(records.data());
+}
+
+const UtxoIndex::Header& UtxoIndex::header() const {
+    return *reinterpret_cast<const Header*>(records.data());
+}
+
+UtxoIndex::Record& UtxoIndex::record(std::uint32_t number) {
+    return reinterpret_cast<Record*>(records.data() + HEADER_SIZE)[number];
+}
+
+const UtxoIndex::Record& UtxoIndex::record(std::uint32_t number) const {
+    return reinterpret_cast<const Record*>(records.data() + HEADER_SIZE)[number];
+}
+
+ByteSpan UtxoIndex::scriptOf(const Record& entry) const {
+    if (entry.scriptLength <= INLINE_SCRIPT) return {entry.script.data(), entry.scriptLength};
+    std::uint64_t offset;
+    std::memcpy(&offset, entry.script.data(), sizeof(offset));
+    return {heap.data() + offset, entry.scriptLength};
+}
+
+UtxoEntry UtxoIndex::toEntry(const Record& entry) const {
+    const ByteSpan script = scriptOf(entry);
+    return {entry.txid, entry.vout, entry.value, static_cast<std::int32_t>(entry.code >> 1), (entry.code & 1) != 0,
+            std::vector<std::uint8_t>(script.begin(), script.end())};
+}
+
+bool UtxoIndex::open() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        Logger::formattedError("Failed to create {}: {}", directory, error.message());
+        return false;
+    }
+    const std::filesystem::path data = std::filesystem::path(directory) / "utxo.dat";
+    const bool create = !std::filesystem::exists(data, error) || std::filesystem::file_size(data, error) == 0;
+    return mapFiles(create, MIN_RECORDS, MIN_SLOTS);
+}
+
+bool UtxoIndex::mapFiles(bool create, std::uint64_t capacity, std::uint64_t slots) {
+    const std::filesystem::path base(directory);
+    const std::size_t recordBytes = create ? HEADER_SIZE + capacity * sizeof(Record) : 0;
+    if (!records.open((base / "utxo.dat").string(), MappedFile::Mode::ReadWrite, recordBytes)
+        || !heap.open((base / "scripts.dat").string(), MappedFile::Mode::ReadWrite, MIN_HEAP)
+        || !outpoints.open((base / "outpoints.idx").string(), MappedFile::Mode::ReadWrite)
+        || !scripts.open((base / "scripts.idx").string(), MappedFile::Mode::ReadWrite)) {
+        close();
+        return false;
+    }
+
+    if (create) {
+        Header& fresh = header();
+        std::memset(&fresh, 0, sizeof(Header));
+        fresh.magic = MAGIC;
+        fresh.version = FORMAT_VERSION;
+        fresh.recordCapacity = capacity;
+        fresh.freeHead = NONE;
+        fresh.tipHeight = -1;
+        return rebuildTables(slots, slots) && flush();
+    }
+
+    if (records.size() < HEADER_SIZE || header().magic != MAGIC || header().version != FORMAT_VERSION) {
+        Logger::formattedError("{} is not a UTXO index of this version or byte order", records.path());
+        close();
+        return false;
+    }
+    if (header().dirty) {
+        Logger::formattedError("The UTXO index in {} was not flushed after its last change; rebuild it", directory);
+        close();
+        return false;
+    }
+    if (records.size() < HEADER_SIZE + header().recordCapacity * sizeof(Record) || heap.size() < header().heapUsed) {
+        Logger::formattedError("The UTXO index in {} is truncated; rebuild it", directory);
+        close();
+        return false;
+    }
+
+    // The tables only cache what the records say; rebuild them if they are missing or torn.
+    const auto usable = [](const MappedFile& table) {
+        const std::size_t slotCount = table.size() / sizeof(std::uint32_t);
+        return slotCount >= MIN_SLOTS && (slotCount & (slotCount - 1)) == 0;
+    };
+    if (!usable(outpoints) || !usable(scripts)) {
+        Logger::formattedWarning("Rebuilding the tables of the UTXO index in {}", directory);
+        beginWrite();
+        return rebuildTables(slotsFor(header().liveCount), slotsFor(header().scriptHeads)) && flush();
+    }
+    return true;
+}
+
+void UtxoIndex::beginWrite() {
+    if (writing) return;
+    header().dirty = 1;
+    records.sync();
+    writing = true;
+}
+
+bool UtxoIndex::writeFailed() {
+    damaged = true;
+    Logger::formattedError("A write to the UTXO index in {} failed; the index stays dirty and must be rebuilt", directory);
+    return false;
+}
+
+bool UtxoIndex::flush() {
+    if (!records.isOpen() || !writing) return true;
+    if (damaged) return false;
+    if (!heap.sync() || !outpoints.sync() || !scripts.sync() || !records.sync()) return false;
+    // Only once everything else is on disk may the dirty mark go.
+    header().dirty = 0;
+    if (!records.sync()) return false;
+    writing = false;
+    return true;
+}
+
+void UtxoIndex::close() {
+    if (records.isOpen()) flush();
+    records.close();
+    heap.close();
+    outpoints.close();
+    scripts.close();
+}
+
+bool UtxoIndex::rebuildTables(std::uint64_t outpointSlots, std::uint64_t scriptSlots) {
+    if ((outpoints.size() != outpointSlots * sizeof(std::uint32_t) && !outpoints.resize(outpointSlots * sizeof(std::uint32_t)))
+        || (scripts.size() != scriptSlots * sizeof(std::uint32_t) && !scripts.resize(scriptSlots * sizeof(std::uint32_t)))) {
+        return false;
+    }
+    std::memset(outpoints.data(), 0xff, outpoints.size());
+    std::memset(scripts.data(), 0xff, scripts.size());
+    header().scriptHeads = 0;
+
+    auto* slots = reinterpret_cast<std::uint32_t*>(outpoints.data());
+    const std::size_t mask = outpointSlots - 1;
+    for (std::uint32_t number = 0; number < header().recordCount; ++number) {
+        const Record& entry = record(number);
+        if (!(entry.flags & LIVE)) continue;
+        std::size_t i = outpointHash(entry.txid, entry.vout) & mask;
+        while (slots[i] != NONE) i = (i + 1) & mask;
+        slots[i] = number;
+        linkScript(number);
+    }
+    return true;
+}
+
+bool UtxoIndex::clear(std::uint64_t coins) {
+    Header& state = header();
+    state.recordCount = 0;
+    state.liveCount = 0;
+    state.freeHead = NONE;
+    state.heapUsed = 0;
+    state.heapGarbage = 0;
+    state.totalValue = 0;
+    state.tipHash = {};
+    state.tipHeight = -1;
+    if (state.recordCapacity < coins) {
+        if (!records.resize(HEADER_SIZE + coins * sizeof(Record))) return false;
+        header().recordCapacity = coins;
+    }
+    return rebuildTables(slotsFor(coins), slotsFor(coins));
+}
+
+bool UtxoIndex::reserve(std::uint64_t coins) {
+    Header& state = header();
+    if (state.recordCapacity - state.liveCount < coins) {
+        const std::uint64_t capacity = std::max(state.recordCapacity * 2, state.liveCount + coins);
+        if (!records.resize(HEADER_SIZE + capacity * sizeof(Record))) return false;
+        header().recordCapacity = capacity;
+    }
+    const std::uint64_t outpointSlots = outpoints.size() / sizeof(std::uint32_t);
+    const std::uint64_t scriptSlots = scripts.size() / sizeof(std::uint32_t);
+    const bool outpointsFull = (header().liveCount + coins) * 10 > outpointSlots * 7;
+    const bool scriptsFull = (header().scriptHeads + coins) * 10 > scriptSlots * 7;
+    if (!outpointsFull && !scriptsFull) return true;
+    return rebuildTables(outpointsFull ? std::max(outpointSlots * 2, slotsFor(header().liveCount + coins)) : outpointSlots,
+                         scriptsFull ? std::max(scriptSlots * 2, slotsFor(header().scriptHeads + coins)) : scriptSlots);
+}
+
+std::uint32_t UtxoIndex::findRecord(const Hash256& txid, std::uint32_t vout, std::size_t* position) const {
+    const auto* slots = reinterpret_cast<const std::uint32_t*>(outpoints.data());
+    const std::size_t mask = outpoints.size() / sizeof(std::uint32_t) - 1;
+    for (std::size_t i = outpointHash(txid, vout) & mask;; i = (i + 1) & mask) {
+        const std::uint32_t number = slots[i];
+        if (number == NONE) return NONE;
+        const Record& entry = record(number);
+        if (entry.vout == vout && entry.txid == txid) {
+            if (position) *position = i;
+            return number;
+        }
+    }
+}
+
+std::size_t UtxoIndex::findScriptSlot(std::uint64_t fingerprint) const {
+    const auto* slots = reinterpret_cast<const std::uint32_t*>(scripts.data());
+    const std::size_t mask = scripts.size() / sizeof(std::uint32_t) - 1;
+    for (std::size_t i = fingerprint & mask;; i = (i + 1) & mask) {
+        if (slots[i] == NONE || record(slots[i]).fingerprint == fingerprint) return i;
+    }
+}
+
+void UtxoIndex::linkScript(std::uint32_t number) {
+    auto* slots = reinterpret_cast<std::uint32_t*>(scripts.data());
+    Record& entry = record(number);
+    const std::size_t slot = findScriptSlot(entry.fingerprint);
+    entry.prevSameScript = NONE;
+    entry.nextSameScript = slots[slot];
+    if (slots[slot] == NONE) {
+        ++header().scriptHeads;
+    } else {
+        record(slots[slot]).prevSameScript = number;
+    }
+    slots[slot] = number;
+}
+
+bool UtxoIndex::addCoin(const Coin& coin) {
+    // Two pre-BIP30 coinbases were created twice; like Core, the later one replaces the earlier.
+    spendCoin(coin.txid, coin.vout);
+    if (!reserve(1)) return false;
+
+    std::uint64_t offset = 0;
+    if (coin.script.size() > INLINE_SCRIPT) {
+        offset = header().heapUsed;
+        if (offset + coin.script.size() > heap.size()
+            && !heap.resize(std::max<std::size_t>(heap.size() * 2, offset + coin.script.size()))) {
+            return false;
+        }
+        std::memcpy(heap.data() + offset, coin.script.data(), coin.script.size());
+        header().heapUsed += coin.script.size();
+    }
+
+    Header& state = header();
+    std::uint32_t number;
+    if (state.freeHead != NONE) {
+        number = static_cast<std::uint32_t>(state.freeHead);
+        state.freeHead = record(number).nextSameScript;
+    } else {
+        number = static_cast<std::uint32_t>(state.recordCount++);
+    }
+    Record& entry = record(number);
+    entry = {};
+    entry.txid = coin.txid;
+    entry.vout = coin.vout;
+    entry.code = coin.code;
+    entry.value = coin.value;
+    entry.fingerprint = scriptFingerprint(coin.script);
+    entry.scriptLength = static_cast<std::uint32_t>(coin.script.size());
+    entry.flags = LIVE;
+    if (coin.script.size() <= INLINE_SCRIPT) {
+        std::copy(coin.script.begin(), coin.script.end(), entry.script.begin());
+    } else {
+        std::memcpy(entry.script.data(), &offset, sizeof(offset));
+    }
+
+    auto* slots = reinterpret_cast<std::uint32_t*>(outpoints.data());
+    const std::size_t mask = outpoints.size() / sizeof(std::uint32_t) - 1;
+    std::size_t i = outpointHash(coin.txid, coin.vout) & mask;
+    while (slots[i] != NONE) i = (i + 1) & mask;
+    slots[i] = number;
+    linkScript(number);
+
+    ++state.liveCount;
+    state.totalValue += coin.value;
+    return true;
+}
+
+bool UtxoIndex::spendCoin(const Hash256& txid, std::uint32_t vout) {
+    std::size_t position = 0;
+    const std::uint32_t number = findRecord(txid, vout, &position);
+    if (number == NONE) return false;
+
+    eraseSlot(reinterpret_cast<std::uint32_t*>(outpoints.data()), outpoints.size() / sizeof(std::uint32_t) - 1, position,
+              [this](std::uint32_t other) { return outpointHash(record(other).txid, record(other).vout); });
+
+    Record& entry = record(number);
+    if (entry.prevSameScript != NONE) {
+        record(entry.prevSameScript).nextSameScript = entry.nextSameScript;
+    } else {
+        // The chain's head: the table slot moves on to the next record, or empties.
+        auto* slots = reinterpret_cast<std::uint32_t*>(scripts.data());
+        const std::size_t slot = findScriptSlot(entry.fingerprint);
+        if (entry.nextSameScript != NONE) {
+            slots[slot] = entry.nextSameScript;
+        } else {
+            eraseSlot(slots, scripts.size() / sizeof(std::uint32_t) - 1, slot,
+                      [this](std::uint32_t other) { return record(other).fingerprint; });
+            --header().scriptHeads;
+        }
+    }
+    if (entry.nextSameScript != NONE) record(entry.nextSameScript).prevSameScript = entry.prevSameScript;
+
+    Header& state = header();
+    if (entry.scriptLength > INLINE_SCRIPT) state.heapGarbage += entry.scriptLength;
+    --state.liveCount;
+    state.totalValue -= entry.value;
+    entry.flags = 0;
+    entry.prevSameScript = NONE;
+    entry.nextSameScript = static_cast<std::uint32_t>(state.freeHead);
+    state.freeHead = number;
+    return true;
+}
+
+void UtxoIndex::reclaimHeap() {
+    Header& state = header();
+    if (state.heapGarbage < MIN_HEAP || state.heapGarbage * 2 <= state.heapUsed) return;
+
+    // Slide the live scripts down over the spent ones in heap order, so none is overwritten before it moves.
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> live;
+    for (std::uint32_t number = 0; number < state.recordCount; ++number) {
+        const Record& entry = record(number);
+        if (!(entry.flags & LIVE) || entry.scriptLength <= INLINE_SCRIPT) continue;
+        std::uint64_t offset;
+        std::memcpy(&offset, entry.script.data(), sizeof(offset));
+        live.emplace_back(offset, number);
+    }
+    std::sort(live.begin(), live.end());
+    std::uint64_t used = 0;
+    for (const auto& [offset, number] : live) {
+        Record& entry = record(number);
+        if (offset != used) std::memmove(heap.data() + used, heap.data() + offset, entry.scriptLength);
+        std::memcpy(entry.script.data(), &used, sizeof(used));
+        used += entry.scriptLength;
+    }
+    Logger::formattedDebug("Compacted the UTXO index script heap from {} to {} bytes", state.heapUsed, used);
+    state.heapUsed = used;
+    state.heapGarbage = 0;
+}
+
+bool UtxoIndex::loadSnapshot(const std::string& snapshotPath) {
+    MappedFile snapshot;
+    if (!snapshot.open(snapshotPath, MappedFile::Mode::ReadOnly)) return false;
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!records.isOpen()) {
+        Logger::error("The UTXO index is not open");
+        return false;
+    }
+    return loadSnapshotLocked({snapshot.data(), snapshot.size()});
+}
+
+bool UtxoIndex::loadSnapshotLocked(ByteSpan data) {
+    // Snapshots of Bitcoin Core 27 and earlier have no header: they start with the base block.
+    ByteReader reader(data);
+    const bool legacy = data.size() < sizeof(SNAPSHOT_MAGIC) || !std::equal(std::begin(SNAPSHOT_MAGIC), std::end(SNAPSHOT_MAGIC), data.begin());
+    if (!legacy) {
+        reader.readBytes(sizeof(SNAPSHOT_MAGIC));
+        const std::uint16_t version = static_cast<std::uint16_t>(reader.readU8() | reader.readU8() << 8);
+        reader.readBytes(4);    // Network magic.
+        if (!reader.failed() && version != SNAPSHOT_VERSION) {
+            Logger::formattedError("Unsupported dumptxoutset snapshot version {}", version);
+            return false;
+        }
+    }
+    const Hash256 baseBlock = reader.readHash();
+    const std::uint64_t coinCount = reader.readU64();
+    // Without a magic to check, a coin count the file cannot hold is what gives a stray file away.
+    if (reader.failed() || coinCount > reader.remaining() / (legacy ? MIN_LEGACY_COIN_BYTES : MIN_COIN_BYTES)) {
+        Logger::error("Not a dumptxoutset snapshot");
+        return false;
+    }
+
+    // Start over with tables sized for the whole set, so nothing is rehashed while loading.
+    beginWrite();
+    if (!clear(coinCount)) return writeFailed();
+
+    std::vector<std::uint8_t> script;
+    const auto readCoin = [&](const Hash256& txid, std::uint32_t vout) {
+        const std::uint64_t code = readVarInt(reader);
+        const Amount value = decompressAmount(readVarInt(reader));
+        if (!readCompressedScript(reader, script) || code > UINT32_MAX) return false;
+        return addCoin({txid, vout, static_cast<std::uint32_t>(code), value, script}) || writeFailed();
+    };
+
+    std::uint64_t loaded = 0;
+    std::uint64_t nextReport = SNAPSHOT_REPORT_INTERVAL;
+    while (loaded < coinCount) {
+        const Hash256 txid = reader.readHash();
+        if (legacy) {
+            const std::uint32_t vout = reader.readU32();
+            if (!readCoin(txid, vout)) break;
+            ++loaded;
+        } else {
+            // Since Bitcoin Core 28, the outputs are grouped by transaction.
+            const std::uint64_t outputs = reader.readCompactSize(coinCount - loaded);
+            if (reader.failed() || outputs == 0) break;
+            std::uint64_t i = 0;
+            for (; i < outputs; ++i) {
+                const std::uint64_t vout = reader.readCompactSize(UINT32_MAX);
+                if (!readCoin(txid, static_cast<std::uint32_t>(vout))) break;
+            }
+            loaded += i;
+            if (i != outputs) break;
+        }
+        if (loaded >= nextReport) {
+            Logger::formattedInfo("Loaded {} of {} coins", loaded, coinCount);
+            nextReport += SNAPSHOT_REPORT_INTERVAL;
+        }
+    }
+    if (damaged) return false;
+    if (loaded != coinCount) {
+        Logger::formattedError("The snapshot is truncated or malformed after {} of {} coins; the index is left empty",
+                               loaded, coinCount);
+        if (!clear(0)) return writeFailed();
+        flush();
+        return false;
+    }
+
+    header().tipHash = baseBlock;
+    Logger::formattedInfo("Loaded {} coins from the snapshot at block {}", coinCount, hashToHex(baseBlock));
+    return flush();
+}
+
+bool UtxoIndex::connectBlock(const Json::Value& block) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    return records.isOpen() && connectLocked(block);
+}
+
+bool UtxoIndex::connectLocked(const Json::Value& block) {
+    ParsedBlock parsed;
+    if (!parseVerboseBlock(block, false, parsed)) {
+        Logger::error("Cannot connect a malformed block to the UTXO index");
+        return false;
+    }
+    if (parsed.previous != header().tipHash) {
+        Logger::formattedError("Block {} does not extend the UTXO index tip {}", hashToHex(parsed.hash), hashToHex(header().tipHash));
+        return false;
+    }
+
+    beginWrite();
+    std::size_t missing = 0;
+    for (std::size_t tx = 0; tx + 1 < parsed.firstSpent.size(); ++tx) {
+        for (std::size_t i = parsed.firstSpent[tx]; i < parsed.firstSpent[tx + 1]; ++i) {
+            if (!spendCoin(parsed.spent[i].txid, parsed.spent[i].vout)) ++missing;
+        }
+        for (std::size_t i = parsed.firstCreated[tx]; i < parsed.firstCreated[tx + 1]; ++i) {
+            const ParsedOutput& output = parsed.created[i];
+            if (!addCoin({output.txid, output.vout, output.code, output.value, output.script})) return writeFailed();
+        }
+    }
+    if (missing) Logger::formattedWarning("Block {} spent {} outputs the UTXO index does not hold", hashToHex(parsed.hash), missing);
+    reclaimHeap();
+
+    header().tipHash = parsed.hash;
+    header().tipHeight = parsed.height;
+    return true;
+}
+
+bool UtxoIndex::disconnectBlock(const Json::Value& block) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    return records.isOpen() && disconnectLocked(block);
+}
+
+bool UtxoIndex::disconnectLocked(const Json::Value& block) {
+    ParsedBlock parsed;
+    if (!parseVerboseBlock(block, true, parsed)) {
+        Logger::error("Cannot disconnect a malformed block from the UTXO index; it needs getblock verbosity 3");
+        return false;
+    }
+    if (parsed.hash != header().tipHash) {
+        Logger::formattedError("Block {} is not the UTXO index tip", hashToHex(parsed.hash));
+        return false;
+    }
+
+    // Undo the transactions last to first, so outputs created and spent within the block cancel out.
+    beginWrite();
+    for (std::size_t tx = parsed.firstSpent.size() - 1; tx-- > 0;) {
+        for (std::size_t i = parsed.firstCreated[tx + 1]; i-- > parsed.firstCreated[tx];) {
+            spendCoin(parsed.created[i].txid, parsed.created[i].vout);
+        }
+        for (std::size_t i = parsed.firstSpent[tx + 1]; i-- > parsed.firstSpent[tx];) {
+            const ParsedOutput& output = parsed.spent[i];
+            if (!addCoin({output.txid, output.vout, output.code, output.value, output.script})) return writeFailed();
+        }
+    }
+    reclaimHeap();
+
+    header().tipHash = parsed.previous;
+    if (header().tipHeight >= 0) --header().tipHeight;
+    return true;
+}
+
+bool UtxoIndex::catchUp(BitcoinClient& client, const BlockFetchSettings& settings) {
+    BlockFetchSettings fetchSettings = settings;
+    fetchSettings.verbosity = 3;
+
+    while (true) {
+        const Json::Value count = client.getBlockCount();
+        if (!count.isIntegral()) return false;
+        const Hash256 start = tipHash();
+        std::int64_t height = -1;
+
+        if (start != Hash256 {}) {
+            Json::Value params(Json::arrayValue);
+            params.append(hashToHex(start));
+            const RpcResult tipHeader = client.sendCall("getblockheader", params);
+            if (!tipHeader.ok()) return false;
+            if (tipHeader.result["confirmations"].asInt64() < 0) {
+                // The tip left the active chain: step back and look again.
+                params.append(3);
+                const RpcResult stale = client.sendCall("getblock", params);
+                if (!stale.ok() || !disconnectBlock(stale.result)) return false;
+                continue;
+            }
+            height = tipHeader.result["height"].asInt64();
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            header().tipHeight = height;    // Unknown right after a snapshot.
+        }
+        if (height >= count.asInt64()) {
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            return flush();
+        }
+
+        BlockFetcher fetcher(client, fetchSettings);
+        const bool complete = fetcher.run(height + 1, count.asInt64(), [this](std::int64_t at, Json::Value&& block) {
+            if (!connectBlock(block)) return false;
+            if (at % 1000 == 0) {
+                std::unique_lock<std::shared_mutex> lock(mutex);
+                flush();
+            }
+            return true;
+        });
+        // A run that made no progress failed for good; otherwise look again, the chain may have moved.
+        if (!complete && tipHash() == start) return false;
+    }
+}
+
+std::optional<UtxoEntry> UtxoIndex::find(const Hash256& txid, std::uint32_t vout) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (!records.isOpen()) return std::nullopt;
+    const std::uint32_t number = findRecord(txid, vout);
+    if (number == NONE) return std::nullopt;
+    return toEntry(record(number));
+}
+
+std::vector<UtxoEntry> UtxoIndex::findByScript(ByteSpan scriptPubKey) const {
+    std::vector<UtxoEntry> found;
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (!records.isOpen()) return found;
+    const std::uint64_t fingerprint = scriptFingerprint(scriptPubKey);
+    const auto* slots = reinterpret_cast<const std::uint32_t*>(scripts.data());
+    for (std::uint32_t number = slots[findScriptSlot(fingerprint)]; number != NONE; number = record(number).nextSameScript) {
+        const Record& entry = record(number);
+        const ByteSpan script = scriptOf(entry);
+        if (std::equal(script.begin(), script.end(), scriptPubKey.begin(), scriptPubKey.end())) found.push_back(toEntry(entry));
+    }
+    return found;
+}
+
+std::size_t UtxoIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return records.isOpen() ? static_cast<std::size_t>(header().liveCount) : 0;
+}
+
+Amount UtxoIndex::totalValue() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return records.isOpen() ? header().totalValue : 0;
+}
+
+Hash256 UtxoIndex::tipHash() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return records.isOpen() ? header().tipHash : Hash256 {};
+}
+
+std::int64_t UtxoIndex::tipHeight() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return records.isOpen() ? header().tipHeight : -1;
+}
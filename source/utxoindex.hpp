@@ -0,0 +1,226 @@
+#ifndef UTXOINDEX_HPP
+#define UTXOINDEX_HPP
+
+#if __has_include("blockfetcher.hpp")
+#   include "blockfetcher.hpp"
+#else
+#   error "Bitcoin's \"blockfetcher.hpp\" was not found!"
+#endif
+
+#if __has_include("mappedfile.hpp")
+#   include "mappedfile.hpp"
+#else
+#   error "Bitcoin's \"mappedfile.hpp\" was not found!"
+#endif
+
+#if __has_include("rawblock.hpp")
+#   include "rawblock.hpp"
+#else
+#   error "Bitcoin's \"rawblock.hpp\" was not found!"
+#endif
+
+#ifdef USE_ZMQ
+#   if __has_include("zmqsubscriber.hpp")
+#       include "zmqsubscriber.hpp"
+#   else
+#       error "Bitcoin's \"zmqsubscriber.hpp\" was not found!"
+#   endif
+#endif
+
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @struct UtxoEntry
+ * @brief One unspent output, as stored in a UtxoIndex.
+ */
+struct UtxoEntry {
+    Hash256 txid {};                        ///< Txid of the creating transaction, internal byte order.
+    std::uint32_t vout = 0;                 ///< Output index.
+    Amount value = 0;                       ///< Value in satoshis.
+    std::int32_t height = 0;                ///< Height of the block that created the output.
+    bool coinbase = false;                  ///< Created by a coinbase transaction.
+    std::vector<std::uint8_t> scriptPubKey; ///< The locking script.
+};
+
+/**
+ * @class UtxoIndex
+ * @brief A local, memory-mapped copy of the UTXO set, for `gettxout` and `scantxoutset` style lookups.
+ *
+ * The index lives in a directory of four files:
+ *  - `utxo.dat`: a header with the tip, followed by fixed-size records, one per output.
+ *    Short scripts are stored in the record itself.
+ *  - `scripts.dat`: the scripts too long to fit in a record. Spent ones leave gaps, which
+ *    are compacted away once they make up more than half of the heap.
+ *  - `outpoints.idx`: an open-addressing table of record numbers keyed by outpoint.
+ *  - `scripts.idx`: the same keyed by script fingerprint. Each slot heads a chain
+ *    of the records paying to that script, so lookups by script walk only their own outputs.
+ *
+ * Both tables are derived from the records and are rebuilt from them when they grow.
+ * Lookups read the mapped pages directly and never block on the node.
+ *
+ * The index is filled either from a `dumptxoutset` snapshot (the headerless layout of Bitcoin
+ * Core 27 and earlier, or version 2 since Core 28) or by replaying the chain from genesis,
+ * and kept at the tip by `catchUp()`, which fetches blocks at verbosity 3 with a
+ * BlockFetcher and undoes blocks a reorganization removed.
+ * Writes mark the index dirty until the next `flush()`; an index that was not flushed after
+ * its last write is refused by `open()`, since a crash may have left it half-updated.
+ *
+ * Records use the host's byte order; the files are not portable between architectures.
+ *
+ * @code
+ * UtxoIndex utxos("/var/lib/utxo");
+ * if (utxos.open() && (utxos.size() || utxos.loadSnapshot("/tmp/utxo.dat")) && utxos.catchUp(client)) {
+ *     auto coin = utxos.find(txid, 0);
+ * }
+ * @endcode
+ */
+class UtxoIndex {
+public:
+    /**
+     * @brief Creates an index stored in `directory`; nothing is opened until `open()`.
+     */
+    explicit UtxoIndex(std::string directory);
+    UtxoIndex(const UtxoIndex&) = delete;
+    UtxoIndex& operator=(const UtxoIndex&) = delete;
+
+    /**
+     * @brief Flushes and closes the index.
+     */
+    ~UtxoIndex();
+
+    /**
+     * @brief Opens the index, creating empty files on first use.
+     * @return `false` if a file could not be mapped or the index was left dirty.
+     */
+    bool open();
+
+    /**
+     * @brief Flushes and unmaps the files.
+     */
+    void close();
+
+    /**
+     * @brief Writes all changes to disk and clears the dirty mark.
+     */
+    bool flush();
+
+    /**
+     * @brief Replaces the contents with a `dumptxoutset` snapshot.
+     *
+     * The tip becomes the snapshot's base block; its height is resolved by the next `catchUp()`.
+     *
+     * @param snapshotPath The file written by `dumptxoutset`; it is read memory-mapped.
+     * @return `false` if the file is missing, truncated or of an unsupported version.
+     */
+    bool loadSnapshot(const std::string& snapshotPath);
+
+    /**
+     * @brief Applies a block on top of the tip.
+     * @param block The result of `getblock <hash> 3`.
+     * @return `false` if the block does not extend the tip or is malformed.
+     */
+    bool connectBlock(const Json::Value& block);
+
+    /**
+     * @brief Undoes the tip block, restoring the outputs it spent from their `prevout`.
+     * @param block The result of `getblock <tip> 3`.
+     * @return `false` if the block is not the tip or is malformed.
+     */
+    bool disconnectBlock(const Json::Value& block);
+
+    /**
+     * @brief Brings the index to the node's tip: undoes blocks no longer on the active chain, then fetches the missing ones.
+     * @param client The node to follow.
+     * @param settings Parallelism of the block fetch; the verbosity is always 3.
+     * @return `true` if the index reached the tip the node reported.
+     */
+    bool catchUp(BitcoinClient& client, const BlockFetchSettings& settings = {});
+
+#ifdef USE_ZMQ
+    /**
+     * @brief Catches up on every `hashblock` notification of a ZmqSubscriber.
+     * @param handlers The handlers passed to `ZmqSubscriber::start()`; `onHashBlock` and `onBlockResync` are replaced.
+     * @param client The node to follow; must outlive the subscriber.
+     */
+    void attach(ZmqHandlers& handlers, BitcoinClient& client) {
+        handlers.onHashBlock = [this, &client](const Hash256&) { catchUp(client); };
+        handlers.onBlockResync = [this, &client](const Json::Value&) { catchUp(client); };
+    }
+#endif
+
+    /**
+     * @name Lookups
+     * @brief Thread-safe reads of the mapped set.
+     */
+    ///@{
+    std::optional<UtxoEntry> find(const Hash256& txid, std::uint32_t vout) const;  ///< Looks up one outpoint.
+    std::vector<UtxoEntry> findByScript(ByteSpan scriptPubKey) const;              ///< All unspent outputs paying to a script.
+    std::size_t size() const;                                                       ///< Number of unspent outputs.
+    Amount totalValue() const;                                                      ///< Sum of all unspent values.
+    Hash256 tipHash() const;                                                        ///< Block the index reflects; zero if empty.
+    std::int64_t tipHeight() const;                                                 ///< Height of the tip; -1 if empty or not resolved yet.
+    ///@}
+
+private:
+    struct Header;
+    struct Record;
+
+    /**
+     * @struct Coin
+     * @brief An output about to be stored.
+     */
+    struct Coin {
+        Hash256 txid;
+        std::uint32_t vout;
+        std::uint32_t code;         ///< `height * 2 + coinbase`, as in Bitcoin Core.
+        Amount value;
+        ByteSpan script;
+    };
+
+    /**
+     * @brief Maps the files, creating them with the given capacities if `create` is set.
+     */
+    bool mapFiles(bool create, std::uint64_t records, std::uint64_t slots);
+
+    Header& header();
+    const Header& header() const;
+    Record& record(std::uint32_t number);
+    const Record& record(std::uint32_t number) const;
+    ByteSpan scriptOf(const Record& entry) const;
+    UtxoEntry toEntry(const Record& entry) const;
+
+    /**
+     * @brief Marks the index dirty before its first change since the last flush.
+     */
+    void beginWrite();
+
+    std::uint32_t findRecord(const Hash256& txid, std::uint32_t vout, std::size_t* position = nullptr) const;
+    std::size_t findScriptSlot(std::uint64_t fingerprint) const;
+    bool addCoin(const Coin& coin);
+    bool spendCoin(const Hash256& txid, std::uint32_t vout);
+    bool reserve(std::uint64_t coins);
+    bool clear(std::uint64_t coins);                ///< Empties the index, with room for `coins`.
+    bool writeFailed();                             ///< Marks the index damaged; returns `false`.
+    bool rebuildTables(std::uint64_t outpointSlots, std::uint64_t scriptSlots);
+    void linkScript(std::uint32_t number);
+    void reclaimHeap();                             ///< Compacts the script heap once more than half of it is spent scripts.
+
+    bool loadSnapshotLocked(ByteSpan data);
+    bool connectLocked(const Json::Value& block);
+    bool disconnectLocked(const Json::Value& block);
+
+    std::string directory;                  ///< Where the files live.
+    mutable std::shared_mutex mutex;        ///< Readers share; changes are exclusive.
+    MappedFile records;                     ///< Header and records.
+    MappedFile heap;                        ///< Long scripts.
+    MappedFile outpoints;                   ///< Outpoint table.
+    MappedFile scripts;                     ///< Script table.
+    bool writing = false;                   ///< The dirty mark is set on disk.
+    bool damaged = false;                   ///< A write failed half-way; the dirty mark must stay.
+};
+
+#endif // UTXOINDEX_HPP
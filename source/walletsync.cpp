@@ -0,0 +1,598 @@
+#include "walletsync.hpp"
+#include "rawblock.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace {
+constexpr std::int32_t UNCONFIRMED_KEY = INT32_MAX;     ///< Height key of unconfirmed coins and transactions.
+constexpr int ALL_CONFIRMATIONS = 9999999;              ///< `maxconf` of `listunspent` that lists every output.
+constexpr std::size_t MAX_FOLLOW_ROUNDS = 16;           ///< Bound on chains of unlisted transactions followed back.
+
+std::int32_t heightKey(std::int32_t height) {
+    return height < 0 ? UNCONFIRMED_KEY : height;
+}
+
+/**
+ * @class WalletListReader
+ * @brief Decodes the elements of a streamed wallet listing one by one, without building a DOM.
+ *
+ * Elements sit at `elementDepth`: 4 for the `transactions` and `removed` arrays of the
+ * `listsinceblock` object, 3 for the array `listunspent` returns. Depth 1 is the envelope.
+ */
+template<typename T>
+class WalletListReader : public JsonHandler {
+public:
+    using ElementCallback = std::function<void(std::string_view container, T&& element)>;
+
+    WalletListReader(int elementDepth, ElementCallback onElement) : elementDepth(elementDepth), onElement(std::move(onElement)) {}
+
+    bool succeeded() const { return hasResult && !hasError && valid; }     ///< A well-formed result and no error.
+    const std::string& lastBlock() const { return lastBlockHash; }        ///< `lastblock` of a `listsinceblock` result.
+    const std::string& error() const { return errorMessage; }             ///< The error `message`, if any.
+
+    bool onNull() override { return scalar({JsonScalar::Kind::Null, {}, false}); }
+    bool onBool(bool b) override { return scalar({JsonScalar::Kind::Bool, {}, b}); }
+    bool onNumber(std::string_view raw) override { return scalar({JsonScalar::Kind::Number, raw, false}); }
+    bool onString(std::string_view text) override { return scalar({JsonScalar::Kind::String, text, false}); }
+
+    bool onKey(std::string_view key) override {
+        if (depth == 1) {
+            section = key == "result" ? Section::Result : key == "error" ? Section::Error : Section::Other;
+        } else if (depth == 2) {
+            container.assign(key);
+        } else if (depth == elementDepth) {
+            member.assign(key);
+            path.assign(key);
+        } else if (depth == elementDepth + 1) {
+            path.assign(member).append(".").append(key);
+        }
+        return true;
+    }
+
+    bool onStartObject() override { return open(); }
+    bool onStartArray() override { return open(); }
+    bool onEndObject() override { return close(); }
+    bool onEndArray() override { return close(); }
+
+private:
+    enum class Section : std::uint8_t { Other, Result, Error };
+
+    bool open() {
+        ++depth;
+        if (depth == 2 && section == Section::Result) hasResult = true;
+        if (depth == 2 && section == Section::Error) hasError = true;
+        if (depth == elementDepth && section == Section::Result) element = {};
+        if (depth == elementDepth + 1) path.assign(member);
+        return true;
+    }
+
+    bool close() {
+        if (depth == elementDepth && section == Section::Result) onElement(container, std::move(element));
+        --depth;
+        return true;
+    }
+
+    bool scalar(const JsonScalar& value) {
+        if (section == Section::Error) {
+            if (depth == 2 && container == "message") errorMessage.assign(value.text);
+            return true;
+        }
+        if (section != Section::Result) return true;
+        if (depth == 2 && container == "lastblock") lastBlockHash.assign(value.text);
+        if (depth < elementDepth || depth > elementDepth + 1) return true;
+        if (!decodeField(element, path, value)) valid = false;
+        return true;
+    }
+
+    int elementDepth;
+    ElementCallback onElement;
+    int depth = 0;
+    Section section = Section::Other;
+    T element;
+    std::string container;      ///< Member of the result (or of the error) being read.
+    std::string member;         ///< Member of the element being decoded.
+    std::string path;           ///< Path of the current scalar, relative to the element.
+    std::string lastBlockHash;
+    std::string errorMessage;
+    bool hasResult = false;
+    bool hasError = false;
+    bool valid = true;
+};
+
+/**
+ * @brief Adds one `listsinceblock` entry to the transaction it belongs to.
+ */
+void mergeEntry(WalletTx& tx, const WalletEntryResult& entry, std::int32_t tipHeight) {
+    if (tx.entries.empty()) {
+        tx.txid = entry.txid;
+        tx.time = entry.time;
+        tx.conflicted = entry.confirmations < 0;
+        if (entry.confirmations > 0) {
+            tx.blockHash = entry.blockHash;
+            // `blockheight` is only reported since Bitcoin Core 0.20.
+            tx.height = entry.blockHeight >= 0 ? entry.blockHeight : tipHeight - static_cast<std::int32_t>(entry.confirmations) + 1;
+        }
+    }
+    tx.abandoned = tx.abandoned || entry.abandoned;
+    tx.amount += entry.amount;
+    if (entry.category == WalletCategory::Send) tx.fee = -entry.fee;
+    tx.entries.push_back({entry.address, entry.amount, entry.vout, entry.category});
+}
+}
+
+std::size_t WalletSync::TxidHash::operator()(const Hash256& txid) const {
+    std::size_t bits;
+    std::memcpy(&bits, txid.data(), sizeof(bits));
+    return bits;
+}
+
+WalletSync::WalletSync(BitcoinClient& client, const WalletSyncSettings& settings)
+    : client(client), syncSettings(settings) {
+    syncSettings.targetConfirmations = std::max(syncSettings.targetConfirmations, 1);
+    syncSettings.transactionBatchSize = std::max<std::size_t>(syncSettings.transactionBatchSize, 1);
+}
+
+WalletSync::~WalletSync() {
+    stop();
+}
+
+WalletSync::Record& WalletSync::State::put(WalletTx tx) {
+    auto [found, added] = records.try_emplace(tx.txid);
+    Record& record = found->second;
+    if (!added) history.erase({record.tx.time, record.tx.txid});
+    record.tx = std::move(tx);
+    history.insert({record.tx.time, record.tx.txid});
+    if (record.tx.height < 0 && !record.tx.conflicted) {
+        pending.insert(record.tx.txid);
+    } else {
+        pending.erase(record.tx.txid);
+    }
+    return record;
+}
+
+void WalletSync::State::spend(Record& record, std::vector<OutPoint> inputs) {
+    for (const OutPoint& outpoint : inputs) {
+        spenders.emplace(outpoint, record.tx.txid);
+        const auto coin = coins.find(outpoint);
+        if (coin == coins.end()) continue;
+        record.spentCoins.push_back(std::move(coin->second));
+        eraseCoin(coin);
+    }
+    record.inputs = std::move(inputs);
+    record.inputsKnown = true;
+}
+
+bool WalletSync::State::markConflicted(Record& record) {
+    const Hash256 txid = record.tx.txid;
+    record.tx.conflicted = true;
+    record.tx.height = -1;
+    record.tx.blockHash = {};
+    pending.erase(txid);
+    eraseCoinsOf(txid);
+
+    for (const OutPoint& outpoint : record.inputs) {
+        for (auto spender = spenders.lower_bound(outpoint); spender != spenders.end() && spender->first == outpoint; ++spender) {
+            if (spender->second == txid) {
+                spenders.erase(spender);
+                break;
+            }
+        }
+    }
+    // A coin goes back to the set unless a replacement of the transaction spends it too.
+    for (WalletUtxo& coin : record.spentCoins) {
+        const OutPoint outpoint {coin.txid, coin.vout};
+        Record* replacement = nullptr;
+        for (auto spender = spenders.lower_bound(outpoint); spender != spenders.end() && spender->first == outpoint; ++spender) {
+            const auto found = records.find(spender->second);
+            if (found != records.end() && !found->second.tx.conflicted) replacement = &found->second;
+        }
+        if (replacement) {
+            replacement->spentCoins.push_back(std::move(coin));
+        } else {
+            insertCoin(std::move(coin));
+        }
+    }
+
+    const bool complete = record.tx.fee == 0 || (record.inputsKnown && !record.loaded);
+    record.inputs.clear();
+    record.spentCoins.clear();
+    record.inputsKnown = false;
+    record.loaded = false;
+    return complete;
+}
+
+void WalletSync::State::insertCoin(WalletUtxo coin) {
+    const OutPoint outpoint {coin.txid, coin.vout};
+    const auto found = coins.find(outpoint);
+    if (found != coins.end()) eraseCoin(found);
+    coinsByHeight.insert({heightKey(coin.height), outpoint});
+    coins.emplace(outpoint, std::move(coin));
+}
+
+void WalletSync::State::eraseCoin(std::map<OutPoint, WalletUtxo>::iterator coin) {
+    coinsByHeight.erase({heightKey(coin->second.height), coin->first});
+    coins.erase(coin);
+}
+
+void WalletSync::State::eraseCoinsOf(const Hash256& txid) {
+    auto coin = coins.lower_bound({txid, 0});
+    while (coin != coins.end() && coin->first.first == txid) {
+        const auto next = std::next(coin);
+        eraseCoin(coin);
+        coin = next;
+    }
+}
+
+std::int32_t WalletSync::State::confirmationsOf(std::int32_t height) const {
+    return height == UNCONFIRMED_KEY ? 0 : tipHeight - height + 1;
+}
+
+bool WalletSync::bootstrap() {
+    std::lock_guard<std::mutex> lock(syncMutex);
+    return load();
+}
+
+bool WalletSync::load() {
+    // The history is read before the set: whatever the wallet does in between is listed again
+    // by the first sync, and the set already reflects it.
+    std::int32_t tip = 0;
+    if (!fetchTipHeight(tip)) return false;
+
+    std::unordered_map<Hash256, WalletTx, TxidHash> reported;
+    Hash256 lastBlock {};
+    if (!fetchSinceBlock(std::nullopt, tip, reported, nullptr, lastBlock)) return false;
+
+    State loaded;
+    if (!fetchHeight(lastBlock, loaded.checkpointHeight, loaded.tipHeight)) return false;
+
+    std::vector<WalletUtxo> coins;
+    if (!fetchUnspent(0, loaded.tipHeight, coins)) return false;
+
+    loaded.records.reserve(reported.size());
+    for (auto& [txid, tx] : reported) loaded.put(std::move(tx)).loaded = true;
+    for (WalletUtxo& coin : coins) loaded.insertCoin(std::move(coin));
+    loaded.checkpoint = lastBlock;
+
+    Logger::formattedInfo("Wallet sync: loaded {} transactions and {} unspent outputs at height {}",
+                          loaded.records.size(), loaded.coins.size(), loaded.tipHeight);
+    {
+        std::unique_lock<std::shared_mutex> lock(stateMutex);
+        state = std::move(loaded);
+    }
+    bootstrapped = true;
+    return true;
+}
+
+bool WalletSync::sync() {
+    std::lock_guard<std::mutex> lock(syncMutex);
+    if (!bootstrapped) return load();
+    return update();
+}
+
+bool WalletSync::update() {
+    Delta delta;
+    std::optional<Hash256> since;
+    std::int32_t checkpointHeight;
+    {
+        std::shared_lock<std::shared_mutex> lock(stateMutex);
+        since = state.checkpoint;
+        checkpointHeight = state.checkpointHeight;
+    }
+
+    std::int32_t tip = 0;
+    if (!fetchTipHeight(tip)) return false;
+    if (!fetchSinceBlock(since, tip, delta.reported, &delta.removed, delta.checkpoint)) return false;
+    if (delta.checkpoint == since) {
+        delta.checkpointHeight = checkpointHeight;
+        delta.tipHeight = tip;
+    } else if (!fetchHeight(delta.checkpoint, delta.checkpointHeight, delta.tipHeight)) {
+        return false;
+    }
+
+    // Every coin that may have changed lies at or above the old checkpoint, unless a deeper
+    // reorganization moved transactions: then from the lowest height they had or now have.
+    delta.windowStart = checkpointHeight;
+    std::vector<Hash256> unread;
+    {
+        std::shared_lock<std::shared_mutex> lock(stateMutex);
+        for (const Hash256& txid : delta.removed) {
+            const auto found = state.records.find(txid);
+            if (found != state.records.end() && found->second.tx.height >= 0) {
+                delta.windowStart = std::min(delta.windowStart, found->second.tx.height);
+            }
+        }
+        for (const auto& [txid, tx] : delta.reported) {
+            if (tx.height >= 0) delta.windowStart = std::min(delta.windowStart, tx.height);
+            if (tx.fee == 0 || tx.conflicted) continue;
+            const auto found = state.records.find(txid);
+            if (found == state.records.end() || (!found->second.inputsKnown && !found->second.loaded)) unread.push_back(txid);
+        }
+    }
+
+    // The margin keeps coins at the bottom of the window listed if blocks arrive meanwhile.
+    const int maxConfirmations = delta.tipHeight - delta.windowStart + 1 + syncSettings.targetConfirmations;
+    if (!fetchUnspent(std::max(maxConfirmations, 1), delta.tipHeight, delta.recentCoins)) return false;
+
+    const auto known = [this, &delta](const Hash256& txid) {
+        if (delta.reported.contains(txid)) return true;
+        std::shared_lock<std::shared_mutex> lock(stateMutex);
+        const auto coin = state.coins.lower_bound({txid, 0});
+        return state.records.contains(txid) || (coin != state.coins.end() && coin->first.first == txid);
+    };
+    // Consolidations that only paid to change are not listed, but their change is.
+    std::unordered_set<Hash256, TxidHash> queued(unread.begin(), unread.end());
+    for (const WalletUtxo& coin : delta.recentCoins) {
+        if (!known(coin.txid) && queued.insert(coin.txid).second) unread.push_back(coin.txid);
+    }
+    if (!fetchSpends(std::move(unread), known, delta.windowStart, delta.spends)) return false;
+
+    if (!apply(delta)) {
+        Logger::warning("Wallet sync: a reorganization rolled back spends from before the bootstrap; reloading unspent outputs");
+        std::vector<WalletUtxo> coins;
+        if (!fetchUnspent(0, delta.tipHeight, coins)) return false;
+        std::unique_lock<std::shared_mutex> lock(stateMutex);
+        state.coins.clear();
+        state.coinsByHeight.clear();
+        for (WalletUtxo& coin : coins) state.insertCoin(std::move(coin));
+    }
+    return true;
+}
+
+bool WalletSync::fetchTipHeight(std::int32_t& tipHeight) {
+    const Json::Value count = client.call<RpcMethod::getblockcount>();
+    if (!count.isIntegral()) {
+        Logger::error("Wallet sync: failed to read the chain height");
+        return false;
+    }
+    tipHeight = count.asInt();
+    return true;
+}
+
+bool WalletSync::fetchSinceBlock(const std::optional<Hash256>& since, std::int32_t tipHeight,
+                                 std::unordered_map<Hash256, WalletTx, TxidHash>& reported,
+                                 std::unordered_set<Hash256, TxidHash>* removed, Hash256& checkpoint) {
+    WalletListReader<WalletEntryResult> reader(4, [&](std::string_view container, WalletEntryResult&& entry) {
+        if (container == "transactions") {
+            mergeEntry(reported[entry.txid], entry, tipHeight);
+        } else if (container == "removed" && removed) {
+            removed->insert(entry.txid);
+        }
+    });
+    const std::optional<std::string> blockHash = since ? std::optional<std::string>(hashToHex(*since)) : std::nullopt;
+    const Json::Value params = toJsonParams(blockHash, syncSettings.targetConfirmations, syncSettings.includeWatchOnly, removed != nullptr);
+    if (!client.streamRequest("listsinceblock", params, reader) || !reader.succeeded() || !parseHash(reader.lastBlock(), checkpoint)) {
+        Logger::formattedError("Wallet sync: failed to list wallet transactions{}", reader.error().empty() ? "" : ": " + reader.error());
+        return false;
+    }
+    return true;
+}
+
+bool WalletSync::fetchUnspent(int maxConfirmations, std::int32_t tipHeight, std::vector<WalletUtxo>& out) {
+    WalletListReader<UnspentOutputResult> reader(3, [&](std::string_view, UnspentOutputResult&& coin) {
+        const std::int32_t height = coin.confirmations > 0 ? tipHeight - static_cast<std::int32_t>(coin.confirmations) + 1 : -1;
+        out.push_back({coin.txid, coin.vout, coin.amount, height, std::move(coin.address), std::move(coin.scriptPubKey),
+                       coin.spendable, coin.safe});
+    });
+    const Json::Value params = toJsonParams(0, maxConfirmations > 0 ? maxConfirmations : ALL_CONFIRMATIONS,
+                                            std::vector<std::string>(), true);
+    if (!client.streamRequest("listunspent", params, reader) || !reader.succeeded()) {
+        Logger::formattedError("Wallet sync: failed to list unspent outputs{}", reader.error().empty() ? "" : ": " + reader.error());
+        return false;
+    }
+    return true;
+}
+
+bool WalletSync::fetchSpends(std::vector<Hash256> txids, const std::function<bool(const Hash256&)>& known, std::int32_t windowStart,
+                             std::vector<std::pair<Hash256, std::vector<OutPoint>>>& spends) {
+    std::unordered_set<Hash256, TxidHash> visited(txids.begin(), txids.end());
+    DecodedTransaction decoded;
+    bool followed = false;
+    for (std::size_t round = 0; !txids.empty() && round < MAX_FOLLOW_ROUNDS; ++round, followed = true) {
+        std::vector<Hash256> next;
+        for (std::size_t first = 0; first < txids.size(); first += syncSettings.transactionBatchSize) {
+            const std::size_t last = std::min(txids.size(), first + syncSettings.transactionBatchSize);
+            RpcBatch batch;
+            for (std::size_t i = first; i < last; ++i) {
+                batch.call<RpcMethod::gettransaction>(hashToHex(txids[i]), syncSettings.includeWatchOnly);
+            }
+
+            const std::vector<RpcResult> results = client.sendBatch(batch);
+            for (std::size_t i = 0; i < results.size(); ++i) {
+                if (results[i].transportFailure) {
+                    Logger::error("Wallet sync: failed to fetch wallet transactions");
+                    return false;
+                }
+                // Not a wallet transaction (a followed input was someone else's), or not funded by the wallet.
+                const Json::Value& result = results[i].result;
+                if (!results[i].ok() || !result.isMember("fee")) continue;
+                // A followed transaction below the window was settled before the last sync.
+                if (followed && result["confirmations"].asInt64() > 0 && result["blockheight"].isIntegral()
+                    && result["blockheight"].asInt() < windowStart) {
+                    continue;
+                }
+                const char* begin = nullptr;
+                const char* end = nullptr;
+                if (!result["hex"].isString() || !result["hex"].getString(&begin, &end)
+                    || !decoded.decode(std::string_view(begin, static_cast<std::size_t>(end - begin)))) {
+                    Logger::formattedError("Wallet sync: failed to decode transaction {}", hashToHex(txids[first + i]));
+                    return false;
+                }
+
+                std::vector<OutPoint> inputs;
+                inputs.reserve(decoded.view().inputs.size());
+                for (const TxInView& input : decoded.view().inputs) {
+                    inputs.emplace_back(input.prevTxid, input.prevIndex);
+                    if (!known(input.prevTxid) && visited.insert(input.prevTxid).second) next.push_back(input.prevTxid);
+                }
+                spends.emplace_back(txids[first + i], std::move(inputs));
+            }
+        }
+        txids = std::move(next);
+    }
+    return true;
+}
+
+bool WalletSync::fetchHeight(const Hash256& blockHash, std::int32_t& height, std::int32_t& tipHeight) {
+    const auto header = client.callTyped<RpcMethod::getblockheader>(hashToHex(blockHash), true);
+    if (!header || header->confirmations < 1) {
+        Logger::formattedError("Wallet sync: failed to look up checkpoint block {}", hashToHex(blockHash));
+        return false;
+    }
+    height = header->height;
+    tipHeight = header->height + static_cast<std::int32_t>(header->confirmations) - 1;
+    return true;
+}
+
+bool WalletSync::apply(Delta& delta) {
+    std::unique_lock<std::shared_mutex> lock(stateMutex);
+    bool complete = true;
+    const auto findRecord = [this](const Hash256& txid) -> Record* {
+        const auto found = state.records.find(txid);
+        return found == state.records.end() ? nullptr : &found->second;
+    };
+
+    // Transactions of disconnected blocks that are neither back in the mempool nor mined again.
+    for (const Hash256& txid : delta.removed) {
+        if (delta.reported.contains(txid)) continue;
+        if (Record* record = findRecord(txid); record && !record->tx.conflicted) {
+            complete = state.markConflicted(*record) && complete;
+        }
+    }
+    // Every unconfirmed transaction is listed again; one that is not was conflicted in the meantime.
+    std::vector<Hash256> vanished;
+    for (const Hash256& txid : state.pending) {
+        if (!delta.reported.contains(txid)) vanished.push_back(txid);
+    }
+    for (const Hash256& txid : vanished) complete = state.markConflicted(state.records.at(txid)) && complete;
+
+    for (auto& [txid, tx] : delta.reported) {
+        Record* existing = findRecord(txid);
+        if (existing && tx.conflicted && !existing->tx.conflicted) complete = state.markConflicted(*existing) && complete;
+        state.put(std::move(tx));
+    }
+
+    for (auto& [txid, inputs] : delta.spends) {
+        if (Record* record = findRecord(txid)) {
+            if (!record->inputsKnown) state.spend(*record, std::move(inputs));
+            continue;
+        }
+        // A transaction the node does not list (it only paid to change): nothing to roll back later.
+        for (const OutPoint& outpoint : inputs) {
+            const auto coin = state.coins.find(outpoint);
+            if (coin != state.coins.end()) state.eraseCoin(coin);
+        }
+    }
+
+    // The node's listing is authoritative for the window: drop what it no longer lists.
+    std::set<OutPoint> listed;
+    for (const WalletUtxo& coin : delta.recentCoins) listed.insert({coin.txid, coin.vout});
+    for (auto key = state.coinsByHeight.lower_bound({delta.windowStart, {}}); key != state.coinsByHeight.end();) {
+        const OutPoint outpoint = (key++)->second;
+        if (!listed.contains(outpoint)) state.eraseCoin(state.coins.find(outpoint));
+    }
+    for (WalletUtxo& coin : delta.recentCoins) state.insertCoin(std::move(coin));
+
+    state.checkpoint = delta.checkpoint;
+    state.checkpointHeight = delta.checkpointHeight;
+    state.tipHeight = delta.tipHeight;
+    return complete;
+}
+
+void WalletSync::start() {
+    if (worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopping = false;
+    }
+    worker = std::thread(&WalletSync::syncLoop, this);
+}
+
+void WalletSync::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopping = true;
+    }
+    stopRequested.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void WalletSync::syncLoop() {
+    while (true) {
+        sync();
+
+        std::unique_lock<std::mutex> lock(stopMutex);
+        if (stopRequested.wait_for(lock, syncSettings.syncInterval, [this] { return stopping; })) return;
+    }
+}
+
+std::size_t WalletSync::size() const {
+    std::shared_lock<std::shared_mutex> lock(stateMutex);
+    return state.records.size();
+}
+
+std::size_t WalletSync::utxoCount() const {
+    std::shared_lock<std::shared_mutex> lock(stateMutex);
+    return state.coins.size();
+}
+
+std::int32_t WalletSync::tipHeight() const {
+    std::shared_lock<std::shared_mutex> lock(stateMutex);
+    return state.tipHeight;
+}
+
+std::optional<Hash256> WalletSync::checkpoint() const {
+    std::shared_lock<std::shared_mutex> lock(stateMutex);
+    return state.checkpoint;
+}
+
+std::optional<WalletTx> WalletSync::find(const Hash256& txid) const {
+    std::shared_lock<std::shared_mutex> lock(stateMutex);
+    const auto found = state.records.find(txid);
+    if (found == state.records.end()) return std::nullopt;
+    return found->second.tx;
+}
+
+std::vector<WalletTx> WalletSync::transactions(std::size_t count, std::size_t skip) const {
+    std::vector<WalletTx> page;
+    std::shared_lock<std::shared_mutex> lock(stateMutex);
+    for (auto key = state.history.rbegin(); key != state.history.rend() && page.size() < count; ++key) {
+        if (skip > 0) {
+            --skip;
+            continue;
+        }
+        page.push_back(state.records.at(key->txid).tx);
+    }
+    return page;
+}
+
+void WalletSync::forEachTransaction(const std::function<bool(const WalletTx&)>& visit) const {
+    std::shared_lock<std::shared_mutex> lock(stateMutex);
+    for (auto key = state.history.rbegin(); key != state.history.rend(); ++key) {
+        if (!visit(state.records.at(key->txid).tx)) return;
+    }
+}
+
+std::vector<WalletUtxo> WalletSync::unspent(int minConfirmations, int maxConfirmations) const {
+    std::vector<WalletUtxo> coins;
+    std::shared_lock<std::shared_mutex> lock(stateMutex);
+    // Confirmed coins with enough confirmations lie below a height bound; unconfirmed ones come last.
+    const std::int32_t lowest = maxConfirmations >= state.tipHeight ? 0 : state.tipHeight - maxConfirmations + 1;
+    for (auto key = state.coinsByHeight.lower_bound({lowest, {}}); key != state.coinsByHeight.end(); ++key) {
+        const std::int32_t confirmations = state.confirmationsOf(key->first);
+        if (confirmations >= minConfirmations && confirmations <= maxConfirmations) coins.push_back(state.coins.at(key->second));
+    }
+    return coins;
+}
+
+Amount WalletSync::balance(int minConfirmations) const {
+    Amount total = 0;
+    std::shared_lock<std::shared_mutex> lock(stateMutex);
+    for (const auto& [height, outpoint] : state.coinsByHeight) {
+        const std::int32_t confirmations = state.confirmationsOf(height);
+        if (confirmations < minConfirmations) continue;
+        const WalletUtxo& coin = state.coins.at(outpoint);
+        if (coin.spendable && (confirmations > 0 || coin.safe)) total += coin.value;
+    }
+    return total;
+}
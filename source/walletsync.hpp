@@ -0,0 +1,336 @@
+#ifndef WALLETSYNC_HPP
+#define WALLETSYNC_HPP
+
+#if __has_include("bitcoinclient.hpp")
+#   include "bitcoinclient.hpp"
+#else
+#   error "Bitcoin's \"bitcoinclient.hpp\" was not found!"
+#endif
+
+#include <cstdint>
+#include <vector>
+#include <set>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <optional>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <functional>
+
+/**
+ * @struct WalletTxEntry
+ * @brief One output a wallet transaction pays to or from the wallet, as listed by `listsinceblock`.
+ */
+struct WalletTxEntry {
+    std::string address;                    ///< Empty for outputs without an address.
+    Amount amount = 0;                      ///< Negative for sends.
+    std::uint32_t vout = 0;
+    WalletCategory category = WalletCategory::Receive;
+};
+
+/**
+ * @struct WalletTx
+ * @brief What the sync keeps about one wallet transaction.
+ */
+struct WalletTx {
+    Hash256 txid {};                        ///< Internal byte order.
+    Hash256 blockHash {};                   ///< Zero while unconfirmed.
+    std::int32_t height = -1;               ///< Block height; -1 while unconfirmed or conflicted.
+    std::int64_t time = 0;                  ///< Unix time the wallet first saw the transaction, or its block time.
+    Amount amount = 0;                      ///< Sum of the entries, in satoshis; the fee is not included.
+    Amount fee = 0;                         ///< Fee paid by the wallet, in satoshis; 0 if the wallet did not fund it.
+    bool conflicted = false;                ///< Conflicts with the active chain.
+    bool abandoned = false;                 ///< Marked with `abandontransaction`.
+    std::vector<WalletTxEntry> entries;
+
+    /**
+     * @brief Returns the confirmations at the given tip height: 0 while unconfirmed, -1 if conflicted.
+     */
+    std::int32_t confirmations(std::int32_t tipHeight) const {
+        if (conflicted) return -1;
+        return height < 0 ? 0 : tipHeight - height + 1;
+    }
+};
+
+/**
+ * @struct WalletUtxo
+ * @brief One unspent wallet output, as listed by `listunspent`.
+ */
+struct WalletUtxo {
+    Hash256 txid {};                        ///< Internal byte order.
+    std::uint32_t vout = 0;
+    Amount value = 0;                       ///< Value in satoshis.
+    std::int32_t height = -1;               ///< Block height; -1 while unconfirmed.
+    std::string address;                    ///< Empty for outputs without an address.
+    std::vector<std::uint8_t> scriptPubKey;
+    bool spendable = false;
+    bool safe = false;                      ///< Unconfirmed outputs from others, or replaceable ones, are not.
+};
+
+/**
+ * @struct WalletSyncSettings
+ * @brief How a WalletSync follows its wallet.
+ */
+struct WalletSyncSettings {
+    int targetConfirmations = 6;                        ///< Depth of the checkpoint below the tip; shallower reorgs are read again without `removed`.
+    bool includeWatchOnly = false;                      ///< Also follow watch-only addresses.
+    std::size_t transactionBatchSize = 200;             ///< `gettransaction` calls per batch.
+    std::chrono::milliseconds syncInterval {5000};      ///< Time between two syncs of the background thread.
+};
+
+/**
+ * @class WalletSync
+ * @brief A local copy of a wallet's history and unspent outputs that is loaded once and then kept up to date by deltas.
+ *
+ * Paging through `listtransactions` with a growing `skip`, or calling `listunspent`, costs the
+ * node time proportional to the size of the wallet on every call. The sync instead loads the
+ * history (`listsinceblock` without a block) and the unspent outputs once, streaming both
+ * straight into its tables, and remembers the `lastblock` checkpoint. Every later sync asks
+ * only for what happened since:
+ *
+ * - `listsinceblock <checkpoint>` returns the transactions of the blocks above the checkpoint
+ *   and the unconfirmed ones, plus the transactions of blocks that a reorganization
+ *   disconnected; those are rolled back.
+ * - `listunspent` is asked only for outputs above the checkpoint, and replaces that part of
+ *   the set.
+ * - Older outputs are only spent by new transactions the wallet funded. Their inputs are
+ *   read from the raw transactions (`gettransaction`, decoded locally), fetched in batches.
+ *
+ * The checkpoint trails the tip by `targetConfirmations - 1` blocks, so reorganizations up to
+ * that depth are simply read again. Steady-state syncs cost time proportional to the new
+ * activity, not to the size of the wallet.
+ *
+ * Like `listunspent`, the set leaves out outputs locked with `lockunspent`.
+ *
+ * Queries take a shared lock and may run on any thread; syncs take the exclusive lock only
+ * to apply an already fetched change, never across an RPC call.
+ *
+ * @code
+ * WalletSync wallet(walletClient);
+ * wallet.start();
+ * // ... on any thread:
+ * Amount spendable = wallet.balance(1);
+ * for (const WalletTx& tx : wallet.transactions(50, 0)) handle(tx);
+ * @endcode
+ */
+class WalletSync {
+public:
+    /**
+     * @brief Creates an empty sync; nothing is fetched until `bootstrap()`, `sync()` or `start()`.
+     * @param client A client for the wallet (its URL ends in `/wallet/<name>` on multiwallet nodes); must outlive the sync.
+     * @param settings How the sync follows the wallet.
+     */
+    explicit WalletSync(BitcoinClient& client, const WalletSyncSettings& settings = {});
+    WalletSync(const WalletSync&) = delete;
+    WalletSync& operator=(const WalletSync&) = delete;
+
+    /**
+     * @brief Stops the background thread.
+     */
+    ~WalletSync();
+
+    /**
+     * @brief Loads the whole history and unspent set, replacing the current contents.
+     * @return `false` if a request failed; the previous contents are kept.
+     */
+    bool bootstrap();
+
+    /**
+     * @brief Applies everything that happened since the checkpoint. Bootstraps first if needed.
+     * @return `false` if a request failed; the next sync tries again from the same checkpoint.
+     */
+    bool sync();
+
+    /**
+     * @brief Starts a thread that bootstraps and then syncs every `syncInterval`.
+     */
+    void start();
+
+    /**
+     * @brief Stops the background thread.
+     */
+    void stop();
+
+    /**
+     * @name Queries
+     * @brief Thread-safe reads of the synced state.
+     */
+    ///@{
+    std::size_t size() const;                                   ///< Number of transactions.
+    std::size_t utxoCount() const;                              ///< Number of unspent outputs.
+    std::int32_t tipHeight() const;                             ///< Chain height at the last sync.
+    std::optional<Hash256> checkpoint() const;                  ///< The `lastblock` the next sync starts from.
+    std::optional<WalletTx> find(const Hash256& txid) const;    ///< Looks up one transaction.
+
+    /**
+     * @brief Returns a page of the history, newest first by the time the wallet saw each transaction.
+     * @param count The page size.
+     * @param skip Transactions to skip.
+     */
+    std::vector<WalletTx> transactions(std::size_t count, std::size_t skip = 0) const;
+
+    /**
+     * @brief Returns the unspent outputs with confirmations in `[minConfirmations, maxConfirmations]`.
+     */
+    std::vector<WalletUtxo> unspent(int minConfirmations = 1, int maxConfirmations = 9999999) const;
+
+    /**
+     * @brief Returns the value of the spendable outputs with at least `minConfirmations`; unsafe unconfirmed outputs are left out.
+     */
+    Amount balance(int minConfirmations = 1) const;
+
+    /**
+     * @brief Visits the transactions from the newest down.
+     * @param visit Receives each transaction; returning `false` stops the walk. Must not call back into the sync.
+     */
+    void forEachTransaction(const std::function<bool(const WalletTx&)>& visit) const;
+    ///@}
+
+private:
+    using OutPoint = std::pair<Hash256, std::uint32_t>;    ///< (txid, vout).
+
+    struct TxidHash {
+        std::size_t operator()(const Hash256& txid) const;  ///< Txids are uniformly distributed already.
+    };
+
+    /**
+     * @struct Record
+     * @brief A transaction and what the sync learned about its inputs.
+     */
+    struct Record {
+        WalletTx tx;
+        std::vector<OutPoint> inputs;           ///< Outputs it spends, once its raw transaction was read.
+        std::vector<WalletUtxo> spentCoins;     ///< Outputs of the set it spent, restored if it is rolled back.
+        bool inputsKnown = false;               ///< Its raw transaction was read and applied.
+        bool loaded = false;                    ///< Came with the bootstrap, whose set already lacks what it spent.
+    };
+
+    /**
+     * @brief Orders the history by the time the wallet saw each transaction, as `listtransactions` does.
+     */
+    struct HistoryKey {
+        std::int64_t time;
+        Hash256 txid;
+
+        auto operator<=>(const HistoryKey&) const = default;
+    };
+
+    /**
+     * @struct State
+     * @brief The synced wallet; bootstraps build a new one and swap it in.
+     */
+    struct State {
+        std::unordered_map<Hash256, Record, TxidHash> records;
+        std::set<HistoryKey> history;           ///< One key per record, iterated backwards.
+        std::unordered_set<Hash256, TxidHash> pending;     ///< Unconfirmed transactions that do not conflict.
+        std::multimap<OutPoint, Hash256> spenders;          ///< Transactions spending each output, as far as they were read.
+        std::map<OutPoint, WalletUtxo> coins;   ///< The unspent set; the outputs of one txid are adjacent.
+        std::set<std::pair<std::int32_t, OutPoint>> coinsByHeight;     ///< (height, outpoint) of every coin, unconfirmed as `INT32_MAX`.
+        std::optional<Hash256> checkpoint;      ///< `lastblock` of the last `listsinceblock`.
+        std::int32_t checkpointHeight = 0;
+        std::int32_t tipHeight = 0;
+
+        Record& put(WalletTx tx);                       ///< Inserts or replaces a transaction, keeping what is known about its inputs.
+        void spend(Record& record, std::vector<OutPoint> inputs);  ///< Applies the inputs of a transaction read raw.
+        bool markConflicted(Record& record);            ///< Rolls back a transaction that left the chain; false if what it spent is unknown.
+        void insertCoin(WalletUtxo coin);               ///< Adds or replaces one coin.
+        void eraseCoin(std::map<OutPoint, WalletUtxo>::iterator coin);
+        void eraseCoinsOf(const Hash256& txid);         ///< Drops the outputs of one transaction from the set.
+        std::int32_t confirmationsOf(std::int32_t height) const;    ///< Confirmations of a coin height key.
+    };
+
+    /**
+     * @struct Delta
+     * @brief Everything one sync fetched, applied at once.
+     */
+    struct Delta {
+        std::unordered_map<Hash256, WalletTx, TxidHash> reported;      ///< Transactions listed since the checkpoint.
+        std::unordered_set<Hash256, TxidHash> removed;                 ///< Transactions of disconnected blocks.
+        std::vector<WalletUtxo> recentCoins;                           ///< Unspent outputs at or above `windowStart`.
+        std::vector<std::pair<Hash256, std::vector<OutPoint>>> spends; ///< Inputs of the transactions read raw.
+        Hash256 checkpoint {};
+        std::int32_t checkpointHeight = 0;
+        std::int32_t tipHeight = 0;
+        std::int32_t windowStart = 0;                                   ///< Lowest height `recentCoins` is complete for.
+    };
+
+    /**
+     * @brief Streams the whole history and unspent set into a new state and swaps it in; `syncMutex` must be held.
+     */
+    bool load();
+
+    /**
+     * @brief Fetches and applies the changes since the checkpoint; `syncMutex` must be held.
+     */
+    bool update();
+
+    /**
+     * @brief Streams `listsinceblock` into `reported` and `removed`.
+     * @param since The checkpoint, or null for the whole history.
+     * @param tipHeight The chain height, for nodes that do not report `blockheight`.
+     * @param[out] checkpoint Receives `lastblock`.
+     */
+    bool fetchSinceBlock(const std::optional<Hash256>& since, std::int32_t tipHeight,
+                         std::unordered_map<Hash256, WalletTx, TxidHash>& reported,
+                         std::unordered_set<Hash256, TxidHash>* removed, Hash256& checkpoint);
+
+    /**
+     * @brief Streams `listunspent` with at most `maxConfirmations` (0: all) into `out`, heights relative to `tipHeight`.
+     */
+    bool fetchUnspent(int maxConfirmations, std::int32_t tipHeight, std::vector<WalletUtxo>& out);
+
+    /**
+     * @brief Reads the inputs of wallet-funded transactions with batched `gettransaction` calls.
+     *
+     * Inputs from transactions the sync has never seen, such as consolidations that only pay
+     * to change and are therefore not listed, are followed as well.
+     *
+     * @param txids The transactions to read.
+     * @param known Returns whether a txid is already known to the sync.
+     * @param windowStart Followed transactions confirmed below this height are left alone.
+     * @param[out] spends One set of inputs per wallet-funded transaction.
+     */
+    bool fetchSpends(std::vector<Hash256> txids, const std::function<bool(const Hash256&)>& known, std::int32_t windowStart,
+                     std::vector<std::pair<Hash256, std::vector<OutPoint>>>& spends);
+
+    /**
+     * @brief Returns the chain height (`getblockcount`).
+     */
+    bool fetchTipHeight(std::int32_t& tipHeight);
+
+    /**
+     * @brief Returns the height of a block, and the tip height derived from its confirmations.
+     */
+    bool fetchHeight(const Hash256& blockHash, std::int32_t& height, std::int32_t& tipHeight);
+
+    /**
+     * @brief Applies a fetched delta under the exclusive lock.
+     * @return `false` if the rollback needed outputs the sync never saw; the set must then be reloaded.
+     */
+    bool apply(Delta& delta);
+
+    /**
+     * @brief Body of the background thread.
+     */
+    void syncLoop();
+
+    BitcoinClient& client;                      ///< Client used for all requests.
+    WalletSyncSettings syncSettings;            ///< Sync rules.
+
+    mutable std::shared_mutex stateMutex;       ///< Guards `state`.
+    State state;                                ///< The synced wallet.
+
+    std::mutex syncMutex;                       ///< Serializes `bootstrap()` and `sync()`.
+    bool bootstrapped = false;                  ///< A bootstrap has succeeded; guarded by `syncMutex`.
+
+    std::mutex stopMutex;                       ///< Guards `stopping`.
+    std::condition_variable stopRequested;      ///< Wakes the background thread.
+    bool stopping = false;                      ///< Stops the background thread.
+    std::thread worker;                         ///< Background sync thread.
+};
+
+#endif // WALLETSYNC_HPP
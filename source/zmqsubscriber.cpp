@@ -0,0 +1,287 @@
+#include "zmqsubscriber.hpp"
+
+#ifdef USE_ZMQ
+
+#include "logger.hpp"
+#include <zmq.h>
+#include <algorithm>
+#include <format>
+
+namespace {
+constexpr int POLL_INTERVAL_MS = 100;   ///< How often the receive thread checks for shutdown.
+
+/**
+ * @brief Reads a hash sent in display order into internal byte order.
+ */
+Hash256 readDisplayHash(const std::uint8_t* data) {
+    Hash256 hash;
+    std::reverse_copy(data, data + hash.size(), hash.begin());
+    return hash;
+}
+
+std::uint32_t readLe32(const std::uint8_t* data) {
+    return std::uint32_t(data[0]) | std::uint32_t(data[1]) << 8 | std::uint32_t(data[2]) << 16 | std::uint32_t(data[3]) << 24;
+}
+
+std::uint64_t readLe64(const std::uint8_t* data) {
+    return std::uint64_t(readLe32(data)) | std::uint64_t(readLe32(data + 4)) << 32;
+}
+
+constexpr std::array<std::string_view, 5> TOPIC_NAMES = {"hashblock", "hashtx", "rawblock", "rawtx", "sequence"};
+}
+
+std::string_view zmqTopicName(ZmqTopic topic) {
+    return TOPIC_NAMES[static_cast<std::size_t>(topic)];
+}
+
+ZmqSubscriber::ZmqSubscriber(BitcoinClient& client, const ZmqSettings& settings)
+    : client(client), zmqSettings(settings) {}
+
+ZmqSubscriber::~ZmqSubscriber() {
+    stop();
+}
+
+void ZmqSubscriber::subscribe(ZmqTopic topic, const std::string& endpoint) {
+    subscriptions.push_back(Subscription{topic, endpoint});
+}
+
+bool ZmqSubscriber::start(ZmqHandlers handlers) {
+    if (running.load()) return false;
+    eventHandlers = std::move(handlers);
+    lastSequence.fill(std::nullopt);
+
+    context = zmq_ctx_new();
+    if (!context) {
+        Logger::formattedError("Failed to create ZMQ context: {}", zmq_strerror(zmq_errno()));
+        return false;
+    }
+
+    // bitcoind may publish several topics on one address; share one socket per address.
+    std::vector<std::string> endpoints;
+    for (const Subscription& subscription : subscriptions) {
+        auto known = std::find(endpoints.begin(), endpoints.end(), subscription.endpoint);
+        void* socket = nullptr;
+        if (known == endpoints.end()) {
+            socket = zmq_socket(context, ZMQ_SUB);
+            if (!socket) {
+                Logger::formattedError("Failed to create ZMQ socket: {}", zmq_strerror(zmq_errno()));
+                closeSockets();
+                return false;
+            }
+            const int keepAlive = 1;
+            const int linger = 0;
+            zmq_setsockopt(socket, ZMQ_RCVHWM, &zmqSettings.receiveHighWaterMark, sizeof(zmqSettings.receiveHighWaterMark));
+            zmq_setsockopt(socket, ZMQ_TCP_KEEPALIVE, &keepAlive, sizeof(keepAlive));
+            zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+            if (zmq_connect(socket, subscription.endpoint.c_str()) != 0) {
+                Logger::formattedError("Failed to connect to ZMQ endpoint {}: {}", subscription.endpoint, zmq_strerror(zmq_errno()));
+                zmq_close(socket);
+                closeSockets();
+                return false;
+            }
+            endpoints.push_back(subscription.endpoint);
+            sockets.push_back(socket);
+        } else {
+            socket = sockets[static_cast<std::size_t>(known - endpoints.begin())];
+        }
+        const std::string_view name = zmqTopicName(subscription.topic);
+        zmq_setsockopt(socket, ZMQ_SUBSCRIBE, name.data(), name.size());
+    }
+
+    running.store(true);
+    dispatcher = std::thread(&ZmqSubscriber::dispatchLoop, this);
+    receiver = std::thread(&ZmqSubscriber::receiveLoop, this);
+    return true;
+}
+
+void ZmqSubscriber::stop() {
+    running.store(false);
+    queueChanged.notify_all();
+    if (receiver.joinable()) receiver.join();
+    if (dispatcher.joinable()) dispatcher.join();
+    closeSockets();
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queue.clear();
+    blockResyncQueued = mempoolResyncQueued = false;
+}
+
+void ZmqSubscriber::closeSockets() {
+    for (void* socket : sockets) zmq_close(socket);
+    sockets.clear();
+    if (context) {
+        zmq_ctx_term(context);
+        context = nullptr;
+    }
+}
+
+void ZmqSubscriber::receiveLoop() {
+    std::vector<zmq_pollitem_t> items;
+    for (void* socket : sockets) items.push_back(zmq_pollitem_t{socket, 0, ZMQ_POLLIN, 0});
+
+    while (running.load(std::memory_order_relaxed)) {
+        const int ready = zmq_poll(items.data(), static_cast<int>(items.size()), POLL_INTERVAL_MS);
+        if (ready < 0) {
+            if (zmq_errno() == EINTR) continue;
+            Logger::formattedError("ZMQ poll failed: {}", zmq_strerror(zmq_errno()));
+            break;
+        }
+        for (const zmq_pollitem_t& item : items) {
+            if (item.revents & ZMQ_POLLIN) receiveMessage(item.socket);
+        }
+    }
+}
+
+void ZmqSubscriber::receiveMessage(void* socket) {
+    // bitcoind sends three parts: topic, body and a 4-byte little-endian sequence number.
+    std::array<std::vector<std::uint8_t>, 3> parts;
+    std::size_t count = 0;
+    bool more = true;
+    while (more) {
+        zmq_msg_t part;
+        zmq_msg_init(&part);
+        if (zmq_msg_recv(&part, socket, ZMQ_DONTWAIT) < 0) {
+            zmq_msg_close(&part);
+            return;
+        }
+        if (count < parts.size()) {
+            const auto* data = static_cast<const std::uint8_t*>(zmq_msg_data(&part));
+            parts[count].assign(data, data + zmq_msg_size(&part));
+        }
+        ++count;
+        more = zmq_msg_more(&part);
+        zmq_msg_close(&part);
+    }
+    if (count != parts.size() || parts[2].size() != 4) {
+        Logger::warning("Ignoring malformed ZMQ message");
+        return;
+    }
+
+    const std::string_view name(reinterpret_cast<const char*>(parts[0].data()), parts[0].size());
+    auto topic = std::find(TOPIC_NAMES.begin(), TOPIC_NAMES.end(), name);
+    if (topic == TOPIC_NAMES.end()) return;
+
+    Event event;
+    event.topic = static_cast<ZmqTopic>(topic - TOPIC_NAMES.begin());
+    event.body = std::move(parts[1]);
+    checkSequence(event.topic, readLe32(parts[2].data()));
+    enqueue(std::move(event));
+}
+
+void ZmqSubscriber::checkSequence(ZmqTopic topic, std::uint32_t sequence) {
+    std::optional<std::uint32_t>& last = lastSequence[static_cast<std::size_t>(topic)];
+    const bool gap = last && sequence != *last + 1;
+    last = sequence;
+    if (!gap) return;
+
+    gaps.fetch_add(1, std::memory_order_relaxed);
+    Logger::formattedWarning("Gap in ZMQ {} notifications, resyncing", zmqTopicName(topic));
+    if (topic != ZmqTopic::HashTx && topic != ZmqTopic::RawTx) enqueue(Event{Event::Kind::BlockResync, topic, {}});
+    if (topic != ZmqTopic::HashBlock && topic != ZmqTopic::RawBlock) enqueue(Event{Event::Kind::MempoolResync, topic, {}});
+}
+
+void ZmqSubscriber::enqueue(Event event) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (event.kind == Event::Kind::Message) {
+            if (queue.size() >= zmqSettings.maxQueuedEvents) {
+                // The event is lost: bring the receiver back in sync once the backlog is drained.
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                const bool blockFeed = event.topic != ZmqTopic::HashTx && event.topic != ZmqTopic::RawTx;
+                const bool mempoolFeed = event.topic != ZmqTopic::HashBlock && event.topic != ZmqTopic::RawBlock;
+                if (blockFeed && !blockResyncQueued) {
+                    queue.push_back(Event{Event::Kind::BlockResync, event.topic, {}});
+                    blockResyncQueued = true;
+                }
+                if (mempoolFeed && !mempoolResyncQueued) {
+                    queue.push_back(Event{Event::Kind::MempoolResync, event.topic, {}});
+                    mempoolResyncQueued = true;
+                }
+                return;
+            }
+        } else {
+            // One pending resync of each kind covers any number of gaps before it runs.
+            bool& queued = event.kind == Event::Kind::BlockResync ? blockResyncQueued : mempoolResyncQueued;
+            if (queued) return;
+            queued = true;
+        }
+        queue.push_back(std::move(event));
+    }
+    queueChanged.notify_one();
+}
+
+void ZmqSubscriber::dispatchLoop() {
+    while (true) {
+        Event event;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueChanged.wait(lock, [this] { return !queue.empty() || !running.load(); });
+            if (!running.load()) return;
+            event = std::move(queue.front());
+            queue.pop_front();
+            if (event.kind == Event::Kind::BlockResync) blockResyncQueued = false;
+            if (event.kind == Event::Kind::MempoolResync) mempoolResyncQueued = false;
+        }
+        dispatch(event);
+    }
+}
+
+void ZmqSubscriber::dispatch(const Event& event) {
+    const ZmqHandlers& handlers = eventHandlers;
+    switch (event.kind) {
+    case Event::Kind::BlockResync: {
+        if (!handlers.onBlockResync) return;
+        Json::Value bestHash = client.getBestBlockHash();
+        if (!bestHash.isString()) {
+            Logger::error("Block resync failed: could not fetch the best block hash");
+            return;
+        }
+        Json::Value block = client.getBlock(bestHash.asString(), false);
+        if (block.isNull()) {
+            Logger::error("Block resync failed: could not fetch the best block");
+            return;
+        }
+        handlers.onBlockResync(block);
+        return;
+    }
+    case Event::Kind::MempoolResync: {
+        if (!handlers.onMempoolResync) return;
+        Json::Value mempool = client.getRawMempool(false);
+        if (mempool.isNull()) {
+            Logger::error("Mempool resync failed: could not fetch the mempool");
+            return;
+        }
+        handlers.onMempoolResync(mempool);
+        return;
+    }
+    case Event::Kind::Message:
+        break;
+    }
+
+    const std::vector<std::uint8_t>& body = event.body;
+    switch (event.topic) {
+    case ZmqTopic::HashBlock:
+        if (handlers.onHashBlock && body.size() == 32) handlers.onHashBlock(readDisplayHash(body.data()));
+        break;
+    case ZmqTopic::HashTx:
+        if (handlers.onHashTx && body.size() == 32) handlers.onHashTx(readDisplayHash(body.data()));
+        break;
+    case ZmqTopic::RawBlock:
+        if (handlers.onRawBlock) handlers.onRawBlock(ByteSpan(body));
+        break;
+    case ZmqTopic::RawTx:
+        if (handlers.onRawTx) handlers.onRawTx(ByteSpan(body));
+        break;
+    case ZmqTopic::Sequence: {
+        if (!handlers.onSequence || body.size() < 33) break;
+        SequenceEvent sequence;
+        sequence.hash = readDisplayHash(body.data());
+        sequence.label = static_cast<SequenceEvent::Label>(body[32]);
+        if (body.size() == 33 + 8) sequence.mempoolSequence = readLe64(body.data() + 33);
+        handlers.onSequence(sequence);
+        break;
+    }
+    }
+}
+
+#endif // USE_ZMQ
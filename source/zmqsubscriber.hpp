@@ -0,0 +1,224 @@
+#ifndef ZMQSUBSCRIBER_HPP
+#define ZMQSUBSCRIBER_HPP
+
+#ifdef USE_ZMQ
+
+#if __has_include("bitcoinclient.hpp")
+#   include "bitcoinclient.hpp"
+#else
+#   error "Bitcoin's \"bitcoinclient.hpp\" was not found!"
+#endif
+
+
+#if __has_include("rawblock.hpp")
+#   include "rawblock.hpp"
+#else
+#   error "Bitcoin's \"rawblock.hpp\" was not found!"
+#endif
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <array>
+#include <optional>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @enum ZmqTopic
+ * @brief The notification feeds published by bitcoind (`-zmqpub<topic>=<address>`).
+ */
+enum class ZmqTopic : std::uint8_t {
+    HashBlock,  ///< Hash of every block connected to the active chain.
+    HashTx,     ///< Hash of every transaction added to the mempool or confirmed in a block.
+    RawBlock,   ///< Serialized connected blocks.
+    RawTx,      ///< Serialized transactions, as for `HashTx`.
+    Sequence    ///< Block connects/disconnects and mempool additions/removals, with a mempool sequence number.
+};
+
+/**
+ * @brief Returns the name bitcoind uses for a topic (e.g. `hashblock`).
+ */
+std::string_view zmqTopicName(ZmqTopic topic);
+
+/**
+ * @struct SequenceEvent
+ * @brief One message of the `sequence` feed.
+ */
+struct SequenceEvent {
+    enum class Label : char {
+        BlockConnected = 'C',
+        BlockDisconnected = 'D',
+        TxAdded = 'A',
+        TxRemoved = 'R'
+    };
+
+    Hash256 hash {};                            ///< Block or transaction hash, internal byte order.
+    Label label = Label::BlockConnected;        ///< What happened.
+    std::optional<std::uint64_t> mempoolSequence;   ///< Mempool sequence number; set for `TxAdded` and `TxRemoved`.
+};
+
+/**
+ * @struct ZmqHandlers
+ * @brief Callbacks of a ZmqSubscriber; all run on its dispatch thread, one at a time.
+ *
+ * Views passed to the callbacks are only valid during the call.
+ */
+struct ZmqHandlers {
+    std::function<void(const Hash256& blockHash)> onHashBlock;          ///< `hashblock` (hash in internal byte order).
+    std::function<void(const Hash256& txid)> onHashTx;                  ///< `hashtx` (hash in internal byte order).
+    std::function<void(ByteSpan block)> onRawBlock;                     ///< `rawblock`; decode with `parseBlock`.
+    std::function<void(ByteSpan tx)> onRawTx;                           ///< `rawtx`; decode with `parseTransaction`.
+    std::function<void(const SequenceEvent& event)> onSequence;         ///< `sequence`.
+
+    /**
+     * @brief Called after block notifications were lost, with `getblock <best hash> 1`.
+     *
+     * Receivers should reconcile their view of the chain from this block (e.g. walk back
+     * through `previousblockhash` until they reach a block they know).
+     */
+    std::function<void(const Json::Value& bestBlock)> onBlockResync;
+
+    /**
+     * @brief Called after mempool notifications were lost, with `getrawmempool false`.
+     */
+    std::function<void(const Json::Value& mempool)> onMempoolResync;
+};
+
+/**
+ * @struct ZmqSettings
+ * @brief Queue bounds of a ZmqSubscriber.
+ */
+struct ZmqSettings {
+    int receiveHighWaterMark = 100000;      ///< Messages buffered per socket by ZeroMQ before it drops new ones.
+    std::size_t maxQueuedEvents = 100000;   ///< Messages waiting for the dispatch thread before new ones are dropped.
+};
+
+/**
+ * @class ZmqSubscriber
+ * @brief Follows bitcoind's ZMQ notification feeds instead of polling the RPC interface.
+ *
+ * A receive thread reads the subscribed feeds and hands each message to a dispatch thread,
+ * which runs the callbacks, so a slow callback never stalls the sockets.
+ *
+ * Every message carries a per-topic sequence number. A jump in it (messages dropped by a
+ * high water mark, by a full dispatch queue, or lost across a bitcoind restart) triggers a
+ * resync through the BitcoinClient: `getbestblockhash` + `getblock` for block feeds,
+ * `getrawmempool` for transaction feeds and both for `sequence`. The result is passed to
+ * `onBlockResync` / `onMempoolResync`, in order with the other events.
+ *
+ * Only available when the library is built with `USE_ZMQ`.
+ *
+ * @code
+ * ZmqSubscriber subscriber(client);
+ * subscriber.subscribe(ZmqTopic::HashBlock, "tcp://127.0.0.1:28332");
+ * ZmqHandlers handlers;
+ * handlers.onHashBlock = [](const Hash256& hash) { std::cout << hashToHex(hash) << std::endl; };
+ * subscriber.start(std::move(handlers));
+ * @endcode
+ */
+class ZmqSubscriber {
+public:
+    /**
+     * @brief Creates a subscriber; nothing is connected until `start()`.
+     * @param client The client used for resyncs; must outlive the subscriber.
+     * @param settings Queue bounds.
+     */
+    explicit ZmqSubscriber(BitcoinClient& client, const ZmqSettings& settings = {});
+    ZmqSubscriber(const ZmqSubscriber&) = delete;
+    ZmqSubscriber& operator=(const ZmqSubscriber&) = delete;
+
+    /**
+     * @brief Stops both threads and closes the sockets.
+     */
+    ~ZmqSubscriber();
+
+    /**
+     * @brief Subscribes to a topic published at an address; call before `start()`.
+     * @param topic The feed.
+     * @param endpoint The address passed to bitcoind's `-zmqpub<topic>` option.
+     */
+    void subscribe(ZmqTopic topic, const std::string& endpoint);
+
+    /**
+     * @brief Connects the sockets and starts the receive and dispatch threads.
+     * @param handlers The callbacks; events of topics without a callback are discarded.
+     * @return `true` if every subscription could be set up; `false` otherwise.
+     */
+    bool start(ZmqHandlers handlers);
+
+    /**
+     * @brief Stops both threads; queued events are discarded.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the number of sequence gaps detected so far.
+     */
+    std::uint64_t gapCount() const { return gaps.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the number of messages dropped because the dispatch queue was full.
+     */
+    std::uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    /**
+     * @struct Event
+     * @brief A unit of work for the dispatch thread.
+     */
+    struct Event {
+        enum class Kind : std::uint8_t { Message, BlockResync, MempoolResync } kind = Kind::Message;
+        ZmqTopic topic = ZmqTopic::HashBlock;
+        std::vector<std::uint8_t> body;
+    };
+
+    /**
+     * @struct Subscription
+     * @brief One topic at one address.
+     */
+    struct Subscription {
+        ZmqTopic topic;
+        std::string endpoint;
+    };
+
+    static constexpr std::size_t TOPIC_COUNT = 5;
+
+    void receiveLoop();
+    void dispatchLoop();
+    void receiveMessage(void* socket);
+    void checkSequence(ZmqTopic topic, std::uint32_t sequence);
+    void enqueue(Event event);
+    void dispatch(const Event& event);
+    void closeSockets();
+
+    BitcoinClient& client;                                  ///< Client used for resyncs.
+    ZmqSettings zmqSettings;                                ///< Queue bounds.
+    ZmqHandlers eventHandlers;                              ///< Callbacks, set by `start()`.
+    std::vector<Subscription> subscriptions;                ///< Requested subscriptions.
+
+    void* context = nullptr;                                ///< ZeroMQ context.
+    std::vector<void*> sockets;                             ///< One SUB socket per address.
+    std::array<std::optional<std::uint32_t>, TOPIC_COUNT> lastSequence; ///< Last sequence number per topic (receive thread only).
+
+    std::mutex queueMutex;                                  ///< Guards `queue` and `blockResyncQueued`/`mempoolResyncQueued`.
+    std::condition_variable queueChanged;                   ///< Signals new events or shutdown.
+    std::deque<Event> queue;                                ///< Events waiting for the dispatch thread.
+    bool blockResyncQueued = false;                         ///< A block resync is already waiting in `queue`.
+    bool mempoolResyncQueued = false;                       ///< A mempool resync is already waiting in `queue`.
+
+    std::atomic<bool> running {false};                      ///< Cleared to stop both threads.
+    std::atomic<std::uint64_t> gaps {0};                    ///< Sequence gaps detected.
+    std::atomic<std::uint64_t> dropped {0};                 ///< Messages dropped on a full queue.
+    std::thread receiver;                                   ///< Reads the sockets.
+    std::thread dispatcher;                                 ///< Runs the callbacks.
+};
+
+#endif // USE_ZMQ
+
+#endif // ZMQSUBSCRIBER_HPP